@@ -0,0 +1,156 @@
+package com.xyoye.common_component.bilibili.live.danmaku
+
+import com.xyoye.data_component.data.bilibili.LiveDanmakuEvent
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 一条 websocket 消息的原生解码结果（布局见 danmaku_live.h），通过直接 [ByteBuffer] 原地读取
+ *
+ * DANMU_MSG 弹幕按到达顺序存放在列式弹幕块（与 danmaku_store.h 相同的 "DDCS" 布局）中，
+ * 时间戳、uid、昵称与推荐分数另成列；认证与心跳回复保留为原始包。其余命令已在原生侧丢弃。
+ *
+ * 属于创建它的 [LiveDanmakuNativeCodec]，下一次解码或关闭后不可再使用。非线程安全。
+ */
+class LiveDanmakuBatch internal constructor(
+    buffer: ByteBuffer
+) {
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+    private var scratch = ByteArray(64)
+
+    val commentCount: Int
+    val packetCount: Int
+
+    private val timestampOffset: Int
+    private val uidOffset: Int
+    private val nameOffsetOffset: Int
+    private val nameLengthOffset: Int
+    private val scoreOffset: Int
+    private val packetOffset: Int
+    private val arenaOffset: Int
+
+    private val colorOffset: Int
+    private val textOffsetOffset: Int
+    private val textLengthOffset: Int
+    private val modeOffset: Int
+    private val textArenaOffset: Int
+
+    init {
+        val view = this.buffer
+        require(view.capacity() >= HEADER_BYTES && view.getInt(0) == MAGIC && view.getInt(4) == VERSION) {
+            "not a live danmaku batch"
+        }
+        commentCount = view.getInt(8)
+        packetCount = view.getInt(12)
+        val storeOffset = view.getInt(16)
+        timestampOffset = view.getInt(20)
+        uidOffset = view.getInt(24)
+        nameOffsetOffset = view.getInt(28)
+        nameLengthOffset = view.getInt(32)
+        scoreOffset = view.getInt(36)
+        packetOffset = view.getInt(40)
+        arenaOffset = view.getInt(44)
+        require(view.getInt(48) <= view.capacity() && view.getInt(storeOffset) == STORE_MAGIC) {
+            "truncated live danmaku batch"
+        }
+        // 列偏移相对于弹幕块起点
+        colorOffset = storeOffset + view.getInt(storeOffset + 20)
+        textOffsetOffset = storeOffset + view.getInt(storeOffset + 24)
+        textLengthOffset = storeOffset + view.getInt(storeOffset + 28)
+        modeOffset = storeOffset + view.getInt(storeOffset + 32)
+        textArenaOffset = storeOffset + view.getInt(storeOffset + 40)
+    }
+
+    fun text(index: Int): String =
+        readString(
+            textArenaOffset + buffer.getInt(textOffsetOffset + index * 4),
+            buffer.getInt(textLengthOffset + index * 4),
+        )
+
+    /**
+     * 1 滚动、4 底部、5 顶部
+     */
+    fun mode(index: Int): Int = buffer.get(modeOffset + index).toInt() and 0xFF
+
+    /**
+     * 0xRRGGBB，不含透明度
+     */
+    fun color(index: Int): Int = buffer.getInt(colorOffset + index * 4)
+
+    /**
+     * 发送端时间戳，缺失时为 0
+     */
+    fun timestampMs(index: Int): Long = buffer.getLong(timestampOffset + index * 8)
+
+    fun userId(index: Int): Long = buffer.getLong(uidOffset + index * 8)
+
+    fun userName(index: Int): String =
+        readString(
+            arenaOffset + buffer.getInt(nameOffsetOffset + index * 4),
+            buffer.getInt(nameLengthOffset + index * 4),
+        )
+
+    fun recommendScore(index: Int): Int = buffer.get(scoreOffset + index).toInt() and 0xFF
+
+    /**
+     * 与 [LiveDanmakuCommandParser] 解析同一条 DANMU_MSG 得到的事件一致
+     */
+    fun danmaku(index: Int): LiveDanmakuEvent.Danmaku =
+        LiveDanmakuEvent.Danmaku(
+            text = text(index),
+            mode =
+                when (mode(index)) {
+                    5 -> LiveDanmakuEvent.DanmakuMode.TOP
+                    4 -> LiveDanmakuEvent.DanmakuMode.BOTTOM
+                    else -> LiveDanmakuEvent.DanmakuMode.SCROLL
+                },
+            color = OPAQUE or color(index),
+            timestampMs = timestampMs(index).takeIf { it > 0 } ?: System.currentTimeMillis(),
+            recommendScore = recommendScore(index).coerceIn(0, 10),
+            userId = userId(index),
+            userName = userName(index),
+        )
+
+    /**
+     * 第 [index] 个认证或心跳回复包，body 复制为新数组；原始 protocolVer 不保留，记为心跳协议
+     */
+    fun packet(index: Int): LiveDanmakuPacket {
+        val row = packetOffset + index * PACKET_ROW_BYTES
+        val length = buffer.getInt(row + 12)
+        val body = ByteArray(length)
+        buffer.position(arenaOffset + buffer.getInt(row + 8))
+        buffer.get(body)
+        return LiveDanmakuPacket(
+            packetLen = HEADER_SIZE + length,
+            headerLen = HEADER_SIZE,
+            protocolVer = LiveDanmakuPacketCodec.PROTOCOL_VER_HEARTBEAT,
+            operation = buffer.getInt(row),
+            sequence = buffer.getInt(row + 4),
+            body = body,
+        )
+    }
+
+    private fun readString(
+        start: Int,
+        length: Int
+    ): String {
+        if (length == 0) return ""
+        if (scratch.size < length) {
+            scratch = ByteArray(maxOf(length, scratch.size * 2))
+        }
+        buffer.position(start)
+        buffer.get(scratch, 0, length)
+        return String(scratch, 0, length, Charsets.UTF_8)
+    }
+
+    companion object {
+        // 与 danmaku_live.h 的 kLiveBatchMagic / kLiveBatchVersion / kLiveBatchHeaderBytes 保持一致
+        private const val MAGIC = 0x424C4444 // "DDLB"
+        private const val VERSION = 1
+        private const val HEADER_BYTES = 52
+        private const val STORE_MAGIC = 0x53434444 // "DDCS"
+        private const val PACKET_ROW_BYTES = 16
+        private const val HEADER_SIZE = 16
+        private const val OPAQUE = 0xFF000000.toInt()
+    }
+}
@@ -0,0 +1,78 @@
+package com.xyoye.common_component.bilibili.live.danmaku
+
+import com.xyoye.common_component.log.LogFacade
+import com.xyoye.common_component.log.model.LogModule
+import java.io.Closeable
+import java.nio.ByteBuffer
+
+/**
+ * 直播弹幕的原生解码器（player_component 的 danmaku_bridge，见 danmaku_live.h）
+ *
+ * 在原生侧按 16 字节头原地拆包，zlib（protover=2）与 brotli（protover=3）包体用跨消息复用的解压状态解压，
+ * DANMU_MSG 的 JSON 直接解析进列式结果，不再为每个包创建 ByteArray、JSONObject 与中间字符串。
+ * 每个连接一个实例，只在解码协程中使用；原生库不可用时 [create] 返回 null，调用方回退到 [LiveDanmakuPacketCodec]。
+ */
+class LiveDanmakuNativeCodec private constructor(
+    private var handle: Long
+) : Closeable {
+    /**
+     * 解码一条 websocket 消息；无法拆出任何包时返回 null。结果在下一次 [decode] 或 [close] 前有效。
+     */
+    fun decode(message: ByteArray): LiveDanmakuBatch? {
+        if (handle == 0L || message.isEmpty()) return null
+        val buffer = nativeDecode(handle, message) ?: return null
+        return runCatching { LiveDanmakuBatch(buffer) }.getOrNull()
+    }
+
+    override fun close() {
+        val current = handle
+        if (current == 0L) return
+        handle = 0L
+        nativeRelease(current)
+    }
+
+    companion object {
+        private const val TAG = "LiveDanmakuNativeCodec"
+
+        val isAvailable: Boolean
+            get() = NativeLibrary.loaded
+
+        /**
+         * 原生库编译时带上了 libbrotlidec；只有此时才向服务器请求 protover=3
+         */
+        val supportsBrotli: Boolean by lazy { NativeLibrary.loaded && nativeSupportsBrotli() }
+
+        fun create(): LiveDanmakuNativeCodec? {
+            if (!NativeLibrary.loaded) return null
+            val handle = nativeCreate()
+            return if (handle == 0L) null else LiveDanmakuNativeCodec(handle)
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(): Long
+
+        @JvmStatic
+        private external fun nativeDecode(
+            handle: Long,
+            message: ByteArray
+        ): ByteBuffer?
+
+        @JvmStatic
+        private external fun nativeSupportsBrotli(): Boolean
+
+        @JvmStatic
+        private external fun nativeRelease(handle: Long)
+    }
+
+    // danmaku_bridge 随播放器模块打包，在第一次使用时加载；单元测试等环境中加载失败则回退到 Kotlin 实现
+    private object NativeLibrary {
+        val loaded: Boolean =
+            try {
+                System.loadLibrary("danmaku_bridge")
+                true
+            } catch (e: UnsatisfiedLinkError) {
+                LogFacade.w(LogModule.PLAYER, TAG, "danmaku_bridge unavailable: ${e.message}")
+                false
+            }
+    }
+}
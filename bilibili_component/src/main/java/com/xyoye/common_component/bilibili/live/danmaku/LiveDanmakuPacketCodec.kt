@@ -65,7 +65,8 @@ object LiveDanmakuPacketCodec {
                 }
 
                 PROTOCOL_VER_BROTLI -> {
-                    // MVP: avoid brotli dependency by using protover=2; ignore unsupported packets safely.
+                    // Only requested when LiveDanmakuNativeCodec supports brotli, which decodes these itself;
+                    // the Kotlin fallback ignores them safely.
                 }
 
                 else -> flattened.add(packet)
@@ -141,7 +141,7 @@ class LiveDanmakuSocketClient(
                                         JSONObject()
                                             .put("uid", uid)
                                             .put("roomid", resolvedRoomId)
-                                            .put("protover", LiveDanmakuPacketCodec.PROTOCOL_VER_ZLIB)
+                                            .put("protover", protocolVersion())
                                             .put("platform", "web")
                                             .put("type", 2)
                                             .put("key", token)
@@ -246,8 +246,14 @@ class LiveDanmakuSocketClient(
         if (decodeJob?.isActive == true) return
         decodeJob =
             scope.launch(Dispatchers.IO) {
-                for (bytes in binaryChannel) {
-                    handleBinary(bytes)
+                // One native decoder per connection: its decompressor state and buffers are reused across messages.
+                val nativeCodec = LiveDanmakuNativeCodec.create()
+                try {
+                    for (bytes in binaryChannel) {
+                        handleBinary(bytes, nativeCodec)
+                    }
+                } finally {
+                    nativeCodec?.close()
                 }
             }
     }
@@ -260,14 +266,28 @@ class LiveDanmakuSocketClient(
         }
     }
 
-    private fun handleBinary(bytes: ByteArray) {
-        val packets = LiveDanmakuPacketCodec.decodeAll(bytes)
-        packets.forEach { packet ->
-            when (packet.operation) {
-                LiveDanmakuPacketCodec.OP_AUTH_REPLY -> handleAuthReply(packet)
-                LiveDanmakuPacketCodec.OP_HEARTBEAT_REPLY -> handleHeartbeatReply(packet)
-                LiveDanmakuPacketCodec.OP_COMMAND -> handleCommand(packet)
+    private fun handleBinary(
+        bytes: ByteArray,
+        nativeCodec: LiveDanmakuNativeCodec?
+    ) {
+        val batch = nativeCodec?.decode(bytes)
+        if (batch != null) {
+            for (index in 0 until batch.packetCount) {
+                handlePacket(batch.packet(index))
+            }
+            for (index in 0 until batch.commentCount) {
+                listener.onEvent(batch.danmaku(index))
             }
+            return
+        }
+        LiveDanmakuPacketCodec.decodeAll(bytes).forEach(::handlePacket)
+    }
+
+    private fun handlePacket(packet: LiveDanmakuPacket) {
+        when (packet.operation) {
+            LiveDanmakuPacketCodec.OP_AUTH_REPLY -> handleAuthReply(packet)
+            LiveDanmakuPacketCodec.OP_HEARTBEAT_REPLY -> handleHeartbeatReply(packet)
+            LiveDanmakuPacketCodec.OP_COMMAND -> handleCommand(packet)
         }
     }
 
@@ -341,6 +361,14 @@ class LiveDanmakuSocketClient(
         heartbeatJob = null
     }
 
+    // Brotli bundles are smaller, but only the native codec can open them.
+    private fun protocolVersion(): Int =
+        if (LiveDanmakuNativeCodec.supportsBrotli) {
+            LiveDanmakuPacketCodec.PROTOCOL_VER_BROTLI
+        } else {
+            LiveDanmakuPacketCodec.PROTOCOL_VER_ZLIB
+        }
+
     private fun buildWssUrl(host: BilibiliLiveDanmuHost): String = "wss://${host.host}:${host.wssPort}/sub"
 
     private fun normalizeHosts(hosts: List<BilibiliLiveDanmuHost>): List<BilibiliLiveDanmuHost> =
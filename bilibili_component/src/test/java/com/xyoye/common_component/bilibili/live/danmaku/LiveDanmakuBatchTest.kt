@@ -0,0 +1,106 @@
+package com.xyoye.common_component.bilibili.live.danmaku
+
+import com.xyoye.data_component.data.bilibili.LiveDanmakuEvent
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.robolectric.RobolectricTestRunner
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+@RunWith(RobolectricTestRunner::class)
+class LiveDanmakuBatchTest {
+    @Test
+    fun readsCommentsAndReplyPackets() {
+        val batch = LiveDanmakuBatch(buildBatch())
+
+        assertEquals(2, batch.commentCount)
+        assertEquals("前方高能", batch.text(0))
+        assertEquals("awsl", batch.text(1))
+        assertEquals("路人", batch.userName(0))
+        assertEquals("", batch.userName(1))
+        assertEquals(4_000_000_000_123L, batch.userId(0))
+
+        val top = batch.danmaku(0)
+        assertEquals(LiveDanmakuEvent.DanmakuMode.TOP, top.mode)
+        assertEquals(0xFFFE0302.toInt(), top.color)
+        assertEquals(1_718_000_000_000L, top.timestampMs)
+        assertEquals(10, top.recommendScore)
+
+        val scroll = batch.danmaku(1)
+        assertEquals(LiveDanmakuEvent.DanmakuMode.SCROLL, scroll.mode)
+        // 缺失的时间戳用本地时间补齐
+        assertEquals(true, scroll.timestampMs > 1_718_000_000_000L)
+
+        assertEquals(1, batch.packetCount)
+        val reply = batch.packet(0)
+        assertEquals(LiveDanmakuPacketCodec.OP_HEARTBEAT_REPLY, reply.operation)
+        assertEquals(7, reply.sequence)
+        assertArrayEquals(byteArrayOf(0, 1, -30, 64), reply.body)
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsOtherBlocks() {
+        LiveDanmakuBatch(ByteBuffer.allocate(64))
+    }
+
+    @Test
+    fun codecIsUnavailableWithoutNativeLibrary() {
+        assertNull(LiveDanmakuNativeCodec.create())
+        assertEquals(false, LiveDanmakuNativeCodec.supportsBrotli)
+    }
+
+    // Same layout danmaku::LiveDecoder packs (danmaku_live.h).
+    private fun buildBatch(): ByteBuffer {
+        val texts = listOf("前方高能", "awsl").map { it.toByteArray(Charsets.UTF_8) }
+        val textArena = texts[0] + texts[1]
+        val storeArenaOffset = 48 + 2 * 4 * 4 + 4
+        val storeBytes = align(storeArenaOffset + textArena.size)
+
+        val names = "路人".toByteArray(Charsets.UTF_8)
+        val body = byteArrayOf(0, 1, -30, 64)
+        val storeOffset = 52
+        val timestampOffset = storeOffset + storeBytes
+        val uidOffset = timestampOffset + 16
+        val nameOffsetOffset = uidOffset + 16
+        val nameLengthOffset = nameOffsetOffset + 8
+        val scoreOffset = nameLengthOffset + 8
+        val packetOffset = align(scoreOffset + 2)
+        val arenaOffset = packetOffset + 16
+        val total = align(arenaOffset + names.size + body.size)
+
+        val buffer = ByteBuffer.allocate(total).order(ByteOrder.LITTLE_ENDIAN)
+        listOf(
+            0x424C4444, 1, 2, 1, storeOffset, timestampOffset, uidOffset, nameOffsetOffset,
+            nameLengthOffset, scoreOffset, packetOffset, arenaOffset, total,
+        ).forEach(buffer::putInt)
+
+        // DDCS block: time, color, text_offset, text_length, mode, size, arena
+        listOf(0x53434444, 1, 2, textArena.size, 48, 56, 64, 72, 80, 82, storeArenaOffset, storeBytes)
+            .forEach(buffer::putInt)
+        buffer.putInt(0).putInt(0)
+        buffer.putInt(0xFE0302).putInt(0xFFFFFF)
+        buffer.putInt(0).putInt(texts[0].size)
+        buffer.putInt(texts[0].size).putInt(texts[1].size)
+        buffer.put(5).put(1).put(25).put(25)
+        buffer.position(storeOffset + storeArenaOffset)
+        buffer.put(textArena)
+
+        buffer.position(timestampOffset)
+        buffer.putLong(1_718_000_000_000L).putLong(0L)
+        buffer.putLong(4_000_000_000_123L).putLong(10002L)
+        buffer.putInt(0).putInt(names.size)
+        buffer.putInt(names.size).putInt(0)
+        buffer.put(12).put(0)
+
+        buffer.position(packetOffset)
+        buffer.putInt(LiveDanmakuPacketCodec.OP_HEARTBEAT_REPLY).putInt(7).putInt(names.size).putInt(body.size)
+        buffer.put(names).put(body)
+        buffer.clear()
+        return buffer
+    }
+
+    private fun align(value: Int): Int = (value + 3) and 3.inv()
+}
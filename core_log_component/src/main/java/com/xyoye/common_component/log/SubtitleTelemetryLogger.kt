@@ -41,6 +41,10 @@ object SubtitleTelemetryLogger {
         sample.cpuUsagePct?.let { builder.append(" cpu=").append(it) }
         sample.gpuOverutilized?.let { builder.append(" gpu_over=").append(it) }
         sample.vsyncMiss?.let { builder.append(" vsync_miss=").append(it) }
+        sample.bitmapCacheHitRate?.let { builder.append(" bitmap_cache_hit=").append(it) }
+        sample.bitmapCacheBytes?.let { builder.append(" bitmap_cache_bytes=").append(it) }
+        sample.libassCacheLimitBytes?.let { builder.append(" libass_cache_limit=").append(it) }
+        sample.renderScale?.let { builder.append(" render_scale=").append(it) }
         state?.let {
             builder.append(" mode=").append(it.mode.name)
             builder.append(" status=").append(it.status.name)
@@ -62,6 +62,10 @@ object DanmuConfigTable {
     @MMKVFiled
     const val cloudDanmuBlock = true
 
+    // 合并刷屏的重复弹幕
+    @MMKVFiled
+    const val mergeDuplicateDanmu = false
+
     // 弹幕语言
     @MMKVFiled
     val danmuLanguage: Int = DanmakuLanguage.ORIGINAL.value
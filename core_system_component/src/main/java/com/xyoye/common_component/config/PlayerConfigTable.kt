@@ -92,4 +92,8 @@ object PlayerConfigTable {
     // MPV 视频同步（video-sync）：default / audio / display-resample / ...
     @MMKVFiled
     val mpvVideoSync = "default"
+
+    // MPV 退出播放时复用已初始化的 mpv 核心（stop 并重置状态），缩短下一次播放的启动耗时
+    @MMKVFiled
+    val mpvReuseHandle = true
 }
@@ -71,4 +71,28 @@ object SubtitleConfigTable {
     // 字幕时间偏移（毫秒）
     @MMKVFiled
     const val subtitleOffsetMs = 0L
+
+    // 字幕简繁转换（ORIGINAL / SC / TC）
+    @MMKVFiled
+    const val subtitleLanguage = "ORIGINAL"
+
+    // ASS 解析缓存容量上限（MB），0 表示关闭
+    @MMKVFiled
+    const val assTrackCacheMaxMb = 128L
+
+    // ASS 解析缓存最大文件数
+    @MMKVFiled
+    const val assTrackCacheMaxEntries = 32
+
+    // ASS 解析缓存淘汰策略（LRU / OLDEST_FIRST）
+    @MMKVFiled
+    const val assTrackCacheEviction = "LRU"
+
+    // ASS 静态事件位图缓存内存上限（MB），0 表示关闭
+    @MMKVFiled
+    const val assBitmapCacheMaxMb = 32L
+
+    // libass 渲染档位（AUTO / LOW_MEMORY / BALANCED / QUALITY），AUTO 按设备内存等级选择
+    @MMKVFiled
+    const val assRendererProfile = "AUTO"
 }
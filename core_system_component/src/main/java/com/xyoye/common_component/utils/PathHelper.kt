@@ -32,6 +32,16 @@ object PathHelper {
      */
     fun getSubtitleDirectory(): File = getCacheDirectory(CacheType.SUBTITLE_CACHE)
 
+    /**
+     * 获取字幕解析缓存文件夹
+     */
+    fun getSubtitleTrackCacheDirectory(): File = getCacheDirectory(CacheType.SUBTITLE_TRACK_CACHE)
+
+    /**
+     * 获取弹幕解析缓存文件夹
+     */
+    fun getDanmuParseCacheDirectory(): File = getCacheDirectory(CacheType.DANMU_PARSE_CACHE)
+
     /**
      * 获取视频封面的文件夹
      */
@@ -12,5 +12,12 @@ data class TelemetrySample(
     val dropReason: String? = null,
     val cpuUsagePct: Double? = null,
     val gpuOverutilized: Boolean? = null,
-    val vsyncMiss: Boolean? = null
+    val vsyncMiss: Boolean? = null,
+    // 静态事件位图缓存自轨道加载以来的命中率
+    val bitmapCacheHitRate: Double? = null,
+    val bitmapCacheBytes: Long? = null,
+    // libass glyph/bitmap 缓存按当前渲染档位设置的上限
+    val libassCacheLimitBytes: Long? = null,
+    // 负载降级后 libass 栅格化分辨率相对输出尺寸的比例，1.0 为原始分辨率
+    val renderScale: Double? = null
 )
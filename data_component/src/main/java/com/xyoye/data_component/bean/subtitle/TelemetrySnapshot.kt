@@ -9,5 +9,6 @@ data class TelemetrySnapshot(
     val vsyncHitRate: Double? = null,
     val cpuPeakPct: Double? = null,
     val mode: SubtitlePipelineMode? = null,
-    val lastFallback: FallbackEvent? = null
+    val lastFallback: FallbackEvent? = null,
+    val bitmapCacheHitRate: Double? = null
 )
@@ -43,5 +43,15 @@ enum class CacheType(
         "font",
         "字幕字体",
         "清除字体缓存将删除已下载的字幕字体，确认清除？",
+    ),
+    SUBTITLE_TRACK_CACHE(
+        "subtitle_track",
+        "字幕解析缓存",
+        "字幕解析缓存用于加快重复打开同一字幕文件，清除后将重新解析字幕，确认清除？",
+    ),
+    DANMU_PARSE_CACHE(
+        "danmu_parse",
+        "弹幕解析缓存",
+        "弹幕解析缓存用于加快重复打开同一弹幕文件，清除后将重新解析弹幕，确认清除？",
     )
 }
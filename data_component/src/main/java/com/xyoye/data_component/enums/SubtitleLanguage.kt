@@ -0,0 +1,16 @@
+package com.xyoye.data_component.enums
+
+/**
+ * 字幕简繁转换目标语言
+ */
+enum class SubtitleLanguage {
+    ORIGINAL,
+
+    SC,
+
+    TC;
+
+    companion object {
+        fun fromName(name: String?): SubtitleLanguage = values().find { it.name == name } ?: ORIGINAL
+    }
+}
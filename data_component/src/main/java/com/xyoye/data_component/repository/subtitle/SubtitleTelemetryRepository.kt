@@ -77,6 +77,7 @@ class SubtitleTelemetryRepository(
             cpuPeakPct = cpuPeak,
             mode = latestState?.mode ?: SubtitlePipelineMode.GPU_GL,
             lastFallback = lastFallback,
+            bitmapCacheHitRate = samples.lastOrNull { it.bitmapCacheHitRate != null }?.bitmapCacheHitRate,
         )
     }
 
@@ -93,4 +93,33 @@ class SubtitleTelemetryRepositoryTest {
             assertNotNull(snapshot.cpuPeakPct)
             assertEquals(9.0, snapshot.cpuPeakPct!!, 0.0001)
         }
+
+    @Test
+    fun latestSnapshot_reportsNewestBitmapCacheHitRate() =
+        runTest {
+            val repository = SubtitleTelemetryRepository(windowMs = 1_000L, maxSamples = 10)
+            repository.submit(
+                TelemetrySample(
+                    timestampMs = 0L,
+                    subtitlePtsMs = 0L,
+                    renderLatencyMs = 1.0,
+                    uploadLatencyMs = 1.0,
+                    frameStatus = SubtitleFrameStatus.Rendered,
+                    bitmapCacheHitRate = 0.25,
+                ),
+            )
+            repository.submit(
+                TelemetrySample(
+                    timestampMs = 100L,
+                    subtitlePtsMs = 100L,
+                    renderLatencyMs = 0.0,
+                    uploadLatencyMs = 0.0,
+                    frameStatus = SubtitleFrameStatus.Skipped,
+                ),
+            )
+
+            val snapshot = repository.latestSnapshot()
+            assertNotNull(snapshot)
+            assertEquals(0.25, snapshot!!.bitmapCacheHitRate!!, 0.0001)
+        }
 }
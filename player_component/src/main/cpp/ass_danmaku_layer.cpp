@@ -0,0 +1,382 @@
+#include "ass_danmaku_layer.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace ass_gpu {
+namespace {
+constexpr const char *kDanmakuLogTag = "AssDanmakuLayer";
+
+// Quad corners come from gl_VertexID (triangle strip), so the layer needs no
+// per-vertex buffer; everything else is per instance. Comments outside their
+// display window collapse to a degenerate point off screen.
+constexpr const char *kDanmakuVertexShader = R"(#version 300 es
+layout (location = 0) in vec4 aTiming;
+layout (location = 1) in vec4 aGeometry;
+layout (location = 2) in vec4 aAtlasRect;
+layout (location = 3) in vec4 aFillColor;
+layout (location = 4) in vec4 aStrokeColor;
+uniform vec2 uViewport;
+uniform float uPtsMs;
+out vec3 vTexCoord;
+out vec4 vFillColor;
+out vec4 vStrokeColor;
+void main() {
+    float elapsed = uPtsMs - aTiming.x;
+    if (elapsed < 0.0 || elapsed >= aTiming.y) {
+        gl_Position = vec4(-2.0, -2.0, 0.0, 1.0);
+        return;
+    }
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    float width = aGeometry.y;
+    int mode = int(aTiming.z + 0.5);
+    float x;
+    if (mode == 1) {
+        x = uViewport.x - elapsed * (uViewport.x + width) / aTiming.y;
+    } else if (mode == 6) {
+        x = elapsed * (uViewport.x + width) / aTiming.y - width;
+    } else {
+        x = (uViewport.x - width) * 0.5;
+    }
+    vec2 pixel = vec2(x, aGeometry.x) + corner * aGeometry.yz;
+    gl_Position = vec4(pixel.x / uViewport.x * 2.0 - 1.0, 1.0 - pixel.y / uViewport.y * 2.0, 0.0, 1.0);
+    vTexCoord = vec3(mix(aAtlasRect.xy, aAtlasRect.zw, corner), aTiming.w);
+    vFillColor = aFillColor;
+    vStrokeColor = aStrokeColor;
+}
+)";
+
+constexpr const char *kDanmakuFragmentShader = R"(#version 300 es
+precision highp float;
+precision mediump sampler2DArray;
+uniform sampler2DArray uAtlas;
+uniform float uAlpha;
+in vec3 vTexCoord;
+in vec4 vFillColor;
+in vec4 vStrokeColor;
+out vec4 fragColor;
+void main() {
+    vec2 coverage = texture(uAtlas, vTexCoord).rg;
+    vec4 fill = vec4(vFillColor.rgb, 1.0) * (vFillColor.a * coverage.r);
+    vec4 stroke = vec4(vStrokeColor.rgb, 1.0) * (vStrokeColor.a * coverage.g);
+    fragColor = (fill + stroke * (1.0 - fill.a)) * uAlpha;
+}
+)";
+
+constexpr GLuint kAttributeCount = 5;
+
+GLuint CompileStage(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    if (shader == 0) return 0;
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetShaderInfoLog(shader, length, nullptr, log.data());
+        __android_log_print(ANDROID_LOG_ERROR, kDanmakuLogTag, "Shader compile failed: %s", log.c_str());
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint LinkProgram() {
+    GLuint vertex = CompileStage(GL_VERTEX_SHADER, kDanmakuVertexShader);
+    GLuint fragment = CompileStage(GL_FRAGMENT_SHADER, kDanmakuFragmentShader);
+    if (vertex == 0 || fragment == 0) {
+        if (vertex != 0) glDeleteShader(vertex);
+        if (fragment != 0) glDeleteShader(fragment);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        __android_log_print(ANDROID_LOG_ERROR, kDanmakuLogTag, "Program link failed");
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+inline void ToRgba(uint32_t argb, uint8_t out[4]) {
+    out[0] = static_cast<uint8_t>(argb >> 16);
+    out[1] = static_cast<uint8_t>(argb >> 8);
+    out[2] = static_cast<uint8_t>(argb);
+    out[3] = static_cast<uint8_t>(argb >> 24);
+}
+}  // namespace
+
+void DanmakuLayer::Configure(int page_width, int page_height, int page_count) {
+    page_width = std::max(page_width, 0);
+    page_height = std::max(page_height, 0);
+    page_count = std::max(page_count, 0);
+    if (page_width == page_width_ && page_height == page_height_ &&
+        static_cast<size_t>(page_count) == pages_.size()) {
+        return;
+    }
+    page_width_ = page_width;
+    page_height_ = page_height;
+    pages_.clear();
+    pages_.resize(static_cast<size_t>(page_count));
+    RebuildInstances();
+}
+
+bool DanmakuLayer::SubmitPage(int page, const uint8_t *rgba, size_t stride, std::vector<Comment> comments) {
+    if (page < 0 || static_cast<size_t>(page) >= pages_.size() || rgba == nullptr || page_width_ <= 0 ||
+        page_height_ <= 0 || stride < static_cast<size_t>(page_width_) * 4) {
+        return false;
+    }
+    Page &target = pages_[static_cast<size_t>(page)];
+    const size_t row_bytes = static_cast<size_t>(page_width_) * 2;
+    target.texels.resize(row_bytes * static_cast<size_t>(page_height_));
+    for (int y = 0; y < page_height_; ++y) {
+        const uint8_t *src = rgba + stride * static_cast<size_t>(y);
+        uint8_t *dst = target.texels.data() + row_bytes * static_cast<size_t>(y);
+        for (int x = 0; x < page_width_; ++x) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            src += 4;
+            dst += 2;
+        }
+    }
+    comments.erase(std::remove_if(comments.begin(), comments.end(),
+                                  [this](const Comment &comment) {
+                                      return comment.duration_ms <= 0 || comment.atlas_w <= 0 ||
+                                             comment.atlas_h <= 0 || comment.atlas_x < 0 ||
+                                             comment.atlas_y < 0 ||
+                                             comment.atlas_x + comment.atlas_w > page_width_ ||
+                                             comment.atlas_y + comment.atlas_h > page_height_;
+                                  }),
+                   comments.end());
+    target.comments = std::move(comments);
+    target.uploaded = false;
+    RebuildInstances();
+    return true;
+}
+
+void DanmakuLayer::Clear() {
+    for (auto &page : pages_) {
+        page.texels.clear();
+        page.texels.shrink_to_fit();
+        page.comments.clear();
+        page.uploaded = false;
+    }
+    RebuildInstances();
+}
+
+void DanmakuLayer::RebuildInstances() {
+    struct Entry {
+        int64_t start_ms;
+        int page;
+        const Comment *comment;
+    };
+    std::vector<Entry> entries;
+    for (size_t index = 0; index < pages_.size(); ++index) {
+        for (const auto &comment : pages_[index].comments) {
+            entries.push_back({comment.start_ms, static_cast<int>(index), &comment});
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry &a, const Entry &b) { return a.start_ms < b.start_ms; });
+
+    instances_.clear();
+    starts_.clear();
+    instances_.reserve(entries.size());
+    starts_.reserve(entries.size());
+    max_duration_ms_ = 0;
+    time_base_ms_ = entries.empty() ? 0 : entries.front().start_ms;
+    const float inv_width = page_width_ > 0 ? 1.0F / static_cast<float>(page_width_) : 0.0F;
+    const float inv_height = page_height_ > 0 ? 1.0F / static_cast<float>(page_height_) : 0.0F;
+    for (const auto &entry : entries) {
+        const Comment &comment = *entry.comment;
+        Instance instance{};
+        // Relative to the first comment so a float keeps millisecond precision for long videos.
+        instance.timing[0] = static_cast<float>(entry.start_ms - time_base_ms_);
+        instance.timing[1] = static_cast<float>(comment.duration_ms);
+        instance.timing[2] = static_cast<float>(comment.mode);
+        instance.timing[3] = static_cast<float>(entry.page);
+        instance.geometry[0] = comment.y;
+        instance.geometry[1] = comment.width;
+        instance.geometry[2] = comment.height;
+        instance.atlas[0] = static_cast<float>(comment.atlas_x) * inv_width;
+        instance.atlas[1] = static_cast<float>(comment.atlas_y) * inv_height;
+        instance.atlas[2] = static_cast<float>(comment.atlas_x + comment.atlas_w) * inv_width;
+        instance.atlas[3] = static_cast<float>(comment.atlas_y + comment.atlas_h) * inv_height;
+        ToRgba(comment.fill_color, instance.fill);
+        ToRgba(comment.stroke_color, instance.stroke);
+        instances_.push_back(instance);
+        starts_.push_back(entry.start_ms);
+        max_duration_ms_ = std::max(max_duration_ms_, comment.duration_ms);
+    }
+    instances_dirty_ = true;
+    content_changed_ = true;
+}
+
+void DanmakuLayer::VisibleRange(int64_t pts_ms, size_t *first, size_t *last) const {
+    // A comment is on screen while start <= pts < start + duration.
+    const auto begin = std::upper_bound(starts_.begin(), starts_.end(), pts_ms - max_duration_ms_);
+    const auto end = std::upper_bound(begin, starts_.end(), pts_ms);
+    *first = static_cast<size_t>(begin - starts_.begin());
+    *last = static_cast<size_t>(end - starts_.begin());
+}
+
+bool DanmakuLayer::NeedsRedraw(int64_t pts_ms) const {
+    if (drawn_visible_) {
+        return content_changed_ || pts_ms != drawn_pts_ms_;
+    }
+    size_t first = 0;
+    size_t last = 0;
+    VisibleRange(pts_ms, &first, &last);
+    return first < last;
+}
+
+bool DanmakuLayer::EnsureGl() {
+    if (gl_failed_) return false;
+    if (program_ == 0) {
+        program_ = LinkProgram();
+        if (program_ == 0) {
+            // Not retried every frame; a new context (OnContextLost) gets another attempt.
+            gl_failed_ = true;
+            return false;
+        }
+        uniform_viewport_ = glGetUniformLocation(program_, "uViewport");
+        uniform_pts_ = glGetUniformLocation(program_, "uPtsMs");
+        uniform_alpha_ = glGetUniformLocation(program_, "uAlpha");
+        glUseProgram(program_);
+        glUniform1i(glGetUniformLocation(program_, "uAtlas"), 0);
+    }
+    if (buffer_ == 0) {
+        glGenBuffers(1, &buffer_);
+        instances_dirty_ = true;
+    }
+    const int layers = static_cast<int>(pages_.size());
+    if (texture_ != 0 &&
+        (texture_width_ != page_width_ || texture_height_ != page_height_ || texture_layers_ != layers)) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    if (texture_ == 0 && page_width_ > 0 && page_height_ > 0 && layers > 0) {
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RG8, page_width_, page_height_, layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        texture_width_ = page_width_;
+        texture_height_ = page_height_;
+        texture_layers_ = layers;
+        for (auto &page : pages_) {
+            page.uploaded = false;
+        }
+    }
+    return texture_ != 0;
+}
+
+bool DanmakuLayer::Draw(int64_t pts_ms, int width, int height, float alpha) {
+    size_t first = 0;
+    size_t last = 0;
+    VisibleRange(pts_ms, &first, &last);
+    content_changed_ = false;
+    drawn_pts_ms_ = pts_ms;
+    drawn_visible_ = false;
+    if (first >= last || width <= 0 || height <= 0 || alpha <= 0.0F) {
+        return true;
+    }
+    if (!EnsureGl()) {
+        return false;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    for (size_t index = 0; index < pages_.size(); ++index) {
+        Page &page = pages_[index];
+        if (page.uploaded || page.texels.empty()) continue;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(index), page_width_, page_height_, 1,
+                        GL_RG, GL_UNSIGNED_BYTE, page.texels.data());
+        page.uploaded = true;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    if (instances_dirty_) {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instances_.size() * sizeof(Instance)),
+                     instances_.data(), GL_STATIC_DRAW);
+        instances_dirty_ = false;
+    }
+
+    glUseProgram(program_);
+    glUniform2f(uniform_viewport_, static_cast<float>(width), static_cast<float>(height));
+    glUniform1f(uniform_pts_, static_cast<float>(pts_ms - time_base_ms_));
+    glUniform1f(uniform_alpha_, alpha);
+
+    // GLES 3.0 has no base instance, so the visible range is selected by offsetting the
+    // attribute pointers instead.
+    const size_t base = first * sizeof(Instance);
+    const GLsizei stride = sizeof(Instance);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<void *>(base + offsetof(Instance, timing)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<void *>(base + offsetof(Instance, geometry)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<void *>(base + offsetof(Instance, atlas)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          reinterpret_cast<void *>(base + offsetof(Instance, fill)));
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          reinterpret_cast<void *>(base + offsetof(Instance, stroke)));
+    for (GLuint attribute = 0; attribute < kAttributeCount; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(last - first));
+    for (GLuint attribute = 0; attribute < kAttributeCount; ++attribute) {
+        glVertexAttribDivisor(attribute, 0);
+        glDisableVertexAttribArray(attribute);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+    drawn_visible_ = true;
+    return true;
+}
+
+void DanmakuLayer::ReleaseGl() {
+    if (program_ != 0) glDeleteProgram(program_);
+    if (buffer_ != 0) glDeleteBuffers(1, &buffer_);
+    if (texture_ != 0) glDeleteTextures(1, &texture_);
+    OnContextLost();
+}
+
+void DanmakuLayer::OnContextLost() {
+    program_ = 0;
+    buffer_ = 0;
+    texture_ = 0;
+    texture_width_ = 0;
+    texture_height_ = 0;
+    texture_layers_ = 0;
+    uniform_viewport_ = -1;
+    uniform_pts_ = -1;
+    uniform_alpha_ = -1;
+    gl_failed_ = false;
+    instances_dirty_ = true;
+    drawn_visible_ = false;
+    for (auto &page : pages_) {
+        page.uploaded = false;
+    }
+}
+
+}  // namespace ass_gpu
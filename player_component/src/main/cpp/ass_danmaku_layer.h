@@ -0,0 +1,136 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ass_gpu {
+
+/**
+ * Danmaku drawn into the subtitle GL context (own surface or the host's
+ * compositor), underneath the subtitles.
+ *
+ * Comment text is rasterized once, by the Kotlin side with the platform text
+ * stack, into atlas pages; every page is one layer of a GL_TEXTURE_2D_ARRAY
+ * and comes with the comments placed on it. The comments of all pages share
+ * one instance buffer sorted by start time, so those on screen at a given pts
+ * are a contiguous range and the layer is a single instanced draw: the vertex
+ * shader derives each quad's position from its start, duration, mode and the
+ * pts uniform. Per frame the CPU only binary-searches that range.
+ *
+ * Atlas texels carry two coverages, R for the glyph fill and G for the
+ * outline, tinted per comment in the fragment shader. Page texels are kept on
+ * the CPU side as well so the atlas can be re-uploaded after the context is
+ * lost.
+ *
+ * Not thread-safe; the GPU bridge calls it under its context mutex. Draw()
+ * and ReleaseGl() need the owning context (GLES 3.0) current.
+ */
+class DanmakuLayer {
+public:
+    // DanmakuFlameMaster / bilibili mode numbers; other modes are not drawn.
+    enum Mode : int {
+        kScrollRightToLeft = 1,
+        kFixedBottom = 4,
+        kFixedTop = 5,
+        kScrollLeftToRight = 6,
+    };
+
+    struct Comment {
+        int64_t start_ms = 0;
+        int32_t duration_ms = 0;
+        int mode = kScrollRightToLeft;
+        float y = 0.0F;  // top edge, pixels
+        float width = 0.0F;
+        float height = 0.0F;
+        int atlas_x = 0;  // texels in the page
+        int atlas_y = 0;
+        int atlas_w = 0;
+        int atlas_h = 0;
+        uint32_t fill_color = 0;  // 0xAARRGGBB
+        uint32_t stroke_color = 0;
+    };
+
+    // Page geometry; a change drops every page.
+    void Configure(int page_width, int page_height, int page_count);
+
+    // Replaces page `page` with `rgba` (page_width x page_height premultiplied
+    // RGBA_8888 rows `stride` bytes apart, fill in R and outline in G) and the
+    // comments placed on it. Comments whose atlas rect is outside the page are
+    // dropped. Returns false when the page index or geometry is invalid.
+    bool SubmitPage(int page, const uint8_t *rgba, size_t stride, std::vector<Comment> comments);
+
+    void Clear();
+
+    bool empty() const { return starts_.empty(); }
+    int page_width() const { return page_width_; }
+    int page_height() const { return page_height_; }
+
+    // Whether the frame at `pts_ms` differs from what the last Draw() left on
+    // screen; false while paused on an unchanged layer or with nothing shown.
+    bool NeedsRedraw(int64_t pts_ms) const;
+
+    // Draws the comments visible at `pts_ms` over a width x height viewport
+    // with premultiplied blending (set up by the caller). Leaves no program,
+    // buffer or texture bound and attribute arrays 0-4 disabled with divisor 0.
+    // Returns false when the shaders cannot be built in this context.
+    bool Draw(int64_t pts_ms, int width, int height, float alpha);
+
+    bool has_gl_objects() const { return program_ != 0 || buffer_ != 0 || texture_ != 0; }
+
+    // Deletes the GL objects; the owning context must be current.
+    void ReleaseGl();
+
+    // Forgets GL object names after their context went away; everything is
+    // re-created and re-uploaded on the next Draw().
+    void OnContextLost();
+
+private:
+    struct Page {
+        std::vector<uint8_t> texels;  // RG8, page_width_ * page_height_ * 2
+        std::vector<Comment> comments;
+        bool uploaded = false;
+    };
+
+    // Per-instance vertex data, see kDanmakuVertexShader for the layout.
+    struct Instance {
+        float timing[4];    // start (relative to time_base_ms_), duration, mode, page
+        float geometry[4];  // y, width, height, unused
+        float atlas[4];     // u0, v0, u1, v1
+        uint8_t fill[4];    // RGBA
+        uint8_t stroke[4];
+    };
+
+    bool EnsureGl();
+    void RebuildInstances();
+    void VisibleRange(int64_t pts_ms, size_t *first, size_t *last) const;
+
+    int page_width_ = 0;
+    int page_height_ = 0;
+    std::vector<Page> pages_;
+
+    std::vector<Instance> instances_;
+    std::vector<int64_t> starts_;
+    int64_t time_base_ms_ = 0;
+    int32_t max_duration_ms_ = 0;
+    bool instances_dirty_ = false;
+
+    bool content_changed_ = false;
+    bool drawn_visible_ = false;
+    int64_t drawn_pts_ms_ = 0;
+
+    bool gl_failed_ = false;
+    GLuint program_ = 0;
+    GLint uniform_viewport_ = -1;
+    GLint uniform_pts_ = -1;
+    GLint uniform_alpha_ = -1;
+    GLuint buffer_ = 0;
+    GLuint texture_ = 0;
+    int texture_width_ = 0;
+    int texture_height_ = 0;
+    int texture_layers_ = 0;
+};
+
+}  // namespace ass_gpu
@@ -0,0 +1,301 @@
+#include "ass_event_bitmap_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ass_gpu {
+namespace {
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+// Longer events (watermarks, episode-long signs) would widen the search window
+// for every lookup, so they are kept aside and tested one by one.
+constexpr long long kLongEventMs = 30 * 1000;
+
+inline uint64_t Mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+inline uint64_t Combine(uint64_t hash, uint64_t value) {
+    return Mix(hash ^ (value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2)));
+}
+
+uint64_t HashString(uint64_t hash, const char *text) {
+    if (text == nullptr) {
+        return hash * kFnvPrime;
+    }
+    for (const unsigned char *p = reinterpret_cast<const unsigned char *>(text); *p != 0; ++p) {
+        hash = (hash ^ *p) * kFnvPrime;
+    }
+    return hash;
+}
+
+uint64_t DoubleBits(double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t HashStyle(const ASS_Style &style) {
+    uint64_t hash = HashString(kFnvOffset, style.FontName);
+    hash = Combine(hash, DoubleBits(style.FontSize));
+    hash = Combine(hash, (static_cast<uint64_t>(style.PrimaryColour) << 32) | style.SecondaryColour);
+    hash = Combine(hash, (static_cast<uint64_t>(style.OutlineColour) << 32) | style.BackColour);
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(style.Bold)) << 32) |
+                             static_cast<uint32_t>(style.Italic));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(style.Underline)) << 32) |
+                             static_cast<uint32_t>(style.StrikeOut));
+    hash = Combine(hash, DoubleBits(style.ScaleX));
+    hash = Combine(hash, DoubleBits(style.ScaleY));
+    hash = Combine(hash, DoubleBits(style.Spacing));
+    hash = Combine(hash, DoubleBits(style.Angle));
+    hash = Combine(hash, static_cast<uint64_t>(style.BorderStyle));
+    hash = Combine(hash, DoubleBits(style.Outline));
+    hash = Combine(hash, DoubleBits(style.Shadow));
+    hash = Combine(hash, DoubleBits(style.Blur));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(style.Alignment)) << 32) |
+                             static_cast<uint32_t>(style.Justify));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(style.MarginL)) << 32) |
+                             static_cast<uint32_t>(style.MarginR));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(style.MarginV)) << 32) |
+                             static_cast<uint32_t>(style.Encoding));
+    return hash;
+}
+
+// Override tags that make an event look different from one frame to the next.
+bool IsStaticEvent(const ASS_Event &event) {
+    if (event.Effect != nullptr && event.Effect[0] != '\0') {
+        return false;
+    }
+    if (event.Text == nullptr) {
+        return true;
+    }
+    bool in_override = false;
+    for (const char *p = event.Text; *p != '\0'; ++p) {
+        if (*p == '{') {
+            in_override = true;
+        } else if (*p == '}') {
+            in_override = false;
+        } else if (in_override && *p == '\\') {
+            const char *tag = p + 1;
+            while (*tag == ' ' || *tag == '\t') ++tag;
+            if (*tag == 'k' || *tag == 'K' || std::strncmp(tag, "move", 4) == 0 ||
+                std::strncmp(tag, "fad", 3) == 0) {
+                return false;
+            }
+            if (*tag == 't') {
+                const char *args = tag + 1;
+                while (*args == ' ' || *args == '\t') ++args;
+                if (*args == '(') {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t HashEvent(const ASS_Track *track, const ASS_Event &event) {
+    uint64_t hash = HashString(kFnvOffset, event.Text);
+    hash = Combine(hash, static_cast<uint64_t>(event.Start));
+    hash = Combine(hash, static_cast<uint64_t>(event.Duration));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(event.ReadOrder)) << 32) |
+                             static_cast<uint32_t>(event.Layer));
+    hash = Combine(hash, (static_cast<uint64_t>(static_cast<uint32_t>(event.MarginL)) << 32) |
+                             static_cast<uint32_t>(event.MarginR));
+    hash = Combine(hash, static_cast<uint64_t>(static_cast<uint32_t>(event.MarginV)));
+    if (event.Style >= 0 && event.Style < track->n_styles) {
+        hash = Combine(hash, HashStyle(track->styles[event.Style]));
+    }
+    return hash;
+}
+}  // namespace
+
+void EventBitmapCache::SetBudget(size_t bytes) {
+    budget_ = bytes;
+    EvictUntil(budget_);
+    pending_valid_ = false;
+}
+
+void EventBitmapCache::UpdateEventIndex(const ASS_Track *track) {
+    if (track != indexed_track_ || track->n_events < indexed_events_) {
+        InvalidateEvents();
+        indexed_track_ = track;
+    }
+    if (track->n_events == indexed_events_) {
+        return;
+    }
+    const size_t sorted = events_by_start_.size();
+    for (int i = indexed_events_; i < track->n_events; ++i) {
+        const ASS_Event &event = track->events[i];
+        if (event.Duration > kLongEventMs) {
+            long_events_.push_back(i);
+        } else {
+            events_by_start_.push_back(i);
+            max_short_duration_ = std::max(max_short_duration_, event.Duration);
+        }
+    }
+    // Appended events are mostly in order already; sort the tail and merge it in.
+    const auto by_start = [track](int a, int b) { return track->events[a].Start < track->events[b].Start; };
+    const auto middle = events_by_start_.begin() + static_cast<std::ptrdiff_t>(sorted);
+    std::sort(middle, events_by_start_.end(), by_start);
+    std::inplace_merge(events_by_start_.begin(), middle, events_by_start_.end(), by_start);
+    indexed_events_ = track->n_events;
+}
+
+bool EventBitmapCache::BuildPendingKey(const ASS_Track *track, long long now_ms, int width, int height) {
+    UpdateEventIndex(track);
+    pending_events_.clear();
+    // Same visibility test as ass_render_frame().
+    const auto add_if_visible = [&](int id) {
+        const ASS_Event &event = track->events[id];
+        if (event.Start > now_ms || now_ms >= event.Start + event.Duration) {
+            return true;
+        }
+        if (!IsStaticEvent(event)) {
+            return false;
+        }
+        pending_events_.push_back(HashEvent(track, event));
+        return true;
+    };
+    // A short event visible at now_ms started within max_short_duration_ before it.
+    const auto first = std::partition_point(events_by_start_.begin(), events_by_start_.end(), [&](int id) {
+        return track->events[id].Start <= now_ms - max_short_duration_;
+    });
+    const auto last = std::partition_point(first, events_by_start_.end(),
+                                           [&](int id) { return track->events[id].Start <= now_ms; });
+    for (auto it = first; it != last; ++it) {
+        if (!add_if_visible(*it)) {
+            return false;
+        }
+    }
+    for (const int id : long_events_) {
+        if (!add_if_visible(id)) {
+            return false;
+        }
+    }
+    if (pending_events_.empty()) {
+        return false;
+    }
+    std::sort(pending_events_.begin(), pending_events_.end());
+    uint64_t hash = Combine(Mix(reinterpret_cast<uintptr_t>(track)),
+                            (static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32) |
+                                static_cast<uint32_t>(height));
+    for (const uint64_t event_hash : pending_events_) {
+        hash = Combine(hash, event_hash);
+    }
+    pending_hash_ = hash;
+    pending_width_ = width;
+    pending_height_ = height;
+    return true;
+}
+
+const EventBitmapCache::Entry *EventBitmapCache::Find(const ASS_Track *track, long long now_ms, int width,
+                                                      int height) {
+    pending_valid_ = false;
+    if (budget_ == 0 || track == nullptr || !BuildPendingKey(track, now_ms, width, height)) {
+        return nullptr;
+    }
+    ++lookups_;
+    const auto found = index_.find(pending_hash_);
+    if (found != index_.end()) {
+        const Entry &entry = *found->second;
+        if (entry.width == width && entry.height == height && entry.events == pending_events_) {
+            entries_.splice(entries_.begin(), entries_, found->second);
+            ++hits_;
+            return &entries_.front();
+        }
+    }
+    pending_valid_ = true;
+    return nullptr;
+}
+
+void EventBitmapCache::StorePending(const ASS_Image *images) {
+    if (!pending_valid_) {
+        return;
+    }
+    pending_valid_ = false;
+
+    Entry entry;
+    entry.hash = pending_hash_;
+    entry.width = pending_width_;
+    entry.height = pending_height_;
+    entry.events = pending_events_;
+    size_t coverage_bytes = 0;
+    size_t image_count = 0;
+    for (const ASS_Image *cur = images; cur != nullptr; cur = cur->next) {
+        if (cur->w <= 0 || cur->h <= 0 || cur->bitmap == nullptr) continue;
+        coverage_bytes += static_cast<size_t>(cur->w) * static_cast<size_t>(cur->h);
+        ++image_count;
+    }
+    entry.bytes = sizeof(Entry) + coverage_bytes + image_count * sizeof(Image) +
+                  entry.events.size() * sizeof(uint64_t);
+    // A single full-screen sign must not flush everything else out.
+    if (entry.bytes > budget_ / 2) {
+        return;
+    }
+
+    entry.images.reserve(image_count);
+    entry.coverage.resize(coverage_bytes);
+    size_t offset = 0;
+    for (const ASS_Image *cur = images; cur != nullptr; cur = cur->next) {
+        if (cur->w <= 0 || cur->h <= 0 || cur->bitmap == nullptr) continue;
+        Image image;
+        image.dst_x = cur->dst_x;
+        image.dst_y = cur->dst_y;
+        image.w = cur->w;
+        image.h = cur->h;
+        image.color = cur->color;
+        image.offset = offset;
+        for (int y = 0; y < cur->h; ++y) {
+            std::memcpy(entry.coverage.data() + offset, cur->bitmap + static_cast<size_t>(y) * cur->stride,
+                        static_cast<size_t>(cur->w));
+            offset += static_cast<size_t>(cur->w);
+        }
+        entry.images.push_back(image);
+    }
+
+    const auto existing = index_.find(entry.hash);
+    if (existing != index_.end()) {
+        bytes_ -= existing->second->bytes;
+        entries_.erase(existing->second);
+        index_.erase(existing);
+    }
+    EvictUntil(budget_ - entry.bytes);
+    bytes_ += entry.bytes;
+    entries_.push_front(std::move(entry));
+    index_[entries_.front().hash] = entries_.begin();
+}
+
+void EventBitmapCache::EvictUntil(size_t budget) {
+    while (bytes_ > budget && !entries_.empty()) {
+        const Entry &victim = entries_.back();
+        bytes_ -= victim.bytes;
+        index_.erase(victim.hash);
+        entries_.pop_back();
+    }
+}
+
+void EventBitmapCache::Clear() {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+    hits_ = 0;
+    lookups_ = 0;
+    pending_valid_ = false;
+    InvalidateEvents();
+}
+
+void EventBitmapCache::InvalidateEvents() {
+    indexed_track_ = nullptr;
+    indexed_events_ = 0;
+    events_by_start_.clear();
+    long_events_.clear();
+    max_short_duration_ = 0;
+}
+
+}  // namespace ass_gpu
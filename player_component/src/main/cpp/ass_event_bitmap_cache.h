@@ -0,0 +1,100 @@
+#pragma once
+
+#include <ass/ass.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace ass_gpu {
+
+/**
+ * Memory-bounded LRU of coverage bitmaps produced by ass_render_frame(), so
+ * seeking back into a recently shown scene is drawn without rendering glyph
+ * outlines again.
+ *
+ * libass only hands out images composited per frame (collision handling moves
+ * events depending on their neighbours), so an entry covers the group of
+ * events visible together. Each event contributes its identity (ReadOrder,
+ * timing, layer, margins, text) and a hash of its style; the frame size
+ * completes the key. Frames showing an event whose appearance changes over its
+ * lifetime (\t, \move, \fad, karaoke, Effect scrolling) are never cached.
+ *
+ * Visible events are found through an index sorted by start time, extended
+ * incrementally as streaming or embedded loading appends events, so a lookup
+ * costs a binary search plus the events around `now_ms`.
+ *
+ * Not thread-safe; the GPU bridge calls it under its context mutex.
+ */
+class EventBitmapCache {
+public:
+    struct Image {
+        int dst_x = 0;
+        int dst_y = 0;
+        int w = 0;
+        int h = 0;
+        uint32_t color = 0;
+        size_t offset = 0;  // into Entry::coverage, rows packed with stride == w
+    };
+
+    struct Entry {
+        uint64_t hash = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint64_t> events;
+        std::vector<Image> images;
+        std::vector<uint8_t> coverage;
+        size_t bytes = 0;
+    };
+
+    void SetBudget(size_t bytes);
+    size_t budget() const { return budget_; }
+
+    // Returns the entry for the events visible at `now_ms`, or nullptr. The
+    // key is remembered so a miss can be filled by StorePending().
+    const Entry *Find(const ASS_Track *track, long long now_ms, int width, int height);
+
+    // Copies `images` (as returned for the last Find() miss) into the cache.
+    void StorePending(const ASS_Image *images);
+
+    // Drops all entries and resets the hit/lookup counters.
+    void Clear();
+
+    // Rebuilds the event index on the next Find(); needed when events are
+    // replaced in place (ass_flush_events followed by new chunks).
+    void InvalidateEvents();
+
+    uint64_t hits() const { return hits_; }
+    uint64_t lookups() const { return lookups_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    using LruList = std::list<Entry>;
+
+    void UpdateEventIndex(const ASS_Track *track);
+    bool BuildPendingKey(const ASS_Track *track, long long now_ms, int width, int height);
+    void EvictUntil(size_t budget);
+
+    size_t budget_ = 0;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t lookups_ = 0;
+    LruList entries_;
+    std::unordered_map<uint64_t, LruList::iterator> index_;
+
+    const ASS_Track *indexed_track_ = nullptr;
+    int indexed_events_ = 0;
+    std::vector<int> events_by_start_;  // event ids with Duration <= kLongEventMs, by Start
+    std::vector<int> long_events_;      // checked on every lookup
+    long long max_short_duration_ = 0;
+
+    bool pending_valid_ = false;
+    uint64_t pending_hash_ = 0;
+    int pending_width_ = 0;
+    int pending_height_ = 0;
+    std::vector<uint64_t> pending_events_;
+};
+
+}  // namespace ass_gpu
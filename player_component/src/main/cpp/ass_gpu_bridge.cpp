@@ -1,5 +1,6 @@
 #include <jni.h>
 
+#include <android/bitmap.h>
 #include <android/log.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
@@ -7,21 +8,38 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES3/gl3.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <cstdarg>
+#include <memory>
 #include <mutex>
 #include <new>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "ass_danmaku_layer.h"
+#include "ass_event_bitmap_cache.h"
+#include "ass_gpu_compositor.h"
+#include "ass_opencc.h"
+#include "ass_program_cache.h"
+#include "ass_stream_loader.h"
+#include "ass_track_cache.h"
+
 #ifndef EGL_RECORDABLE_ANDROID
 #define EGL_RECORDABLE_ANDROID 0x3142
 #endif
 
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
 namespace {
 constexpr const char *kGpuLogTag = "AssGpuBridge";
 constexpr const char *kVertexShaderSrc = R"(#version 300 es
@@ -47,14 +65,52 @@ void main() {
 }
 )";
 constexpr long long kDefaultEmbeddedChunkDurationMs = 5000;
+// 超过该大小的外挂字幕走流式加载，避免 ass_read_file 一次性解析阻塞渲染线程。
+constexpr off_t kStreamingLoadThresholdBytes = 512 * 1024;
+// libass MSGL_DBG2 会为每一行事件打印日志，流式加载时会刷屏。
+constexpr int kMaxForwardedLibassLevel = 6;
+// metrics 数组：渲染/上传/合成耗时（毫秒），静态事件位图缓存累计命中数与查询数、当前占用字节，
+// libass 位图缓存上限字节（libass 未提供实际占用的查询接口），以及当前渲染分辨率档位。
+constexpr jsize kRenderMetricCount = 8;
+// nativeDanmakuSubmitPage 每条弹幕的 int / float 个数，与 AssGpuNativeBridge 保持一致。
+constexpr jint kDanmakuAttributeStride = 8;
+constexpr jint kDanmakuGeometryStride = 3;
+
+struct RendererProfile {
+    int glyph_cache_max;
+    int bitmap_cache_max_mb;
+    ASS_ShapingLevel shaping;
+    ASS_Hinting hinting;
+};
+// 下标与 Kotlin 侧 AssRendererProfile.nativeValue 对应。
+constexpr RendererProfile kRendererProfiles[] = {
+    // LOW_MEMORY：1GB 内存设备；简单整形跳过 HarfBuzz（对中日文字幕无影响），
+    // light hinting 让低分辨率输出下的小字号更清晰。
+    {2000, 16, ASS_SHAPING_SIMPLE, ASS_HINTING_LIGHT},
+    // BALANCED：接近 libass 默认，缓存减半。
+    {5000, 64, ASS_SHAPING_COMPLEX, ASS_HINTING_NONE},
+    // QUALITY：4K 输出下特效字幕位图体积大，放宽缓存上限。
+    {10000, 192, ASS_SHAPING_COMPLEX, ASS_HINTING_NONE},
+};
+constexpr int kDefaultRendererProfile = 1;
+// 负载降级的渲染分辨率阶梯，下标与 Kotlin 侧 SubtitleRenderQuality.nativeValue 对应：
+// libass 按缩小后的帧尺寸栅格化（storage size 保持输出尺寸，模糊与边框按比例缩小），
+// 绘制时由纹理线性过滤放大回输出尺寸。
+constexpr float kRenderQualityScales[] = {1.0F, 2.0F / 3.0F, 0.5F};
+constexpr int kRenderQualityCount =
+    static_cast<int>(sizeof(kRenderQualityScales) / sizeof(kRenderQualityScales[0]));
 
 struct GpuContext {
     std::mutex mutex;
     ANativeWindow *window = nullptr;
     int width = 0;
     int height = 0;
+    // 交给 libass 的帧尺寸，即 ASS_Image 坐标所在的空间；按 render_quality 缩小。
     int last_frame_width = 0;
     int last_frame_height = 0;
+    int last_storage_width = 0;
+    int last_storage_height = 0;
+    int render_quality = 0;
     float scale = 1.0F;
     int rotation = 0;
     std::string color_format;
@@ -66,13 +122,28 @@ struct GpuContext {
     EGLContext egl_context = EGL_NO_CONTEXT;
     EGLSurface egl_surface = EGL_NO_SURFACE;
     EGLConfig egl_config = nullptr;
+    EGLint egl_native_visual = 0;
+    // 窗口分离期间让上下文保持 current 的 1x1 pbuffer；支持 EGL_KHR_surfaceless_context 时不需要。
+    EGLSurface idle_surface = EGL_NO_SURFACE;
+    bool surfaceless = false;
     GLuint program = 0;
+    // glGetProgramBinary 缓存文件，空表示不缓存；program_stored 表示当前 program 已与该文件同步过。
+    std::string program_cache_path;
+    bool program_stored = false;
     GLuint vertex_buffer = 0;
     GLint uniform_color = -1;
     GLint uniform_sampler = -1;
     ASS_Library *library = nullptr;
     ASS_Renderer *renderer = nullptr;
     ASS_Track *track = nullptr;
+    std::unique_ptr<ass_gpu::AssStreamLoader> stream_loader;
+    long long last_subtitle_pts_ms = 0;
+    ass_gpu::TrackCacheConfig track_cache;
+    std::shared_ptr<ass_gpu::OpenCCConverter> text_converter;
+    int renderer_profile = kDefaultRendererProfile;
+    ass_gpu::EventBitmapCache bitmap_cache;
+    // 屏幕上当前内容来自位图缓存时记录条目哈希，0 表示来自 ass_render_frame。
+    uint64_t presented_cache_hash = 0;
     float user_alpha = 1.0F;
     bool pending_invalidate = false;
     struct TextureEntry {
@@ -84,6 +155,20 @@ struct GpuContext {
     std::vector<TextureEntry> texture_pool;
     size_t texture_pool_pos = 0;
     std::vector<uint8_t> upload_buffer;
+    // 合成模式（AssGpuCompositeFrame）：program/texture_pool 等 GL 对象属于宿主的 EGL 上下文，
+    // 宿主每帧都会重画视频，字幕未变化时直接用 composite_quads 重放上一帧的纹理。
+    uint64_t composite_host_generation = 0;
+    struct CompositeQuad {
+        GLuint texture = 0;
+        int dst_x = 0;
+        int dst_y = 0;
+        int w = 0;
+        int h = 0;
+        uint32_t color = 0;
+    };
+    std::vector<CompositeQuad> composite_quads;
+    // 弹幕层，与字幕共用上下文，画在字幕下方。
+    ass_gpu::DanmakuLayer danmaku;
 };
 
 struct ScoredConfig {
@@ -265,12 +350,19 @@ void ReleaseWindow(GpuContext *context) {
     context->window = nullptr;
 }
 
-void DestroyAss(GpuContext *context) {
-    if (context == nullptr) return;
+void FreeTrack(GpuContext *context) {
     if (context->track != nullptr) {
         ass_free_track(context->track);
         context->track = nullptr;
     }
+    // 缓存键包含轨道指针，轨道释放后必须清空，避免新轨道复用同一地址时误命中。
+    context->bitmap_cache.Clear();
+    context->presented_cache_hash = 0;
+}
+
+void DestroyAss(GpuContext *context) {
+    if (context == nullptr) return;
+    FreeTrack(context);
     if (context->renderer != nullptr) {
         ass_renderer_done(context->renderer);
         context->renderer = nullptr;
@@ -281,10 +373,21 @@ void DestroyAss(GpuContext *context) {
     }
 }
 
+void ApplyRendererProfile(GpuContext *context) {
+    if (context->renderer == nullptr) return;
+    const RendererProfile &profile = kRendererProfiles[context->renderer_profile];
+    ass_set_cache_limits(context->renderer, profile.glyph_cache_max, profile.bitmap_cache_max_mb);
+    ass_set_shaper(context->renderer, profile.shaping);
+    ass_set_hinting(context->renderer, profile.hinting);
+}
+
 void EnsureAss(GpuContext *context) {
     if (context->library == nullptr) {
         context->library = ass_library_init();
         ass_set_message_cb(context->library, [](int level, const char *fmt, va_list args, void *) {
+            if (level > kMaxForwardedLibassLevel) {
+                return;
+            }
             char buffer[1024];
             if (fmt != nullptr) {
                 vsnprintf(buffer, sizeof(buffer), fmt, args);
@@ -306,9 +409,68 @@ void EnsureAss(GpuContext *context) {
     }
     if (context->renderer == nullptr) {
         context->renderer = ass_renderer_init(context->library);
+        ApplyRendererProfile(context);
     }
 }
 
+// 必须在未持有 context->mutex 时调用：加载线程每次追加事件都会获取该锁。
+void StopStreamingLoad(GpuContext *context) {
+    std::unique_ptr<ass_gpu::AssStreamLoader> loader;
+    {
+        std::lock_guard<std::mutex> guard(context->mutex);
+        loader = std::move(context->stream_loader);
+    }
+    if (loader != nullptr) {
+        loader->Cancel();
+    }
+}
+
+void StoreTrackCacheAsync(const ass_gpu::TrackCacheConfig &config, const std::string &key, std::string blob) {
+    if (blob.empty()) {
+        return;
+    }
+    std::thread([config, key, blob = std::move(blob)]() {
+        ass_gpu::StoreCachedTrack(config, key, blob);
+    }).detach();
+}
+
+bool LoadTrackStreaming(GpuContext *context, const std::string &track_path, long long position_hint_ms,
+                        const std::string &cache_key) {
+    auto loader = ass_gpu::AssStreamLoader::Open(context->library, track_path);
+    if (loader == nullptr) {
+        return false;
+    }
+    context->track = loader->track();
+    context->last_subtitle_pts_ms = position_hint_ms;
+    ass_gpu::AssStreamLoader::CompleteCallback on_complete;
+    if (!cache_key.empty()) {
+        // 加载线程结束前 StopStreamingLoad 会等待其退出，track 与 loader 在此期间保持有效。
+        on_complete = [mutex = &context->mutex, track = loader->track(), loader_ptr = loader.get(),
+                       config = context->track_cache, cache_key]() {
+            std::string blob;
+            {
+                std::lock_guard<std::mutex> guard(*mutex);
+                blob = ass_gpu::SerializeTrack(track, loader_ptr->header(), cache_key);
+            }
+            ass_gpu::StoreCachedTrack(config, cache_key, blob);
+        };
+    }
+    loader->Start(&context->mutex, position_hint_ms, [context, converter = context->text_converter](
+                      int first_event, int end_event, long long first_start_ms, long long last_end_ms) {
+        // 回调在持有 context->mutex 时执行；仅当新事件覆盖当前画面时间才强制重绘。
+        if (converter != nullptr) {
+            converter->ConvertTrackEvents(context->track, first_event, end_event);
+        }
+        if (first_start_ms <= context->last_subtitle_pts_ms && last_end_ms >= context->last_subtitle_pts_ms) {
+            context->pending_invalidate = true;
+        }
+    }, std::move(on_complete));
+    __android_log_print(ANDROID_LOG_INFO, kGpuLogTag, "Streaming subtitle track (%zu bytes)",
+                        loader->file_size());
+    context->stream_loader = std::move(loader);
+    return true;
+}
+
 void ConfigureFonts(GpuContext *context, const std::string &default_font,
                     const std::vector<std::string> &font_dirs) {
     if (context == nullptr || context->library == nullptr || context->renderer == nullptr) {
@@ -355,18 +517,20 @@ GLuint CompileShader(GLenum type, const char *source) {
     return shader;
 }
 
-bool EnsureProgram(GpuContext *context) {
-    if (context->program != 0) return true;
+GLuint LinkProgram(bool retrievable) {
     GLuint vertex = CompileShader(GL_VERTEX_SHADER, kVertexShaderSrc);
     GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, kFragmentShaderSrc);
     if (vertex == 0 || fragment == 0) {
         if (vertex != 0) glDeleteShader(vertex);
         if (fragment != 0) glDeleteShader(fragment);
-        return false;
+        return 0;
     }
     GLuint program = glCreateProgram();
     glAttachShader(program, vertex);
     glAttachShader(program, fragment);
+    if (retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(program);
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -379,6 +543,53 @@ bool EnsureProgram(GpuContext *context) {
         glGetProgramInfoLog(program, length, nullptr, log.data());
         LogError(("Program link failed: " + log).c_str());
         glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// 冷启动优先读取缓存的程序二进制，跳过着色器编译；失败时从源码链接并写回缓存。
+GLuint LoadOrLinkProgram(GpuContext *context) {
+    const bool cacheable = context->gles_version >= 3 && !context->program_cache_path.empty();
+    if (!cacheable) {
+        return LinkProgram(false);
+    }
+    const auto started = std::chrono::steady_clock::now();
+    const uint64_t key = ass_gpu::ProgramCacheKey(kVertexShaderSrc, kFragmentShaderSrc);
+    GLuint program = glCreateProgram();
+    if (ass_gpu::LoadProgramBinary(context->program_cache_path, key, program)) {
+        context->program_stored = true;
+        __android_log_print(ANDROID_LOG_INFO, kGpuLogTag, "Loaded cached GL program in %lld us",
+                            static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - started).count()));
+        return program;
+    }
+    glDeleteProgram(program);
+    program = LinkProgram(true);
+    if (program != 0) {
+        const bool stored = ass_gpu::StoreProgramBinary(context->program_cache_path, key, program);
+        context->program_stored = true;
+        __android_log_print(ANDROID_LOG_INFO, kGpuLogTag, "Compiled GL program in %lld us (cached=%d)",
+                            static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - started).count()),
+                            stored ? 1 : 0);
+    }
+    return program;
+}
+
+bool EnsureProgram(GpuContext *context) {
+    if (context->program != 0) {
+        // 缓存路径在程序链接之后才配置时补写一次；失败也不再重试，避免每帧读回二进制。
+        if (!context->program_stored && context->gles_version >= 3 && !context->program_cache_path.empty()) {
+            ass_gpu::StoreProgramBinary(context->program_cache_path,
+                                        ass_gpu::ProgramCacheKey(kVertexShaderSrc, kFragmentShaderSrc),
+                                        context->program);
+            context->program_stored = true;
+        }
+        return true;
+    }
+    GLuint program = LoadOrLinkProgram(context);
+    if (program == 0) {
         return false;
     }
     context->program = program;
@@ -396,25 +607,75 @@ bool EnsureProgram(GpuContext *context) {
     return true;
 }
 
-void DestroyEgl(GpuContext *context, bool destroy_context = true) {
-    if (context == nullptr) return;
-    if (context->egl_display != EGL_NO_DISPLAY && context->egl_surface != EGL_NO_SURFACE) {
-        eglDestroySurface(context->egl_display, context->egl_surface);
-        context->egl_surface = EGL_NO_SURFACE;
+bool HasEglExtension(EGLDisplay display, const char *name) {
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions == nullptr) return false;
+    const size_t length = std::strlen(name);
+    for (const char *p = std::strstr(extensions, name); p != nullptr; p = std::strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
     }
-    if (destroy_context && context->egl_display != EGL_NO_DISPLAY &&
-        context->egl_context != EGL_NO_CONTEXT) {
+    return false;
+}
+
+// 没有窗口 surface 时让上下文保持 current（无 surface 或 1x1 pbuffer），删除/保留 GL 对象都依赖它。
+bool MakeIdleCurrent(GpuContext *context) {
+    if (context->egl_display == EGL_NO_DISPLAY || context->egl_context == EGL_NO_CONTEXT) {
+        return false;
+    }
+    if (!context->surfaceless && context->idle_surface == EGL_NO_SURFACE) {
+        const EGLint attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        context->idle_surface = eglCreatePbufferSurface(context->egl_display, context->egl_config, attribs);
+        if (context->idle_surface == EGL_NO_SURFACE) {
+            LogError(FormatEglError("Failed to create idle pbuffer").c_str());
+            return false;
+        }
+    }
+    const EGLSurface idle = context->surfaceless ? EGL_NO_SURFACE : context->idle_surface;
+    if (eglGetCurrentContext() == context->egl_context && eglGetCurrentSurface(EGL_DRAW) == idle) {
+        return true;
+    }
+    if (!eglMakeCurrent(context->egl_display, idle, idle, context->egl_context)) {
+        LogError(FormatEglError("eglMakeCurrent (idle) failed").c_str());
+        return false;
+    }
+    return true;
+}
+
+// 只销毁窗口 surface；display、上下文以及 program、顶点缓冲、纹理池等 GL 对象留给下一次 attach。
+void DetachEglSurface(GpuContext *context) {
+    if (context == nullptr || context->egl_display == EGL_NO_DISPLAY || context->egl_surface == EGL_NO_SURFACE) {
+        return;
+    }
+    if (!MakeIdleCurrent(context)) {
+        // 仍然 current 的窗口 surface 会推迟到解绑时才真正销毁，拿不到 idle surface 就先解绑上下文。
+        eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    eglDestroySurface(context->egl_display, context->egl_surface);
+    context->egl_surface = EGL_NO_SURFACE;
+}
+
+// terminate_display 为 false 时保留 display 的初始化：合成模式下宿主与我们共用默认 display。
+// 返回 false 表示 GL 对象还在却无法在当前线程 make current，只能随上下文一起延迟回收。
+bool DestroyEgl(GpuContext *context, bool terminate_display = true) {
+    if (context == nullptr) return true;
+    bool gl_released = true;
+    if (context->egl_display != EGL_NO_DISPLAY && context->egl_context != EGL_NO_CONTEXT) {
         if (context->program != 0 || context->vertex_buffer != 0 ||
-            !context->texture_pool.empty()) {
-            eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
-                           context->egl_context);
-            if (context->program != 0) {
-                glDeleteProgram(context->program);
-            }
-            if (context->vertex_buffer != 0) {
-                glDeleteBuffers(1, &context->vertex_buffer);
-            }
-            if (!context->texture_pool.empty()) {
+            !context->texture_pool.empty() || context->danmaku.has_gl_objects()) {
+            const bool current =
+                context->egl_surface != EGL_NO_SURFACE
+                    ? eglMakeCurrent(context->egl_display, context->egl_surface, context->egl_surface,
+                                     context->egl_context) == EGL_TRUE
+                    : MakeIdleCurrent(context);
+            if (current) {
+                if (context->program != 0) {
+                    glDeleteProgram(context->program);
+                }
+                if (context->vertex_buffer != 0) {
+                    glDeleteBuffers(1, &context->vertex_buffer);
+                }
                 std::vector<GLuint> ids;
                 ids.reserve(context->texture_pool.size());
                 for (const auto &entry : context->texture_pool) {
@@ -423,22 +684,78 @@ void DestroyEgl(GpuContext *context, bool destroy_context = true) {
                 if (!ids.empty()) {
                     glDeleteTextures(static_cast<GLsizei>(ids.size()), ids.data());
                 }
-                context->texture_pool.clear();
-                context->texture_pool_pos = 0;
+                context->danmaku.ReleaseGl();
+            } else {
+                gl_released = false;
             }
+            context->texture_pool.clear();
+            context->texture_pool_pos = 0;
         }
+        eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         eglDestroyContext(context->egl_display, context->egl_context);
         context->egl_context = EGL_NO_CONTEXT;
         context->program = 0;
         context->vertex_buffer = 0;
+        context->danmaku.OnContextLost();
     }
-    if (destroy_context && context->egl_display != EGL_NO_DISPLAY) {
-        eglTerminate(context->egl_display);
+    if (context->egl_display != EGL_NO_DISPLAY) {
+        if (context->egl_surface != EGL_NO_SURFACE) {
+            eglDestroySurface(context->egl_display, context->egl_surface);
+        }
+        if (context->idle_surface != EGL_NO_SURFACE) {
+            eglDestroySurface(context->egl_display, context->idle_surface);
+        }
+        if (terminate_display) {
+            eglTerminate(context->egl_display);
+        }
         context->egl_display = EGL_NO_DISPLAY;
     }
+    context->egl_surface = EGL_NO_SURFACE;
+    context->idle_surface = EGL_NO_SURFACE;
+    context->surfaceless = false;
     context->uniform_color = -1;
     context->uniform_sampler = -1;
     context->egl_config = nullptr;
+    context->egl_native_visual = 0;
+    return gl_released;
+}
+
+// detach 后保留的 EGL 上下文在合成模式下用不上，其 program/纹理句柄还会和宿主上下文里的混淆。
+// 在宿主的渲染线程上释放，完成后恢复宿主当前绑定的上下文与 surface。
+void ReleaseKeptEglForComposite(GpuContext *context) {
+    const EGLDisplay host_display = eglGetCurrentDisplay();
+    const EGLContext host_context = eglGetCurrentContext();
+    const EGLSurface host_draw = eglGetCurrentSurface(EGL_DRAW);
+    const EGLSurface host_read = eglGetCurrentSurface(EGL_READ);
+    const bool gl_released = DestroyEgl(context, false);
+    // 下面按“宿主换了上下文”处理，丢弃合成模式残留的句柄。
+    context->composite_host_generation = 0;
+    if (host_display != EGL_NO_DISPLAY && host_context != EGL_NO_CONTEXT &&
+        eglMakeCurrent(host_display, host_draw, host_read, host_context) != EGL_TRUE) {
+        LogError(FormatEglError("eglMakeCurrent (host) failed").c_str());
+        return;
+    }
+    if (!gl_released) {
+        LogError("Kept EGL context still current on another thread, its GL objects were not deleted");
+        return;
+    }
+    LogInfo("Kept EGL context released for composite mode");
+}
+
+EGLSurface CreateWindowSurface(GpuContext *context, EGLConfig config, EGLint native_visual) {
+    if (native_visual != 0) {
+        const int result = ANativeWindow_setBuffersGeometry(context->window, 0, 0, native_visual);
+        if (result != 0) {
+            __android_log_print(ANDROID_LOG_WARN, kGpuLogTag,
+                                "setBuffersGeometry failed: %d (format=0x%x)",
+                                result, native_visual);
+        }
+    }
+    EGLSurface egl_surface = eglCreateWindowSurface(context->egl_display, config, context->window, nullptr);
+    if (egl_surface == EGL_NO_SURFACE) {
+        LogError(FormatEglError("Failed to create EGL surface").c_str());
+    }
+    return egl_surface;
 }
 
 bool InitEglAndSurface(GpuContext *context) {
@@ -480,28 +797,18 @@ bool InitEglAndSurface(GpuContext *context) {
             continue;
         }
 
-        if (candidate.native_visual != 0) {
-            const int result =
-                ANativeWindow_setBuffersGeometry(context->window, 0, 0, candidate.native_visual);
-            if (result != 0) {
-                __android_log_print(ANDROID_LOG_WARN, kGpuLogTag,
-                                    "setBuffersGeometry failed: %d (format=0x%x)",
-                                    result, candidate.native_visual);
-            }
-        }
-
-        EGLSurface egl_surface = eglCreateWindowSurface(context->egl_display, candidate.config,
-                                                        context->window, nullptr);
+        EGLSurface egl_surface = CreateWindowSurface(context, candidate.config, candidate.native_visual);
         if (egl_surface == EGL_NO_SURFACE) {
-            LogError(FormatEglError("Failed to create EGL surface").c_str());
             eglDestroyContext(context->egl_display, egl_context);
             continue;
         }
 
         context->egl_config = candidate.config;
+        context->egl_native_visual = candidate.native_visual;
         context->gles_version = candidate.gles_version;
         context->egl_context = egl_context;
         context->egl_surface = egl_surface;
+        context->surfaceless = HasEglExtension(context->egl_display, "EGL_KHR_surfaceless_context");
         return true;
     }
 
@@ -531,13 +838,19 @@ bool EnsureSurface(GpuContext *context) {
     if (context->window == nullptr) {
         return false;
     }
-    if (context->egl_display == EGL_NO_DISPLAY || context->egl_context == EGL_NO_CONTEXT ||
-        context->egl_config == nullptr || context->egl_surface == EGL_NO_SURFACE) {
+    const bool has_context = context->egl_display != EGL_NO_DISPLAY &&
+                             context->egl_context != EGL_NO_CONTEXT && context->egl_config != nullptr;
+    if (has_context && context->egl_surface == EGL_NO_SURFACE) {
+        // 分离期间保留下来的上下文直接用于新窗口，只重建 EGLSurface。
+        context->egl_surface = CreateWindowSurface(context, context->egl_config, context->egl_native_visual);
+    }
+    if (!has_context || context->egl_surface == EGL_NO_SURFACE) {
         if (!InitEglAndSurface(context)) {
             return false;
         }
     }
     if (!MakeCurrent(context)) {
+        // 上下文丢失（EGL_CONTEXT_LOST 等）时整体重建。
         DestroyEgl(context);
         if (!InitEglAndSurface(context) || !MakeCurrent(context)) {
             return false;
@@ -547,25 +860,41 @@ bool EnsureSurface(GpuContext *context) {
     return EnsureProgram(context);
 }
 
-void WriteRenderMetrics(JNIEnv *env, jlongArray metrics_out, jlong render_ms, jlong upload_ms,
-                        jlong composite_ms) {
+void WriteRenderMetrics(JNIEnv *env, jlongArray metrics_out, const GpuContext *context, jlong render_ms,
+                        jlong upload_ms, jlong composite_ms) {
     if (metrics_out == nullptr) {
         return;
     }
-    jlong values[3] = {render_ms, upload_ms, composite_ms};
-    env->SetLongArrayRegion(metrics_out, 0, 3, values);
+    jlong values[kRenderMetricCount] = {
+        render_ms,
+        upload_ms,
+        composite_ms,
+        static_cast<jlong>(context->bitmap_cache.hits()),
+        static_cast<jlong>(context->bitmap_cache.lookups()),
+        static_cast<jlong>(context->bitmap_cache.bytes()),
+        static_cast<jlong>(kRendererProfiles[context->renderer_profile].bitmap_cache_max_mb) * 1024 * 1024,
+        static_cast<jlong>(context->render_quality),
+    };
+    const jsize count = std::min(kRenderMetricCount, env->GetArrayLength(metrics_out));
+    env->SetLongArrayRegion(metrics_out, 0, count, values);
 }
 
 void UpdateFrameSizeIfNeeded(GpuContext *context) {
     if (context == nullptr || context->renderer == nullptr) return;
     if (context->width <= 0 || context->height <= 0) return;
-    if (context->width == context->last_frame_width &&
-        context->height == context->last_frame_height) {
+    const float quality_scale = kRenderQualityScales[context->render_quality];
+    const int frame_width = std::max(1, static_cast<int>(std::lround(context->width * quality_scale)));
+    const int frame_height = std::max(1, static_cast<int>(std::lround(context->height * quality_scale)));
+    if (frame_width == context->last_frame_width && frame_height == context->last_frame_height &&
+        context->width == context->last_storage_width && context->height == context->last_storage_height) {
         return;
     }
-    ass_set_frame_size(context->renderer, context->width, context->height);
-    context->last_frame_width = context->width;
-    context->last_frame_height = context->height;
+    ass_set_storage_size(context->renderer, context->width, context->height);
+    ass_set_frame_size(context->renderer, frame_width, frame_height);
+    context->last_frame_width = frame_width;
+    context->last_frame_height = frame_height;
+    context->last_storage_width = context->width;
+    context->last_storage_height = context->height;
 }
 
 GpuContext::TextureEntry &AcquireTexture(GpuContext *context, int width, int height) {
@@ -592,6 +921,133 @@ GpuContext::TextureEntry &AcquireTexture(GpuContext *context, int width, int hei
     }
     return entry;
 }
+
+struct FrameTimings {
+    double upload_ms = 0.0;
+    double composite_ms = 0.0;
+};
+
+// 绘制当前绑定纹理对应的四边形；坐标位于 libass 帧空间，降级档位下随 NDC 换算放大到整个视口。
+void DrawBoundQuad(const GpuContext *context, int dst_x, int dst_y, int w, int h, uint32_t color,
+                   float alpha) {
+    const auto frame_width = static_cast<float>(context->last_frame_width);
+    const auto frame_height = static_cast<float>(context->last_frame_height);
+    const float left = (static_cast<float>(dst_x) / frame_width) * 2.0F - 1.0F;
+    const float right = (static_cast<float>(dst_x + w) / frame_width) * 2.0F - 1.0F;
+    const float top = 1.0F - (static_cast<float>(dst_y) / frame_height) * 2.0F;
+    const float bottom = 1.0F - (static_cast<float>(dst_y + h) / frame_height) * 2.0F;
+
+    const float red = static_cast<float>((color >> 24) & 0xFF) / 255.0F;
+    const float green = static_cast<float>((color >> 16) & 0xFF) / 255.0F;
+    const float blue = static_cast<float>((color >> 8) & 0xFF) / 255.0F;
+    glUniform4f(context->uniform_color, red, green, blue, alpha);
+
+    const float vertices[] = {
+        left,  top,    0.0F, 0.0F,  // left-top
+        right, top,    1.0F, 0.0F,  // right-top
+        left,  bottom, 0.0F, 1.0F,  // left-bottom
+        right, bottom, 1.0F, 1.0F   // right-bottom
+    };
+
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+// 返回承载本次上传的纹理，未绘制时返回 0。
+GLuint DrawCoverage(GpuContext *context, int dst_x, int dst_y, int w, int h, int stride,
+                    const uint8_t *bitmap, uint32_t color, bool collect_metrics, FrameTimings *timings) {
+    if (w <= 0 || h <= 0) return 0;
+    const float base_alpha = static_cast<float>(AssAlphaToAndroid(color)) / 255.0F;
+    const float final_alpha = base_alpha * context->user_alpha;
+    if (final_alpha <= 0.0F) return 0;
+
+    const std::chrono::steady_clock::time_point upload_start =
+        collect_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    const GLuint texture = AcquireTexture(context, w, h).id;
+    if (context->gles_version >= 3 && bitmap != nullptr && stride > 0 && stride >= w) {
+        if (stride != w) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_UNSIGNED_BYTE, bitmap);
+        if (stride != w) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+    } else {
+        const size_t required = static_cast<size_t>(w * h);
+        if (context->upload_buffer.size() < required) {
+            context->upload_buffer.resize(required);
+        }
+        uint8_t *coverage = context->upload_buffer.data();
+        for (int y = 0; y < h; ++y) {
+            const uint8_t *src_row = bitmap + y * stride;
+            std::memcpy(coverage + static_cast<size_t>(y * w), src_row, static_cast<size_t>(w));
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_UNSIGNED_BYTE, coverage);
+    }
+    if (collect_metrics) {
+        const auto upload_end = std::chrono::steady_clock::now();
+        timings->upload_ms +=
+            std::chrono::duration_cast<std::chrono::microseconds>(upload_end - upload_start).count() /
+            1000.0;
+    }
+
+    const std::chrono::steady_clock::time_point draw_start =
+        collect_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    DrawBoundQuad(context, dst_x, dst_y, w, h, color, final_alpha);
+    if (collect_metrics) {
+        const auto draw_end = std::chrono::steady_clock::now();
+        timings->composite_ms +=
+            std::chrono::duration_cast<std::chrono::microseconds>(draw_end - draw_start).count() /
+            1000.0;
+    }
+    return texture;
+}
+
+void BindQuadVertexLayout(const GpuContext *context) {
+    glBindBuffer(GL_ARRAY_BUFFER, context->vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16, nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4,
+                          reinterpret_cast<void *>(0));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4,
+                          reinterpret_cast<void *>(sizeof(float) * 2));
+    glEnableVertexAttribArray(1);
+}
+
+// 宿主上下文的 GL 状态由宿主（mpv）维护，合成前后都需要显式设置/还原。
+void BeginCompositeState(const GpuContext *context) {
+    glViewport(0, 0, context->width, context->height);
+    glUseProgram(context->program);
+    glUniform1i(context->uniform_sampler, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    BindQuadVertexLayout(context);
+}
+
+// 弹幕画完后恢复字幕的 program 与顶点布局；弹幕清空后仍需调用一次以擦除上一帧。
+void DrawDanmaku(GpuContext *context, int64_t pts_ms) {
+    const bool had_content = !context->danmaku.empty();
+    if (!context->danmaku.Draw(pts_ms, context->width, context->height, context->user_alpha)) {
+        return;
+    }
+    if (had_content) {
+        glUseProgram(context->program);
+        BindQuadVertexLayout(context);
+    }
+}
+
+void EndCompositeState() {
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_BLEND);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glUseProgram(0);
+}
 }  // namespace
 
 extern "C" JNIEXPORT jlong JNICALL
@@ -615,6 +1071,7 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeDestroy(
     if (context == nullptr) {
         return;
     }
+    StopStreamingLoad(context);
     {
         std::lock_guard<std::mutex> guard(context->mutex);
         DestroyAss(context);
@@ -643,11 +1100,17 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeAttachSurface(
         return JNI_FALSE;
     }
     std::lock_guard<std::mutex> guard(context->mutex);
-    DestroyEgl(context);
-    ReleaseWindow(context);
-    if (surface != nullptr) {
-        context->window = ANativeWindow_fromSurface(env, surface);
+    ANativeWindow *window = surface != nullptr ? ANativeWindow_fromSurface(env, surface) : nullptr;
+    if (window != nullptr && window == context->window && context->egl_surface != EGL_NO_SURFACE) {
+        // 同一个 Surface 重新绑定（旋转、尺寸变化）：EGLSurface 仍然有效，只更新尺寸。
+        ANativeWindow_release(window);
+    } else {
+        DetachEglSurface(context);
+        ReleaseWindow(context);
+        context->window = window;
     }
+    // 新窗口（或改变尺寸的窗口）里还没有上一帧的内容。
+    context->pending_invalidate = true;
     context->width = width;
     context->height = height;
     context->scale = scale;
@@ -676,14 +1139,125 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeDetachSurface(
         return;
     }
     std::lock_guard<std::mutex> guard(context->mutex);
-    DestroyEgl(context);
+    DetachEglSurface(context);
+    // GL 对象已处理完，从调用线程解绑上下文：下次 attach、销毁或合成模式释放可能在别的线程上，
+    // 上下文仍 current 在这里时它们的 eglMakeCurrent 会以 EGL_BAD_ACCESS 失败。
+    if (context->egl_context != EGL_NO_CONTEXT && eglGetCurrentContext() == context->egl_context &&
+        eglMakeCurrent(context->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) != EGL_TRUE) {
+        LogError(FormatEglError("eglMakeCurrent (release) failed").c_str());
+    }
     ReleaseWindow(context);
     context->width = 0;
     context->height = 0;
     context->last_frame_width = 0;
     context->last_frame_height = 0;
+    context->last_storage_width = 0;
+    context->last_storage_height = 0;
     context->last_vsync_id = 0;
-    LogInfo("GPU surface detached");
+    LogInfo("GPU surface detached, EGL context kept");
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetTextConversion(
+    JNIEnv *env,
+    jobject /*thiz*/,
+    jlong handle,
+    jstring phrases_path,
+    jstring characters_path) {
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return JNI_FALSE;
+    const std::string phrases = JStringToUtf8(env, phrases_path);
+    const std::string characters = JStringToUtf8(env, characters_path);
+    std::shared_ptr<ass_gpu::OpenCCConverter> converter;
+    if (!phrases.empty() && !characters.empty()) {
+        // 词典只在首次使用时加载，放在锁外避免阻塞渲染。
+        converter = ass_gpu::OpenCCConverter::Acquire(phrases, characters);
+        if (converter == nullptr) {
+            LogError("Failed to load OpenCC dictionaries, subtitle conversion disabled");
+        }
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->text_converter = std::move(converter);
+    return context->text_converter != nullptr || phrases.empty() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeConfigureTrackCache(
+    JNIEnv *env,
+    jobject /*thiz*/,
+    jlong handle,
+    jstring directory,
+    jlong max_bytes,
+    jint max_entries,
+    jint eviction) {
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return;
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->track_cache.directory = JStringToUtf8(env, directory);
+    context->track_cache.max_bytes = static_cast<long long>(max_bytes);
+    context->track_cache.max_entries = static_cast<int>(max_entries);
+    context->track_cache.eviction = eviction == static_cast<jint>(ass_gpu::TrackCacheEviction::kOldestFirst)
+                                        ? ass_gpu::TrackCacheEviction::kOldestFirst
+                                        : ass_gpu::TrackCacheEviction::kLeastRecentlyUsed;
+}
+
+// 已链接的 program 会在下一帧补写到新路径；空路径关闭缓存。
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetProgramCache(
+    JNIEnv *env, jobject /*thiz*/, jlong handle, jstring path) {
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return;
+    std::lock_guard<std::mutex> guard(context->mutex);
+    const std::string cache_path = JStringToUtf8(env, path);
+    if (cache_path == context->program_cache_path) return;
+    context->program_cache_path = cache_path;
+    context->program_stored = false;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetRendererProfile(
+    JNIEnv *env, jobject /*thiz*/, jlong handle, jint profile) {
+    (void)env;
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return;
+    constexpr int kProfileCount = static_cast<int>(sizeof(kRendererProfiles) / sizeof(kRendererProfiles[0]));
+    const int clamped = std::max(0, std::min(kProfileCount - 1, static_cast<int>(profile)));
+    std::lock_guard<std::mutex> guard(context->mutex);
+    if (context->renderer_profile == clamped) return;
+    context->renderer_profile = clamped;
+    if (context->renderer != nullptr) {
+        ApplyRendererProfile(context);
+        // 整形器与 hinting 会改变字形，缓存的覆盖位图已失效。
+        context->bitmap_cache.Clear();
+        context->presented_cache_hash = 0;
+        context->pending_invalidate = true;
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetRenderQuality(
+    JNIEnv *env, jobject /*thiz*/, jlong handle, jint level) {
+    (void)env;
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return;
+    const int clamped = std::max(0, std::min(kRenderQualityCount - 1, static_cast<int>(level)));
+    std::lock_guard<std::mutex> guard(context->mutex);
+    if (context->render_quality == clamped) return;
+    context->render_quality = clamped;
+    // 下一帧由 UpdateFrameSizeIfNeeded 换帧尺寸；屏幕上的四边形仍是旧档位的坐标，必须重绘。
+    // 位图缓存按帧尺寸区分条目，无需清空。
+    context->presented_cache_hash = 0;
+    context->pending_invalidate = true;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetBitmapCacheBudget(
+    JNIEnv *env, jobject /*thiz*/, jlong handle, jlong max_bytes) {
+    (void)env;
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) return;
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->bitmap_cache.SetBudget(max_bytes > 0 ? static_cast<size_t>(max_bytes) : 0);
 }
 
 extern "C" JNIEXPORT jboolean JNICALL
@@ -693,20 +1267,86 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeLoadTrack(
     jlong handle,
     jstring path,
     jobjectArray font_dirs,
-    jstring default_font) {
+    jstring default_font,
+    jlong position_hint_ms) {
     auto *context = reinterpret_cast<GpuContext *>(handle);
     if (context == nullptr) return JNI_FALSE;
-    std::lock_guard<std::mutex> guard(context->mutex);
-    EnsureAss(context);
+    StopStreamingLoad(context);
     const std::string track_path = JStringToUtf8(env, path);
     const auto fontDirectories = JObjectArrayToStrings(env, font_dirs);
     const std::string defaultFontPath = JStringToUtf8(env, default_font);
-    ConfigureFonts(context, defaultFontPath, fontDirectories);
-    if (context->track != nullptr) {
-        ass_free_track(context->track);
-        context->track = nullptr;
+    ASS_Library *library = nullptr;
+    ass_gpu::TrackCacheConfig track_cache;
+    std::shared_ptr<ass_gpu::OpenCCConverter> converter;
+    {
+        std::lock_guard<std::mutex> guard(context->mutex);
+        EnsureAss(context);
+        ConfigureFonts(context, defaultFontPath, fontDirectories);
+        library = context->library;
+        track_cache = context->track_cache;
+        converter = context->text_converter;
+    }
+
+    // 整文件哈希与读文件不持锁：合成模式下 AssGpuCompositeFrame 在 mpv 渲染线程上取同一把锁。
+    // ASS_Library 不是线程安全的，解析时会向其中添加内嵌字体，因此恢复缓存与解析必须持锁；
+    // 大文件走流式加载，持锁解析的只有较小的文件。新轨道只在最后换入，此前屏幕上仍是旧轨道。
+    std::string cache_key;
+    ass_gpu::MappedFile source;
+    const bool mapped = source.Open(track_path);
+    if (track_cache.enabled() && mapped) {
+        cache_key = ass_gpu::TrackCacheKey(source.data(), source.size());
+        if (converter != nullptr) {
+            // 缓存的是转换后的文本，不同转换方向需要区分条目。
+            cache_key += "-" + converter->id();
+        }
+        ass_gpu::CachedTrackEntry entry;
+        if (ass_gpu::OpenCachedTrack(track_cache, cache_key, &entry)) {
+            std::lock_guard<std::mutex> guard(context->mutex);
+            ASS_Track *restored = ass_gpu::RestoreCachedTrack(library, &entry);
+            if (restored != nullptr) {
+                FreeTrack(context);
+                context->track = restored;
+                UpdateFrameSizeIfNeeded(context);
+                LogInfo("GPU subtitle track restored from cache");
+                return JNI_TRUE;
+            }
+        }
+    }
+    struct stat file_stat {};
+    if (stat(track_path.c_str(), &file_stat) == 0 && file_stat.st_size >= kStreamingLoadThresholdBytes) {
+        std::lock_guard<std::mutex> guard(context->mutex);
+        FreeTrack(context);
+        if (LoadTrackStreaming(context, track_path, static_cast<long long>(position_hint_ms), cache_key)) {
+            UpdateFrameSizeIfNeeded(context);
+            LogInfo("GPU subtitle track loaded");
+            return JNI_TRUE;
+        }
+    }
+    // ass_read_memory 会原地改写缓冲区，先在锁外复制出来。
+    std::string script;
+    if (mapped) {
+        script.assign(source.data(), source.size());
+    }
+    ASS_Track *track = nullptr;
+    if (!script.empty()) {
+        std::lock_guard<std::mutex> guard(context->mutex);
+        track = ass_read_memory(library, &script[0], script.size(), nullptr);
+    }
+    if (track != nullptr && track->name == nullptr) {
+        track->name = strdup(track_path.c_str());
     }
-    context->track = ass_read_file(context->library, track_path.c_str(), nullptr);
+    // 新轨道尚未换入，转换与序列化只访问它自己，不需要持锁。
+    if (track != nullptr && converter != nullptr) {
+        converter->ConvertTrackEvents(track, 0, track->n_events);
+    }
+    if (track != nullptr && !cache_key.empty()) {
+        ass_gpu::AssScriptLayout layout;
+        ass_gpu::SplitAssScript(source.data(), source.size(), &layout);
+        StoreTrackCacheAsync(track_cache, cache_key, ass_gpu::SerializeTrack(track, layout.header, cache_key));
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    FreeTrack(context);
+    context->track = track;
     if (context->track == nullptr) {
         LogError("Failed to load subtitle track for GPU pipeline");
         return JNI_FALSE;
@@ -726,15 +1366,13 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeInitEmbeddedTrack(
     jstring default_font) {
     auto *context = reinterpret_cast<GpuContext *>(handle);
     if (context == nullptr) return;
+    StopStreamingLoad(context);
     std::lock_guard<std::mutex> guard(context->mutex);
     EnsureAss(context);
     const auto fontDirectories = JObjectArrayToStrings(env, font_dirs);
     const std::string defaultFontPath = JStringToUtf8(env, default_font);
     ConfigureFonts(context, defaultFontPath, fontDirectories);
-    if (context->track != nullptr) {
-        ass_free_track(context->track);
-        context->track = nullptr;
-    }
+    FreeTrack(context);
     context->track = ass_new_track(context->library);
     if (context->track == nullptr) {
         LogError("Failed to create embedded SSA/ASS track");
@@ -776,12 +1414,17 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeAppendEmbeddedChunk(
     }
     jbyte *bytes = env->GetByteArrayElements(data, nullptr);
     const long long safe_duration = duration_ms > 0 ? duration_ms : kDefaultEmbeddedChunkDurationMs;
+    const int first_event = context->track->n_events;
     ass_process_chunk(context->track,
                       reinterpret_cast<char *>(bytes),
                       length,
                       static_cast<long long>(time_ms),
                       safe_duration);
     env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
+    if (context->text_converter != nullptr) {
+        // 重复下发的事件会被 libass 按 ReadOrder 去重，此处只转换真正新增的事件。
+        context->text_converter->ConvertTrackEvents(context->track, first_event, context->track->n_events);
+    }
     context->pending_invalidate = true;
 }
 
@@ -794,6 +1437,7 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeFlushEmbeddedEvents(
     std::lock_guard<std::mutex> guard(context->mutex);
     if (context->track != nullptr) {
         ass_flush_events(context->track);
+        context->bitmap_cache.InvalidateEvents();
         context->pending_invalidate = true;
     }
 }
@@ -804,11 +1448,9 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeClearEmbeddedTrack(
     (void)env;
     auto *context = reinterpret_cast<GpuContext *>(handle);
     if (context == nullptr) return;
+    StopStreamingLoad(context);
     std::lock_guard<std::mutex> guard(context->mutex);
-    if (context->track != nullptr) {
-        ass_free_track(context->track);
-        context->track = nullptr;
-    }
+    FreeTrack(context);
 }
 
 extern "C" JNIEXPORT jboolean JNICALL
@@ -825,135 +1467,81 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeRender(
     }
     std::lock_guard<std::mutex> guard(context->mutex);
     context->last_vsync_id = vsync_id;
+    context->last_subtitle_pts_ms = subtitle_pts_ms;
+    if (context->stream_loader != nullptr) {
+        context->stream_loader->UpdatePositionHint(subtitle_pts_ms);
+    }
     const bool collect_metrics = metrics_out != nullptr && context->telemetry_enabled;
-    if (context->window == nullptr || context->renderer == nullptr || context->track == nullptr ||
-        context->width <= 0 || context->height <= 0) {
+    const bool has_track = context->renderer != nullptr && context->track != nullptr;
+    if (context->window == nullptr || context->width <= 0 || context->height <= 0 ||
+        (!has_track && !context->danmaku.NeedsRedraw(subtitle_pts_ms))) {
         if (collect_metrics) {
-            WriteRenderMetrics(env, metrics_out, 0, 0, 0);
+            WriteRenderMetrics(env, metrics_out, context, 0, 0, 0);
         }
         return JNI_FALSE;
     }
     UpdateFrameSizeIfNeeded(context);
     if (!EnsureSurface(context) || !MakeCurrent(context)) {
         if (collect_metrics) {
-            WriteRenderMetrics(env, metrics_out, 0, 0, 0);
+            WriteRenderMetrics(env, metrics_out, context, 0, 0, 0);
         }
         return JNI_FALSE;
     }
 
-    int change = 0;
     std::chrono::steady_clock::time_point render_start;
     if (collect_metrics) {
         render_start = std::chrono::steady_clock::now();
     }
-    ASS_Image *img = ass_render_frame(context->renderer, context->track,
-                                      static_cast<int>(subtitle_pts_ms), &change);
+    // 回退/拖动到刚看过的静态画面时直接复用缓存的覆盖位图，跳过 ass_render_frame。
+    const ass_gpu::EventBitmapCache::Entry *cached = nullptr;
+    int change = 0;
+    ASS_Image *img = nullptr;
+    if (has_track) {
+        cached = context->bitmap_cache.Find(context->track, static_cast<long long>(subtitle_pts_ms),
+                                            context->last_frame_width, context->last_frame_height);
+        if (cached == nullptr) {
+            img = ass_render_frame(context->renderer, context->track, static_cast<int>(subtitle_pts_ms),
+                                   &change);
+            context->bitmap_cache.StorePending(img);
+        }
+    }
     std::chrono::steady_clock::time_point render_end;
     if (collect_metrics) {
         render_end = std::chrono::steady_clock::now();
     }
-    if (change == 0 && !context->pending_invalidate) {
-        // libass 表示当前时间戳无需重绘，直接复用上一帧，避免重复上传/绘制开销。
+    // libass 的 change 只相对它自己上一次输出；若屏幕内容来自缓存则必须重绘。
+    const bool unchanged = cached != nullptr ? cached->hash == context->presented_cache_hash
+                                             : change == 0 && context->presented_cache_hash == 0;
+    if (unchanged && !context->pending_invalidate && !context->danmaku.NeedsRedraw(subtitle_pts_ms)) {
+        // 当前时间戳无需重绘，直接复用上一帧，避免重复上传/绘制开销。
         if (collect_metrics) {
-            WriteRenderMetrics(env, metrics_out, 0, 0, 0);
+            WriteRenderMetrics(env, metrics_out, context, 0, 0, 0);
         }
         return JNI_TRUE;
     }
     context->pending_invalidate = false;
+    context->presented_cache_hash = cached != nullptr ? cached->hash : 0;
 
     context->texture_pool_pos = 0;
     glViewport(0, 0, context->width, context->height);
     glClearColor(0.0F, 0.0F, 0.0F, 0.0F);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    double upload_ms = 0.0;
-    double composite_ms = 0.0;
+    FrameTimings timings;
 
     glUseProgram(context->program);
-    glBindBuffer(GL_ARRAY_BUFFER, context->vertex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16, nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4,
-                          reinterpret_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4,
-                          reinterpret_cast<void *>(sizeof(float) * 2));
-    glEnableVertexAttribArray(1);
+    BindQuadVertexLayout(context);
+    DrawDanmaku(context, subtitle_pts_ms);
 
-    for (ASS_Image *cur = img; cur != nullptr; cur = cur->next) {
-        if (cur->w <= 0 || cur->h <= 0) continue;
-        const float base_alpha = static_cast<float>(AssAlphaToAndroid(cur->color)) / 255.0F;
-        const float final_alpha = base_alpha * context->user_alpha;
-        if (final_alpha <= 0.0F) continue;
-
-        const std::chrono::steady_clock::time_point upload_start =
-            collect_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
-        AcquireTexture(context, cur->w, cur->h);
-        if (context->gles_version >= 3 && cur->bitmap != nullptr && cur->stride > 0 &&
-            cur->stride >= cur->w) {
-            if (cur->stride != cur->w) {
-                glPixelStorei(GL_UNPACK_ROW_LENGTH, cur->stride);
-            }
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cur->w, cur->h, GL_RED, GL_UNSIGNED_BYTE,
-                            cur->bitmap);
-            if (cur->stride != cur->w) {
-                glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            }
-        } else {
-            const size_t required = static_cast<size_t>(cur->w * cur->h);
-            if (context->upload_buffer.size() < required) {
-                context->upload_buffer.resize(required);
-            }
-            uint8_t *coverage = context->upload_buffer.data();
-            for (int y = 0; y < cur->h; ++y) {
-                const uint8_t *src_row = cur->bitmap + y * cur->stride;
-                std::memcpy(coverage + static_cast<size_t>(y * cur->w), src_row,
-                            static_cast<size_t>(cur->w));
-            }
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cur->w, cur->h, GL_RED, GL_UNSIGNED_BYTE,
-                            coverage);
+    if (cached != nullptr) {
+        for (const auto &image : cached->images) {
+            DrawCoverage(context, image.dst_x, image.dst_y, image.w, image.h, image.w,
+                         cached->coverage.data() + image.offset, image.color, collect_metrics, &timings);
         }
-        if (collect_metrics) {
-            const auto upload_end = std::chrono::steady_clock::now();
-            upload_ms += std::chrono::duration_cast<std::chrono::microseconds>(upload_end - upload_start)
-                             .count() /
-                         1000.0;
-        }
-
-        const float left = (static_cast<float>(cur->dst_x) / static_cast<float>(context->width)) *
-                               2.0F -
-                           1.0F;
-        const float right = (static_cast<float>(cur->dst_x + cur->w) /
-                             static_cast<float>(context->width)) *
-                                2.0F -
-                            1.0F;
-        const float top = 1.0F -
-                          (static_cast<float>(cur->dst_y) / static_cast<float>(context->height)) *
-                              2.0F;
-        const float bottom =
-            1.0F - (static_cast<float>(cur->dst_y + cur->h) / static_cast<float>(context->height)) *
-                       2.0F;
-
-        const std::chrono::steady_clock::time_point draw_start =
-            collect_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
-        const float red = static_cast<float>((cur->color >> 24) & 0xFF) / 255.0F;
-        const float green = static_cast<float>((cur->color >> 16) & 0xFF) / 255.0F;
-        const float blue = static_cast<float>((cur->color >> 8) & 0xFF) / 255.0F;
-        glUniform4f(context->uniform_color, red, green, blue, final_alpha);
-
-        const float vertices[] = {
-            left,  top,    0.0F, 0.0F,  // left-top
-            right, top,    1.0F, 0.0F,  // right-top
-            left,  bottom, 0.0F, 1.0F,  // left-bottom
-            right, bottom, 1.0F, 1.0F   // right-bottom
-        };
-
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        if (collect_metrics) {
-            const auto draw_end = std::chrono::steady_clock::now();
-            composite_ms += std::chrono::duration_cast<std::chrono::microseconds>(draw_end - draw_start)
-                                .count() /
-                            1000.0;
+    } else {
+        for (ASS_Image *cur = img; cur != nullptr; cur = cur->next) {
+            DrawCoverage(context, cur->dst_x, cur->dst_y, cur->w, cur->h, cur->stride, cur->bitmap,
+                         cur->color, collect_metrics, &timings);
         }
     }
 
@@ -964,15 +1552,15 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeRender(
     eglSwapBuffers(context->egl_display, context->egl_surface);
     if (collect_metrics) {
         const auto swap_end = std::chrono::steady_clock::now();
-        composite_ms +=
+        timings.composite_ms +=
             std::chrono::duration_cast<std::chrono::microseconds>(swap_end - swap_start).count() /
             1000.0;
 
         const auto render_latency =
             std::chrono::duration_cast<std::chrono::microseconds>(render_end - render_start).count() /
             1000;
-        WriteRenderMetrics(env, metrics_out, render_latency, static_cast<jlong>(upload_ms),
-                           static_cast<jlong>(composite_ms));
+        WriteRenderMetrics(env, metrics_out, context, render_latency, static_cast<jlong>(timings.upload_ms),
+                           static_cast<jlong>(timings.composite_ms));
     }
     return JNI_TRUE;
 }
@@ -1025,3 +1613,202 @@ Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeSetGlobalOpacity(
         context->pending_invalidate = true;
     }
 }
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeDanmakuConfigure(
+    JNIEnv *env, jobject /*thiz*/, jlong handle, jint page_width, jint page_height, jint page_count) {
+    (void)env;
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->danmaku.Configure(page_width, page_height, page_count);
+}
+
+// 每条弹幕在 attributes 中占 kDanmakuAttributeStride 个 int（时长、模式、图集矩形、填充色、描边色），
+// 在 geometry 中占 kDanmakuGeometryStride 个 float（y、宽、高）。
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeDanmakuSubmitPage(
+    JNIEnv *env,
+    jobject /*thiz*/,
+    jlong handle,
+    jint page,
+    jobject bitmap,
+    jlongArray starts,
+    jintArray attributes,
+    jfloatArray geometry,
+    jint count) {
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr || bitmap == nullptr || starts == nullptr || attributes == nullptr ||
+        geometry == nullptr || count < 0) {
+        return JNI_FALSE;
+    }
+    if (env->GetArrayLength(starts) < count ||
+        env->GetArrayLength(attributes) < count * kDanmakuAttributeStride ||
+        env->GetArrayLength(geometry) < count * kDanmakuGeometryStride) {
+        return JNI_FALSE;
+    }
+    std::vector<jlong> start_values(static_cast<size_t>(count));
+    std::vector<jint> attribute_values(static_cast<size_t>(count) * kDanmakuAttributeStride);
+    std::vector<jfloat> geometry_values(static_cast<size_t>(count) * kDanmakuGeometryStride);
+    env->GetLongArrayRegion(starts, 0, count, start_values.data());
+    env->GetIntArrayRegion(attributes, 0, count * kDanmakuAttributeStride, attribute_values.data());
+    env->GetFloatArrayRegion(geometry, 0, count * kDanmakuGeometryStride, geometry_values.data());
+
+    std::vector<ass_gpu::DanmakuLayer::Comment> comments(static_cast<size_t>(count));
+    for (jint i = 0; i < count; ++i) {
+        const jint *attribute = attribute_values.data() + i * kDanmakuAttributeStride;
+        const jfloat *box = geometry_values.data() + i * kDanmakuGeometryStride;
+        auto &comment = comments[static_cast<size_t>(i)];
+        comment.start_ms = start_values[static_cast<size_t>(i)];
+        comment.duration_ms = attribute[0];
+        comment.mode = attribute[1];
+        comment.atlas_x = attribute[2];
+        comment.atlas_y = attribute[3];
+        comment.atlas_w = attribute[4];
+        comment.atlas_h = attribute[5];
+        comment.fill_color = static_cast<uint32_t>(attribute[6]);
+        comment.stroke_color = static_cast<uint32_t>(attribute[7]);
+        comment.y = box[0];
+        comment.width = box[1];
+        comment.height = box[2];
+    }
+
+    AndroidBitmapInfo info{};
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LogError("Danmaku atlas page must be an ARGB_8888 bitmap");
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    if (static_cast<int>(info.width) != context->danmaku.page_width() ||
+        static_cast<int>(info.height) != context->danmaku.page_height()) {
+        return JNI_FALSE;
+    }
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || pixels == nullptr) {
+        return JNI_FALSE;
+    }
+    const bool submitted = context->danmaku.SubmitPage(page, static_cast<const uint8_t *>(pixels), info.stride,
+                                                       std::move(comments));
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return submitted ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_subtitle_gpu_AssGpuNativeBridge_nativeDanmakuClear(
+    JNIEnv *env, jobject /*thiz*/, jlong handle) {
+    (void)env;
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->danmaku.Clear();
+}
+
+extern "C" JNIEXPORT bool AssGpuCompositeFrame(int64_t handle, int64_t pts_ms, int width, int height,
+                                               uint64_t host_generation) {
+    auto *context = reinterpret_cast<GpuContext *>(handle);
+    if (context == nullptr || width <= 0 || height <= 0 || host_generation == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(context->mutex);
+    // 自带 surface 时由 nativeRender 输出，两种模式互斥。
+    if (context->window != nullptr) {
+        return false;
+    }
+    if (context->egl_context != EGL_NO_CONTEXT) {
+        ReleaseKeptEglForComposite(context);
+    }
+    context->last_subtitle_pts_ms = pts_ms;
+    if (context->stream_loader != nullptr) {
+        context->stream_loader->UpdatePositionHint(pts_ms);
+    }
+    const bool has_track = context->renderer != nullptr && context->track != nullptr;
+    if (!has_track && context->danmaku.empty()) {
+        return true;
+    }
+    if (host_generation != context->composite_host_generation) {
+        // 宿主换了 EGL 上下文（surface 重建），旧上下文里的 GL 对象已随之释放，只需丢弃句柄。
+        context->composite_host_generation = host_generation;
+        context->program = 0;
+        context->vertex_buffer = 0;
+        context->uniform_color = -1;
+        context->uniform_sampler = -1;
+        context->texture_pool.clear();
+        context->texture_pool_pos = 0;
+        context->composite_quads.clear();
+        context->presented_cache_hash = 0;
+        context->pending_invalidate = true;
+        context->danmaku.OnContextLost();
+    }
+    context->width = width;
+    context->height = height;
+    UpdateFrameSizeIfNeeded(context);
+    if (!EnsureProgram(context)) {
+        return false;
+    }
+
+    const ass_gpu::EventBitmapCache::Entry *cached = nullptr;
+    int change = 0;
+    ASS_Image *img = nullptr;
+    if (has_track) {
+        cached = context->bitmap_cache.Find(context->track, static_cast<long long>(pts_ms),
+                                            context->last_frame_width, context->last_frame_height);
+        if (cached == nullptr) {
+            img = ass_render_frame(context->renderer, context->track, static_cast<int>(pts_ms), &change);
+            context->bitmap_cache.StorePending(img);
+        }
+    }
+    const bool unchanged = cached != nullptr ? cached->hash == context->presented_cache_hash
+                                             : change == 0 && context->presented_cache_hash == 0;
+
+    BeginCompositeState(context);
+    DrawDanmaku(context, pts_ms);
+    if (!has_track) {
+        EndCompositeState();
+        return true;
+    }
+    if (unchanged && !context->pending_invalidate) {
+        glActiveTexture(GL_TEXTURE0);
+        for (const auto &quad : context->composite_quads) {
+            glBindTexture(GL_TEXTURE_2D, quad.texture);
+            const float alpha =
+                static_cast<float>(AssAlphaToAndroid(quad.color)) / 255.0F * context->user_alpha;
+            DrawBoundQuad(context, quad.dst_x, quad.dst_y, quad.w, quad.h, quad.color, alpha);
+        }
+        EndCompositeState();
+        return true;
+    }
+    context->pending_invalidate = false;
+    context->presented_cache_hash = cached != nullptr ? cached->hash : 0;
+    context->texture_pool_pos = 0;
+    context->composite_quads.clear();
+
+    FrameTimings timings;
+    auto record = [context](GLuint texture, int x, int y, int w, int h, uint32_t color) {
+        if (texture != 0) {
+            context->composite_quads.push_back({texture, x, y, w, h, color});
+        }
+    };
+    if (cached != nullptr) {
+        for (const auto &image : cached->images) {
+            record(DrawCoverage(context, image.dst_x, image.dst_y, image.w, image.h, image.w,
+                                cached->coverage.data() + image.offset, image.color, false, &timings),
+                   image.dst_x, image.dst_y, image.w, image.h, image.color);
+        }
+    } else {
+        for (ASS_Image *cur = img; cur != nullptr; cur = cur->next) {
+            record(DrawCoverage(context, cur->dst_x, cur->dst_y, cur->w, cur->h, cur->stride, cur->bitmap,
+                                cur->color, false, &timings),
+                   cur->dst_x, cur->dst_y, cur->w, cur->h, cur->color);
+        }
+    }
+    EndCompositeState();
+    return true;
+}
+
+static_assert(std::is_same<decltype(&AssGpuCompositeFrame), AssGpuCompositeFrameFn>::value,
+              "AssGpuCompositeFrame must match the signature mpv_bridge resolves");
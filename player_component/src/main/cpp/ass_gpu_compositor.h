@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * C entry points that let another native library draw a GPU subtitle context
+ * into a framebuffer it owns, instead of the context presenting through its own
+ * ANativeWindow. mpv_bridge's render thread uses them to put libass output on
+ * top of the video before a single eglSwapBuffers().
+ *
+ * The symbols are resolved with dlsym() from the already loaded libass_bridge,
+ * so neither library links against the other. `handle` is the value held by
+ * AssGpuNativeBridge on the Kotlin side.
+ */
+extern "C" {
+
+// Draws the subtitles visible at `pts_ms` over the framebuffer currently bound
+// in the caller's (current) EGL context, sized `width` x `height`. GL objects
+// created here belong to that context; the caller bumps `host_generation`
+// whenever it replaces the context, so stale object names are dropped instead
+// of deleted. Returns false when the handle owns its own EGL context (a surface
+// is attached, or was and the context is kept for the next attach) or the GL
+// setup fails.
+using AssGpuCompositeFrameFn = bool (*)(int64_t handle, int64_t pts_ms, int width, int height,
+                                        uint64_t host_generation);
+
+}
+
+constexpr const char *kAssGpuBridgeLibrary = "liblibass_bridge.so";
+constexpr const char *kAssGpuCompositeFrameSymbol = "AssGpuCompositeFrame";
@@ -0,0 +1,541 @@
+#include "ass_opencc.h"
+
+#include "ass_stream_loader.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <utility>
+
+namespace ass_gpu {
+namespace {
+constexpr const char *kOpenCCLogTag = "AssOpenCC";
+constexpr char kOcd2Header[] = "OPENCC_MARISA_0.2.5";
+constexpr char kMarisaHeader[16] = "We love Marisa.";
+constexpr size_t kInvalidId = static_cast<size_t>(-1);
+constexpr uint32_t kNoValue = UINT32_MAX;
+constexpr size_t kMemoCapacity = 8192;
+
+class Reader {
+public:
+    Reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+    bool ok() const { return ok_; }
+    size_t position() const { return pos_; }
+
+    bool Skip(size_t bytes) {
+        if (!ok_ || size_ - pos_ < bytes) {
+            ok_ = false;
+            return false;
+        }
+        pos_ += bytes;
+        return true;
+    }
+
+    template <typename T>
+    T Read() {
+        T value {};
+        const size_t start = pos_;
+        if (Skip(sizeof(T))) {
+            std::memcpy(&value, data_ + start, sizeof(T));
+        }
+        return value;
+    }
+
+    const char *Bytes(size_t bytes) {
+        const size_t start = pos_;
+        return Skip(bytes) ? data_ + start : nullptr;
+    }
+
+    // marisa::grimoire::Vector: u64 byte size, payload, zero padding to 8 bytes.
+    const char *Vector(size_t *bytes) {
+        const uint64_t total = Read<uint64_t>();
+        if (!ok_ || total > size_) {
+            ok_ = false;
+            return nullptr;
+        }
+        *bytes = static_cast<size_t>(total);
+        const char *payload = Bytes(*bytes);
+        Skip((8 - (*bytes % 8)) % 8);
+        return ok_ ? payload : nullptr;
+    }
+
+private:
+    const char *data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+inline size_t SelectInWord(uint64_t word, size_t rank) {
+    for (size_t i = 0; i < rank; ++i) {
+        word &= word - 1;
+    }
+    return static_cast<size_t>(__builtin_ctzll(word));
+}
+
+class BitVector {
+public:
+    bool Read(Reader &reader) {
+        size_t bytes = 0;
+        const char *units = reader.Vector(&bytes);
+        size_ = reader.Read<uint32_t>();
+        num_1s_ = reader.Read<uint32_t>();
+        size_t skipped = 0;
+        reader.Vector(&skipped);  // ranks
+        reader.Vector(&skipped);  // select0 hints
+        reader.Vector(&skipped);  // select1 hints
+        if (!reader.ok() || bytes * 8 < size_) {
+            return false;
+        }
+        words_.assign((bytes + 7) / 8, 0);
+        if (bytes > 0) {
+            std::memcpy(words_.data(), units, bytes);
+        }
+        ranks_.assign(words_.size() + 1, 0);
+        for (size_t i = 0; i < words_.size(); ++i) {
+            ranks_[i + 1] = ranks_[i] + static_cast<uint32_t>(__builtin_popcountll(words_[i]));
+        }
+        return true;
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t num_1s() const { return num_1s_; }
+
+    bool Get(size_t i) const { return i < size_ && ((words_[i / 64] >> (i % 64)) & 1U) != 0; }
+
+    size_t Rank1(size_t i) const {
+        const size_t word = i / 64;
+        const size_t bit = i % 64;
+        size_t rank = ranks_[word];
+        if (bit != 0) {
+            rank += static_cast<size_t>(__builtin_popcountll(words_[word] & ((1ULL << bit) - 1)));
+        }
+        return rank;
+    }
+
+    size_t Select1(size_t k) const {
+        size_t low = 0;
+        size_t high = words_.size();
+        while (high - low > 1) {
+            const size_t mid = (low + high) / 2;
+            if (ranks_[mid] <= k) low = mid; else high = mid;
+        }
+        return low * 64 + SelectInWord(words_[low], k - ranks_[low]);
+    }
+
+    size_t Select0(size_t k) const {
+        size_t low = 0;
+        size_t high = words_.size();
+        while (high - low > 1) {
+            const size_t mid = (low + high) / 2;
+            if (mid * 64 - ranks_[mid] <= k) low = mid; else high = mid;
+        }
+        return low * 64 + SelectInWord(~words_[low], k - (low * 64 - ranks_[low]));
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    std::vector<uint32_t> ranks_;
+    size_t size_ = 0;
+    size_t num_1s_ = 0;
+};
+
+class FlatVector {
+public:
+    bool Read(Reader &reader) {
+        size_t bytes = 0;
+        const char *units = reader.Vector(&bytes);
+        value_size_ = reader.Read<uint32_t>();
+        mask_ = reader.Read<uint32_t>();
+        size_ = static_cast<size_t>(reader.Read<uint64_t>());
+        if (!reader.ok() || value_size_ > 32) {
+            return false;
+        }
+        words_.assign((bytes + 7) / 8 + 1, 0);
+        if (bytes > 0) {
+            std::memcpy(words_.data(), units, bytes);
+        }
+        return true;
+    }
+
+    uint32_t Get(size_t i) const {
+        const size_t pos = i * value_size_;
+        const size_t word = pos / 64;
+        const size_t offset = pos % 64;
+        uint64_t value = words_[word] >> offset;
+        if (offset + value_size_ > 64) {
+            value |= words_[word + 1] << (64 - offset);
+        }
+        return static_cast<uint32_t>(value) & mask_;
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    uint32_t value_size_ = 0;
+    uint32_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+class Tail {
+public:
+    bool Read(Reader &reader) {
+        size_t bytes = 0;
+        const char *buf = reader.Vector(&bytes);
+        if (!reader.ok()) return false;
+        buf_.assign(buf, buf + bytes);
+        return end_flags_.Read(reader);
+    }
+
+    bool empty() const { return buf_.empty(); }
+
+    bool Match(const char *query, size_t length, size_t &pos, size_t offset) const {
+        if (end_flags_.empty()) {
+            do {
+                if (offset >= buf_.size() || buf_[offset] != query[pos]) return false;
+                ++pos;
+                ++offset;
+                if (offset >= buf_.size() || buf_[offset] == '\0') return true;
+            } while (pos < length);
+            return false;
+        }
+        do {
+            if (offset >= buf_.size() || buf_[offset] != query[pos]) return false;
+            ++pos;
+            if (end_flags_.Get(offset++)) return true;
+        } while (pos < length);
+        return false;
+    }
+
+private:
+    std::vector<char> buf_;
+    BitVector end_flags_;
+};
+}  // namespace
+
+// marisa::grimoire::LoudsTrie, lookup side only.
+class OpenCCDictionary::Trie {
+public:
+    bool Read(Reader &reader) {
+        if (!louds_.Read(reader) || !terminal_flags_.Read(reader) || !link_flags_.Read(reader)) {
+            return false;
+        }
+        size_t bytes = 0;
+        const char *bases = reader.Vector(&bytes);
+        if (!reader.ok()) return false;
+        bases_.assign(reinterpret_cast<const uint8_t *>(bases), reinterpret_cast<const uint8_t *>(bases) + bytes);
+        if (!extras_.Read(reader) || !tail_.Read(reader)) {
+            return false;
+        }
+        if (link_flags_.num_1s() != 0 && tail_.empty()) {
+            next_.reset(new Trie());
+            if (!next_->Read(reader)) return false;
+        }
+        const char *cache = reader.Vector(&bytes);
+        if (!reader.ok() || bytes % sizeof(CacheEntry) != 0) return false;
+        cache_.resize(bytes / sizeof(CacheEntry));
+        if (!cache_.empty()) {
+            std::memcpy(cache_.data(), cache, bytes);
+        }
+        cache_mask_ = cache_.empty() ? 0 : cache_.size() - 1;
+        num_l1_nodes_ = reader.Read<uint32_t>();
+        reader.Read<uint32_t>();  // config flags
+        return reader.ok();
+    }
+
+    size_t LongestPrefix(const char *query, size_t length, size_t *key_id) const {
+        size_t node = 0;
+        size_t pos = 0;
+        size_t best = 0;
+        while (pos < length && FindChild(query, length, node, pos)) {
+            if (terminal_flags_.Get(node)) {
+                best = pos;
+                *key_id = terminal_flags_.Rank1(node);
+            }
+        }
+        return best;
+    }
+
+private:
+    uint32_t Link(size_t node, size_t link_id) const {
+        return bases_[node] | (extras_.Get(link_id) << 8);
+    }
+
+    bool MatchLink(const char *query, size_t length, size_t &pos, size_t link) const {
+        return next_ != nullptr ? next_->MatchReversed(query, length, pos, link)
+                                : tail_.Match(query, length, pos, link);
+    }
+
+    bool FindChild(const char *query, size_t length, size_t &node, size_t &pos) const {
+        if (!cache_.empty()) {
+            // Hot transitions are precomputed by marisa; a hit skips the sibling scan.
+            const CacheEntry &entry = cache_[(node ^ (node << 5) ^ static_cast<uint8_t>(query[pos])) & cache_mask_];
+            if (entry.parent == node) {
+                if ((entry.link >> 8) != kInvalidExtra) {
+                    if (!MatchLink(query, length, pos, entry.link)) return false;
+                } else {
+                    ++pos;
+                }
+                node = entry.child;
+                return true;
+            }
+        }
+        size_t louds_pos = louds_.Select0(node) + 1;
+        if (!louds_.Get(louds_pos)) return false;
+        node = louds_pos - node - 1;
+        size_t link_id = kInvalidId;
+        do {
+            if (link_flags_.Get(node)) {
+                link_id = link_id == kInvalidId ? link_flags_.Rank1(node) : link_id + 1;
+                const size_t previous = pos;
+                if (MatchLink(query, length, pos, Link(node, link_id))) return true;
+                if (pos != previous) return false;
+            } else if (bases_[node] == static_cast<uint8_t>(query[pos])) {
+                ++pos;
+                return true;
+            }
+            ++node;
+            ++louds_pos;
+        } while (louds_.Get(louds_pos));
+        return false;
+    }
+
+    bool MatchReversed(const char *query, size_t length, size_t &pos, size_t node) const {
+        for (;;) {
+            if (link_flags_.Get(node)) {
+                if (!MatchLink(query, length, pos, Link(node, link_flags_.Rank1(node)))) return false;
+            } else if (bases_[node] == static_cast<uint8_t>(query[pos])) {
+                ++pos;
+            } else {
+                return false;
+            }
+            if (node <= num_l1_nodes_) return true;
+            if (pos >= length) return false;
+            node = louds_.Select1(node) - node - 1;
+        }
+    }
+
+    struct CacheEntry {
+        uint32_t parent;
+        uint32_t child;
+        uint32_t link;
+    };
+    static constexpr uint32_t kInvalidExtra = UINT32_MAX >> 8;
+
+    BitVector louds_;
+    BitVector terminal_flags_;
+    BitVector link_flags_;
+    std::vector<uint8_t> bases_;
+    FlatVector extras_;
+    Tail tail_;
+    std::unique_ptr<Trie> next_;
+    std::vector<CacheEntry> cache_;
+    size_t cache_mask_ = 0;
+    size_t num_l1_nodes_ = 0;
+};
+
+OpenCCDictionary::OpenCCDictionary() = default;
+OpenCCDictionary::~OpenCCDictionary() = default;
+
+bool OpenCCDictionary::Open(const std::string &path) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        __android_log_print(ANDROID_LOG_ERROR, kOpenCCLogTag, "Cannot open %s", path.c_str());
+        return false;
+    }
+    Reader reader(file.data(), file.size());
+    const char *header = reader.Bytes(sizeof(kOcd2Header) - 1);
+    const char *marisa_header = reader.Bytes(sizeof(kMarisaHeader));
+    if (header == nullptr || marisa_header == nullptr ||
+        std::memcmp(header, kOcd2Header, sizeof(kOcd2Header) - 1) != 0 ||
+        std::memcmp(marisa_header, kMarisaHeader, sizeof(kMarisaHeader)) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, kOpenCCLogTag, "Invalid dictionary header: %s", path.c_str());
+        return false;
+    }
+    std::unique_ptr<Trie> trie(new Trie());
+    if (!trie->Read(reader)) {
+        __android_log_print(ANDROID_LOG_ERROR, kOpenCCLogTag, "Corrupt dictionary trie: %s", path.c_str());
+        return false;
+    }
+    // opencc::SerializedValues: item count, NUL-separated value buffer, then per item a u16
+    // value count followed by the u16 byte length (NUL included) of each value, in buffer order.
+    const uint32_t item_count = reader.Read<uint32_t>();
+    const uint32_t values_length = reader.Read<uint32_t>();
+    const char *values = reader.Bytes(values_length);
+    if (values == nullptr) {
+        return false;
+    }
+    std::vector<uint32_t> offsets(item_count, kNoValue);
+    uint32_t cursor = 0;
+    for (uint32_t i = 0; i < item_count && reader.ok(); ++i) {
+        const uint16_t value_count = reader.Read<uint16_t>();
+        for (uint16_t j = 0; j < value_count; ++j) {
+            const uint16_t value_bytes = reader.Read<uint16_t>();
+            if (j == 0 && cursor < values_length) {
+                offsets[i] = cursor;
+            }
+            cursor += value_bytes;
+        }
+    }
+    if (!reader.ok() || cursor != values_length || values_length == 0 || values[values_length - 1] != '\0') {
+        __android_log_print(ANDROID_LOG_ERROR, kOpenCCLogTag, "Corrupt dictionary values: %s", path.c_str());
+        return false;
+    }
+    trie_ = std::move(trie);
+    values_.assign(values, values_length);
+    first_value_offsets_ = std::move(offsets);
+    return true;
+}
+
+size_t OpenCCDictionary::MatchPrefix(const char *text, size_t length, const char **value) const {
+    if (trie_ == nullptr || length == 0) {
+        return 0;
+    }
+    size_t key_id = kInvalidId;
+    const size_t matched = trie_->LongestPrefix(text, length, &key_id);
+    if (matched == 0 || key_id >= first_value_offsets_.size() || first_value_offsets_[key_id] == kNoValue) {
+        return 0;
+    }
+    *value = values_.data() + first_value_offsets_[key_id];
+    return matched;
+}
+
+std::shared_ptr<OpenCCConverter> OpenCCConverter::Acquire(const std::string &phrases_path,
+                                                          const std::string &characters_path) {
+    static std::mutex registry_mutex;
+    static std::map<std::pair<std::string, std::string>, std::weak_ptr<OpenCCConverter>> registry;
+    std::lock_guard<std::mutex> guard(registry_mutex);
+    const auto key = std::make_pair(phrases_path, characters_path);
+    if (auto existing = registry[key].lock()) {
+        return existing;
+    }
+    std::shared_ptr<OpenCCConverter> converter(new OpenCCConverter());
+    if (!converter->phrases_.Open(phrases_path) || !converter->characters_.Open(characters_path)) {
+        return nullptr;
+    }
+    // Short, stable tag so cached tracks are keyed per conversion direction.
+    uint32_t hash = 2166136261U;
+    for (const std::string *part : {&phrases_path, &characters_path}) {
+        const size_t slash = part->find_last_of('/');
+        for (size_t i = slash == std::string::npos ? 0 : slash + 1; i < part->size(); ++i) {
+            hash = (hash ^ static_cast<uint8_t>((*part)[i])) * 16777619U;
+        }
+    }
+    char id[16];
+    std::snprintf(id, sizeof(id), "%08x", hash);
+    converter->id_ = id;
+    registry[key] = converter;
+    __android_log_print(ANDROID_LOG_INFO, kOpenCCLogTag, "Dictionaries loaded (%s)", id);
+    return converter;
+}
+
+std::string OpenCCConverter::Convert(const char *text, size_t length) const {
+    std::string out;
+    out.reserve(length + length / 4);
+    size_t pos = 0;
+    while (pos < length) {
+        const auto lead = static_cast<uint8_t>(text[pos]);
+        if (lead < 0x80) {
+            out.push_back(text[pos++]);
+            continue;
+        }
+        const char *phrase = nullptr;
+        const char *character = nullptr;
+        const size_t phrase_length = phrases_.MatchPrefix(text + pos, length - pos, &phrase);
+        // Character dictionaries hold single code points, so they can only win when no phrase matched.
+        const size_t character_length =
+            phrase_length > 0 ? 0 : characters_.MatchPrefix(text + pos, length - pos, &character);
+        if (phrase_length > 0) {
+            out.append(phrase);
+            pos += phrase_length;
+        } else if (character_length > 0) {
+            out.append(character);
+            pos += character_length;
+        } else {
+            size_t step = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            step = std::min(step, length - pos);
+            out.append(text + pos, step);
+            pos += step;
+        }
+    }
+    return out;
+}
+
+std::string OpenCCConverter::ConvertAssText(const char *text) {
+    if (text == nullptr || *text == '\0') {
+        return {};
+    }
+    std::string source(text);
+    {
+        std::lock_guard<std::mutex> guard(memo_mutex_);
+        auto it = memo_.find(source);
+        if (it != memo_.end()) {
+            return it->second;
+        }
+    }
+    std::string out;
+    out.reserve(source.size() + source.size() / 4);
+    size_t run_start = 0;
+    size_t pos = 0;
+    auto flush_run = [&](size_t end) {
+        if (end > run_start) {
+            out.append(Convert(source.data() + run_start, end - run_start));
+        }
+    };
+    while (pos < source.size()) {
+        const char c = source[pos];
+        if (c == '{') {
+            const size_t close = source.find('}', pos);
+            const size_t block_end = close == std::string::npos ? source.size() : close + 1;
+            flush_run(pos);
+            out.append(source, pos, block_end - pos);
+            pos = run_start = block_end;
+        } else if (c == '\\' && pos + 1 < source.size() &&
+                   (source[pos + 1] == 'N' || source[pos + 1] == 'n' || source[pos + 1] == 'h')) {
+            flush_run(pos);
+            out.append(source, pos, 2);
+            pos = run_start = pos + 2;
+        } else {
+            ++pos;
+        }
+    }
+    flush_run(source.size());
+
+    std::lock_guard<std::mutex> guard(memo_mutex_);
+    if (memo_.size() >= kMemoCapacity) {
+        memo_.clear();
+    }
+    memo_.emplace(std::move(source), out);
+    return out;
+}
+
+void OpenCCConverter::ConvertTrackEvents(ASS_Track *track, int first_event, int last_event) {
+    if (track == nullptr) {
+        return;
+    }
+    last_event = std::min(last_event, track->n_events);
+    for (int i = std::max(first_event, 0); i < last_event; ++i) {
+        ASS_Event &event = track->events[i];
+        if (event.Text == nullptr) {
+            continue;
+        }
+        const std::string converted = ConvertAssText(event.Text);
+        if (converted.size() == std::strlen(event.Text) &&
+            std::memcmp(converted.data(), event.Text, converted.size()) == 0) {
+            continue;
+        }
+        auto *text = static_cast<char *>(std::malloc(converted.size() + 1));
+        if (text == nullptr) {
+            continue;
+        }
+        std::memcpy(text, converted.c_str(), converted.size() + 1);
+        std::free(event.Text);
+        event.Text = text;
+    }
+}
+
+}  // namespace ass_gpu
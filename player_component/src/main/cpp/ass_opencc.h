@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ass/ass.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ass_gpu {
+
+/**
+ * Read-only view of an OpenCC .ocd2 dictionary (marisa trie + serialized
+ * values). Only the longest-prefix lookup used by OpenCC's conversion step is
+ * implemented; rank/select indexes are rebuilt at load time.
+ */
+class OpenCCDictionary {
+public:
+    OpenCCDictionary();
+    ~OpenCCDictionary();
+
+    OpenCCDictionary(const OpenCCDictionary &) = delete;
+    OpenCCDictionary &operator=(const OpenCCDictionary &) = delete;
+
+    bool Open(const std::string &path);
+
+    // Returns the number of bytes of `text` matched by the longest key, 0 if none.
+    size_t MatchPrefix(const char *text, size_t length, const char **value) const;
+
+private:
+    class Trie;
+
+    std::unique_ptr<Trie> trie_;
+    std::string values_;
+    std::vector<uint32_t> first_value_offsets_;
+};
+
+/**
+ * OpenCC-compatible conversion over a phrase dictionary and a character
+ * dictionary (s2t: STPhrases + STCharacters, t2s: TSPhrases + TSCharacters).
+ * Converts greedily by longest match, phrases winning ties, which is what the
+ * bundled configs' mmseg + dictionary-group chain reduces to.
+ *
+ * Instances are shared between GPU contexts; conversion is thread-safe.
+ */
+class OpenCCConverter {
+public:
+    static std::shared_ptr<OpenCCConverter> Acquire(const std::string &phrases_path,
+                                                    const std::string &characters_path);
+
+    // Converts plain text; ASCII bytes are copied through untouched.
+    std::string Convert(const char *text, size_t length) const;
+
+    // Converts the text of an ASS event, leaving {...} override blocks and \N, \n, \h escapes intact.
+    std::string ConvertAssText(const char *text);
+
+    // Replaces Text of events [first_event, last_event) in place.
+    void ConvertTrackEvents(ASS_Track *track, int first_event, int last_event);
+
+    const std::string &id() const { return id_; }
+
+private:
+    OpenCCConverter() = default;
+
+    OpenCCDictionary phrases_;
+    OpenCCDictionary characters_;
+    std::string id_;
+    std::mutex memo_mutex_;
+    std::unordered_map<std::string, std::string> memo_;
+};
+
+}  // namespace ass_gpu
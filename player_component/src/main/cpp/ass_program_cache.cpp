@@ -0,0 +1,148 @@
+#include "ass_program_cache.h"
+
+#include "hash64.h"
+
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace ass_gpu {
+namespace {
+constexpr const char *kProgramLogTag = "AssProgramCache";
+constexpr uint32_t kProgramMagic = 0x42504741;  // "AGPB"
+constexpr uint32_t kProgramFormatVersion = 1;
+// Program binaries of two small shaders stay in the tens of KiB on every driver seen so far.
+constexpr off_t kMaxProgramFileBytes = 4 * 1024 * 1024;
+
+struct ProgramFileHeader {
+    uint32_t magic;
+    uint32_t format_version;
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t length;
+    uint64_t checksum;
+};
+static_assert(sizeof(ProgramFileHeader) == 32, "ProgramFileHeader is written as is");
+
+uint64_t HashString(const char *value, uint64_t seed) {
+    if (value == nullptr) {
+        return hash64::Hash64(nullptr, 0, seed + 1);
+    }
+    return hash64::Hash64(value, std::strlen(value), seed);
+}
+
+bool ReadFile(const std::string &path, std::vector<uint8_t> *out) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ProgramFileHeader)) ||
+        st.st_size > kMaxProgramFileBytes) {
+        close(fd);
+        return false;
+    }
+    out->resize(static_cast<size_t>(st.st_size));
+    size_t read_bytes = 0;
+    while (read_bytes < out->size()) {
+        const ssize_t result = read(fd, out->data() + read_bytes, out->size() - read_bytes);
+        if (result <= 0) {
+            break;
+        }
+        read_bytes += static_cast<size_t>(result);
+    }
+    close(fd);
+    return read_bytes == out->size();
+}
+}  // namespace
+
+uint64_t ProgramCacheKey(const char *vertex_source, const char *fragment_source) {
+    uint64_t key = HashString(vertex_source, kProgramFormatVersion);
+    key = HashString(fragment_source, key);
+    key = HashString(reinterpret_cast<const char *>(glGetString(GL_VENDOR)), key);
+    key = HashString(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), key);
+    return HashString(reinterpret_cast<const char *>(glGetString(GL_VERSION)), key);
+}
+
+bool LoadProgramBinary(const std::string &path, uint64_t key, GLuint program) {
+    if (path.empty() || program == 0) {
+        return false;
+    }
+    std::vector<uint8_t> file;
+    if (!ReadFile(path, &file)) {
+        return false;
+    }
+    ProgramFileHeader header {};
+    std::memcpy(&header, file.data(), sizeof(header));
+    const uint8_t *binary = file.data() + sizeof(header);
+    if (header.magic != kProgramMagic || header.format_version != kProgramFormatVersion || header.key != key ||
+        header.length != file.size() - sizeof(header) ||
+        header.checksum != hash64::Hash64(binary, header.length)) {
+        // Another GPU or driver, or a torn write; the next successful link replaces it.
+        return false;
+    }
+    glProgramBinary(program, header.binary_format, binary, static_cast<GLsizei>(header.length));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        __android_log_print(ANDROID_LOG_WARN, kProgramLogTag, "Driver rejected cached program binary");
+        return false;
+    }
+    return true;
+}
+
+bool StoreProgramBinary(const std::string &path, uint64_t key, GLuint program) {
+    if (path.empty() || program == 0) {
+        return false;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || length > kMaxProgramFileBytes) {
+        return false;
+    }
+    std::vector<uint8_t> file(sizeof(ProgramFileHeader) + static_cast<size_t>(length));
+    uint8_t *binary = file.data() + sizeof(ProgramFileHeader);
+    GLsizei written_length = 0;
+    GLenum binary_format = 0;
+    glGetProgramBinary(program, length, &written_length, &binary_format, binary);
+    if (written_length <= 0 || written_length > length) {
+        return false;
+    }
+    file.resize(sizeof(ProgramFileHeader) + static_cast<size_t>(written_length));
+    ProgramFileHeader header {};
+    header.magic = kProgramMagic;
+    header.format_version = kProgramFormatVersion;
+    header.key = key;
+    header.binary_format = binary_format;
+    header.length = static_cast<uint32_t>(written_length);
+    header.checksum = hash64::Hash64(binary, header.length);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    const std::string tmp_path = path + ".tmp";
+    const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_WARN, kProgramLogTag, "Cannot create %s", tmp_path.c_str());
+        return false;
+    }
+    size_t written = 0;
+    while (written < file.size()) {
+        const ssize_t result = write(fd, file.data() + written, file.size() - written);
+        if (result <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(result);
+    }
+    close(fd);
+    if (written != file.size() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace ass_gpu
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <string>
+
+namespace ass_gpu {
+
+/**
+ * On-disk copy of a linked GL program (glGetProgramBinary), so a cold start
+ * loads the driver's binary instead of compiling the shaders again.
+ *
+ * The key covers the shader sources and the GL_VENDOR / GL_RENDERER /
+ * GL_VERSION strings of the current context, so a driver update or another
+ * GPU simply misses. The file holds a single program:
+ *
+ *   u32 magic "AGPB", u32 version, u64 key, u32 binary_format, u32 length,
+ *   u64 checksum of the binary, binary
+ *
+ * All functions need a current GLES 3 context.
+ */
+uint64_t ProgramCacheKey(const char *vertex_source, const char *fragment_source);
+
+// Loads the cached binary into `program` (created, not linked). False when the
+// file is missing, stale, corrupt or rejected by the driver; `program` is then
+// left unlinked and can still be built from source.
+bool LoadProgramBinary(const std::string &path, uint64_t key, GLuint program);
+
+// Saves the binary of linked `program`, atomically (tmp + rename).
+bool StoreProgramBinary(const std::string &path, uint64_t key, GLuint program);
+
+}  // namespace ass_gpu
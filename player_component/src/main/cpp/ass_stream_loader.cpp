@@ -0,0 +1,394 @@
+#include "ass_stream_loader.h"
+
+#include <android/log.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace ass_gpu {
+namespace {
+constexpr const char *kLoaderLogTag = "AssStreamLoader";
+constexpr size_t kEventsPerChunk = 256;
+constexpr int kLoaderThreadNice = 10;
+
+struct LineView {
+    size_t begin = 0;
+    size_t end = 0;   // exclusive, trailing '\r' stripped
+    size_t next = 0;  // start of the following line
+};
+
+bool NextLine(const char *data, size_t size, size_t pos, LineView *out) {
+    if (pos >= size) return false;
+    const void *newline = std::memchr(data + pos, '\n', size - pos);
+    size_t end = newline == nullptr ? size : static_cast<size_t>(static_cast<const char *>(newline) - data);
+    out->begin = pos;
+    out->next = newline == nullptr ? size : end + 1;
+    while (end > pos && data[end - 1] == '\r') {
+        --end;
+    }
+    out->end = end;
+    return true;
+}
+
+size_t SkipSpaces(const char *data, size_t pos, size_t end) {
+    while (pos < end && (data[pos] == ' ' || data[pos] == '\t')) {
+        ++pos;
+    }
+    return pos;
+}
+
+bool StartsWithNoCase(const char *data, size_t pos, size_t end, const char *prefix) {
+    const size_t length = std::strlen(prefix);
+    if (end - pos < length) return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(data[pos + i])) !=
+            std::tolower(static_cast<unsigned char>(prefix[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mirrors libass' string2timecode(): H:MM:SS.CC, centisecond precision.
+bool ParseTimecode(const char *data, size_t pos, size_t end, long long *out_ms) {
+    long long parts[4] = {0, 0, 0, 0};
+    int index = 0;
+    bool has_digit = false;
+    pos = SkipSpaces(data, pos, end);
+    for (; pos < end && index < 4; ++pos) {
+        const char c = data[pos];
+        if (c >= '0' && c <= '9') {
+            parts[index] = parts[index] * 10 + (c - '0');
+            has_digit = true;
+        } else if ((c == ':' && index < 2) || (c == '.' && index == 2)) {
+            ++index;
+        } else {
+            break;
+        }
+    }
+    if (!has_digit || index < 2) return false;
+    *out_ms = parts[0] * 3600000LL + parts[1] * 60000LL + parts[2] * 1000LL + parts[3] * 10LL;
+    return true;
+}
+
+void AppendLine(std::string &out, const char *data, const LineView &line) {
+    out.append(data + line.begin, line.end - line.begin);
+    out.push_back('\n');
+}
+}  // namespace
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string &path) {
+    Close();
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(mapped);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+AssStreamLoader::~AssStreamLoader() {
+    Cancel();
+}
+
+std::unique_ptr<AssStreamLoader> AssStreamLoader::Open(ASS_Library *library, const std::string &path) {
+    if (library == nullptr || path.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<AssStreamLoader> loader(new AssStreamLoader());
+    if (!loader->file_.Open(path)) {
+        __android_log_print(ANDROID_LOG_ERROR, kLoaderLogTag, "mmap failed: %s", path.c_str());
+        return nullptr;
+    }
+    if (loader->file_.size() > std::numeric_limits<uint32_t>::max() || !loader->ParseHeader(library)) {
+        return nullptr;
+    }
+    return loader;
+}
+
+bool SplitAssScript(const char *data, size_t size, AssScriptLayout *out) {
+    if (data == nullptr || out == nullptr) {
+        return false;
+    }
+    size_t pos = 0;
+    if (size >= 3 && std::memcmp(data, "\xef\xbb\xbf", 3) == 0) {
+        pos = 3;
+    }
+
+    enum class Phase { kBeforeEvents, kEventsPreamble, kEventsBody, kAfterEvents };
+    Phase phase = Phase::kBeforeEvents;
+    // Sections that follow [Events] (usually [Fonts]/[Graphics]) are emitted before the
+    // events preamble, so the parser state is left in [Events] for the streamed lines.
+    std::string prefix;
+    std::string suffix;
+    std::string events_preamble;
+    out->events_begin = size;
+    out->events_end = size;
+
+    LineView line;
+    while (NextLine(data, size, pos, &line)) {
+        pos = line.next;
+        const size_t text = SkipSpaces(data, line.begin, line.end);
+        const bool is_section = text < line.end && data[text] == '[';
+        switch (phase) {
+            case Phase::kBeforeEvents:
+                if (is_section && StartsWithNoCase(data, text, line.end, "[Events]")) {
+                    phase = Phase::kEventsPreamble;
+                    AppendLine(events_preamble, data, line);
+                } else {
+                    AppendLine(prefix, data, line);
+                }
+                break;
+            case Phase::kEventsPreamble:
+                if (is_section) {
+                    phase = Phase::kAfterEvents;
+                    AppendLine(suffix, data, line);
+                } else if (StartsWithNoCase(data, text, line.end, "Dialogue:") ||
+                           StartsWithNoCase(data, text, line.end, "Comment:")) {
+                    phase = Phase::kEventsBody;
+                    out->events_begin = line.begin;
+                } else {
+                    AppendLine(events_preamble, data, line);
+                    if (StartsWithNoCase(data, text, line.end, "Format:")) {
+                        int field = 0;
+                        size_t cursor = text + 7;
+                        while (cursor <= line.end) {
+                            const char *comma = static_cast<const char *>(
+                                std::memchr(data + cursor, ',', line.end - cursor));
+                            const size_t field_end = comma == nullptr ? line.end
+                                                                      : static_cast<size_t>(comma - data);
+                            const size_t name = SkipSpaces(data, cursor, field_end);
+                            if (StartsWithNoCase(data, name, field_end, "Start")) out->start_field = field;
+                            if (StartsWithNoCase(data, name, field_end, "End")) out->end_field = field;
+                            ++field;
+                            cursor = field_end + 1;
+                        }
+                    }
+                }
+                break;
+            case Phase::kEventsBody:
+                if (is_section) {
+                    phase = Phase::kAfterEvents;
+                    out->events_end = line.begin;
+                    AppendLine(suffix, data, line);
+                }
+                break;
+            case Phase::kAfterEvents:
+                AppendLine(suffix, data, line);
+                break;
+        }
+    }
+
+    out->header.clear();
+    out->header.reserve(prefix.size() + suffix.size() + events_preamble.size());
+    out->header.append(prefix).append(suffix).append(events_preamble);
+    return true;
+}
+
+bool AssStreamLoader::ParseHeader(ASS_Library *library) {
+    if (!SplitAssScript(file_.data(), file_.size(), &layout_)) {
+        return false;
+    }
+    track_ = ass_new_track(library);
+    if (track_ == nullptr) {
+        return false;
+    }
+    ass_process_data(track_, layout_.header.data(), static_cast<int>(layout_.header.size()));
+    if (track_->track_type == ASS_Track::TRACK_TYPE_UNKNOWN) {
+        __android_log_print(ANDROID_LOG_ERROR, kLoaderLogTag, "Unknown subtitle track type");
+        ass_free_track(track_);
+        track_ = nullptr;
+        return false;
+    }
+    // ass_read_memory() applies the library's style overrides after parsing; ass_process_data()
+    // does not, so apply them here before any event references the styles.
+    ass_process_force_style(track_);
+    return true;
+}
+
+void AssStreamLoader::Start(std::mutex *track_mutex, long long position_hint_ms, ChunkCallback on_chunk,
+                            CompleteCallback on_complete) {
+    position_hint_ms_.store(position_hint_ms);
+    worker_ = std::thread([this, track_mutex, on_chunk = std::move(on_chunk),
+                           on_complete = std::move(on_complete)]() {
+        pthread_setname_np(pthread_self(), "AssStreamLoad");
+        setpriority(PRIO_PROCESS, 0, kLoaderThreadNice);
+        Run(track_mutex, on_chunk, on_complete);
+    });
+}
+
+void AssStreamLoader::Cancel() {
+    cancelled_.store(true);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void AssStreamLoader::IndexEvents() {
+    const char *data = file_.data();
+    int read_order = 0;
+    size_t pos = layout_.events_begin;
+    LineView line;
+    while (pos < layout_.events_end && NextLine(data, layout_.events_end, pos, &line)) {
+        pos = line.next;
+        const size_t text = SkipSpaces(data, line.begin, line.end);
+        if (!StartsWithNoCase(data, text, line.end, "Dialogue:")) {
+            continue;
+        }
+        EventLine event;
+        event.offset = static_cast<uint32_t>(line.begin);
+        event.length = static_cast<uint32_t>(line.end - line.begin);
+        event.read_order = read_order++;
+        int field = 0;
+        size_t cursor = text + 9;
+        while (cursor < line.end && field <= std::max(layout_.start_field, layout_.end_field)) {
+            const char *comma =
+                static_cast<const char *>(std::memchr(data + cursor, ',', line.end - cursor));
+            const size_t field_end = comma == nullptr ? line.end : static_cast<size_t>(comma - data);
+            if (field == layout_.start_field) ParseTimecode(data, cursor, field_end, &event.start_ms);
+            if (field == layout_.end_field) ParseTimecode(data, cursor, field_end, &event.end_ms);
+            ++field;
+            cursor = field_end + 1;
+        }
+        events_.push_back(event);
+        if ((read_order & 0x3FF) == 0 && cancelled_.load()) {
+            return;
+        }
+    }
+    std::stable_sort(events_.begin(), events_.end(), [](const EventLine &a, const EventLine &b) {
+        return a.start_ms < b.start_ms;
+    });
+    for (size_t begin = 0; begin < events_.size(); begin += kEventsPerChunk) {
+        chunks_.push_back({begin, std::min(begin + kEventsPerChunk, events_.size()), false});
+    }
+}
+
+size_t AssStreamLoader::PickNextChunk(long long position_ms) const {
+    // Chunk holding the playback position first, then forward chunks; earlier chunks
+    // are weighted twice as far since playback rarely moves backwards.
+    size_t anchor = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        if (events_[chunks_[i].begin].start_ms > position_ms) break;
+        anchor = i;
+    }
+    size_t best = chunks_.size();
+    size_t best_distance = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        if (chunks_[i].done) continue;
+        const size_t distance = i >= anchor ? i - anchor : (anchor - i) * 2;
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void AssStreamLoader::AppendChunk(const Chunk &chunk, std::string &scratch) {
+    const char *data = file_.data();
+    scratch.clear();
+    for (size_t i = chunk.begin; i < chunk.end; ++i) {
+        const EventLine &event = events_[i];
+        scratch.append(data + event.offset, event.length);
+        scratch.push_back('\n');
+    }
+    const int first_new = track_->n_events;
+    ass_process_data(track_, scratch.data(), static_cast<int>(scratch.size()));
+    // External scripts carry no ReadOrder column; libass' own file loader assigns the
+    // file position after parsing, which keeps same-layer collision order stable.
+    // If libass rejected some lines, realign on the start time instead of the index.
+    const bool exact = static_cast<size_t>(track_->n_events - first_new) == chunk.end - chunk.begin;
+    size_t cursor = chunk.begin;
+    for (int eid = first_new; eid < track_->n_events && cursor < chunk.end; ++eid) {
+        ASS_Event &parsed = track_->events[eid];
+        while (!exact && cursor + 1 < chunk.end && events_[cursor].start_ms != parsed.Start) {
+            ++cursor;
+        }
+        parsed.ReadOrder = events_[cursor].read_order;
+        ++cursor;
+    }
+}
+
+void AssStreamLoader::Run(std::mutex *track_mutex, const ChunkCallback &on_chunk,
+                          const CompleteCallback &on_complete) {
+    const auto started = std::chrono::steady_clock::now();
+    IndexEvents();
+    std::string scratch;
+    size_t appended = 0;
+    while (!cancelled_.load() && appended < chunks_.size()) {
+        const size_t next = PickNextChunk(position_hint_ms_.load());
+        if (next >= chunks_.size()) break;
+        Chunk &chunk = chunks_[next];
+        long long first_start = events_[chunk.begin].start_ms;
+        long long last_end = first_start;
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            last_end = std::max(last_end, events_[i].end_ms);
+        }
+        {
+            std::lock_guard<std::mutex> guard(*track_mutex);
+            if (cancelled_.load()) break;
+            const int first_event = track_->n_events;
+            AppendChunk(chunk, scratch);
+            if (on_chunk) {
+                on_chunk(first_event, track_->n_events, first_start, last_end);
+            }
+        }
+        chunk.done = true;
+        ++appended;
+    }
+    if (!cancelled_.load()) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - started)
+                                 .count();
+        __android_log_print(ANDROID_LOG_INFO, kLoaderLogTag,
+                            "Streamed %zu events in %zu chunks (%zu bytes) in %lld ms",
+                            events_.size(), chunks_.size(), file_.size(),
+                            static_cast<long long>(elapsed));
+    }
+    const bool finished = !cancelled_.load();
+    events_.clear();
+    events_.shrink_to_fit();
+    chunks_.clear();
+    file_.Close();
+    if (finished) {
+        complete_.store(true);
+        if (on_complete) {
+            on_complete();
+        }
+    }
+}
+
+}  // namespace ass_gpu
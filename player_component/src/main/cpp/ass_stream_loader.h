@@ -0,0 +1,125 @@
+#pragma once
+
+#include <ass/ass.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ass_gpu {
+
+/**
+ * Read-only mmap of a subtitle file. Pages are released on destruction.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * An ASS/SSA script split into its non-event part and the byte range of the
+ * [Events] body. The header holds every other section plus the [Events]
+ * preamble (Format line), ordered so that feeding it to ass_process_data()
+ * leaves the parser ready for Dialogue lines.
+ */
+struct AssScriptLayout {
+    std::string header;
+    size_t events_begin = 0;
+    size_t events_end = 0;
+    int start_field = 1;
+    int end_field = 2;
+};
+
+bool SplitAssScript(const char *data, size_t size, AssScriptLayout *out);
+
+/**
+ * Loads an external ASS/SSA file without blocking the render thread on the
+ * whole [Events] section.
+ *
+ * Open() mmaps the file and feeds every non-event section (script info,
+ * styles, fonts) plus the event Format line into a fresh track synchronously,
+ * so the track is renderable immediately. Start() then parses Dialogue lines
+ * on a background thread and appends them with ass_process_data() in
+ * time-sorted chunks, always picking the pending chunk closest to the last
+ * playback position hint first.
+ *
+ * The track is shared with the renderer; every append happens under the
+ * caller-provided mutex. Cancel() must be called (without holding that mutex)
+ * before the track is freed.
+ */
+class AssStreamLoader {
+public:
+    // Runs with the track mutex held; [first_event, end_event) are the event ids just appended.
+    using ChunkCallback =
+        std::function<void(int first_event, int end_event, long long first_start_ms, long long last_end_ms)>;
+    // Runs on the loader thread after the last chunk, without the track mutex held.
+    using CompleteCallback = std::function<void()>;
+
+    ~AssStreamLoader();
+
+    static std::unique_ptr<AssStreamLoader> Open(ASS_Library *library, const std::string &path);
+
+    ASS_Track *track() const { return track_; }
+    size_t file_size() const { return file_.size(); }
+    const std::string &header() const { return layout_.header; }
+
+    void Start(std::mutex *track_mutex, long long position_hint_ms, ChunkCallback on_chunk,
+               CompleteCallback on_complete = nullptr);
+    void UpdatePositionHint(long long position_ms) { position_hint_ms_.store(position_ms); }
+    void Cancel();
+    bool complete() const { return complete_.load(); }
+
+private:
+    struct EventLine {
+        long long start_ms = 0;
+        long long end_ms = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        int read_order = 0;
+    };
+    struct Chunk {
+        size_t begin = 0;
+        size_t end = 0;
+        bool done = false;
+    };
+
+    AssStreamLoader() = default;
+
+    bool ParseHeader(ASS_Library *library);
+    void Run(std::mutex *track_mutex, const ChunkCallback &on_chunk, const CompleteCallback &on_complete);
+    void IndexEvents();
+    size_t PickNextChunk(long long position_ms) const;
+    void AppendChunk(const Chunk &chunk, std::string &scratch);
+
+    MappedFile file_;
+    ASS_Track *track_ = nullptr;
+    AssScriptLayout layout_;
+    std::vector<EventLine> events_;
+    std::vector<Chunk> chunks_;
+    std::thread worker_;
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> complete_{false};
+    std::atomic<long long> position_hint_ms_{0};
+};
+
+}  // namespace ass_gpu
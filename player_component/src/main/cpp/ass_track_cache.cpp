@@ -0,0 +1,319 @@
+#include "ass_track_cache.h"
+
+#include "hash64.h"
+
+#include <android/log.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace ass_gpu {
+namespace {
+constexpr const char *kCacheLogTag = "AssTrackCache";
+constexpr const char *kCacheSuffix = ".asstrk";
+constexpr char kCacheMagic[8] = {'D', 'D', 'A', 'S', 'S', 'T', 'R', 'K'};
+constexpr uint32_t kCacheFormatVersion = 1;
+constexpr size_t kKeyCapacity = 48;
+
+struct CacheFileHeader {
+    char magic[8];
+    uint32_t format_version;
+    int32_t libass_version;
+    char key[kKeyCapacity];
+    uint64_t header_bytes;
+    uint64_t event_count;
+    uint64_t string_bytes;
+};
+
+struct CachedEvent {
+    int64_t start;
+    int64_t duration;
+    int32_t read_order;
+    int32_t layer;
+    int32_t style;
+    int32_t margin_l;
+    int32_t margin_r;
+    int32_t margin_v;
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint32_t effect_offset;
+    uint32_t effect_length;
+    uint32_t text_offset;
+    uint32_t text_length;
+};
+
+constexpr size_t AlignUp(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// The key as it appears in the file name and the entry header. Keys that do not fit the
+// header (a long converter id appended to TrackCacheKey()) are replaced by their hash.
+std::string StoredKey(const std::string &key) {
+    if (key.size() < kKeyCapacity) {
+        return key;
+    }
+    char hashed[kKeyCapacity];
+    std::snprintf(hashed, sizeof(hashed), "h%016llx%016llx",
+                  static_cast<unsigned long long>(hash64::Hash64(key.data(), key.size())),
+                  static_cast<unsigned long long>(hash64::Hash64(key.data(), key.size(), 1)));
+    return hashed;
+}
+
+std::string EntryPath(const TrackCacheConfig &config, const std::string &key) {
+    return config.directory + "/" + StoredKey(key) + kCacheSuffix;
+}
+
+char *CopyString(const char *data, uint32_t length) {
+    auto *copy = static_cast<char *>(std::malloc(length + 1));
+    if (copy != nullptr) {
+        std::memcpy(copy, data, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+void AppendString(std::string &pool, const char *value, uint32_t *offset, uint32_t *length) {
+    const size_t size = value == nullptr ? 0 : std::strlen(value);
+    *offset = static_cast<uint32_t>(pool.size());
+    *length = static_cast<uint32_t>(size);
+    if (size > 0) {
+        pool.append(value, size);
+    }
+}
+
+void EvictEntries(const TrackCacheConfig &config) {
+    struct Entry {
+        std::string path;
+        long long bytes = 0;
+        long long mtime_ns = 0;
+    };
+    DIR *dir = opendir(config.directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    std::vector<Entry> entries;
+    long long total_bytes = 0;
+    const size_t suffix_length = std::strlen(kCacheSuffix);
+    while (dirent *item = readdir(dir)) {
+        const size_t name_length = std::strlen(item->d_name);
+        if (name_length <= suffix_length ||
+            std::strcmp(item->d_name + name_length - suffix_length, kCacheSuffix) != 0) {
+            continue;
+        }
+        Entry entry;
+        entry.path = config.directory + "/" + item->d_name;
+        struct stat st {};
+        if (stat(entry.path.c_str(), &st) != 0) {
+            continue;
+        }
+        entry.bytes = static_cast<long long>(st.st_size);
+        entry.mtime_ns = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        total_bytes += entry.bytes;
+        entries.push_back(std::move(entry));
+    }
+    closedir(dir);
+    // LRU entries get their mtime refreshed on every hit; oldest-first ones keep the write time.
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.mtime_ns < b.mtime_ns; });
+    size_t remaining = entries.size();
+    for (const auto &entry : entries) {
+        if (total_bytes <= config.max_bytes && remaining <= static_cast<size_t>(config.max_entries)) {
+            break;
+        }
+        if (unlink(entry.path.c_str()) == 0) {
+            total_bytes -= entry.bytes;
+            --remaining;
+        }
+    }
+}
+}  // namespace
+
+std::string TrackCacheKey(const char *data, size_t size) {
+    char key[kKeyCapacity];
+    std::snprintf(key, sizeof(key), "%016llx-%llx-%x",
+                  static_cast<unsigned long long>(hash64::Hash64(data, size)),
+                  static_cast<unsigned long long>(size),
+                  static_cast<unsigned>(ass_library_version()));
+    return key;
+}
+
+bool OpenCachedTrack(const TrackCacheConfig &config, const std::string &key, CachedTrackEntry *entry) {
+    if (!config.enabled() || key.empty() || entry == nullptr) {
+        return false;
+    }
+    const std::string path = EntryPath(config, key);
+    if (!entry->file.Open(path)) {
+        return false;
+    }
+    CacheFileHeader header {};
+    if (entry->file.size() < sizeof(header)) {
+        entry->file.Close();
+        unlink(path.c_str());
+        return false;
+    }
+    std::memcpy(&header, entry->file.data(), sizeof(header));
+    if (header.header_bytes > entry->file.size() || header.event_count > entry->file.size() ||
+        header.string_bytes > entry->file.size()) {
+        entry->file.Close();
+        unlink(path.c_str());
+        return false;
+    }
+    const size_t events_offset = AlignUp(sizeof(header) + header.header_bytes);
+    const size_t strings_offset = events_offset + header.event_count * sizeof(CachedEvent);
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.format_version != kCacheFormatVersion ||
+        header.libass_version != ass_library_version() ||
+        std::strncmp(header.key, StoredKey(key).c_str(), sizeof(header.key)) != 0 ||
+        header.event_count > static_cast<uint64_t>(INT32_MAX) ||
+        strings_offset + header.string_bytes != entry->file.size()) {
+        __android_log_print(ANDROID_LOG_WARN, kCacheLogTag, "Dropping stale cache entry %s", key.c_str());
+        entry->file.Close();
+        unlink(path.c_str());
+        return false;
+    }
+    entry->path = path;
+    entry->header_bytes = static_cast<size_t>(header.header_bytes);
+    entry->events_offset = events_offset;
+    entry->event_count = static_cast<size_t>(header.event_count);
+    entry->strings_offset = strings_offset;
+    entry->string_bytes = static_cast<size_t>(header.string_bytes);
+    if (config.eviction == TrackCacheEviction::kLeastRecentlyUsed) {
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    }
+    return true;
+}
+
+ASS_Track *RestoreCachedTrack(ASS_Library *library, CachedTrackEntry *entry) {
+    if (library == nullptr || entry == nullptr || entry->file.data() == nullptr) {
+        return nullptr;
+    }
+    const char *data = entry->file.data();
+    ASS_Track *track = ass_new_track(library);
+    if (track == nullptr) {
+        return nullptr;
+    }
+    ass_process_data(track, const_cast<char *>(data + sizeof(CacheFileHeader)),
+                     static_cast<int>(entry->header_bytes));
+    if (track->track_type == ASS_Track::TRACK_TYPE_UNKNOWN) {
+        ass_free_track(track);
+        return nullptr;
+    }
+    // Same as the uncached loads: style overrides are applied once the header is in.
+    ass_process_force_style(track);
+    const char *strings = data + entry->strings_offset;
+    for (size_t i = 0; i < entry->event_count; ++i) {
+        CachedEvent cached {};
+        std::memcpy(&cached, data + entry->events_offset + i * sizeof(CachedEvent), sizeof(cached));
+        if (static_cast<uint64_t>(cached.text_offset) + cached.text_length > entry->string_bytes ||
+            static_cast<uint64_t>(cached.name_offset) + cached.name_length > entry->string_bytes ||
+            static_cast<uint64_t>(cached.effect_offset) + cached.effect_length > entry->string_bytes ||
+            cached.style < 0 || cached.style >= track->n_styles) {
+            __android_log_print(ANDROID_LOG_WARN, kCacheLogTag, "Corrupt cache entry %s", entry->path.c_str());
+            ass_free_track(track);
+            entry->file.Close();
+            unlink(entry->path.c_str());
+            return nullptr;
+        }
+        const int eid = ass_alloc_event(track);
+        if (eid < 0) {
+            ass_free_track(track);
+            return nullptr;
+        }
+        ASS_Event &event = track->events[eid];
+        event.Start = cached.start;
+        event.Duration = cached.duration;
+        event.ReadOrder = cached.read_order;
+        event.Layer = cached.layer;
+        event.Style = cached.style;
+        event.MarginL = cached.margin_l;
+        event.MarginR = cached.margin_r;
+        event.MarginV = cached.margin_v;
+        event.Name = CopyString(strings + cached.name_offset, cached.name_length);
+        event.Effect = CopyString(strings + cached.effect_offset, cached.effect_length);
+        event.Text = CopyString(strings + cached.text_offset, cached.text_length);
+    }
+    return track;
+}
+
+std::string SerializeTrack(const ASS_Track *track, const std::string &header, const std::string &key) {
+    std::string blob;
+    if (track == nullptr || key.empty()) {
+        return blob;
+    }
+    std::string pool;
+    std::vector<CachedEvent> events(static_cast<size_t>(track->n_events));
+    for (int i = 0; i < track->n_events; ++i) {
+        const ASS_Event &source = track->events[i];
+        CachedEvent &cached = events[static_cast<size_t>(i)];
+        cached.start = source.Start;
+        cached.duration = source.Duration;
+        cached.read_order = source.ReadOrder;
+        cached.layer = source.Layer;
+        cached.style = source.Style;
+        cached.margin_l = source.MarginL;
+        cached.margin_r = source.MarginR;
+        cached.margin_v = source.MarginV;
+        AppendString(pool, source.Name, &cached.name_offset, &cached.name_length);
+        AppendString(pool, source.Effect, &cached.effect_offset, &cached.effect_length);
+        AppendString(pool, source.Text, &cached.text_offset, &cached.text_length);
+    }
+
+    CacheFileHeader file_header {};
+    std::memcpy(file_header.magic, kCacheMagic, sizeof(kCacheMagic));
+    file_header.format_version = kCacheFormatVersion;
+    file_header.libass_version = ass_library_version();
+    std::strncpy(file_header.key, StoredKey(key).c_str(), sizeof(file_header.key) - 1);
+    file_header.header_bytes = header.size();
+    file_header.event_count = events.size();
+    file_header.string_bytes = pool.size();
+
+    const size_t events_offset = AlignUp(sizeof(file_header) + header.size());
+    blob.reserve(events_offset + events.size() * sizeof(CachedEvent) + pool.size());
+    blob.append(reinterpret_cast<const char *>(&file_header), sizeof(file_header));
+    blob.append(header);
+    blob.resize(events_offset, '\0');
+    blob.append(reinterpret_cast<const char *>(events.data()), events.size() * sizeof(CachedEvent));
+    blob.append(pool);
+    return blob;
+}
+
+void StoreCachedTrack(const TrackCacheConfig &config, const std::string &key, const std::string &blob) {
+    if (!config.enabled() || key.empty() || blob.empty()) {
+        return;
+    }
+    if (static_cast<long long>(blob.size()) > config.max_bytes) {
+        return;
+    }
+    const std::string path = EntryPath(config, key);
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%d.tmp", static_cast<int>(gettid()));
+    const std::string tmp_path = path + suffix;
+    const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_WARN, kCacheLogTag, "Cannot create %s", tmp_path.c_str());
+        return;
+    }
+    size_t written = 0;
+    while (written < blob.size()) {
+        const ssize_t result = write(fd, blob.data() + written, blob.size() - written);
+        if (result <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(result);
+    }
+    close(fd);
+    if (written != blob.size() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return;
+    }
+    EvictEntries(config);
+}
+
+}  // namespace ass_gpu
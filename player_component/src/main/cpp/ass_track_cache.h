@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ass/ass.h>
+
+#include "ass_stream_loader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ass_gpu {
+
+enum class TrackCacheEviction : int {
+    kLeastRecentlyUsed = 0,
+    kOldestFirst = 1,
+};
+
+struct TrackCacheConfig {
+    std::string directory;
+    long long max_bytes = 0;
+    int max_entries = 0;
+    TrackCacheEviction eviction = TrackCacheEviction::kLeastRecentlyUsed;
+
+    bool enabled() const { return !directory.empty() && max_bytes > 0 && max_entries > 0; }
+};
+
+/**
+ * Binary cache of parsed external subtitle tracks.
+ *
+ * An entry is keyed by a hash of the subtitle bytes plus the libass version
+ * and stores the script header (script info, styles, embedded fonts; replayed
+ * through ass_process_data(), which is cheap) followed by a flat event table
+ * and string pool, so restoring skips Dialogue parsing entirely.
+ *
+ * Event text is stored as one string with its override blocks in place rather
+ * than pre-split into tags: ass_render_frame() tokenizes Text itself and
+ * libass has no entry point that accepts parsed tags, so a split copy would
+ * only be converted back on restore.
+ */
+std::string TrackCacheKey(const char *data, size_t size);
+
+// A mapped and validated cache entry, see OpenCachedTrack().
+struct CachedTrackEntry {
+    MappedFile file;
+    std::string path;
+    size_t header_bytes = 0;
+    size_t events_offset = 0;
+    size_t event_count = 0;
+    size_t strings_offset = 0;
+    size_t string_bytes = 0;
+};
+
+// Maps the entry for `key` and checks its header; only file I/O, no libass calls, so it needs
+// no lock. Returns false on miss or when the entry is stale (the entry is then removed).
+bool OpenCachedTrack(const TrackCacheConfig &config, const std::string &key, CachedTrackEntry *entry);
+
+// Builds a track from an opened entry. Replaying the header adds embedded fonts to `library`,
+// so this must run under the lock that guards ass_render_frame() on the same library.
+// Returns nullptr when the entry is corrupt (the entry is then removed).
+ASS_Track *RestoreCachedTrack(ASS_Library *library, CachedTrackEntry *entry);
+
+// Must be called with the track mutex held; only copies bytes, no I/O.
+std::string SerializeTrack(const ASS_Track *track, const std::string &header, const std::string &key);
+
+// Writes atomically (tmp + rename) and applies the eviction policy. Safe from any thread.
+void StoreCachedTrack(const TrackCacheConfig &config, const std::string &key, const std::string &blob);
+
+}  // namespace ass_gpu
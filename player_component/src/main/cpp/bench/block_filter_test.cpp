@@ -0,0 +1,118 @@
+// Checks danmaku::BlockFilter (Aho-Corasick over UTF-8 bytes) against the plain substring
+// search that DanmakuBlockMatcher.kt falls back to when the native library is missing.
+//
+//   cmake -S player_component/src/main/cpp -B build/danmaku-bench -DDANMAKU_HOST_BENCH=ON
+//   cmake --build build/danmaku-bench
+//   build/danmaku-bench/block_filter_test [seed]
+//   ctest --test-dir build/danmaku-bench
+//
+// Keywords and regex literals are drawn from a small alphabet mixing ASCII and CJK, so
+// patterns overlap, nest and share prefixes (the failure-link cases), and every comment text
+// is matched both one by one (Match) and through Scan with one and several threads. Exits
+// non-zero on the first differences.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../danmaku_filter.h"
+#include "../danmaku_store.h"
+
+namespace {
+
+constexpr int kRounds = 200;
+constexpr int kTextsPerRound = 300;
+
+const char *const kAlphabet[] = {"a", "b", "ab", "前", "方", "高能", "哈", "2", "3"};
+
+int failures = 0;
+
+void Expect(bool condition, const std::string &what) {
+    if (!condition && failures++ < 20) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+std::string RandomString(std::mt19937 &random, int max_pieces) {
+    std::uniform_int_distribution<int> pieces(1, max_pieces);
+    std::uniform_int_distribution<size_t> letter(0, std::size(kAlphabet) - 1);
+    std::string text;
+    for (int i = pieces(random); i > 0; --i) {
+        text += kAlphabet[letter(random)];
+    }
+    return text;
+}
+
+bool ContainsAny(const std::string &text, const std::vector<std::string> &patterns) {
+    for (const std::string &pattern : patterns) {
+        // Same rule as the Kotlin side: empty rules are dropped before matching.
+        if (!pattern.empty() && text.find(pattern) != std::string::npos) return true;
+    }
+    return false;
+}
+
+// What DanmakuBlockMatcher.match computes without the native library, before the regex check.
+uint32_t ReferenceMatch(const std::string &text, const std::vector<std::string> &keywords,
+                        const std::vector<std::string> &literals) {
+    if (ContainsAny(text, keywords)) return danmaku::BlockFilter::kMatchKeyword;
+    if (ContainsAny(text, literals)) return danmaku::BlockFilter::kMatchRegexLiteral;
+    return 0;
+}
+
+void CheckRound(std::mt19937 &random, int round) {
+    std::uniform_int_distribution<int> list_size(0, 6);
+    std::vector<std::string> keywords(list_size(random));
+    std::vector<std::string> literals(list_size(random));
+    for (std::string &keyword : keywords) keyword = RandomString(random, 3);
+    for (std::string &literal : literals) literal = RandomString(random, 3);
+    if (!keywords.empty() && round % 7 == 0) keywords.front().clear();
+
+    const danmaku::BlockFilter filter(keywords, literals);
+    danmaku::CommentStoreBuilder builder;
+    std::uniform_int_distribution<int> time(0, 600000);
+    for (int i = 0; i < kTextsPerRound; ++i) {
+        builder.Add(time(random), 1, 25, 0xFFFFFF, RandomString(random, 12));
+    }
+    const auto store = builder.Finish();
+    const size_t words = (store->count() + 63) / 64;
+
+    std::vector<uint32_t> expected(store->count());
+    for (uint32_t row = 0; row < store->count(); ++row) {
+        const std::string text(store->text(row));
+        expected[row] = ReferenceMatch(text, keywords, literals);
+        Expect(filter.Match(text) == expected[row],
+               "round " + std::to_string(round) + " Match(\"" + text + "\")");
+    }
+    for (const int threads : {1, 3}) {
+        std::vector<uint64_t> keyword_mask(words, ~uint64_t{0});
+        std::vector<uint64_t> literal_mask(words, ~uint64_t{0});
+        filter.Scan(*store, threads, keyword_mask.data(), literal_mask.data());
+        for (uint32_t row = 0; row < store->count(); ++row) {
+            const uint64_t bit = uint64_t{1} << (row & 63);
+            const bool keyword = (keyword_mask[row >> 6] & bit) != 0;
+            const bool literal = (literal_mask[row >> 6] & bit) != 0;
+            Expect(keyword == (expected[row] == danmaku::BlockFilter::kMatchKeyword) &&
+                       literal == (expected[row] == danmaku::BlockFilter::kMatchRegexLiteral),
+                   "round " + std::to_string(round) + " Scan(threads=" + std::to_string(threads) + ") row " +
+                       std::to_string(row));
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const unsigned seed = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 20240611u;
+    std::mt19937 random(seed);
+    for (int round = 0; round < kRounds; ++round) {
+        CheckRound(random, round);
+    }
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed (seed %u)\n", failures, seed);
+        return 1;
+    }
+    std::printf("seed %u: %d rounds of %d texts agree with the substring search\n", seed, kRounds, kTextsPerRound);
+    return 0;
+}
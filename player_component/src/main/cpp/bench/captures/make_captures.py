@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Writes the live danmaku captures replayed by live_replay.
+
+Each capture is a sequence of websocket binary messages, every one stored as a
+u32 big-endian length followed by the message bytes exactly as the server
+frames them. The messages are synthesized in the wire format of the bilibili
+live stream (16-byte big-endian headers, protover 2 zlib and protover 3 brotli
+bundles, DANMU_MSG bodies shaped like the ones the web client receives), and
+the matching .expected dump is written from the same source events, so the
+check does not depend on the decoder under test.
+
+Brotli goes through libbrotlienc with ctypes; the captures are regenerated with
+
+    python3 make_captures.py
+"""
+
+import ctypes
+import ctypes.util
+import json
+import os
+import struct
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+OP_HEARTBEAT_REPLY = 3
+OP_COMMAND = 5
+OP_AUTH_REPLY = 8
+
+
+def frame(operation, protocol, body, sequence=0):
+    return struct.pack(">IHHII", 16 + len(body), 16, protocol, operation, sequence) + body
+
+
+def brotli(data):
+    lib = ctypes.CDLL(ctypes.util.find_library("brotlienc") or "libbrotlienc.so.1")
+    lib.BrotliEncoderMaxCompressedSize.restype = ctypes.c_size_t
+    lib.BrotliEncoderMaxCompressedSize.argtypes = [ctypes.c_size_t]
+    lib.BrotliEncoderCompress.argtypes = [
+        ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_char_p,
+        ctypes.POINTER(ctypes.c_size_t), ctypes.c_char_p,
+    ]
+    size = ctypes.c_size_t(lib.BrotliEncoderMaxCompressedSize(len(data)) + 64)
+    out = ctypes.create_string_buffer(size.value)
+    # quality 11, 4 MB window, generic mode
+    if not lib.BrotliEncoderCompress(11, 22, 0, len(data), data, ctypes.byref(size), out):
+        raise RuntimeError("brotli compression failed")
+    return out.raw[: size.value]
+
+
+class Comment:
+    def __init__(self, text, uid, name, mode=1, size=25, color=0xFFFFFF, timestamp=1718000000000, score=0,
+                 extra=True, info_first=False, ascii_json=True):
+        self.text = text
+        self.uid = uid
+        self.name = name
+        self.mode = mode
+        self.size = size
+        self.color = color
+        self.timestamp = timestamp
+        self.score = score
+        self.extra = extra
+        self.info_first = info_first
+        self.ascii_json = ascii_json
+
+    def body(self):
+        extra = {
+            "send_from_me": False,
+            "mode": 0,
+            "color": self.color,
+            "dm_type": 0,
+            "font_size": self.size,
+            "player_mode": 1,
+            "show_player_type": 0,
+            "content": self.text,
+            "user_hash": "2451305923",
+            "emoticon_unique": "",
+            "bulge_display": 0,
+            "recommend_score": self.score,
+            "main_state_dm_color": "",
+            "objective_state_dm_color": "",
+            "direction": 0,
+            "pk_direction": 0,
+            "quartet_direction": 0,
+            "anniversary_crowd": 0,
+            "yeah_space_type": "",
+            "yeah_space_url": "",
+            "jump_to_url": "",
+            "space_type": "",
+            "space_url": "",
+            "animation": {},
+            "emots": None,
+            "is_audited": False,
+            "id_str": "f1c2a0b6e4d54f0a8e8f",
+            "icon": None,
+            "show_reply": True,
+            "reply_mid": 0,
+            "reply_uname": "",
+            "reply_uname_color": "",
+            "reply_is_mystery": False,
+            "hit_combo": 0,
+        }
+        head = [0, self.mode, self.size, self.color, self.timestamp, 1718000000, 0, "a0b1c2d3", 0, 0, 0, "",
+                0, "{}", "{}"]
+        if self.extra:
+            head.append({"mode": 0, "show_player_type": 0, "extra": json.dumps(extra, ensure_ascii=self.ascii_json)})
+        head.append({"activity_identity": "", "activity_source": 0, "not_show": 0})
+        head.append(0)
+        info = [
+            head,
+            self.text,
+            [self.uid, self.name, 0, 0, 0, 10000, 1, ""],
+            [21, "粉丝团", "主播", 22637261, 1725515, "", 0, 6809855, 1725515, 5414290, 0, 1, 1405289],
+            [0, 0, 9868950, ">50000", 0],
+            ["", ""],
+            0,
+            0,
+            None,
+            {"ts": self.timestamp // 1000, "ct": "8A1F3C52"},
+            0,
+            0,
+            None,
+            None,
+            0,
+            105,
+            [3],
+            None,
+        ]
+        if self.info_first:
+            root = {"info": info, "dm_v2": "", "cmd": "DANMU_MSG"}
+        else:
+            root = {"cmd": "DANMU_MSG:4:0:2:2:2:0", "info": info, "dm_v2": ""}
+        return json.dumps(root, ensure_ascii=self.ascii_json, separators=(",", ":")).encode("utf-8")
+
+    def expected(self):
+        mode = self.mode if self.mode in (4, 5) else 1
+        text = self.text.replace("\\", "\\\\").replace("\n", "\\n")
+        return "comment uid=%d name=%s mode=%d size=%d color=%06x ts=%d score=%d text=%s" % (
+            self.uid, self.name, mode, min(max(self.size, 0), 255), self.color & 0xFFFFFF,
+            max(self.timestamp, 0), min(max(self.score if self.extra else 0, 0), 255), text)
+
+
+def other_command(cmd):
+    return json.dumps({"cmd": cmd, "data": {"uid": 1, "uname": "x", "num": 1, "giftName": "辣条"}},
+                      ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+
+
+COMMENTS = [
+    Comment("前方高能", 10001, "路过的观众", score=3),
+    Comment("awsl!!!", 10002, "小明", mode=5, color=0xFE0302, score=1),
+    Comment("Hello \"world\"\n第二行", 10003, "user_3", mode=4, size=18, color=0x00CD00, ascii_json=False),
+    Comment("emoji 😂🎉 and tab\t", 10004, "表情党", score=12),
+    Comment("   ", 10005, "blank"),  # dropped like LiveDanmakuCommandParser
+    Comment("　 ", 10006, "wide blank"),  # dropped as well
+    Comment("no extra member", 10007, "老用户", extra=False, timestamp=0),
+    Comment("cmd after info", 10008, "order", mode=7, color=0x1FFFFFF, info_first=True, score=-2),
+    Comment("反斜杠 \\ 与 / 斜杠", 10009, "slash", mode=6, size=300),
+    Comment("短", 4000000000123, "大号 uid", score=10),
+]
+
+
+def expected_line(kind, *args):
+    if kind == "packet":
+        operation, sequence, body = args
+        return "packet op=%d seq=%d body=%s" % (operation, sequence, body.hex())
+    return args[0].expected()
+
+
+class Capture:
+    def __init__(self, name):
+        self.name = name
+        self.messages = []
+        self.expected = []
+
+    def add(self, message, lines):
+        self.messages.append(message)
+        self.expected.append("message %d" % len(self.messages))
+        self.expected.extend(lines)
+
+    def write(self):
+        with open(os.path.join(HERE, self.name + ".bin"), "wb") as out:
+            for message in self.messages:
+                out.write(struct.pack(">I", len(message)) + message)
+        with open(os.path.join(HERE, self.name + ".expected"), "w", encoding="utf-8") as out:
+            out.write("\n".join(self.expected) + "\n")
+
+
+def session(name, protocol, compress):
+    capture = Capture(name)
+    auth = b'{"code":0}'
+    capture.add(frame(OP_AUTH_REPLY, 1, auth, 1), [expected_line("packet", OP_AUTH_REPLY, 1, auth)])
+    popularity = struct.pack(">I", 123456)
+    capture.add(frame(OP_HEARTBEAT_REPLY, 1, popularity, 2) + frame(OP_HEARTBEAT_REPLY, 1, b"", 3),
+                [expected_line("packet", OP_HEARTBEAT_REPLY, 2, popularity),
+                 expected_line("packet", OP_HEARTBEAT_REPLY, 3, b"")])
+
+    # One compressed bundle of every comment mixed with commands that are dropped.
+    inner = b""
+    lines = []
+    for index, comment in enumerate(COMMENTS):
+        inner += frame(OP_COMMAND, 0, comment.body())
+        if comment.text.strip(" 　 "):
+            lines.append(comment.expected())
+        if index % 3 == 0:
+            inner += frame(OP_COMMAND, 0, other_command("SEND_GIFT"))
+    capture.add(frame(OP_COMMAND, protocol, compress(inner)), lines)
+
+    # Uncompressed command next to a compressed bundle in one message.
+    plain = Comment("plain frame", 20001, "plain", mode=4)
+    nested = Comment("nested bundle", 20002, "nested", score=7)
+    capture.add(frame(OP_COMMAND, 0, plain.body()) +
+                frame(OP_COMMAND, protocol, compress(frame(OP_COMMAND, 0, nested.body()))),
+                [plain.expected(), nested.expected()])
+
+    # A bundle inside a bundle is followed one level; a third level is ignored like the Kotlin codec.
+    deep = Comment("second level", 20003, "deep")
+    too_deep = Comment("third level", 20004, "too deep")
+    level3 = frame(OP_COMMAND, protocol, compress(frame(OP_COMMAND, protocol, compress(
+        frame(OP_COMMAND, 0, too_deep.body())))))
+    capture.add(frame(OP_COMMAND, protocol, compress(frame(OP_COMMAND, 0, deep.body()) + level3)),
+                [deep.expected()])
+
+    # Trailing partial frame: the complete frames before it still decode.
+    whole = Comment("before the cut", 20005, "cut")
+    cut = frame(OP_COMMAND, 0, Comment("cut off", 20006, "cut").body())
+    capture.add(frame(OP_COMMAND, 0, whole.body()) + cut[: len(cut) // 2], [whole.expected()])
+
+    # Corrupt body: counted as a failure, the frame after it still decodes.
+    after = Comment("after corrupt body", 20007, "ok")
+    capture.add(frame(OP_COMMAND, protocol, b"\x00garbage\xff" * 4) + frame(OP_COMMAND, 0, after.body()),
+                [after.expected()])
+
+    # A busy second: 200 comments in one bundle.
+    inner = b""
+    lines = []
+    for index in range(200):
+        comment = Comment("弹幕 %d 2333" % index, 30000 + index, "viewer%d" % (index % 17),
+                          mode=(1, 4, 5)[index % 3], color=(index * 2654435761) & 0xFFFFFF,
+                          timestamp=1718000000000 + index * 5, score=index % 11, ascii_json=index % 2 == 0)
+        inner += frame(OP_COMMAND, 0, comment.body())
+        lines.append(comment.expected())
+    capture.add(frame(OP_COMMAND, protocol, compress(inner)), lines)
+    capture.write()
+
+
+if __name__ == "__main__":
+    session("zlib_session", 2, zlib.compress)
+    session("brotli_session", 3, brotli)
@@ -0,0 +1,397 @@
+// Host benchmark for the native danmaku parser (danmaku_store.cpp).
+//
+//   cmake -S player_component/src/main/cpp -B build/danmaku-bench -DDANMAKU_HOST_BENCH=ON
+//   cmake --build build/danmaku-bench
+//   build/danmaku-bench/danmaku_bench [--iterations N] [--dump N] [--keywords FILE]
+//                                     [--layout WxH] [--density] [--merge] [--cache DIR]
+//                                     <file-or-directory>...
+//
+// Directories are walked recursively for *.xml and *.json files. Every file is parsed
+// N times from the page cache; the report lists the best run per file and the corpus total.
+// --keywords loads a block list (one keyword per line) and also times BlockFilter::Scan on
+// each store, single threaded and with the automatic thread count.
+// --layout WxH also times LayoutEngine::LayoutAll for a WxH screen and checks that the
+// parallel result equals laying the windows out one after another.
+// --density also times BuildDensityIndex (comments matching --keywords are tagged), checks
+// the per-second counts against plain division and prints the hot moments.
+// --merge also times MergeDuplicates and prints the largest groups.
+// --cache DIR writes a DanmakuCache of each store (filter masks and, with --layout, the
+// placements included) into DIR, then times reopening it against the parse and checks that
+// the mapped store and restored layout equal the computed ones.
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../danmaku_cache.h"
+#include "../danmaku_density.h"
+#include "../danmaku_filter.h"
+#include "../danmaku_layout.h"
+#include "../danmaku_merge.h"
+#include "../danmaku_store.h"
+
+namespace {
+
+bool HasDanmakuExtension(const std::string &path) {
+    const size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == "xml" || ext == "json";
+}
+
+void CollectFiles(const std::string &path, std::vector<std::string> *out) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) {
+        std::fprintf(stderr, "skip %s: %s\n", path.c_str(), std::strerror(errno));
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        out->push_back(path);
+        return;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) return;
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        const std::string child = path + "/" + entry->d_name;
+        struct stat child_st {};
+        if (stat(child.c_str(), &child_st) != 0) continue;
+        if (S_ISDIR(child_st.st_mode)) {
+            CollectFiles(child, out);
+        } else if (HasDanmakuExtension(child)) {
+            out->push_back(child);
+        }
+    }
+    closedir(dir);
+    std::sort(out->begin(), out->end());
+}
+
+void Dump(const danmaku::CommentStore &store, uint32_t limit) {
+    for (uint32_t i = 0; i < std::min(limit, store.count()); ++i) {
+        const std::string_view text = store.text(i);
+        std::printf("  %9d ms  mode %u  size %3u  color %06x  %.*s\n", store.time_ms(i), store.mode(i), store.size(i),
+                    store.color(i), static_cast<int>(text.size()), text.data());
+    }
+}
+
+std::vector<std::string> ReadLines(const char *path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) lines.push_back(line);
+    }
+    return lines;
+}
+
+double TimeScan(const danmaku::BlockFilter &filter, const danmaku::CommentStore &store, int threads, int iterations,
+                size_t *blocked) {
+    std::vector<uint64_t> keyword_mask((store.count() + 63) / 64);
+    std::vector<uint64_t> literal_mask(keyword_mask.size());
+    double best = 1e30;
+    for (int run = 0; run < iterations; ++run) {
+        const auto started = std::chrono::steady_clock::now();
+        filter.Scan(store, threads, keyword_mask.data(), literal_mask.data());
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        best = std::min(best, elapsed.count());
+    }
+    *blocked = 0;
+    for (const uint64_t word : keyword_mask) {
+        *blocked += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return best;
+}
+
+danmaku::LayoutConfig BenchLayoutConfig(int width, int height) {
+    danmaku::LayoutConfig config;
+    config.width = width;
+    config.height = height;
+    config.text_scale = 1.5F;
+    config.stroke = 2.0F;
+    config.lane_height = 25 * 1.5F * 1.2F + 8.0F;
+    for (float &advance : config.font.ascii) {
+        advance = 0.55F;
+    }
+    return config;
+}
+
+void BenchLayout(const danmaku::CommentStore &store, int width, int height, int iterations) {
+    const danmaku::LayoutConfig config = BenchLayoutConfig(width, height);
+    auto time_layout = [&](int threads, danmaku::LayoutEngine *engine) {
+        double best = 1e30;
+        for (int run = 0; run < iterations; ++run) {
+            engine->Configure(config);
+            const auto started = std::chrono::steady_clock::now();
+            engine->LayoutAll(threads);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    };
+    danmaku::LayoutEngine parallel(store);
+    const double single = time_layout(1, &parallel);
+    const double automatic = time_layout(0, &parallel);
+
+    // Reference: windows one after another, each seeded with its predecessor's exact lanes.
+    danmaku::LayoutEngine sequential(store);
+    sequential.Configure(config);
+    for (size_t window = 0; window < sequential.window_count(); ++window) {
+        const int64_t start = static_cast<int64_t>(window) * danmaku::LayoutEngine::kWindowMs;
+        sequential.Layout(start, start + danmaku::LayoutEngine::kWindowMs);
+    }
+    size_t placed = 0;
+    size_t mismatches = 0;
+    for (uint32_t row = 0; row < store.count(); ++row) {
+        const danmaku::Placement &a = parallel.placements()[row];
+        const danmaku::Placement &b = sequential.placements()[row];
+        if ((a.flags & danmaku::Placement::kPlaced) != 0) ++placed;
+        if (a.lane != b.lane || a.flags != b.flags) ++mismatches;
+    }
+    std::printf("  layout %dx%d: %zu windows, %zu placed, %.2f ms single, %.2f ms auto threads, %zu mismatches\n",
+                width, height, parallel.window_count(), placed, single * 1000, automatic * 1000, mismatches);
+}
+
+void BenchDensity(const danmaku::CommentStore &store, const danmaku::BlockFilter &filter, int iterations) {
+    const size_t words = (static_cast<size_t>(store.count()) + 63) / 64;
+    std::vector<uint64_t> tag_mask(words);
+    std::vector<uint64_t> literal_mask(words);
+    filter.Scan(store, 0, tag_mask.data(), literal_mask.data());
+    std::unique_ptr<danmaku::DensityIndex> index;
+    double best = 1e30;
+    for (int run = 0; run < iterations; ++run) {
+        const auto started = std::chrono::steady_clock::now();
+        index = danmaku::BuildDensityIndex(store, tag_mask.data(), danmaku::DensityOptions(), 0);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        best = std::min(best, elapsed.count());
+    }
+    const uint32_t seconds = index->seconds();
+    std::vector<uint32_t> expected(seconds, 0);
+    for (uint32_t row = 0; row < store.count(); ++row) {
+        ++expected[std::max(0, store.time_ms(row)) / 1000];
+    }
+    const uint8_t *counts = index->data() + danmaku::kDensityHeaderBytes;
+    size_t mismatches = 0;
+    for (uint32_t second = 0; second < seconds; ++second) {
+        uint32_t count;
+        std::memcpy(&count, counts + second * 4, sizeof(count));
+        if (count != expected[second]) ++mismatches;
+    }
+    std::printf("  density: %u seconds, %u peaks, %zu bytes, %.3f ms, %zu mismatches\n", seconds,
+                index->peak_count(), index->bytes(), best * 1000, mismatches);
+    const uint8_t *peaks = counts + static_cast<size_t>(seconds) * 12;
+    for (uint32_t i = 0; i < index->peak_count(); ++i) {
+        uint32_t second;
+        float heat;
+        std::memcpy(&second, peaks + i * 4, sizeof(second));
+        std::memcpy(&heat, peaks + index->peak_count() * 4 + i * 4, sizeof(heat));
+        std::printf("    %02u:%02u heat %.1f\n", second / 60, second % 60, heat);
+    }
+}
+
+void BenchMerge(const danmaku::CommentStore &store, int iterations) {
+    std::vector<uint16_t> counts;
+    double best = 1e30;
+    for (int run = 0; run < iterations; ++run) {
+        const auto started = std::chrono::steady_clock::now();
+        danmaku::MergeDuplicates(store, danmaku::MergeOptions(), &counts);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        best = std::min(best, elapsed.count());
+    }
+    size_t folded = 0;
+    std::vector<uint32_t> groups;
+    for (uint32_t row = 0; row < store.count(); ++row) {
+        if (counts[row] == 0) ++folded;
+        if (counts[row] > 1) groups.push_back(row);
+    }
+    std::printf("  merge: %zu folded into %zu groups, %.2f ms\n", folded, groups.size(), best * 1000);
+    std::sort(groups.begin(), groups.end(), [&](uint32_t a, uint32_t b) { return counts[a] > counts[b]; });
+    for (size_t i = 0; i < std::min<size_t>(5, groups.size()); ++i) {
+        const std::string_view text = store.text(groups[i]);
+        std::printf("    %8d ms x%u %.*s\n", store.time_ms(groups[i]), counts[groups[i]], static_cast<int>(text.size()),
+                    text.data());
+    }
+}
+
+void BenchCache(const std::string &file, const danmaku::CommentStore &store, const danmaku::BlockFilter &filter,
+                int width, int height, const std::string &directory, int iterations) {
+    const size_t slash = file.rfind('/');
+    const std::string path =
+        directory + "/" + (slash == std::string::npos ? file : file.substr(slash + 1)) + ".ddcache";
+    std::remove(path.c_str());
+    const size_t words = (static_cast<size_t>(store.count()) + 63) / 64;
+    std::vector<uint64_t> masks(words * 2);
+    filter.Scan(store, 0, masks.data(), masks.data() + words);
+    danmaku::LayoutEngine layout(store);
+    const bool laid_out = width > 0 && height > 0;
+    if (laid_out) {
+        layout.Configure(BenchLayoutConfig(width, height));
+        layout.LayoutAll(0);
+    }
+
+    const auto written_started = std::chrono::steady_clock::now();
+    auto cache = danmaku::DanmakuCache::Open(path, file);
+    if (!cache) {
+        std::printf("  cache: cannot open %s\n", path.c_str());
+        return;
+    }
+    cache->Put(danmaku::kSectionStore, danmaku::kStoreVersion, store.data(), store.bytes());
+    cache->Put(danmaku::kSectionFilter, filter.fingerprint(), masks.data(), masks.size() * sizeof(uint64_t));
+    if (laid_out) {
+        cache->Put(danmaku::kSectionLayout, layout.Fingerprint(), layout.placements(), layout.placements_bytes());
+    }
+    const bool flushed = cache->Flush();
+    const std::chrono::duration<double> written = std::chrono::steady_clock::now() - written_started;
+    if (!flushed) {
+        std::printf("  cache: cannot write %s\n", path.c_str());
+        return;
+    }
+
+    double best = 1e30;
+    size_t mismatches = 0;
+    for (int run = 0; run < iterations; ++run) {
+        const auto started = std::chrono::steady_clock::now();
+        auto reopened = danmaku::DanmakuCache::Open(path, file);
+        size_t bytes = 0;
+        const uint8_t *block = reopened ? reopened->Find(danmaku::kSectionStore, danmaku::kStoreVersion, &bytes)
+                                        : nullptr;
+        auto mapped = danmaku::CommentStore::FromBlock(block, bytes, reopened ? reopened->owner() : nullptr);
+        size_t mask_bytes = 0;
+        const uint8_t *mask =
+            reopened ? reopened->Find(danmaku::kSectionFilter, filter.fingerprint(), &mask_bytes) : nullptr;
+        std::unique_ptr<danmaku::LayoutEngine> restored;
+        bool layout_restored = !laid_out;
+        if (mapped && laid_out) {
+            restored = std::make_unique<danmaku::LayoutEngine>(*mapped);
+            restored->Configure(BenchLayoutConfig(width, height));
+            size_t placement_bytes = 0;
+            const uint8_t *rows = reopened->Find(danmaku::kSectionLayout, restored->Fingerprint(), &placement_bytes);
+            layout_restored = rows != nullptr && restored->Restore(reinterpret_cast<const danmaku::Placement *>(rows),
+                                                                   placement_bytes / sizeof(danmaku::Placement));
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        best = std::min(best, elapsed.count());
+        if (run > 0) continue;
+
+        if (!mapped || mapped->bytes() != store.bytes() || std::memcmp(mapped->data(), store.data(), store.bytes()) != 0) {
+            ++mismatches;
+        }
+        if (mask == nullptr || mask_bytes != masks.size() * sizeof(uint64_t) ||
+            std::memcmp(mask, masks.data(), mask_bytes) != 0) {
+            ++mismatches;
+        }
+        if (!layout_restored || (restored && std::memcmp(restored->placements(), layout.placements(),
+                                                         layout.placements_bytes()) != 0)) {
+            ++mismatches;
+        }
+    }
+    struct stat st {};
+    stat(path.c_str(), &st);
+    std::printf("  cache: %.1f KiB, written in %.2f ms, reopened in %.3f ms, %zu mismatches\n", st.st_size / 1024.0,
+                written.count() * 1000, best * 1000, mismatches);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    int iterations = 5;
+    uint32_t dump = 0;
+    std::vector<std::string> keywords;
+    int layout_width = 0;
+    int layout_height = 0;
+    bool density = false;
+    bool merge = false;
+    std::string cache_directory;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            dump = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--keywords") == 0 && i + 1 < argc) {
+            keywords = ReadLines(argv[++i]);
+        } else if (std::strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            std::sscanf(argv[++i], "%dx%d", &layout_width, &layout_height);
+        } else if (std::strcmp(argv[i], "--density") == 0) {
+            density = true;
+        } else if (std::strcmp(argv[i], "--merge") == 0) {
+            merge = true;
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_directory = argv[++i];
+        } else {
+            CollectFiles(argv[i], &files);
+        }
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage: %s [--iterations N] [--dump N] [--keywords FILE] [--layout WxH] [--density] [--merge] "
+                     "[--cache DIR] <file-or-directory>...\n", argv[0]);
+        return 2;
+    }
+
+    double total_bytes = 0;
+    double total_comments = 0;
+    double total_seconds = 0;
+    int failures = 0;
+    const danmaku::BlockFilter filter(keywords, {});
+    for (const std::string &file : files) {
+        double best = 1e30;
+        std::unique_ptr<danmaku::CommentStore> store;
+        std::string error;
+        for (int run = 0; run < iterations; ++run) {
+            const auto started = std::chrono::steady_clock::now();
+            store = danmaku::ParseFile(file, danmaku::SourceFormat::kAuto, &error);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            best = std::min(best, elapsed.count());
+            if (!store) break;
+        }
+        if (!store) {
+            std::printf("%s: FAILED (%s)\n", file.c_str(), error.c_str());
+            ++failures;
+            continue;
+        }
+        struct stat st {};
+        stat(file.c_str(), &st);
+        std::printf("%s: %u comments, %.1f KiB -> %.1f KiB store, %.2f ms, %.0f MB/s\n", file.c_str(), store->count(),
+                    st.st_size / 1024.0, store->bytes() / 1024.0, best * 1000, st.st_size / best / 1e6);
+        Dump(*store, dump);
+        if (!keywords.empty()) {
+            size_t blocked = 0;
+            const double single = TimeScan(filter, *store, 1, iterations, &blocked);
+            const double parallel = TimeScan(filter, *store, 0, iterations, &blocked);
+            std::printf("  filter: %zu keywords, %zu blocked, %.2f ms single, %.2f ms auto threads\n",
+                        keywords.size(), blocked, single * 1000, parallel * 1000);
+        }
+        if (layout_width > 0 && layout_height > 0) {
+            BenchLayout(*store, layout_width, layout_height, iterations);
+        }
+        if (density) {
+            BenchDensity(*store, filter, iterations);
+        }
+        if (merge) {
+            BenchMerge(*store, iterations);
+        }
+        if (!cache_directory.empty()) {
+            BenchCache(file, *store, filter, layout_width, layout_height, cache_directory, iterations);
+        }
+        total_bytes += static_cast<double>(st.st_size);
+        total_comments += store->count();
+        total_seconds += best;
+    }
+    if (total_seconds > 0) {
+        std::printf("total: %zu files, %.0f comments, %.1f MiB in %.2f ms (%.0f MB/s, %.2f M comments/s)\n",
+                    files.size() - failures, total_comments, total_bytes / (1024 * 1024), total_seconds * 1000,
+                    total_bytes / total_seconds / 1e6, total_comments / total_seconds / 1e6);
+    }
+    return failures == 0 ? 0 : 1;
+}
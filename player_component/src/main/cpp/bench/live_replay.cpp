@@ -0,0 +1,205 @@
+// Replays recorded live danmaku websocket messages through danmaku::LiveDecoder.
+//
+//   cmake -S player_component/src/main/cpp -B build/danmaku-bench -DDANMAKU_HOST_BENCH=ON
+//   cmake --build build/danmaku-bench
+//   build/danmaku-bench/live_replay [--iterations N] <capture.bin> [capture.expected]
+//   ctest --test-dir build/danmaku-bench
+//
+// A capture is a sequence of websocket binary messages, each a u32 big-endian length
+// followed by the message bytes (bench/captures/make_captures.py writes them). Every
+// decoded batch is read back through its documented layout, the way LiveDanmakuBatch.kt
+// reads it, and dumped one line per comment or reply packet; with an expected dump the
+// tool exits non-zero on the first difference. --iterations times N replays of the whole
+// capture with one decoder, so decompressor and scratch buffers are reused as on a device.
+// Brotli captures are skipped (exit 0) when the decoder was built without brotli.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../danmaku_live.h"
+
+namespace {
+
+uint32_t U32(const uint8_t *block, size_t offset) {
+    uint32_t value;
+    memcpy(&value, block + offset, sizeof(value));
+    return value;
+}
+
+int64_t I64(const uint8_t *block, size_t offset) {
+    int64_t value;
+    memcpy(&value, block + offset, sizeof(value));
+    return value;
+}
+
+bool ReadCapture(const char *path, std::vector<std::vector<uint8_t>> *messages) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    while (data.size() - offset >= 4) {
+        const uint32_t length = static_cast<uint32_t>(data[offset]) << 24 | static_cast<uint32_t>(data[offset + 1]) << 16 |
+                                static_cast<uint32_t>(data[offset + 2]) << 8 | data[offset + 3];
+        offset += 4;
+        if (length > data.size() - offset) return false;
+        messages->emplace_back(data.begin() + static_cast<std::ptrdiff_t>(offset),
+                               data.begin() + static_cast<std::ptrdiff_t>(offset + length));
+        offset += length;
+    }
+    return offset == data.size();
+}
+
+std::string Escape(const uint8_t *text, size_t length) {
+    std::string out;
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] == '\\') {
+            out += "\\\\";
+        } else if (text[i] == '\n') {
+            out += "\\n";
+        } else {
+            out.push_back(static_cast<char>(text[i]));
+        }
+    }
+    return out;
+}
+
+// One line per comment and reply packet of the batch, in the format of the expected dumps.
+bool DumpBatch(const uint8_t *block, size_t bytes, std::vector<std::string> *lines) {
+    if (bytes < danmaku::kLiveBatchHeaderBytes || U32(block, 0) != danmaku::kLiveBatchMagic ||
+        U32(block, 4) != danmaku::kLiveBatchVersion || U32(block, 48) != bytes) {
+        return false;
+    }
+    const uint32_t count = U32(block, 8);
+    const uint32_t packet_count = U32(block, 12);
+    const uint8_t *store = block + U32(block, 16);
+    if (U32(store, 0) != danmaku::kStoreMagic || U32(store, 8) != count) return false;
+    const uint32_t color_offset = U32(store, 20);
+    const uint32_t text_offset_offset = U32(store, 24);
+    const uint32_t text_length_offset = U32(store, 28);
+    const uint32_t mode_offset = U32(store, 32);
+    const uint32_t size_offset = U32(store, 36);
+    const uint32_t text_arena = U32(store, 40);
+    const uint32_t arena = U32(block, 44);
+    char line[1024];
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t name_offset = U32(block, U32(block, 28) + i * 4);
+        const uint32_t name_length = U32(block, U32(block, 32) + i * 4);
+        std::snprintf(line, sizeof(line), "comment uid=%lld name=%.*s mode=%u size=%u color=%06x ts=%lld score=%u text=",
+                      static_cast<long long>(I64(block, U32(block, 24) + i * 8)), static_cast<int>(name_length),
+                      reinterpret_cast<const char *>(block + arena + name_offset), store[mode_offset + i],
+                      store[size_offset + i], U32(store, color_offset + i * 4),
+                      static_cast<long long>(I64(block, U32(block, 20) + i * 8)), block[U32(block, 36) + i]);
+        lines->push_back(line + Escape(store + text_arena + U32(store, text_offset_offset + i * 4),
+                                       U32(store, text_length_offset + i * 4)));
+    }
+    for (uint32_t i = 0; i < packet_count; ++i) {
+        const size_t row = U32(block, 40) + i * 16;
+        std::string hex;
+        const uint8_t *body = block + arena + U32(block, row + 8);
+        for (uint32_t j = 0; j < U32(block, row + 12); ++j) {
+            char digits[3];
+            std::snprintf(digits, sizeof(digits), "%02x", body[j]);
+            hex += digits;
+        }
+        std::snprintf(line, sizeof(line), "packet op=%u seq=%u body=", U32(block, row), U32(block, row + 4));
+        lines->push_back(line + hex);
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    int iterations = 0;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(0, std::atoi(argv[++i]));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::fprintf(stderr, "usage: %s [--iterations N] <capture.bin> [capture.expected]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::vector<uint8_t>> messages;
+    if (!ReadCapture(paths[0], &messages)) {
+        std::fprintf(stderr, "%s: not a capture\n", paths[0]);
+        return 1;
+    }
+    if (!danmaku::LiveDecoder::SupportsBrotli() && std::strstr(paths[0], "brotli") != nullptr) {
+        std::printf("%s: built without brotli, skipped\n", paths[0]);
+        return 0;
+    }
+
+    danmaku::LiveDecoder decoder;
+    std::vector<std::string> dump;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        dump.push_back("message " + std::to_string(i + 1));
+        decoder.Decode(messages[i].data(), messages[i].size());
+        if (!DumpBatch(decoder.batch(), decoder.batch_bytes(), &dump)) {
+            std::fprintf(stderr, "message %zu: malformed batch\n", i + 1);
+            return 1;
+        }
+    }
+    const danmaku::LiveDecodeStats &stats = decoder.stats();
+    std::printf("%s: %zu messages, %llu packets, %llu commands, %llu comments, %llu -> %llu bytes inflated, "
+                "%llu failed bodies\n",
+                paths[0], messages.size(), static_cast<unsigned long long>(stats.packets),
+                static_cast<unsigned long long>(stats.commands), static_cast<unsigned long long>(stats.comments),
+                static_cast<unsigned long long>(stats.compressed_bytes),
+                static_cast<unsigned long long>(stats.inflated_bytes), static_cast<unsigned long long>(stats.failures));
+
+    int status = 0;
+    if (paths.size() == 2) {
+        std::vector<std::string> expected;
+        std::ifstream in(paths[1]);
+        for (std::string line; std::getline(in, line);) {
+            expected.push_back(line);
+        }
+        if (expected.empty()) {
+            std::fprintf(stderr, "%s: no expected dump\n", paths[1]);
+            return 1;
+        }
+        const size_t lines = std::max(dump.size(), expected.size());
+        for (size_t i = 0; i < lines && status == 0; ++i) {
+            const std::string &got = i < dump.size() ? dump[i] : std::string("<end>");
+            const std::string &want = i < expected.size() ? expected[i] : std::string("<end>");
+            if (got != want) {
+                std::fprintf(stderr, "line %zu differs\n  expected: %s\n  decoded:  %s\n", i + 1, want.c_str(),
+                             got.c_str());
+                status = 1;
+            }
+        }
+        if (status == 0) std::printf("%zu lines match %s\n", dump.size(), paths[1]);
+    } else {
+        for (const std::string &line : dump) {
+            std::printf("%s\n", line.c_str());
+        }
+    }
+
+    if (iterations > 0) {
+        size_t bytes = 0;
+        for (const auto &message : messages) bytes += message.size();
+        double best = 1e30;
+        for (int run = 0; run < iterations; ++run) {
+            const auto started = std::chrono::steady_clock::now();
+            for (const auto &message : messages) {
+                decoder.Decode(message.data(), message.size());
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            best = std::min(best, elapsed.count());
+        }
+        std::printf("replay: %.3f ms per pass, %.1f MB/s of wire data\n", best * 1e3, bytes / best / 1e6);
+    }
+    return status;
+}
@@ -0,0 +1,175 @@
+// Round trip of mpv_thumb::SpriteSheetWriter through the cache layout documented in
+// mpv_thumbnail.h.
+//
+//   cmake -S player_component/src/main/cpp -B build/danmaku-bench -DDANMAKU_HOST_BENCH=ON
+//   cmake --build build/danmaku-bench
+//   build/danmaku-bench/thumbnail_sheet_test [output.ddth]
+//   ctest --test-dir build/danmaku-bench
+//
+// Frames with a distinct pattern per pixel are written through the native writer (padded
+// input stride, several sheets, a partly filled last one), then the file is parsed field by
+// field the way MpvThumbnailSheet.kt reads it and every tile is inflated and compared with
+// the RGB565 value of its input pixel. Exits non-zero on the first difference.
+
+#include <zlib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../mpv_thumbnail.h"
+
+namespace {
+
+constexpr int kTileWidth = 5;
+constexpr int kTileHeight = 3;
+constexpr int kColumns = 3;
+constexpr int kRows = 2;
+constexpr int kFrames = 14;  // two full sheets and two tiles of a third
+constexpr size_t kStride = kTileWidth * 4 + 12;
+constexpr int64_t kDurationMs = 140500;
+
+int failures = 0;
+
+void Expect(bool condition, const std::string &what) {
+    if (!condition && failures++ < 20) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+uint32_t U32(const std::vector<uint8_t> &data, size_t offset) {
+    return static_cast<uint32_t>(data[offset]) | static_cast<uint32_t>(data[offset + 1]) << 8 |
+           static_cast<uint32_t>(data[offset + 2]) << 16 | static_cast<uint32_t>(data[offset + 3]) << 24;
+}
+
+uint64_t U64(const std::vector<uint8_t> &data, size_t offset) {
+    return static_cast<uint64_t>(U32(data, offset)) | static_cast<uint64_t>(U32(data, offset + 4)) << 32;
+}
+
+int64_t FramePts(int frame) { return frame * 10000LL + (frame % 3) * 7; }
+
+// Input pixel (r, g, b) of frame `frame`; every channel varies so a swapped or shifted
+// field shows up in the comparison.
+void FramePixel(int frame, int x, int y, uint8_t *rgb) {
+    rgb[0] = static_cast<uint8_t>(frame * 17 + x * 41 + y * 3);
+    rgb[1] = static_cast<uint8_t>(frame * 29 + y * 53 + x);
+    rgb[2] = static_cast<uint8_t>(255 - frame * 13 - x * 7 - y * 31);
+}
+
+uint16_t ExpectedRgb565(int frame, int x, int y) {
+    uint8_t rgb[3];
+    FramePixel(frame, x, y, rgb);
+    return static_cast<uint16_t>((rgb[0] >> 3) << 11 | (rgb[1] >> 2) << 5 | (rgb[2] >> 3));
+}
+
+bool WriteSheet(const std::string &path) {
+    mpv_thumb::SpriteSheetWriter writer(kTileWidth, kTileHeight, kColumns, kRows);
+    std::vector<uint8_t> frame(kStride * kTileHeight);
+    for (int f = 0; f < kFrames; ++f) {
+        // Padding bytes and the 4th channel must not leak into the output.
+        std::fill(frame.begin(), frame.end(), static_cast<uint8_t>(0xA5));
+        for (int y = 0; y < kTileHeight; ++y) {
+            for (int x = 0; x < kTileWidth; ++x) {
+                FramePixel(f, x, y, &frame[y * kStride + x * 4]);
+            }
+        }
+        writer.AddFrame(FramePts(f), frame.data(), kStride);
+    }
+    Expect(writer.frame_count() == kFrames, "frame_count()");
+    std::string error;
+    if (!writer.Write(path, kDurationMs, &error)) {
+        std::fprintf(stderr, "Write failed: %s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+void CheckSheet(const std::vector<uint8_t> &data) {
+    const int tiles_per_sheet = kColumns * kRows;
+    const int sheet_count = (kFrames + tiles_per_sheet - 1) / tiles_per_sheet;
+    const size_t table = 40 + kFrames * 8;
+    if (data.size() < table + sheet_count * 16) {
+        Expect(false, "file shorter than its tables: " + std::to_string(data.size()));
+        return;
+    }
+    Expect(U32(data, 0) == mpv_thumb::kSpriteMagic, "magic");
+    Expect(U32(data, 4) == mpv_thumb::kSpriteVersion, "version");
+    Expect(U32(data, 8) == kTileWidth, "tile_width");
+    Expect(U32(data, 12) == kTileHeight, "tile_height");
+    Expect(U32(data, 16) == kColumns, "columns");
+    Expect(U32(data, 20) == kRows, "rows");
+    Expect(U32(data, 24) == kFrames, "frame_count");
+    Expect(U32(data, 28) == static_cast<uint32_t>(sheet_count), "sheet_count " + std::to_string(U32(data, 28)));
+    Expect(static_cast<int64_t>(U64(data, 32)) == kDurationMs, "duration_ms");
+    for (int f = 0; f < kFrames; ++f) {
+        Expect(static_cast<int64_t>(U64(data, 40 + f * 8)) == FramePts(f), "pts of frame " + std::to_string(f));
+    }
+
+    const size_t sheet_width = static_cast<size_t>(kColumns) * kTileWidth;
+    const size_t raw_bytes = sheet_width * kRows * kTileHeight * 2;
+    size_t expected_offset = table + sheet_count * 16;
+    for (int s = 0; s < sheet_count; ++s) {
+        const std::string sheet = "sheet " + std::to_string(s);
+        const uint64_t offset = U64(data, table + s * 16);
+        const uint32_t compressed = U32(data, table + s * 16 + 8);
+        Expect(offset == expected_offset, sheet + " offset");
+        Expect(U32(data, table + s * 16 + 12) == raw_bytes, sheet + " raw_bytes");
+        if (offset > data.size() || compressed > data.size() - offset) {
+            Expect(false, sheet + " runs past the end of the file");
+            return;
+        }
+        expected_offset = offset + compressed;
+
+        std::vector<uint8_t> raw(raw_bytes);
+        uLongf raw_size = static_cast<uLongf>(raw.size());
+        if (uncompress(raw.data(), &raw_size, data.data() + offset, compressed) != Z_OK || raw_size != raw.size()) {
+            Expect(false, sheet + " does not inflate to raw_bytes");
+            continue;
+        }
+        for (int tile = 0; tile < tiles_per_sheet; ++tile) {
+            const int frame = s * tiles_per_sheet + tile;
+            const size_t origin_x = static_cast<size_t>(tile % kColumns) * kTileWidth;
+            const size_t origin_y = static_cast<size_t>(tile / kColumns) * kTileHeight;
+            for (int y = 0; y < kTileHeight; ++y) {
+                for (int x = 0; x < kTileWidth; ++x) {
+                    const size_t at = ((origin_y + y) * sheet_width + origin_x + x) * 2;
+                    const uint16_t pixel = static_cast<uint16_t>(raw[at] | raw[at + 1] << 8);
+                    // Unused tiles of the last sheet stay black.
+                    const uint16_t expected = frame < kFrames ? ExpectedRgb565(frame, x, y) : 0;
+                    Expect(pixel == expected, "frame " + std::to_string(frame) + " pixel " + std::to_string(x) + "," +
+                                                  std::to_string(y));
+                }
+            }
+        }
+    }
+    Expect(expected_offset == data.size(), "trailing bytes after the last sheet");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const std::string path = argc > 1 ? argv[1] : "thumbnail_sheet_test.ddth";
+
+    std::string error;
+    mpv_thumb::SpriteSheetWriter empty(kTileWidth, kTileHeight, kColumns, kRows);
+    Expect(!empty.Write(path, kDurationMs, &error) && !error.empty(), "writing no frames must fail");
+
+    if (!WriteSheet(path)) {
+        return 1;
+    }
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    CheckSheet(data);
+    Expect(!std::ifstream(path + ".tmp"), "temporary file left behind");
+    std::remove(path.c_str());
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("%s: %d frames in %zu bytes round-tripped\n", path.c_str(), kFrames, data.size());
+    return 0;
+}
@@ -0,0 +1,430 @@
+#include <jni.h>
+#include <android/log.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "danmaku_cache.h"
+#include "danmaku_density.h"
+#include "danmaku_filter.h"
+#include "danmaku_layout.h"
+#include "danmaku_live.h"
+#include "danmaku_merge.h"
+#include "danmaku_store.h"
+
+namespace {
+constexpr const char* kLogTag = "danmaku_bridge";
+
+// Owns everything native that belongs to one loaded danmaku track; Kotlin holds it as a handle.
+struct StoreHandle {
+    std::unique_ptr<danmaku::DanmakuCache> cache;  // null when the track is not cached
+    std::unique_ptr<danmaku::CommentStore> store;
+    std::unique_ptr<danmaku::LayoutEngine> layout;  // created by the first DanmakuLayout call
+    std::unique_ptr<danmaku::DensityIndex> density;  // replaced by every DanmakuDensity load
+    std::vector<uint16_t> repeatCounts;              // replaced by every DanmakuMerge run
+};
+
+StoreHandle* fromHandle(jlong handle) {
+    return reinterpret_cast<StoreHandle*>(handle);
+}
+
+std::string jstringToString(JNIEnv* env, jstring value) {
+    if (value == nullptr) return "";
+    const char* chars = env->GetStringUTFChars(value, nullptr);
+    const std::string result = chars == nullptr ? "" : chars;
+    if (chars != nullptr) {
+        env->ReleaseStringUTFChars(value, chars);
+    }
+    return result;
+}
+
+// Standard UTF-8, unlike GetStringUTFChars: texts are compared byte-wise with the store arena,
+// where characters outside the BMP are 4-byte sequences rather than encoded surrogates.
+std::string jstringToUtf8(JNIEnv* env, jstring value) {
+    std::string result;
+    if (value == nullptr) return result;
+    const jsize length = env->GetStringLength(value);
+    const jchar* chars = env->GetStringChars(value, nullptr);
+    if (chars == nullptr) return result;
+    result.reserve(static_cast<size_t>(length) * 3);
+    for (jsize i = 0; i < length; ++i) {
+        uint32_t code = chars[i];
+        if (code >= 0xD800 && code <= 0xDBFF && i + 1 < length && chars[i + 1] >= 0xDC00 && chars[i + 1] <= 0xDFFF) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (chars[++i] - 0xDC00);
+        } else if (code >= 0xD800 && code <= 0xDFFF) {
+            code = 0xFFFD;
+        }
+        if (code < 0x80) {
+            result.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            result.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            result.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            result.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+    env->ReleaseStringChars(value, chars);
+    return result;
+}
+
+std::vector<std::string> stringArrayToUtf8(JNIEnv* env, jobjectArray array) {
+    std::vector<std::string> result;
+    if (array == nullptr) return result;
+    const jsize length = env->GetArrayLength(array);
+    result.reserve(static_cast<size_t>(length));
+    for (jsize i = 0; i < length; ++i) {
+        auto item = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+        result.push_back(jstringToUtf8(env, item));
+        env->DeleteLocalRef(item);
+    }
+    return result;
+}
+
+danmaku::BlockFilter* filterFromHandle(jlong handle) {
+    return reinterpret_cast<danmaku::BlockFilter*>(handle);
+}
+
+danmaku::LayoutEngine* layoutFromHandle(jlong handle) {
+    auto* store = fromHandle(handle);
+    if (store == nullptr || !store->store) return nullptr;
+    if (!store->layout) {
+        store->layout = std::make_unique<danmaku::LayoutEngine>(*store->store);
+    }
+    return store->layout.get();
+}
+
+long long elapsedUs(std::chrono::steady_clock::time_point started) {
+    return static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+}
+}  // namespace
+
+// Parses a danmaku file into a columnar store; 0 when it cannot be read or recognised, the
+// caller then falls back to the Java parser. `format` is a danmaku::SourceFormat value. With a
+// `cachePath` the store is mapped from that danmaku::DanmakuCache when it still matches the file,
+// otherwise it is parsed and the cache rewritten; filter masks, layout and density index computed
+// later for the store are kept there too and written back by nativeRelease.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_xyoye_danmaku_DanmakuStore_nativeParse(JNIEnv* env, jclass, jstring path, jint format, jstring cachePath) {
+    const std::string pathString = jstringToString(env, path);
+    if (pathString.empty()) return 0;
+    const auto started = std::chrono::steady_clock::now();
+    auto handle = std::make_unique<StoreHandle>();
+    const std::string cacheString = jstringToString(env, cachePath);
+    if (!cacheString.empty()) {
+        handle->cache = danmaku::DanmakuCache::Open(cacheString, pathString);
+    }
+    if (handle->cache) {
+        size_t bytes = 0;
+        std::shared_ptr<const void> owner;
+        const uint8_t* block = handle->cache->Find(danmaku::kSectionStore, danmaku::kStoreVersion, &bytes, &owner);
+        handle->store = danmaku::CommentStore::FromBlock(block, bytes, owner);
+        if (handle->store) {
+            __android_log_print(ANDROID_LOG_INFO, kLogTag, "mapped %u comments (%zu bytes) from cache in %lld us",
+                                handle->store->count(), handle->store->bytes(), elapsedUs(started));
+            return reinterpret_cast<jlong>(handle.release());
+        }
+    }
+
+    std::string error;
+    handle->store = danmaku::ParseFile(pathString, static_cast<danmaku::SourceFormat>(format), &error);
+    if (!handle->store) {
+        __android_log_print(ANDROID_LOG_WARN, kLogTag, "parse %s failed: %s", pathString.c_str(), error.c_str());
+        return 0;
+    }
+    __android_log_print(ANDROID_LOG_INFO, kLogTag, "parsed %u comments (%zu bytes) in %lld ms", handle->store->count(),
+                        handle->store->bytes(), elapsedUs(started) / 1000);
+    if (handle->cache) {
+        // Written right away rather than on release, so a killed process still leaves the store behind.
+        handle->cache->Put(danmaku::kSectionStore, danmaku::kStoreVersion, handle->store->data(),
+                           handle->store->bytes());
+        if (!handle->cache->Flush()) {
+            __android_log_print(ANDROID_LOG_WARN, kLogTag, "cannot write danmaku cache %s", cacheString.c_str());
+        }
+    }
+    return reinterpret_cast<jlong>(handle.release());
+}
+
+// Direct view of the store block; valid until nativeRelease.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_xyoye_danmaku_DanmakuStore_nativeBuffer(JNIEnv* env, jclass, jlong handle) {
+    auto* store = fromHandle(handle);
+    if (store == nullptr || !store->store) return nullptr;
+    return env->NewDirectByteBuffer(const_cast<uint8_t*>(store->store->data()),
+                                    static_cast<jlong>(store->store->bytes()));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_danmaku_DanmakuStore_nativeRelease(JNIEnv*, jclass, jlong handle) {
+    auto* storeHandle = fromHandle(handle);
+    if (storeHandle != nullptr && storeHandle->cache && storeHandle->cache->dirty() && !storeHandle->cache->Flush()) {
+        __android_log_print(ANDROID_LOG_WARN, kLogTag, "cannot update danmaku cache");
+    }
+    delete storeHandle;
+}
+
+// Compiles a block list; rebuilt by Kotlin only when the list changes.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_xyoye_danmaku_filter_DanmakuBlockMatcher_nativeCreate(
+    JNIEnv* env, jclass, jobjectArray keywords, jobjectArray regexLiterals) {
+    return reinterpret_cast<jlong>(
+        new danmaku::BlockFilter(stringArrayToUtf8(env, keywords), stringArrayToUtf8(env, regexLiterals)));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_xyoye_danmaku_filter_DanmakuBlockMatcher_nativeMatch(JNIEnv* env, jclass, jlong filter, jstring text) {
+    auto* blockFilter = filterFromHandle(filter);
+    if (blockFilter == nullptr || text == nullptr) return 0;
+    return static_cast<jint>(blockFilter->Match(jstringToUtf8(env, text)));
+}
+
+// Fills both masks (one bit per comment, see BlockFilter::Scan); false when the arrays are too
+// short for the store.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_danmaku_filter_DanmakuBlockMatcher_nativeScan(
+    JNIEnv* env, jclass, jlong filter, jlong store, jint threads, jlongArray keywordMask, jlongArray literalMask) {
+    auto* blockFilter = filterFromHandle(filter);
+    auto* storeHandle = fromHandle(store);
+    if (blockFilter == nullptr || storeHandle == nullptr || !storeHandle->store) return JNI_FALSE;
+    const auto words = static_cast<jsize>((storeHandle->store->count() + 63) / 64);
+    if (keywordMask == nullptr || literalMask == nullptr || env->GetArrayLength(keywordMask) < words ||
+        env->GetArrayLength(literalMask) < words) {
+        return JNI_FALSE;
+    }
+    // Both masks live in one cache section, keyword words first.
+    danmaku::DanmakuCache* cache = storeHandle->cache.get();
+    size_t cachedBytes = 0;
+    std::shared_ptr<const void> cachedOwner;
+    const uint8_t* cached = cache == nullptr ? nullptr
+                                             : cache->Find(danmaku::kSectionFilter, blockFilter->fingerprint(),
+                                                           &cachedBytes, &cachedOwner);
+    if (cached != nullptr && cachedBytes == static_cast<size_t>(words) * 2 * sizeof(uint64_t)) {
+        env->SetLongArrayRegion(keywordMask, 0, words, reinterpret_cast<const jlong*>(cached));
+        env->SetLongArrayRegion(literalMask, 0, words, reinterpret_cast<const jlong*>(cached) + words);
+        return JNI_TRUE;
+    }
+    // Scanned into native buffers rather than pinned arrays: a large store takes milliseconds
+    // and a critical section would hold off the GC for all of it.
+    std::vector<uint64_t> masks(static_cast<size_t>(words) * 2);
+    blockFilter->Scan(*storeHandle->store, threads, masks.data(), masks.data() + words);
+    env->SetLongArrayRegion(keywordMask, 0, words, reinterpret_cast<const jlong*>(masks.data()));
+    env->SetLongArrayRegion(literalMask, 0, words, reinterpret_cast<const jlong*>(masks.data()) + words);
+    if (cache != nullptr) {
+        cache->Put(danmaku::kSectionFilter, blockFilter->fingerprint(), masks.data(), masks.size() * sizeof(uint64_t));
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_danmaku_filter_DanmakuBlockMatcher_nativeRelease(JNIEnv*, jclass, jlong filter) {
+    delete filterFromHandle(filter);
+}
+
+// `ascii` holds the advances of U+0020..U+007E per pixel of font size (see danmaku::FontMetrics).
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeConfigure(
+    JNIEnv* env, jclass, jlong store, jint width, jint height, jfloat textScale, jfloat stroke, jfloat laneHeight,
+    jint scrollDurationMs, jint fixedDurationMs, jfloatArray ascii, jfloat wide, jfloat other, jfloat line) {
+    auto* layout = layoutFromHandle(store);
+    danmaku::LayoutConfig config;
+    constexpr jsize kAsciiCount = static_cast<jsize>(sizeof(config.font.ascii) / sizeof(config.font.ascii[0]));
+    if (layout == nullptr || ascii == nullptr || env->GetArrayLength(ascii) != kAsciiCount) return JNI_FALSE;
+    config.width = width;
+    config.height = height;
+    config.text_scale = textScale;
+    config.stroke = stroke;
+    config.lane_height = laneHeight;
+    config.scroll_duration_ms = scrollDurationMs;
+    config.fixed_duration_ms = fixedDurationMs;
+    env->GetFloatArrayRegion(ascii, 0, kAsciiCount, config.font.ascii);
+    config.font.wide = wide;
+    config.font.other = other;
+    config.font.line = line;
+    layout->Configure(config);
+    return JNI_TRUE;
+}
+
+// `mask` is a block mask as filled by DanmakuBlockMatcher.nativeScan; null shows every comment.
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeSetHidden(JNIEnv* env, jclass, jlong store, jlongArray mask) {
+    auto* layout = layoutFromHandle(store);
+    if (layout == nullptr) return;
+    if (mask == nullptr) {
+        layout->SetHidden(nullptr, 0);
+        return;
+    }
+    std::vector<uint64_t> words(static_cast<size_t>(env->GetArrayLength(mask)));
+    env->GetLongArrayRegion(mask, 0, static_cast<jsize>(words.size()), reinterpret_cast<jlong*>(words.data()));
+    layout->SetHidden(words.data(), words.size());
+}
+
+// Folds the duplicates found by the last DanmakuMerge run of the store, or stops folding.
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeSetMerged(JNIEnv*, jclass, jlong store, jboolean merged) {
+    auto* layout = layoutFromHandle(store);
+    if (layout == nullptr) return;
+    const std::vector<uint16_t>& counts = fromHandle(store)->repeatCounts;
+    if (merged && !counts.empty()) {
+        layout->SetRepeatCounts(counts.data(), counts.size());
+    } else {
+        layout->SetRepeatCounts(nullptr, 0);
+    }
+}
+
+// Restores the placements cached for the current configuration, hidden rows and repeat counts,
+// or lays everything out and caches the result.
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeLayoutAll(JNIEnv*, jclass, jlong store, jint threads) {
+    auto* layout = layoutFromHandle(store);
+    if (layout == nullptr) return;
+    const auto started = std::chrono::steady_clock::now();
+    danmaku::DanmakuCache* cache = fromHandle(store)->cache.get();
+    const uint64_t fingerprint = layout->Fingerprint();
+    size_t cachedBytes = 0;
+    std::shared_ptr<const void> cachedOwner;
+    const uint8_t* cached =
+        cache == nullptr ? nullptr : cache->Find(danmaku::kSectionLayout, fingerprint, &cachedBytes, &cachedOwner);
+    if (cached != nullptr && cachedBytes % sizeof(danmaku::Placement) == 0 &&
+        layout->Restore(reinterpret_cast<const danmaku::Placement*>(cached), cachedBytes / sizeof(danmaku::Placement))) {
+        __android_log_print(ANDROID_LOG_INFO, kLogTag, "restored %zu windows from cache in %lld us",
+                            layout->window_count(), elapsedUs(started));
+        return;
+    }
+    layout->LayoutAll(threads);
+    __android_log_print(ANDROID_LOG_INFO, kLogTag, "laid out %zu windows in %lld ms", layout->window_count(),
+                        elapsedUs(started) / 1000);
+    if (cache != nullptr) {
+        cache->Put(danmaku::kSectionLayout, fingerprint, layout->placements(), layout->placements_bytes());
+    }
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeLayout(JNIEnv*, jclass, jlong store, jlong fromMs, jlong toMs) {
+    auto* layout = layoutFromHandle(store);
+    if (layout == nullptr) return 0;
+    return static_cast<jint>(layout->Layout(fromMs, toMs));
+}
+
+// Direct view of the placements (danmaku::Placement rows); valid until the store is released.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_xyoye_danmaku_DanmakuLayout_nativeBuffer(JNIEnv* env, jclass, jlong store) {
+    auto* layout = layoutFromHandle(store);
+    if (layout == nullptr || layout->placements_bytes() == 0) return nullptr;
+    return env->NewDirectByteBuffer(const_cast<danmaku::Placement*>(layout->placements()),
+                                    static_cast<jlong>(layout->placements_bytes()));
+}
+
+// Loads the density index of `store` from its danmaku cache, or builds it (tagging comments that
+// contain one of `keywords`) and stores it there. The view is valid until the next load or
+// nativeRelease.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_xyoye_danmaku_DanmakuDensity_nativeLoad(
+    JNIEnv* env, jclass, jlong store, jstring sourcePath, jobjectArray keywords) {
+    auto* storeHandle = fromHandle(store);
+    if (storeHandle == nullptr || !storeHandle->store) return nullptr;
+    const std::vector<std::string> keywordList = stringArrayToUtf8(env, keywords);
+    const danmaku::DensityOptions options;
+    const std::string sourceString = jstringToString(env, sourcePath);
+    const uint64_t key = sourceString.empty() ? 0 : danmaku::DensityCacheKey(sourceString, keywordList, options);
+
+    danmaku::DanmakuCache* cache = storeHandle->cache.get();
+    size_t cachedBytes = 0;
+    std::shared_ptr<const void> cachedOwner;
+    const uint8_t* cached =
+        cache == nullptr ? nullptr : cache->Find(danmaku::kSectionDensity, key, &cachedBytes, &cachedOwner);
+    storeHandle->density = danmaku::LoadDensityIndex(cached, cachedBytes, key);
+    if (!storeHandle->density) {
+        const auto started = std::chrono::steady_clock::now();
+        const danmaku::CommentStore& comments = *storeHandle->store;
+        const size_t words = (static_cast<size_t>(comments.count()) + 63) / 64;
+        std::vector<uint64_t> tagMask(words);
+        std::vector<uint64_t> literalMask(words);
+        danmaku::BlockFilter(keywordList, {}).Scan(comments, 0, tagMask.data(), literalMask.data());
+        storeHandle->density = danmaku::BuildDensityIndex(comments, tagMask.data(), options, key);
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+        __android_log_print(ANDROID_LOG_INFO, kLogTag, "density index: %u seconds, %u peaks in %lld us",
+                            storeHandle->density->seconds(), storeHandle->density->peak_count(),
+                            static_cast<long long>(elapsed));
+        if (key != 0 && cache != nullptr) {
+            cache->Put(danmaku::kSectionDensity, key, storeHandle->density->data(), storeHandle->density->bytes());
+        }
+    }
+    return env->NewDirectByteBuffer(const_cast<uint8_t*>(storeHandle->density->data()),
+                                    static_cast<jlong>(storeHandle->density->bytes()));
+}
+
+// Repeat counts of every comment (see danmaku::MergeDuplicates), u16 per row; rows set in
+// `excluded` (same layout as nativeSetHidden) are left out of every group. The view is valid
+// until the next merge or nativeRelease.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_xyoye_danmaku_DanmakuMerge_nativeMerge(
+    JNIEnv* env, jclass, jlong store, jint windowMs, jint maxRun, jboolean foldWidth, jfloat fuzzyMinSimilarity,
+    jint fuzzyMinLength, jlongArray excluded) {
+    auto* storeHandle = fromHandle(store);
+    if (storeHandle == nullptr || !storeHandle->store || storeHandle->store->count() == 0) return nullptr;
+    danmaku::MergeOptions options;
+    options.window_ms = windowMs;
+    options.max_run = maxRun;
+    options.fold_width = foldWidth == JNI_TRUE;
+    options.fuzzy_min_similarity = fuzzyMinSimilarity;
+    options.fuzzy_min_length = fuzzyMinLength;
+    std::vector<uint64_t> excludedWords;
+    if (excluded != nullptr) {
+        excludedWords.resize(static_cast<size_t>(env->GetArrayLength(excluded)));
+        env->GetLongArrayRegion(excluded, 0, static_cast<jsize>(excludedWords.size()),
+                                reinterpret_cast<jlong*>(excludedWords.data()));
+    }
+    const auto started = std::chrono::steady_clock::now();
+    danmaku::MergeDuplicates(*storeHandle->store, options, &storeHandle->repeatCounts, excludedWords.data(),
+                             excludedWords.size());
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    __android_log_print(ANDROID_LOG_INFO, kLogTag, "merged duplicates of %u comments in %lld ms",
+                        storeHandle->store->count(), static_cast<long long>(elapsed));
+    return env->NewDirectByteBuffer(storeHandle->repeatCounts.data(),
+                                    static_cast<jlong>(storeHandle->repeatCounts.size() * sizeof(uint16_t)));
+}
+
+// Live danmaku decoder of one websocket connection (see danmaku::LiveDecoder), called from
+// bilibili_component's LiveDanmakuNativeCodec on its decode coroutine only.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_xyoye_common_1component_bilibili_live_danmaku_LiveDanmakuNativeCodec_nativeCreate(JNIEnv*, jclass) {
+    return reinterpret_cast<jlong>(new danmaku::LiveDecoder());
+}
+
+// Decodes one websocket message in place; the view is valid until the next decode or nativeRelease.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_xyoye_common_1component_bilibili_live_danmaku_LiveDanmakuNativeCodec_nativeDecode(
+    JNIEnv* env, jclass, jlong handle, jbyteArray message) {
+    auto* decoder = reinterpret_cast<danmaku::LiveDecoder*>(handle);
+    if (decoder == nullptr || message == nullptr) return nullptr;
+    const jsize length = env->GetArrayLength(message);
+    // Frames are split straight out of the Java array; no JNI call is made until it is released.
+    auto* bytes = static_cast<const uint8_t*>(env->GetPrimitiveArrayCritical(message, nullptr));
+    if (bytes == nullptr) return nullptr;
+    const bool decoded = decoder->Decode(bytes, static_cast<size_t>(length));
+    env->ReleasePrimitiveArrayCritical(message, const_cast<uint8_t*>(bytes), JNI_ABORT);
+    if (!decoded) return nullptr;
+    return env->NewDirectByteBuffer(const_cast<uint8_t*>(decoder->batch()), static_cast<jlong>(decoder->batch_bytes()));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_common_1component_bilibili_live_danmaku_LiveDanmakuNativeCodec_nativeSupportsBrotli(JNIEnv*, jclass) {
+    return danmaku::LiveDecoder::SupportsBrotli() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_common_1component_bilibili_live_danmaku_LiveDanmakuNativeCodec_nativeRelease(
+    JNIEnv*, jclass, jlong handle) {
+    delete reinterpret_cast<danmaku::LiveDecoder*>(handle);
+}
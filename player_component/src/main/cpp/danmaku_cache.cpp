@@ -0,0 +1,271 @@
+#include "danmaku_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "hash64.h"
+
+namespace danmaku {
+
+using hash64::Hash64;
+
+namespace {
+
+// Bigger files are not ours: a store of a million comments stays far below.
+constexpr uint64_t kMaxCacheFileBytes = 512ULL * 1024 * 1024;
+
+uint32_t ReadU32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t ReadU64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void Write(uint8_t *p, T value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+size_t Align8(size_t value) { return (value + 7) & ~static_cast<size_t>(7); }
+
+int64_t MtimeNs(const struct stat &st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+// Header fields and section table are covered together, so a torn write of either is caught.
+uint64_t HeaderChecksum(const uint8_t *file, size_t table_bytes) {
+    return Hash64(file + kCacheHeaderBytes, table_bytes, Hash64(file, kCacheHeaderBytes - 8));
+}
+
+bool HashFile(const std::string &path, uint64_t *hash) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        close(fd);
+        *hash = Hash64(nullptr, 0);
+        return true;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    *hash = Hash64(mapped, size);
+    munmap(mapped, size);
+    return true;
+}
+
+}  // namespace
+
+struct DanmakuCache::Mapping {
+    void *address = nullptr;
+    size_t bytes = 0;
+
+    ~Mapping() {
+        if (address != nullptr) {
+            munmap(address, bytes);
+        }
+    }
+};
+
+DanmakuCache::~DanmakuCache() = default;
+
+std::unique_ptr<DanmakuCache> DanmakuCache::Open(const std::string &path, const std::string &source_path) {
+    struct stat st {};
+    if (path.empty() || stat(source_path.c_str(), &st) != 0) return nullptr;
+    auto cache = std::unique_ptr<DanmakuCache>(new DanmakuCache());
+    cache->path_ = path;
+    cache->source_path_ = source_path;
+    cache->source_size_ = static_cast<uint64_t>(st.st_size);
+    cache->source_mtime_ns_ = MtimeNs(st);
+
+    if (cache->Map()) {
+        const auto *header = static_cast<const uint8_t *>(cache->mapping_->address);
+        const uint64_t cached_hash = ReadU64(header + 32);
+        if (ReadU64(header + 16) == cache->source_size_ &&
+            static_cast<int64_t>(ReadU64(header + 24)) == cache->source_mtime_ns_) {
+            cache->source_hash_ = cached_hash;
+            return cache;
+        }
+        uint64_t hash;
+        if (ReadU64(header + 16) == cache->source_size_ && HashFile(source_path, &hash) && hash == cached_hash) {
+            // Same content under a new mtime: keep every section, restamp on the next flush.
+            cache->source_hash_ = hash;
+            cache->dirty_ = true;
+            return cache;
+        }
+        cache->mapping_.reset();
+        cache->sections_.clear();
+    }
+    if (!HashFile(source_path, &cache->source_hash_)) return nullptr;
+    return cache;
+}
+
+bool DanmakuCache::Map() {
+    const int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kCacheHeaderBytes) ||
+        static_cast<uint64_t>(st.st_size) > kMaxCacheFileBytes) {
+        close(fd);
+        return false;
+    }
+    auto mapping = std::make_shared<Mapping>();
+    mapping->bytes = static_cast<size_t>(st.st_size);
+    mapping->address = mmap(nullptr, mapping->bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping->address == MAP_FAILED) {
+        mapping->address = nullptr;
+        return false;
+    }
+
+    const auto *file = static_cast<const uint8_t *>(mapping->address);
+    const size_t size = mapping->bytes;
+    if (ReadU32(file) != kCacheMagic || ReadU32(file + 4) != kCacheVersion) return false;
+    const uint32_t count = ReadU32(file + 8);
+    const size_t table_bytes = static_cast<size_t>(count) * kCacheSectionBytes;
+    if (table_bytes > size - kCacheHeaderBytes || ReadU64(file + 40) != HeaderChecksum(file, table_bytes)) {
+        return false;
+    }
+
+    std::vector<Section> sections;
+    sections.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t *row = file + kCacheHeaderBytes + static_cast<size_t>(i) * kCacheSectionBytes;
+        const uint64_t offset = ReadU64(row + 16);
+        const uint64_t bytes = ReadU64(row + 24);
+        if (offset % 8 != 0 || offset > size || bytes > size - offset) return false;
+        sections.push_back(Section{ReadU32(row), ReadU64(row + 8), file + offset, static_cast<size_t>(bytes),
+                                   ReadU64(row + 32), false, nullptr});
+    }
+    mapping_ = std::move(mapping);
+    sections_ = std::move(sections);
+    return true;
+}
+
+std::shared_ptr<const void> DanmakuCache::owner() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mapping_;
+}
+
+bool DanmakuCache::dirty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirty_;
+}
+
+bool DanmakuCache::mapped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mapping_ != nullptr;
+}
+
+const uint8_t *DanmakuCache::Find(uint32_t tag, uint64_t key, size_t *bytes, std::shared_ptr<const void> *owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = sections_.begin(); it != sections_.end(); ++it) {
+        if (it->tag != tag) continue;
+        if (it->key != key) return nullptr;
+        if (!it->verified) {
+            if (Hash64(it->data, it->bytes) != it->checksum) {
+                // Dropped so the next Put() replaces it and the next Flush() rewrites the file.
+                sections_.erase(it);
+                dirty_ = true;
+                return nullptr;
+            }
+            it->verified = true;
+        }
+        *bytes = it->bytes;
+        if (owner != nullptr) {
+            if (it->pending) {
+                *owner = it->pending;
+            } else {
+                *owner = mapping_;
+            }
+        }
+        return it->data;
+    }
+    return nullptr;
+}
+
+void DanmakuCache::Put(uint32_t tag, uint64_t key, const void *data, size_t bytes) {
+    auto copy = std::make_shared<std::vector<uint8_t>>(static_cast<const uint8_t *>(data),
+                                                       static_cast<const uint8_t *>(data) + bytes);
+    Section section{tag, key, copy->data(), bytes, Hash64(copy->data(), bytes), true, copy};
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Section &existing : sections_) {
+        if (existing.tag == tag) {
+            existing = std::move(section);
+            dirty_ = true;
+            return;
+        }
+    }
+    sections_.push_back(std::move(section));
+    dirty_ = true;
+}
+
+bool DanmakuCache::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t table_bytes = sections_.size() * kCacheSectionBytes;
+    std::vector<uint8_t> head(kCacheHeaderBytes + table_bytes, 0);
+    uint8_t *header = head.data();
+    Write(header, kCacheMagic);
+    Write(header + 4, kCacheVersion);
+    Write(header + 8, static_cast<uint32_t>(sections_.size()));
+    Write(header + 16, source_size_);
+    Write(header + 24, source_mtime_ns_);
+    Write(header + 32, source_hash_);
+    size_t offset = Align8(head.size());
+    for (size_t i = 0; i < sections_.size(); ++i) {
+        const Section &section = sections_[i];
+        uint8_t *row = header + kCacheHeaderBytes + i * kCacheSectionBytes;
+        Write(row, section.tag);
+        Write(row + 8, section.key);
+        Write(row + 16, static_cast<uint64_t>(offset));
+        Write(row + 24, static_cast<uint64_t>(section.bytes));
+        Write(row + 32, section.checksum);
+        offset = Align8(offset + section.bytes);
+    }
+    Write(header + 40, HeaderChecksum(header, table_bytes));
+
+    const std::string temporary = path_ + ".tmp";
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) return false;
+    static const uint8_t kPadding[8] = {};
+    bool written = std::fwrite(head.data(), 1, head.size(), file) == head.size();
+    size_t position = head.size();
+    for (const Section &section : sections_) {
+        if (!written) break;
+        const size_t padding = Align8(position) - position;
+        written = std::fwrite(kPadding, 1, padding, file) == padding &&
+                  std::fwrite(section.data, 1, section.bytes, file) == section.bytes;
+        position = Align8(position) + section.bytes;
+    }
+    if (std::fclose(file) != 0 || !written || std::rename(temporary.c_str(), path_.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    dirty_ = false;
+    // Pending copies are dropped for the mapped file; memory handed out before stays alive
+    // through the owner references of Find() and owner().
+    if (Map()) {
+        for (Section &section : sections_) {
+            section.verified = true;
+        }
+    }
+    return true;
+}
+
+}  // namespace danmaku
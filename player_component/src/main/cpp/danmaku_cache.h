@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace danmaku {
+
+/**
+ * Binary cache of everything derived from one danmaku source, written after
+ * the first parse and mapped read-only on later opens (integers little
+ * endian, sections 8-byte aligned):
+ *
+ *   u32 magic "DDCC", u32 version, u32 section_count, u32 reserved
+ *   u64 source_size, i64 source_mtime_ns, u64 source_hash (Hash64 of the source bytes)
+ *   u64 header_checksum (Hash64 of the 40 bytes above and the section table)
+ *   section_count x {u32 tag, u32 reserved, u64 key, u64 offset, u64 bytes, u64 checksum}
+ *   sections
+ *
+ * A section is only returned for the key it was stored with (the producer's
+ * inputs: block list, layout configuration, ...) and when its checksum holds.
+ * Sections are stored in the producer's own block format, so each keeps its
+ * own magic and version as well.
+ *
+ * One cache serves every entry point of a store (scan, layout, density,
+ * merge), which may run on different threads, so all members lock.
+ */
+constexpr uint32_t kCacheMagic = 0x43434444;  // "DDCC"
+constexpr uint32_t kCacheVersion = 1;
+constexpr size_t kCacheHeaderBytes = 48;
+constexpr size_t kCacheSectionBytes = 40;
+
+constexpr uint32_t kSectionStore = 0x524F5453;    // "STOR": CommentStore block
+constexpr uint32_t kSectionFilter = 0x544C4946;   // "FILT": keyword then literal mask of BlockFilter::Scan
+constexpr uint32_t kSectionLayout = 0x4F59414C;   // "LAYO": Placement rows of LayoutEngine
+constexpr uint32_t kSectionDensity = 0x534E4544;  // "DENS": DensityIndex block
+
+class DanmakuCache {
+public:
+    ~DanmakuCache();
+
+    /**
+     * Binds the cache file at `path` to `source_path`. An existing file is
+     * used when it belongs to the source: same size and mtime, or otherwise
+     * the same content hash (a re-download of the same track). Anything else
+     * starts empty and is replaced by the next Flush(). Null when the source
+     * cannot be read.
+     */
+    static std::unique_ptr<DanmakuCache> Open(const std::string &path, const std::string &source_path);
+
+    // Section `tag` when stored with `key` and intact; the checksum is verified on first access.
+    // The bytes stay valid while `owner` (when given) is held; without it, only until another
+    // thread calls Put() for the same tag or Flush().
+    const uint8_t *Find(uint32_t tag, uint64_t key, size_t *bytes, std::shared_ptr<const void> *owner = nullptr);
+
+    // Keeps the memory of mapped Find() results alive, also across Flush().
+    std::shared_ptr<const void> owner() const;
+
+    // Adds or replaces section `tag`; the data is copied and written by the next Flush().
+    void Put(uint32_t tag, uint64_t key, const void *data, size_t bytes);
+
+    bool dirty() const;
+    bool mapped() const;
+
+    // Rewrites the file through a temporary file renamed into place and maps the
+    // result; false on any I/O error.
+    bool Flush();
+
+private:
+    struct Mapping;
+    struct Section {
+        uint32_t tag;
+        uint64_t key;
+        const uint8_t *data;
+        size_t bytes;
+        uint64_t checksum;
+        bool verified;
+        std::shared_ptr<std::vector<uint8_t>> pending;  // set until flushed
+    };
+
+    DanmakuCache() = default;
+    bool Map();  // called with mutex_ held, or before the cache is shared
+
+    mutable std::mutex mutex_;  // guards mapping_, sections_ and dirty_; held across Flush()
+    std::string path_;
+    std::string source_path_;
+    uint64_t source_size_ = 0;
+    int64_t source_mtime_ns_ = 0;
+    uint64_t source_hash_ = 0;
+    std::shared_ptr<Mapping> mapping_;
+    std::vector<Section> sections_;
+    bool dirty_ = false;
+};
+
+}  // namespace danmaku
@@ -0,0 +1,242 @@
+#include "danmaku_density.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace danmaku {
+namespace {
+
+// Rows compared per step when looking for the end of a second; a fixed-size
+// compare-and-sum the compiler turns into vector code.
+constexpr uint32_t kBinBlock = 16;
+
+uint32_t ReadU32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t ReadU64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void Write(uint8_t *p, T value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+size_t BlockBytes(uint32_t seconds, uint32_t peaks) {
+    return kDensityHeaderBytes + static_cast<size_t>(seconds) * 12 + static_cast<size_t>(peaks) * 8;
+}
+
+class Fnv1a {
+public:
+    void Add(const void *data, size_t size) {
+        const auto *p = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ p[i]) * 0x100000001B3ULL;
+        }
+    }
+    template <typename T>
+    void AddValue(T value) {
+        Add(&value, sizeof(value));
+    }
+    uint64_t hash() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xCBF29CE484222325ULL;
+};
+
+// Comments per second of the time column, which is sorted. Every second ends
+// where the first time >= its upper bound is; the number of times below the
+// bound in a block is exactly how far that end lies inside it.
+void CountPerSecond(const CommentStore &store, uint32_t *count, uint32_t seconds) {
+    const uint32_t rows = store.count();
+    uint32_t row = 0;
+    for (uint32_t second = 0; second < seconds; ++second) {
+        const int32_t bound = static_cast<int32_t>(std::min<int64_t>((second + 1) * int64_t{1000}, INT32_MAX));
+        const uint32_t first = row;
+        while (row + kBinBlock <= rows) {
+            uint32_t below = 0;
+            for (uint32_t i = 0; i < kBinBlock; ++i) {
+                below += store.time_ms(row + i) < bound ? 1 : 0;
+            }
+            row += below;
+            if (below < kBinBlock) break;
+        }
+        if (row + kBinBlock > rows) {
+            while (row < rows && store.time_ms(row) < bound) {
+                ++row;
+            }
+        }
+        count[second] = row - first;
+    }
+}
+
+void CountTagged(const CommentStore &store, const uint64_t *tag_mask, uint32_t *tagged, uint32_t seconds) {
+    const uint32_t rows = store.count();
+    const size_t words = (static_cast<size_t>(rows) + 63) / 64;
+    for (size_t word = 0; word < words; ++word) {
+        for (uint64_t bits = tag_mask[word]; bits != 0; bits &= bits - 1) {
+            const auto row = static_cast<uint32_t>(word * 64 + __builtin_ctzll(bits));
+            if (row >= rows) break;
+            const uint32_t second = static_cast<uint32_t>(std::max(0, store.time_ms(row)) / 1000);
+            ++tagged[std::min(second, seconds - 1)];
+        }
+    }
+}
+
+void Smooth(const std::vector<float> &raw, float sigma, float *heat) {
+    const int radius = sigma > 0.0F ? static_cast<int>(std::ceil(sigma * 3.0F)) : 0;
+    std::vector<float> kernel(static_cast<size_t>(radius) * 2 + 1);
+    float total = 0.0F;
+    for (int k = -radius; k <= radius; ++k) {
+        const float weight = radius == 0 ? 1.0F : std::exp(-0.5F * k * k / (sigma * sigma));
+        kernel[k + radius] = weight;
+        total += weight;
+    }
+    for (float &weight : kernel) {
+        weight /= total;
+    }
+    const int seconds = static_cast<int>(raw.size());
+    for (int second = 0; second < seconds; ++second) {
+        const int from = std::max(0, second - radius);
+        const int to = std::min(seconds - 1, second + radius);
+        float sum = 0.0F;
+        for (int s = from; s <= to; ++s) {
+            sum += kernel[s - second + radius] * raw[s];
+        }
+        heat[second] = sum;
+    }
+}
+
+// Local maxima above mean + peak_sigmas * stddev, strongest first, at least
+// min_peak_gap_seconds apart; returned in time order.
+std::vector<uint32_t> FindPeaks(const float *heat, uint32_t seconds, const DensityOptions &options) {
+    double sum = 0.0;
+    double squares = 0.0;
+    for (uint32_t s = 0; s < seconds; ++s) {
+        sum += heat[s];
+        squares += static_cast<double>(heat[s]) * heat[s];
+    }
+    const double mean = sum / seconds;
+    const double deviation = std::sqrt(std::max(0.0, squares / seconds - mean * mean));
+    const double threshold = mean + options.peak_sigmas * deviation;
+
+    std::vector<uint32_t> candidates;
+    for (uint32_t s = 0; s < seconds; ++s) {
+        if (heat[s] <= 0.0F || heat[s] < threshold) continue;
+        if (s > 0 && heat[s - 1] > heat[s]) continue;
+        if (s + 1 < seconds && heat[s + 1] >= heat[s]) continue;
+        candidates.push_back(s);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [heat](uint32_t a, uint32_t b) { return heat[a] > heat[b]; });
+    std::vector<uint32_t> peaks;
+    const auto gap = static_cast<int64_t>(std::max(0, options.min_peak_gap_seconds));
+    for (const uint32_t candidate : candidates) {
+        if (static_cast<int32_t>(peaks.size()) >= options.max_peaks) break;
+        const bool isolated = std::none_of(peaks.begin(), peaks.end(), [&](uint32_t peak) {
+            return std::llabs(static_cast<int64_t>(peak) - candidate) < gap;
+        });
+        if (isolated) peaks.push_back(candidate);
+    }
+    std::sort(peaks.begin(), peaks.end());
+    return peaks;
+}
+
+}  // namespace
+
+uint32_t DensityIndex::seconds() const { return ReadU32(block_.data() + 8); }
+
+uint32_t DensityIndex::peak_count() const { return ReadU32(block_.data() + 12); }
+
+uint64_t DensityIndex::key() const { return ReadU64(block_.data() + 16); }
+
+std::unique_ptr<DensityIndex> BuildDensityIndex(const CommentStore &store, const uint64_t *tag_mask,
+                                                const DensityOptions &options, uint64_t key) {
+    const uint32_t rows = store.count();
+    const uint32_t seconds = rows == 0 ? 0 : static_cast<uint32_t>(std::max(0, store.time_ms(rows - 1)) / 1000) + 1;
+
+    std::vector<uint32_t> count(seconds, 0);
+    std::vector<uint32_t> tagged(seconds, 0);
+    std::vector<float> heat(seconds, 0.0F);
+    if (seconds > 0) {
+        CountPerSecond(store, count.data(), seconds);
+        if (tag_mask != nullptr) {
+            CountTagged(store, tag_mask, tagged.data(), seconds);
+        }
+        std::vector<float> raw(seconds);
+        for (uint32_t s = 0; s < seconds; ++s) {
+            raw[s] = static_cast<float>(count[s]) + options.tag_weight * static_cast<float>(tagged[s]);
+        }
+        Smooth(raw, options.sigma_seconds, heat.data());
+    }
+    const std::vector<uint32_t> peaks =
+        seconds == 0 ? std::vector<uint32_t>() : FindPeaks(heat.data(), seconds, options);
+    const auto peak_count = static_cast<uint32_t>(peaks.size());
+
+    auto index = std::make_unique<DensityIndex>();
+    index->block_.assign(BlockBytes(seconds, peak_count), 0);
+    uint8_t *p = index->block_.data();
+    Write(p, kDensityMagic);
+    Write(p + 4, kDensityVersion);
+    Write(p + 8, seconds);
+    Write(p + 12, peak_count);
+    Write(p + 16, key);
+    Write(p + 24, seconds == 0 ? 0.0F : *std::max_element(heat.begin(), heat.end()));
+    Write(p + 28, seconds == 0 ? 0U : *std::max_element(count.begin(), count.end()));
+    p += kDensityHeaderBytes;
+    std::memcpy(p, count.data(), seconds * sizeof(uint32_t));
+    p += seconds * sizeof(uint32_t);
+    std::memcpy(p, tagged.data(), seconds * sizeof(uint32_t));
+    p += seconds * sizeof(uint32_t);
+    std::memcpy(p, heat.data(), seconds * sizeof(float));
+    p += seconds * sizeof(float);
+    std::memcpy(p, peaks.data(), peak_count * sizeof(uint32_t));
+    p += peak_count * sizeof(uint32_t);
+    for (const uint32_t peak : peaks) {
+        Write(p, heat[peak]);
+        p += sizeof(float);
+    }
+    return index;
+}
+
+uint64_t DensityCacheKey(const std::string &source_path, const std::vector<std::string> &keywords,
+                         const DensityOptions &options) {
+    struct stat st {};
+    if (source_path.empty() || stat(source_path.c_str(), &st) != 0) return 0;
+    Fnv1a hash;
+    hash.AddValue(kDensityVersion);
+    hash.AddValue(static_cast<int64_t>(st.st_size));
+    hash.AddValue(static_cast<int64_t>(st.st_mtim.tv_sec));
+    hash.AddValue(static_cast<int64_t>(st.st_mtim.tv_nsec));
+    hash.AddValue(options.tag_weight);
+    hash.AddValue(options.sigma_seconds);
+    hash.AddValue(options.peak_sigmas);
+    hash.AddValue(options.min_peak_gap_seconds);
+    hash.AddValue(options.max_peaks);
+    for (const std::string &keyword : keywords) {
+        hash.AddValue(static_cast<uint32_t>(keyword.size()));
+        hash.Add(keyword.data(), keyword.size());
+    }
+    return hash.hash() == 0 ? 1 : hash.hash();
+}
+
+std::unique_ptr<DensityIndex> LoadDensityIndex(const uint8_t *data, size_t bytes, uint64_t key) {
+    if (key == 0 || data == nullptr || bytes < kDensityHeaderBytes || ReadU32(data) != kDensityMagic ||
+        ReadU32(data + 4) != kDensityVersion || ReadU64(data + 16) != key ||
+        bytes != BlockBytes(ReadU32(data + 8), ReadU32(data + 12))) {
+        return nullptr;
+    }
+    auto index = std::make_unique<DensityIndex>();
+    index->block_.assign(data, data + bytes);
+    return index;
+}
+
+}  // namespace danmaku
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "danmaku_store.h"
+
+namespace danmaku {
+
+/**
+ * Per-second comment density of a store plus its hot moments, one contiguous
+ * block handed to Kotlin as a direct ByteBuffer and written to disk as is
+ * (little endian, every section 4-byte aligned):
+ *
+ *   u32 magic "DDDI", u32 version, u32 seconds, u32 peak_count
+ *   u64 key            (DensityCacheKey of the source; 0 when not cacheable)
+ *   f32 max_heat, u32 max_count
+ *   seconds x u32 count   (comments starting in [s, s + 1) seconds)
+ *   seconds x u32 tagged  (of those, comments containing a hot keyword)
+ *   seconds x f32 heat    (count + tag_weight * tagged, Gaussian smoothed)
+ *   peak_count x u32 peak second, ascending
+ *   peak_count x f32 peak heat
+ *
+ * DanmakuDensity.kt reads the same layout.
+ */
+constexpr uint32_t kDensityMagic = 0x49444444;  // "DDDI"
+constexpr uint32_t kDensityVersion = 1;
+constexpr size_t kDensityHeaderBytes = 32;
+
+struct DensityOptions {
+    float tag_weight = 4.0F;     // a tagged comment counts this much extra
+    float sigma_seconds = 2.0F;  // Gaussian smoothing of the heat curve
+    float peak_sigmas = 1.5F;    // a peak must exceed mean + peak_sigmas * stddev of the heat
+    int32_t min_peak_gap_seconds = 30;
+    int32_t max_peaks = 16;
+};
+
+class DensityIndex {
+public:
+    const uint8_t *data() const { return block_.data(); }
+    size_t bytes() const { return block_.size(); }
+    uint32_t seconds() const;
+    uint32_t peak_count() const;
+    uint64_t key() const;
+
+private:
+    friend std::unique_ptr<DensityIndex> BuildDensityIndex(const CommentStore &, const uint64_t *,
+                                                           const DensityOptions &, uint64_t);
+    friend std::unique_ptr<DensityIndex> LoadDensityIndex(const uint8_t *, size_t, uint64_t);
+
+    std::vector<uint8_t> block_;
+};
+
+/**
+ * Bins `store` by second. Bit i of `tag_mask` (word i / 64, as produced by
+ * BlockFilter::Scan over the hot keywords) tags comment i; nullptr tags none.
+ */
+std::unique_ptr<DensityIndex> BuildDensityIndex(const CommentStore &store, const uint64_t *tag_mask,
+                                                const DensityOptions &options, uint64_t key);
+
+/**
+ * Identifies an index built from the danmaku file at `source_path` (size and
+ * modification time) with `keywords` and `options`; 0 when the file cannot be
+ * stat'ed, in which case the index is not cached.
+ */
+uint64_t DensityCacheKey(const std::string &source_path, const std::vector<std::string> &keywords,
+                         const DensityOptions &options);
+
+// Copies an index block (e.g. a DanmakuCache section); null when malformed or built for another key.
+std::unique_ptr<DensityIndex> LoadDensityIndex(const uint8_t *data, size_t bytes, uint64_t key);
+
+}  // namespace danmaku
@@ -0,0 +1,182 @@
+#include "danmaku_filter.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <thread>
+
+#include "hash64.h"
+
+namespace danmaku {
+
+using hash64::Hash64;
+
+namespace {
+
+constexpr uint32_t kMinRowsPerThread = 8192;
+constexpr int kMaxScanThreads = 4;
+
+std::vector<std::string> Concat(const std::vector<std::string> &first, const std::vector<std::string> &second) {
+    std::vector<std::string> all;
+    all.reserve(first.size() + second.size());
+    all.insert(all.end(), first.begin(), first.end());
+    all.insert(all.end(), second.begin(), second.end());
+    return all;
+}
+
+uint64_t ListFingerprint(const std::vector<std::string> &items, uint64_t seed) {
+    uint64_t hash = Hash64(nullptr, 0, seed + items.size());
+    for (const std::string &item : items) {
+        const auto length = static_cast<uint64_t>(item.size());
+        hash = Hash64(item.data(), item.size(), Hash64(&length, sizeof(length), hash));
+    }
+    return hash;
+}
+
+}  // namespace
+
+KeywordAutomaton::KeywordAutomaton(const std::vector<std::string> &patterns) {
+    // Build a trie with ordered children first, then flatten it breadth first.
+    std::vector<std::map<uint8_t, uint32_t>> children(1);
+    std::vector<std::vector<uint32_t>> own_outputs(1);
+    for (size_t id = 0; id < patterns.size(); ++id) {
+        const std::string &pattern = patterns[id];
+        if (pattern.empty()) continue;
+        ++pattern_count_;
+        uint32_t state = 0;
+        for (const char c : pattern) {
+            const auto byte = static_cast<uint8_t>(c);
+            auto found = children[state].find(byte);
+            if (found == children[state].end()) {
+                const auto next = static_cast<uint32_t>(children.size());
+                children[state].emplace(byte, next);
+                children.emplace_back();
+                own_outputs.emplace_back();
+                state = next;
+            } else {
+                state = found->second;
+            }
+        }
+        own_outputs[state].push_back(static_cast<uint32_t>(id));
+    }
+
+    states_.resize(children.size());
+    for (uint32_t state = 0; state < children.size(); ++state) {
+        states_[state].first_edge = static_cast<uint32_t>(edges_.size());
+        states_[state].edge_count = static_cast<uint32_t>(children[state].size());
+        for (const auto &[byte, target] : children[state]) {
+            edges_.push_back({byte, target});
+        }
+    }
+    for (const auto &[byte, target] : children[0]) {
+        root_[byte] = target;
+    }
+
+    // Failure links in BFS order, so a state's fail target is final before its children.
+    std::vector<std::vector<uint32_t>> all_outputs(states_.size());
+    std::deque<uint32_t> queue;
+    for (const auto &[byte, target] : children[0]) {
+        states_[target].fail = 0;
+        all_outputs[target] = own_outputs[target];
+        queue.push_back(target);
+    }
+    while (!queue.empty()) {
+        const uint32_t state = queue.front();
+        queue.pop_front();
+        for (const auto &[byte, target] : children[state]) {
+            const uint32_t fail = Next(states_[state].fail, byte);
+            states_[target].fail = fail;
+            all_outputs[target] = own_outputs[target];
+            all_outputs[target].insert(all_outputs[target].end(), all_outputs[fail].begin(), all_outputs[fail].end());
+            queue.push_back(target);
+        }
+    }
+    for (uint32_t state = 0; state < states_.size(); ++state) {
+        states_[state].first_output = static_cast<uint32_t>(outputs_.size());
+        states_[state].output_count = static_cast<uint32_t>(all_outputs[state].size());
+        outputs_.insert(outputs_.end(), all_outputs[state].begin(), all_outputs[state].end());
+    }
+}
+
+uint32_t KeywordAutomaton::Next(uint32_t state, uint8_t byte) const {
+    while (state != 0) {
+        const State &current = states_[state];
+        const Edge *begin = edges_.data() + current.first_edge;
+        const Edge *end = begin + current.edge_count;
+        const Edge *found =
+            std::lower_bound(begin, end, byte, [](const Edge &edge, uint8_t value) { return edge.byte < value; });
+        if (found != end && found->byte == byte) {
+            return found->target;
+        }
+        state = current.fail;
+    }
+    return root_[byte];
+}
+
+BlockFilter::BlockFilter(const std::vector<std::string> &keywords, const std::vector<std::string> &regex_literals)
+    : keyword_count_(static_cast<uint32_t>(keywords.size())),
+      fingerprint_(ListFingerprint(regex_literals, ListFingerprint(keywords, 0))),
+      automaton_(Concat(keywords, regex_literals)) {}
+
+uint32_t BlockFilter::Match(std::string_view text) const {
+    uint32_t result = 0;
+    automaton_.Scan(text, [&](uint32_t id) {
+        if (id < keyword_count_) {
+            result = kMatchKeyword;
+            return true;
+        }
+        result = kMatchRegexLiteral;
+        return false;
+    });
+    return result;
+}
+
+void BlockFilter::ScanRange(const CommentStore &store, uint32_t begin, uint32_t end, uint64_t *keyword_mask,
+                            uint64_t *literal_mask) const {
+    for (uint32_t row = begin; row < end; ++row) {
+        const uint32_t match = Match(store.text(row));
+        const uint64_t bit = uint64_t{1} << (row & 63);
+        if (match == kMatchKeyword) {
+            keyword_mask[row >> 6] |= bit;
+        } else if (match == kMatchRegexLiteral) {
+            literal_mask[row >> 6] |= bit;
+        }
+    }
+}
+
+void BlockFilter::Scan(const CommentStore &store, int threads, uint64_t *keyword_mask, uint64_t *literal_mask) const {
+    const uint32_t count = store.count();
+    const size_t words = (static_cast<size_t>(count) + 63) / 64;
+    std::fill(keyword_mask, keyword_mask + words, 0);
+    std::fill(literal_mask, literal_mask + words, 0);
+    if (automaton_.empty() || count == 0) {
+        return;
+    }
+    if (threads <= 0) {
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        threads = std::min({cores, kMaxScanThreads, static_cast<int>(count / kMinRowsPerThread) + 1});
+    }
+    if (threads <= 1) {
+        ScanRange(store, 0, count, keyword_mask, literal_mask);
+        return;
+    }
+
+    // Whole 64-row words per thread, so no two threads write the same mask word.
+    const size_t words_per_thread = (words + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        const size_t begin = std::min<size_t>(count, i * words_per_thread * 64);
+        const size_t end = std::min<size_t>(count, (i + 1) * words_per_thread * 64);
+        if (begin >= end) break;
+        workers.emplace_back([=, &store] {
+            ScanRange(store, static_cast<uint32_t>(begin), static_cast<uint32_t>(end), keyword_mask, literal_mask);
+        });
+    }
+    ScanRange(store, 0, static_cast<uint32_t>(std::min<size_t>(count, words_per_thread * 64)), keyword_mask,
+              literal_mask);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+}  // namespace danmaku
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "danmaku_store.h"
+
+namespace danmaku {
+
+/**
+ * Aho-Corasick automaton over UTF-8 bytes. The root has a dense 256-entry table,
+ * the other states sorted sparse edges plus failure links; every state lists the
+ * patterns ending there, including those inherited through its failure chain.
+ */
+class KeywordAutomaton {
+public:
+    // Pattern ids are indices into `patterns`; empty patterns never match.
+    explicit KeywordAutomaton(const std::vector<std::string> &patterns);
+
+    bool empty() const { return pattern_count_ == 0; }
+
+    // Calls `on_match(pattern_id)` for every occurrence, stopping when it returns true.
+    template <typename OnMatch>
+    void Scan(std::string_view text, OnMatch &&on_match) const {
+        uint32_t state = 0;
+        for (const char c : text) {
+            state = Next(state, static_cast<uint8_t>(c));
+            const State &current = states_[state];
+            for (uint32_t i = 0; i < current.output_count; ++i) {
+                if (on_match(outputs_[current.first_output + i])) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    struct State {
+        uint32_t first_edge = 0;
+        uint32_t edge_count = 0;
+        uint32_t fail = 0;
+        uint32_t first_output = 0;
+        uint32_t output_count = 0;
+    };
+    struct Edge {
+        uint8_t byte;
+        uint32_t target;
+    };
+
+    uint32_t Next(uint32_t state, uint8_t byte) const;
+
+    size_t pattern_count_ = 0;
+    uint32_t root_[256] = {};
+    std::vector<State> states_;
+    std::vector<Edge> edges_;
+    std::vector<uint32_t> outputs_;
+};
+
+/**
+ * Danmaku block list compiled for batch filtering. Keywords block on substring
+ * match. Regexes keep Java semantics and are confirmed by DanmakuBlockMatcher.kt;
+ * this side only prefilters them by the literal each one requires, so most texts
+ * never reach java.util.regex.
+ */
+class BlockFilter {
+public:
+    static constexpr uint32_t kMatchKeyword = 1;
+    static constexpr uint32_t kMatchRegexLiteral = 2;
+
+    BlockFilter(const std::vector<std::string> &keywords, const std::vector<std::string> &regex_literals);
+
+    // kMatchKeyword if any keyword occurs, otherwise kMatchRegexLiteral if any literal does.
+    uint32_t Match(std::string_view text) const;
+
+    /**
+     * Matches every comment of `store`. Bit i of the masks (word i / 64) is set
+     * when comment i has a keyword / a regex literal. `threads` <= 0 picks a count
+     * from the store size and the cores available; every thread owns whole words.
+     */
+    void Scan(const CommentStore &store, int threads, uint64_t *keyword_mask, uint64_t *literal_mask) const;
+
+    // Hash of the keyword and literal lists; equal fingerprints scan to equal masks.
+    uint64_t fingerprint() const { return fingerprint_; }
+
+private:
+    void ScanRange(const CommentStore &store, uint32_t begin, uint32_t end, uint64_t *keyword_mask,
+                   uint64_t *literal_mask) const;
+
+    uint32_t keyword_count_;
+    uint64_t fingerprint_;
+    KeywordAutomaton automaton_;
+};
+
+}  // namespace danmaku
@@ -0,0 +1,378 @@
+#include "danmaku_layout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <thread>
+
+#include "hash64.h"
+#include "danmaku_utf8.h"
+
+namespace danmaku {
+
+using hash64::Hash64;
+
+namespace {
+
+constexpr int kMaxLayoutThreads = 4;
+constexpr int64_t kFreeLane = std::numeric_limits<int64_t>::min();
+
+constexpr uint8_t kModeScroll = 1;
+constexpr uint8_t kModeBottom = 4;
+constexpr uint8_t kModeTop = 5;
+constexpr uint8_t kModeReverse = 6;
+
+bool IsWide(uint32_t code) {
+    return (code >= 0x1100 && code <= 0x115F) || (code >= 0x2E80 && code <= 0xA4CF) ||
+           (code >= 0xAC00 && code <= 0xD7A3) || (code >= 0xF900 && code <= 0xFAFF) ||
+           (code >= 0xFE30 && code <= 0xFE4F) || (code >= 0xFF00 && code <= 0xFF60) ||
+           (code >= 0xFFE0 && code <= 0xFFE6) || (code >= 0x1F300 && code <= 0x1F64F) ||
+           (code >= 0x1F900 && code <= 0x1F9FF) || (code >= 0x20000 && code <= 0x3FFFD);
+}
+
+// A scrolling comment may enter a lane once the previous occupant's tail is on
+// screen, unless it is faster and would catch that tail before it leaves.
+bool CanScrollEnter(int64_t previous_start, float previous_width, int64_t start, float width, int32_t duration,
+                    int screen_width) {
+    if (previous_start == kFreeLane) return true;
+    const double elapsed = static_cast<double>(start - previous_start);
+    if (elapsed >= duration) return true;
+    const double previous_speed = (screen_width + static_cast<double>(previous_width)) / duration;
+    const double speed = (screen_width + static_cast<double>(width)) / duration;
+    if (elapsed * previous_speed < previous_width) return false;
+    return speed <= previous_speed || static_cast<double>(start) + screen_width / speed >=
+                                          static_cast<double>(previous_start) + duration;
+}
+
+bool IsBlank(std::string_view text) {
+    return std::all_of(text.begin(), text.end(), [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); });
+}
+
+bool SamePlacement(const Placement &a, const Placement &b) {
+    return a.lane == b.lane && a.flags == b.flags;
+}
+
+}  // namespace
+
+void LayoutEngine::Lanes::Reset(size_t lanes) {
+    scroll_start.assign(lanes, kFreeLane);
+    scroll_width.assign(lanes, 0.0F);
+    reverse_start.assign(lanes, kFreeLane);
+    reverse_width.assign(lanes, 0.0F);
+    top_until.assign(lanes, kFreeLane);
+    bottom_until.assign(lanes, kFreeLane);
+}
+
+bool LayoutEngine::Lanes::operator==(const Lanes &other) const {
+    return scroll_start == other.scroll_start && scroll_width == other.scroll_width &&
+           reverse_start == other.reverse_start && reverse_width == other.reverse_width &&
+           top_until == other.top_until && bottom_until == other.bottom_until;
+}
+
+LayoutEngine::LayoutEngine(const CommentStore &store) : store_(store) {
+    const uint32_t count = store.count();
+    placements_.assign(count, Placement{0.0F, 0.0F, 0.0F, 0, -1, 0, 0});
+    if (count == 0) return;
+    const int64_t last = std::max<int64_t>(0, store.time_ms(count - 1));
+    windows_.resize(static_cast<size_t>(last / kWindowMs) + 1);
+    uint32_t row = 0;
+    for (size_t index = 0; index < windows_.size(); ++index) {
+        windows_[index].begin = row;
+        const int64_t window_end = static_cast<int64_t>(index + 1) * kWindowMs;
+        while (row < count && store.time_ms(row) < window_end) {
+            ++row;
+        }
+        windows_[index].end = row;
+    }
+    windows_.back().end = count;
+}
+
+void LayoutEngine::Invalidate() {
+    for (auto &window : windows_) {
+        window.valid = false;
+    }
+    for (auto &placement : placements_) {
+        placement.flags = 0;
+    }
+}
+
+void LayoutEngine::Configure(const LayoutConfig &config) {
+    config_ = config;
+    Invalidate();
+}
+
+void LayoutEngine::SetHidden(const uint64_t *mask, size_t words) {
+    hidden_.clear();
+    if (mask != nullptr) {
+        hidden_.assign(mask, mask + std::min(words, (placements_.size() + 63) / 64));
+    }
+    Invalidate();
+}
+
+void LayoutEngine::SetRepeatCounts(const uint16_t *counts, size_t size) {
+    repeats_.clear();
+    if (counts != nullptr && size == placements_.size()) {
+        repeats_.assign(counts, counts + size);
+    }
+    Invalidate();
+}
+
+uint64_t LayoutEngine::Fingerprint() const {
+    const auto add = [](uint64_t hash, const auto &value) { return Hash64(&value, sizeof(value), hash); };
+    uint64_t hash = add(0, static_cast<uint64_t>(placements_.size()));
+    hash = add(hash, config_.width);
+    hash = add(hash, config_.height);
+    hash = add(hash, config_.text_scale);
+    hash = add(hash, config_.stroke);
+    hash = add(hash, config_.lane_height);
+    hash = add(hash, config_.scroll_duration_ms);
+    hash = add(hash, config_.fixed_duration_ms);
+    hash = add(hash, config_.font);
+    hash = Hash64(hidden_.data(), hidden_.size() * sizeof(uint64_t), hash);
+    return Hash64(repeats_.data(), repeats_.size() * sizeof(uint16_t), hash);
+}
+
+bool LayoutEngine::Restore(const Placement *rows, size_t count) {
+    if (count != placements_.size()) return false;
+    std::copy(rows, rows + count, placements_.begin());
+    // End lanes stay empty: every change that could make a window stale again
+    // invalidates all of them, so no seam repair ever starts from a restored window.
+    for (auto &window : windows_) {
+        window.valid = true;
+        window.end_lanes = Lanes();
+    }
+    return true;
+}
+
+float LayoutEngine::MeasureWidth(std::string_view text, uint8_t size, std::string_view suffix) const {
+    return std::ceil((Advance(text) + Advance(suffix)) * size * config_.text_scale + config_.stroke * 2.0F);
+}
+
+float LayoutEngine::Advance(std::string_view text) const {
+    const auto *p = reinterpret_cast<const unsigned char *>(text.data());
+    const auto *end = p + text.size();
+    float advance = 0.0F;
+    while (p < end) {
+        const uint32_t code = NextCodePoint(&p, end);
+        if (code >= 0x20 && code <= 0x7E) {
+            advance += config_.font.ascii[code - 0x20];
+        } else if (code == '\n') {
+            advance += config_.font.ascii[0];  // drawn as a space
+        } else if (IsWide(code)) {
+            advance += config_.font.wide;
+        } else if (code >= 0x20) {
+            advance += config_.font.other;
+        }
+    }
+    return advance;
+}
+
+int32_t LayoutEngine::max_duration_ms() const {
+    return std::max({config_.scroll_duration_ms, config_.fixed_duration_ms, 1});
+}
+
+size_t LayoutEngine::lane_count() const {
+    if (config_.lane_height <= 0.0F || config_.height <= 0) return 1;
+    return std::max<size_t>(1, static_cast<size_t>(static_cast<float>(config_.height) / config_.lane_height));
+}
+
+Placement LayoutEngine::Place(uint32_t row, Lanes *lanes) const {
+    Placement placement{0.0F, 0.0F, 0.0F, 0, -1, Placement::kLaidOut, 0};
+    if (!hidden_.empty() && (row >> 6) < hidden_.size() && (hidden_[row >> 6] >> (row & 63) & 1) != 0) {
+        placement.flags |= Placement::kHidden;
+        return placement;
+    }
+    const uint8_t mode = store_.mode(row);
+    if (mode != kModeScroll && mode != kModeBottom && mode != kModeTop && mode != kModeReverse) {
+        return placement;
+    }
+    const uint16_t repeats = repeats_.empty() ? 1 : repeats_[row];
+    if (repeats == 0) {
+        placement.flags |= Placement::kFolded;
+        return placement;
+    }
+    const std::string_view text = store_.text(row);
+    if (IsBlank(text)) return placement;
+    const uint8_t size = store_.size(row);
+    const int64_t start = store_.time_ms(row);
+    char suffix[16] = {};
+    if (repeats > 1) {
+        std::snprintf(suffix, sizeof(suffix), " +%u", static_cast<unsigned>(repeats - 1));
+    }
+    placement.width = MeasureWidth(text, size, suffix);
+    placement.height = std::ceil(size * config_.text_scale * config_.font.line + config_.stroke * 2.0F);
+    const size_t count = lanes->scroll_start.size();
+
+    if (mode == kModeTop || mode == kModeBottom) {
+        placement.duration_ms = config_.fixed_duration_ms;
+        auto &until = mode == kModeTop ? lanes->top_until : lanes->bottom_until;
+        for (size_t lane = 0; lane < count; ++lane) {
+            if (until[lane] != kFreeLane && until[lane] > start) continue;
+            until[lane] = start + placement.duration_ms;
+            placement.lane = static_cast<int16_t>(lane);
+            placement.y = mode == kModeTop ? static_cast<float>(lane) * config_.lane_height
+                                           : static_cast<float>(config_.height) -
+                                                 static_cast<float>(lane + 1) * config_.lane_height;
+            placement.flags |= Placement::kPlaced;
+            return placement;
+        }
+        return placement;
+    }
+
+    placement.duration_ms = config_.scroll_duration_ms;
+    auto &starts = mode == kModeScroll ? lanes->scroll_start : lanes->reverse_start;
+    auto &widths = mode == kModeScroll ? lanes->scroll_width : lanes->reverse_width;
+    for (size_t lane = 0; lane < count; ++lane) {
+        if (!CanScrollEnter(starts[lane], widths[lane], start, placement.width, placement.duration_ms,
+                            config_.width)) {
+            continue;
+        }
+        starts[lane] = start;
+        widths[lane] = placement.width;
+        placement.lane = static_cast<int16_t>(lane);
+        placement.y = static_cast<float>(lane) * config_.lane_height;
+        placement.flags |= Placement::kPlaced;
+        return placement;
+    }
+    return placement;
+}
+
+void LayoutEngine::WarmUp(size_t index, Lanes *lanes) const {
+    lanes->Reset(lane_count());
+    const Window &window = windows_[index];
+    const int64_t from = static_cast<int64_t>(index) * kWindowMs - max_duration_ms();
+    uint32_t row = window.begin;
+    while (row > 0 && store_.time_ms(row - 1) >= from) {
+        --row;
+    }
+    for (; row < window.begin; ++row) {
+        Place(row, lanes);
+    }
+}
+
+void LayoutEngine::Compute(size_t index, const Lanes &start) {
+    Window &window = windows_[index];
+    Lanes lanes = start;
+    for (uint32_t row = window.begin; row < window.end; ++row) {
+        placements_[row] = Place(row, &lanes);
+    }
+    window.end_lanes = std::move(lanes);
+    window.valid = true;
+}
+
+bool LayoutEngine::Repair(size_t index) {
+    Window &window = windows_[index];
+    Lanes lanes = windows_[index - 1].end_lanes;
+    // Lanes only remember occupants that have not left the screen, so once the
+    // placements agree for a full max-duration the states agree as well.
+    const int32_t settle = max_duration_ms();
+    int64_t last_difference = window.begin < window.end ? store_.time_ms(window.begin) : 0;
+    for (uint32_t row = window.begin; row < window.end; ++row) {
+        if (store_.time_ms(row) - last_difference >= settle) {
+            return false;
+        }
+        const Placement placement = Place(row, &lanes);
+        if (!SamePlacement(placement, placements_[row])) {
+            placements_[row] = placement;
+            last_difference = store_.time_ms(row);
+        }
+    }
+    if (lanes == window.end_lanes) {
+        return false;
+    }
+    window.end_lanes = std::move(lanes);
+    return true;
+}
+
+void LayoutEngine::Run(const std::vector<size_t> &stale, int threads) {
+    if (stale.empty()) return;
+    const size_t count = windows_.size();
+    std::vector<char> recomputed(count, 0);
+    for (const size_t index : stale) {
+        recomputed[index] = 1;
+    }
+    // Seeds are chosen before anything changes: the end lanes of a valid predecessor
+    // that is not recomputed are exact, every other window starts from a warm-up.
+    std::vector<char> exact_seed(count, 0);
+    for (const size_t index : stale) {
+        exact_seed[index] = index == 0 || (windows_[index - 1].valid && !recomputed[index - 1]);
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        Lanes start;
+        for (size_t i = next.fetch_add(1); i < stale.size(); i = next.fetch_add(1)) {
+            const size_t index = stale[i];
+            if (index == 0) {
+                start.Reset(lane_count());
+            } else if (exact_seed[index]) {
+                start = windows_[index - 1].end_lanes;
+            } else {
+                WarmUp(index, &start);
+            }
+            Compute(index, start);
+        }
+    };
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(stale.size())));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    // Seams, in timeline order. A window needs repair when its seed is not its
+    // predecessor's current end lanes.
+    bool previous_moved = false;
+    bool previous_repaired = false;
+    for (size_t index = 0; index < count; ++index) {
+        Window &window = windows_[index];
+        if (!window.valid) {
+            previous_moved = false;
+            previous_repaired = false;
+            continue;
+        }
+        bool repaired = false;
+        if (index > 0 && windows_[index - 1].valid) {
+            const bool stale_seed =
+                recomputed[index] ? (!exact_seed[index] || previous_repaired) : previous_moved;
+            if (stale_seed) {
+                repaired = Repair(index);
+            }
+        }
+        previous_moved = recomputed[index] || repaired;
+        previous_repaired = repaired;
+    }
+}
+
+void LayoutEngine::LayoutAll(int threads) {
+    std::vector<size_t> stale;
+    for (size_t index = 0; index < windows_.size(); ++index) {
+        if (!windows_[index].valid) stale.push_back(index);
+    }
+    if (threads <= 0) {
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        threads = std::min(cores, kMaxLayoutThreads);
+    }
+    Run(stale, threads);
+}
+
+size_t LayoutEngine::Layout(int64_t from_ms, int64_t to_ms) {
+    if (windows_.empty() || to_ms <= from_ms) return 0;
+    const auto window_of = [this](int64_t time_ms) {
+        return static_cast<size_t>(
+            std::clamp<int64_t>(time_ms / kWindowMs, 0, static_cast<int64_t>(windows_.size()) - 1));
+    };
+    std::vector<size_t> stale;
+    for (size_t index = window_of(from_ms); index <= window_of(to_ms - 1); ++index) {
+        if (!windows_[index].valid) stale.push_back(index);
+    }
+    Run(stale, 1);
+    return stale.size();
+}
+
+}  // namespace danmaku
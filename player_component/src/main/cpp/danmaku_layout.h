@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "danmaku_store.h"
+
+namespace danmaku {
+
+/**
+ * Advance widths per pixel of font size, measured once by the caller with the
+ * typeface the renderer draws with. Texts are never shaped here: a comment is
+ * as wide as the sum of its code points' advances.
+ */
+struct FontMetrics {
+    float ascii[95] = {};  // U+0020..U+007E
+    float wide = 1.0F;     // CJK, kana, hangul, full-width forms, emoji
+    float other = 0.6F;    // every other code point
+    float line = 1.2F;     // descent - ascent
+};
+
+struct LayoutConfig {
+    int width = 0;
+    int height = 0;
+    float text_scale = 1.0F;   // font pixels per store size unit
+    float stroke = 0.0F;       // outline pixels on each side of the text
+    float lane_height = 0.0F;  // pixels
+    int32_t scroll_duration_ms = 3800;
+    int32_t fixed_duration_ms = 3800;
+    FontMetrics font;
+};
+
+/**
+ * Where and whether one comment is shown; one per store row, in a flat array
+ * read in place by DanmakuLayout.kt (little endian, 20 bytes per row).
+ */
+struct Placement {
+    static constexpr uint8_t kLaidOut = 1;  // the row's window has been laid out
+    static constexpr uint8_t kPlaced = 2;   // got a lane and is drawn
+    static constexpr uint8_t kHidden = 4;   // hidden by the caller (block list)
+    static constexpr uint8_t kFolded = 8;   // folded into an earlier duplicate (MergeDuplicates)
+
+    float y;  // top edge, pixels
+    float width;
+    float height;
+    int32_t duration_ms;
+    int16_t lane;  // -1 when not placed
+    uint8_t flags;
+    uint8_t reserved;
+};
+static_assert(sizeof(Placement) == 20, "Placement layout is shared with DanmakuLayout.kt");
+
+/**
+ * Lane layout of a whole comment store, computed ahead of playback instead of
+ * per frame.
+ *
+ * Scrolling comments enter the first lane whose previous occupant has fully
+ * entered the screen and will not be caught before it leaves; top and bottom
+ * comments hold a lane until they disappear; a comment without a free lane is
+ * dropped. Every lane keeps only its latest occupant interval, because that is
+ * the only one a later comment can collide with.
+ *
+ * The timeline is cut into fixed windows. Windows are laid out independently
+ * (in parallel) from a warm-up over the preceding max-duration of comments,
+ * then every seam is repaired sequentially: the window is re-run from its
+ * predecessor's final lane state until its placements agree with the
+ * speculative ones over a full max-duration, after which nothing later can
+ * differ. The result equals one sequential pass.
+ *
+ * Changing the configuration, the hidden rows or the repeat counts only marks
+ * windows stale; Layout() recomputes the requested ones (e.g. around the
+ * playback position after a resize) and repairs the seams after them as far
+ * as placements change.
+ *
+ * The store must outlive the engine. Not thread-safe.
+ */
+class LayoutEngine {
+public:
+    static constexpr int64_t kWindowMs = 60 * 1000;
+
+    explicit LayoutEngine(const CommentStore &store);
+
+    // Every window becomes stale.
+    void Configure(const LayoutConfig &config);
+
+    // Rows whose bit is set (word i / 64, as produced by BlockFilter::Scan) take
+    // no lane. nullptr shows every row. Every window becomes stale.
+    void SetHidden(const uint64_t *mask, size_t words);
+
+    // Repeat counts as filled by MergeDuplicates: rows with 0 take no lane, rows
+    // above 1 are drawn with a " +N" suffix (N = count - 1) and measured with it.
+    // nullptr disables folding. Every window becomes stale.
+    void SetRepeatCounts(const uint16_t *counts, size_t size);
+
+    // Lays out every stale window. `threads` <= 0 picks a count from the number
+    // of stale windows and the cores available.
+    void LayoutAll(int threads);
+
+    // Lays out the stale windows overlapping [from_ms, to_ms) on the calling
+    // thread. Returns the number of windows laid out, seams repairs excluded.
+    size_t Layout(int64_t from_ms, int64_t to_ms);
+
+    /**
+     * Identifies the inputs of the layout (configuration, hidden rows, repeat
+     * counts, row count); placements cached under it can be restored later.
+     */
+    uint64_t Fingerprint() const;
+
+    // Takes `count` placements produced by an engine with the same Fingerprint()
+    // as a completed layout; false when `count` does not match the store.
+    bool Restore(const Placement *rows, size_t count);
+
+    const Placement *placements() const { return placements_.data(); }
+    size_t placements_bytes() const { return placements_.size() * sizeof(Placement); }
+    size_t window_count() const { return windows_.size(); }
+
+    // Comment width in pixels for `text` followed by `suffix` at store size `size`, outline included.
+    float MeasureWidth(std::string_view text, uint8_t size, std::string_view suffix = {}) const;
+
+private:
+    struct Lanes {
+        std::vector<int64_t> scroll_start;  // INT64_MIN when free
+        std::vector<float> scroll_width;
+        std::vector<int64_t> reverse_start;
+        std::vector<float> reverse_width;
+        std::vector<int64_t> top_until;
+        std::vector<int64_t> bottom_until;
+
+        void Reset(size_t lanes);
+        bool operator==(const Lanes &other) const;
+    };
+
+    struct Window {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        bool valid = false;
+        Lanes end_lanes;
+    };
+
+    void Invalidate();
+    float Advance(std::string_view text) const;
+    int32_t max_duration_ms() const;
+    size_t lane_count() const;
+    // Computes row's placement against `lanes`, updating them when it is placed.
+    Placement Place(uint32_t row, Lanes *lanes) const;
+    // Lanes at the start of window `index`, simulated from empty lanes.
+    void WarmUp(size_t index, Lanes *lanes) const;
+    void Compute(size_t index, const Lanes &start);
+    // Re-runs window `index` from its predecessor's end lanes; returns whether its end lanes changed.
+    bool Repair(size_t index);
+    void Run(const std::vector<size_t> &stale, int threads);
+
+    const CommentStore &store_;
+    LayoutConfig config_;
+    std::vector<uint64_t> hidden_;
+    std::vector<uint16_t> repeats_;
+    std::vector<Placement> placements_;
+    std::vector<Window> windows_;
+};
+
+}  // namespace danmaku
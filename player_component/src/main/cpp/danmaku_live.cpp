@@ -0,0 +1,556 @@
+#include "danmaku_live.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if DANMAKU_BROTLI
+#include <brotli/decode.h>
+#endif
+
+#include "danmaku_utf8.h"
+
+namespace danmaku {
+namespace {
+
+// Compressed frames nest at most this deep (LiveDanmakuPacketCodec.decodeAll stops at the same level).
+constexpr int kMaxDepth = 2;
+// A websocket message inflates to a few hundred KB at most; anything larger is dropped.
+constexpr size_t kMaxInflatedBytes = 16u << 20;
+constexpr int kMaxJsonDepth = 64;
+constexpr uint8_t kDefaultSize = 25;
+
+uint32_t ReadU32BigEndian(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 |
+           p[3];
+}
+
+uint16_t ReadU16BigEndian(const uint8_t *p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+
+template <typename T>
+void Put(uint8_t *out, T value) {
+    memcpy(out, &value, sizeof(T));
+}
+
+size_t AlignUp(size_t value) { return (value + 3) & ~static_cast<size_t>(3); }
+
+// Char.isWhitespace as used by Kotlin's isBlank.
+bool IsWhitespace(uint32_t code) {
+    return code == ' ' || (code >= '\t' && code <= '\r') || (code >= 0x1C && code <= 0x1F) || code == 0xA0 ||
+           code == 0x1680 || (code >= 0x2000 && code <= 0x200A) || code == 0x2028 || code == 0x2029 ||
+           code == 0x202F || code == 0x205F || code == 0x3000;
+}
+
+bool IsBlank(const std::string &text) {
+    const auto *p = reinterpret_cast<const unsigned char *>(text.data());
+    const auto *end = p + text.size();
+    while (p < end) {
+        if (!IsWhitespace(NextCodePoint(&p, end))) return false;
+    }
+    return true;
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Forward-only cursor over one JSON value, enough to pick members and array
+ * elements by position the way LiveDanmakuCommandParser does with optXxx:
+ * anything missing or of the wrong type reads as absent.
+ */
+class JsonCursor {
+public:
+    JsonCursor(const char *begin, const char *end) : p_(begin), end_(end) {}
+
+    char Peek() {
+        SkipSpace();
+        return p_ < end_ ? *p_ : '\0';
+    }
+
+    // Moves to element `index` of the array at the cursor.
+    bool Element(int index) {
+        if (!Enter('[')) return false;
+        for (int i = 0; Next(']'); ++i) {
+            if (i == index) return true;
+            if (!Skip(0)) return false;
+        }
+        return false;
+    }
+
+    // Moves to the value of member `key` of the object at the cursor.
+    bool Member(std::string_view key, std::string *scratch) {
+        if (!Enter('{')) return false;
+        while (Next('}')) {
+            scratch->clear();
+            if (Peek() != '"' || !ReadString(scratch) || Peek() != ':') return false;
+            ++p_;
+            if (*scratch == key) return true;
+            if (!Skip(0)) return false;
+        }
+        return false;
+    }
+
+    // Enters the array or object at the cursor; Next() then steps over the separators.
+    bool Enter(char open) {
+        if (Peek() != open) return false;
+        ++p_;
+        return true;
+    }
+
+    // True while another element follows; false at `close` or on malformed input.
+    bool Next(char close) {
+        if (Peek() == ',') ++p_;
+        const char c = Peek();
+        return c != '\0' && c != close;
+    }
+
+    bool Skip(int depth) {
+        switch (Peek()) {
+            case '"':
+                return ReadString(nullptr);
+            case '{':
+            case '[': {
+                if (depth >= kMaxJsonDepth) return false;
+                const char close = *p_ == '{' ? '}' : ']';
+                ++p_;
+                while (Next(close)) {
+                    if (close == '}') {
+                        if (Peek() != '"' || !ReadString(nullptr) || Peek() != ':') return false;
+                        ++p_;
+                    }
+                    if (!Skip(depth + 1)) return false;
+                }
+                if (Peek() != close) return false;
+                ++p_;
+                return true;
+            }
+            case '\0':
+                return false;
+            default:
+                while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !IsSpace(*p_)) ++p_;
+                return true;
+        }
+    }
+
+    // Reads an integer, truncating fractions like optLong; other values are skipped.
+    bool ReadInteger(int64_t *out) {
+        const char first = Peek();
+        if (first != '-' && (first < '0' || first > '9')) {
+            Skip(0);
+            return false;
+        }
+        const bool negative = *p_ == '-';
+        if (negative) ++p_;
+        uint64_t value = 0;
+        bool digits = false;
+        for (; p_ < end_ && *p_ >= '0' && *p_ <= '9'; ++p_) {
+            value = value * 10 + static_cast<uint64_t>(*p_ - '0');
+            digits = true;
+        }
+        Skip(0);
+        if (!digits) return false;
+        *out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+        return true;
+    }
+
+    // Reads the string at the cursor; `out` receives the unescaped value, null skips it.
+    bool ReadString(std::string *out) {
+        if (Peek() != '"') return false;
+        ++p_;
+        for (;;) {
+            const char *stop = p_;
+            while (stop < end_ && *stop != '"' && *stop != '\\') ++stop;
+            if (stop >= end_) return false;
+            if (out != nullptr) out->append(p_, static_cast<size_t>(stop - p_));
+            p_ = stop + 1;
+            if (*stop == '"') return true;
+            if (p_ >= end_) return false;
+            const char escape = *p_++;
+            if (out == nullptr) continue;
+            switch (escape) {
+                case 'n': out->push_back('\n'); break;
+                case 't': out->push_back('\t'); break;
+                case 'r': out->push_back('\r'); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!ReadHex4(&code)) return false;
+                    if (code >= 0xD800 && code <= 0xDBFF && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                        const char *saved = p_;
+                        p_ += 2;
+                        uint32_t low = 0;
+                        if (ReadHex4(&low) && low >= 0xDC00 && low <= 0xDFFF) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            p_ = saved;
+                        }
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default: out->push_back(escape); break;
+            }
+        }
+    }
+
+private:
+    static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    void SkipSpace() {
+        while (p_ < end_ && IsSpace(*p_)) ++p_;
+    }
+
+    bool ReadHex4(uint32_t *code) {
+        if (end_ - p_ < 4) return false;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int digit = HexValue(p_[i]);
+            if (digit < 0) return false;
+            value = value * 16 + static_cast<uint32_t>(digit);
+        }
+        p_ += 4;
+        *code = value;
+        return true;
+    }
+
+    const char *p_;
+    const char *end_;
+};
+
+#if DANMAKU_BROTLI
+/**
+ * Brotli has no reset call, so a decoder is created per stream. Its ring
+ * buffer and tables go through this pool and are handed to the next decoder
+ * instead of going back to malloc: streams of one connection share a window
+ * size and ask for the same blocks.
+ */
+class BlockPool {
+public:
+    ~BlockPool() {
+        for (void *block : free_) std::free(block);
+    }
+
+    static void *Alloc(void *opaque, size_t size) {
+        auto *pool = static_cast<BlockPool *>(opaque);
+        for (size_t i = 0; i < pool->free_.size(); ++i) {
+            auto *block = static_cast<size_t *>(pool->free_[i]);
+            if (*block == size) {
+                pool->free_[i] = pool->free_.back();
+                pool->free_.pop_back();
+                return reinterpret_cast<uint8_t *>(block) + kHeader;
+            }
+        }
+        auto *block = static_cast<size_t *>(std::malloc(size + kHeader));
+        if (block == nullptr) return nullptr;
+        *block = size;
+        return reinterpret_cast<uint8_t *>(block) + kHeader;
+    }
+
+    static void Free(void *opaque, void *address) {
+        if (address == nullptr) return;
+        auto *pool = static_cast<BlockPool *>(opaque);
+        void *block = static_cast<uint8_t *>(address) - kHeader;
+        if (pool->free_.size() < kMaxPooled) {
+            pool->free_.push_back(block);
+        } else {
+            std::free(block);
+        }
+    }
+
+private:
+    // Keeps the returned blocks aligned for the decoder's tables.
+    static constexpr size_t kHeader = 16;
+    static constexpr size_t kMaxPooled = 16;
+    std::vector<void *> free_;
+};
+#endif
+
+}  // namespace
+
+struct LiveDecoder::Codecs {
+    z_stream zlib{};
+    bool zlib_ready = false;
+#if DANMAKU_BROTLI
+    BlockPool pool;
+#endif
+
+    ~Codecs() {
+        if (zlib_ready) inflateEnd(&zlib);
+    }
+
+    bool Inflate(const uint8_t *data, size_t size, std::vector<uint8_t> *out) {
+        if (!zlib_ready) {
+            if (inflateInit(&zlib) != Z_OK) return false;
+            zlib_ready = true;
+        } else if (inflateReset(&zlib) != Z_OK) {
+            return false;
+        }
+        out->resize(std::max<size_t>(out->capacity(), std::max<size_t>(size * 4, 4096)));
+        zlib.next_in = const_cast<Bytef *>(data);
+        zlib.avail_in = static_cast<uInt>(size);
+        size_t written = 0;
+        for (;;) {
+            if (written == out->size()) {
+                if (out->size() >= kMaxInflatedBytes) return false;
+                out->resize(out->size() * 2);
+            }
+            zlib.next_out = out->data() + written;
+            zlib.avail_out = static_cast<uInt>(out->size() - written);
+            const int result = inflate(&zlib, Z_NO_FLUSH);
+            written = out->size() - zlib.avail_out;
+            if (result == Z_STREAM_END) break;
+            // Truncated input: keep what was inflated, as Inflater does.
+            if (result == Z_BUF_ERROR && zlib.avail_in == 0) break;
+            if (result != Z_OK && result != Z_BUF_ERROR) return false;
+        }
+        out->resize(written);
+        return true;
+    }
+
+    bool Decompress(const uint8_t *data, size_t size, std::vector<uint8_t> *out) {
+#if DANMAKU_BROTLI
+        BrotliDecoderState *state = BrotliDecoderCreateInstance(&BlockPool::Alloc, &BlockPool::Free, &pool);
+        if (state == nullptr) return false;
+        out->resize(std::max<size_t>(out->capacity(), std::max<size_t>(size * 6, 4096)));
+        size_t available_in = size;
+        const uint8_t *next_in = data;
+        size_t written = 0;
+        bool ok = false;
+        for (;;) {
+            if (written == out->size()) {
+                if (out->size() >= kMaxInflatedBytes) break;
+                out->resize(out->size() * 2);
+            }
+            size_t available_out = out->size() - written;
+            uint8_t *next_out = out->data() + written;
+            const BrotliDecoderResult result =
+                BrotliDecoderDecompressStream(state, &available_in, &next_in, &available_out, &next_out, nullptr);
+            written = out->size() - available_out;
+            if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+                ok = true;
+                break;
+            }
+            if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) break;
+        }
+        BrotliDecoderDestroyInstance(state);
+        out->resize(written);
+        return ok;
+#else
+        (void) data;
+        (void) size;
+        (void) out;
+        return false;
+#endif
+    }
+};
+
+size_t SplitLivePackets(const uint8_t *data, size_t size, std::vector<LivePacket> *out) {
+    size_t offset = 0;
+    size_t count = 0;
+    while (size - offset >= kLiveHeaderBytes) {
+        const uint8_t *header = data + offset;
+        const uint32_t packet_length = ReadU32BigEndian(header);
+        const uint16_t header_length = ReadU16BigEndian(header + 4);
+        // A header shorter than 16 bytes would overlap the body; LiveDanmakuPacketCodec
+        // only rejects 0, but no server sends either.
+        if (packet_length < header_length || header_length == 0 || packet_length > size - offset) {
+            break;
+        }
+        out->push_back({ReadU32BigEndian(header + 8), ReadU32BigEndian(header + 12), ReadU16BigEndian(header + 6),
+                        header + header_length, packet_length - header_length});
+        offset += packet_length;
+        ++count;
+    }
+    return count;
+}
+
+LiveDecoder::LiveDecoder()
+    : codecs_(std::make_unique<Codecs>()), scratch_(kMaxDepth), frames_(kMaxDepth + 1) {}
+
+LiveDecoder::~LiveDecoder() = default;
+
+bool LiveDecoder::SupportsBrotli() {
+#if DANMAKU_BROTLI
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LiveDecoder::Decode(const uint8_t *data, size_t size) {
+    columns_.clear();
+    packets_.clear();
+    arena_.clear();
+    decoded_ = false;
+    Walk(data, size, 0);
+    Pack();
+    return decoded_;
+}
+
+void LiveDecoder::Walk(const uint8_t *data, size_t size, int depth) {
+    std::vector<LivePacket> &frames = frames_[depth];
+    frames.clear();
+    if (SplitLivePackets(data, size, &frames) > 0) decoded_ = true;
+    for (const LivePacket &frame : frames) {
+        ++stats_.packets;
+        if (frame.protocol == kLiveProtocolZlib || frame.protocol == kLiveProtocolBrotli) {
+            if (depth >= kMaxDepth) continue;
+            std::vector<uint8_t> &inflated = scratch_[depth];
+            const bool ok = frame.protocol == kLiveProtocolZlib
+                                ? codecs_->Inflate(frame.body, frame.body_length, &inflated)
+                                : codecs_->Decompress(frame.body, frame.body_length, &inflated);
+            if (!ok) {
+                ++stats_.failures;
+                continue;
+            }
+            stats_.compressed_bytes += frame.body_length;
+            stats_.inflated_bytes += inflated.size();
+            Walk(inflated.data(), inflated.size(), depth + 1);
+        } else if (frame.operation == kLiveOpCommand) {
+            ++stats_.commands;
+            ParseCommand(frame.body, frame.body_length);
+        } else if (frame.operation == kLiveOpHeartbeatReply || frame.operation == kLiveOpAuthReply) {
+            packets_.push_back({frame.operation, frame.sequence, static_cast<uint32_t>(arena_.size()),
+                                frame.body_length});
+            arena_.append(reinterpret_cast<const char *>(frame.body), frame.body_length);
+        }
+    }
+}
+
+void LiveDecoder::ParseCommand(const uint8_t *body, size_t length) {
+    const char *begin = reinterpret_cast<const char *>(body);
+
+    // {"cmd":"DANMU_MSG:4:0:2:2:2:0","info":[...],...}; members may come in any order.
+    JsonCursor root(begin, begin + length);
+    JsonCursor info(begin, begin);
+    bool has_info = false;
+    bool danmu = false;
+    if (!root.Enter('{')) return;
+    while (root.Next('}')) {
+        extra_.clear();
+        if (root.Peek() != '"' || !root.ReadString(&extra_) || !root.Enter(':')) return;
+        if (extra_ == "cmd" && root.Peek() == '"') {
+            extra_.clear();
+            if (!root.ReadString(&extra_)) return;
+            danmu = extra_.compare(0, 9, "DANMU_MSG") == 0;
+            continue;
+        }
+        if (extra_ == "info") {
+            info = root;
+            has_info = true;
+        }
+        if (!root.Skip(0)) return;
+    }
+    if (!danmu || !has_info) return;
+
+    // info[1]: text. Blank comments are dropped, as LiveDanmakuCommandParser does.
+    std::string &text = comments_.PendingText();
+    text.clear();
+    JsonCursor cursor = info;
+    if (!cursor.Element(1) || !cursor.ReadString(&text) || IsBlank(text)) return;
+
+    // info[0]: [_, mode, size, color, timestamp, ..., 15: {"extra": "<json>"}]
+    int64_t mode = 1;
+    int64_t size = kDefaultSize;
+    int64_t color = 0xFFFFFF;
+    int64_t timestamp = 0;
+    int64_t score = 0;
+    cursor = info;
+    if (cursor.Element(0) && cursor.Enter('[')) {
+        int64_t *const fields[] = {nullptr, &mode, &size, &color, &timestamp};
+        for (int i = 0; i <= 15 && cursor.Next(']'); ++i) {
+            if (i == 15) {
+                extra_.clear();
+                if (cursor.Member("extra", &name_) && cursor.ReadString(&extra_)) {
+                    JsonCursor extra(extra_.data(), extra_.data() + extra_.size());
+                    if (extra.Member("recommend_score", &name_)) extra.ReadInteger(&score);
+                }
+            } else if (i < 5 && fields[i] != nullptr) {
+                cursor.ReadInteger(fields[i]);
+            } else if (!cursor.Skip(0)) {
+                break;
+            }
+        }
+    }
+
+    // info[2]: [uid, uname, ...]
+    int64_t uid = 0;
+    name_.clear();
+    cursor = info;
+    if (cursor.Element(2) && cursor.Enter('[') && cursor.Next(']')) {
+        cursor.ReadInteger(&uid);
+        if (cursor.Next(']') && !cursor.ReadString(&name_)) name_.clear();
+    }
+
+    const size_t before = comments_.count();
+    comments_.Commit(0, static_cast<uint8_t>(mode == 4 || mode == 5 ? mode : 1),
+                     static_cast<uint8_t>(std::clamp<int64_t>(size, 0, 255)), static_cast<uint32_t>(color) & 0xFFFFFF);
+    if (comments_.count() == before) return;
+    ++stats_.comments;
+    columns_.push_back({timestamp > 0 ? timestamp : 0, uid, static_cast<uint32_t>(arena_.size()),
+                        static_cast<uint32_t>(name_.size()), static_cast<uint8_t>(std::clamp<int64_t>(score, 0, 255))});
+    arena_.append(name_);
+}
+
+void LiveDecoder::Pack() {
+    const std::unique_ptr<CommentStore> store = comments_.Finish();
+    const size_t count = columns_.size();
+    const size_t packet_count = packets_.size();
+
+    const size_t store_offset = kLiveBatchHeaderBytes;
+    const size_t timestamp_offset = store_offset + store->bytes();
+    const size_t uid_offset = timestamp_offset + count * 8;
+    const size_t name_offset_offset = uid_offset + count * 8;
+    const size_t name_length_offset = name_offset_offset + count * 4;
+    const size_t score_offset = name_length_offset + count * 4;
+    const size_t packet_offset = AlignUp(score_offset + count);
+    const size_t arena_offset = packet_offset + packet_count * 16;
+    const size_t total = AlignUp(arena_offset + arena_.size());
+
+    batch_.assign(total, 0);
+    uint8_t *block = batch_.data();
+    Put<uint32_t>(block, kLiveBatchMagic);
+    Put<uint32_t>(block + 4, kLiveBatchVersion);
+    Put<uint32_t>(block + 8, static_cast<uint32_t>(count));
+    Put<uint32_t>(block + 12, static_cast<uint32_t>(packet_count));
+    Put<uint32_t>(block + 16, static_cast<uint32_t>(store_offset));
+    Put<uint32_t>(block + 20, static_cast<uint32_t>(timestamp_offset));
+    Put<uint32_t>(block + 24, static_cast<uint32_t>(uid_offset));
+    Put<uint32_t>(block + 28, static_cast<uint32_t>(name_offset_offset));
+    Put<uint32_t>(block + 32, static_cast<uint32_t>(name_length_offset));
+    Put<uint32_t>(block + 36, static_cast<uint32_t>(score_offset));
+    Put<uint32_t>(block + 40, static_cast<uint32_t>(packet_offset));
+    Put<uint32_t>(block + 44, static_cast<uint32_t>(arena_offset));
+    Put<uint32_t>(block + 48, static_cast<uint32_t>(total));
+
+    memcpy(block + store_offset, store->data(), store->bytes());
+    for (size_t i = 0; i < count; ++i) {
+        const Comment &comment = columns_[i];
+        Put<int64_t>(block + timestamp_offset + i * 8, comment.timestamp_ms);
+        Put<int64_t>(block + uid_offset + i * 8, comment.uid);
+        Put<uint32_t>(block + name_offset_offset + i * 4, comment.name_offset);
+        Put<uint32_t>(block + name_length_offset + i * 4, comment.name_length);
+        block[score_offset + i] = comment.score;
+    }
+    for (size_t i = 0; i < packet_count; ++i) {
+        const Packet &packet = packets_[i];
+        uint8_t *row = block + packet_offset + i * 16;
+        Put<uint32_t>(row, packet.operation);
+        Put<uint32_t>(row + 4, packet.sequence);
+        Put<uint32_t>(row + 8, packet.body_offset);
+        Put<uint32_t>(row + 12, packet.body_length);
+    }
+    if (!arena_.empty()) {
+        memcpy(block + arena_offset, arena_.data(), arena_.size());
+    }
+}
+
+}  // namespace danmaku
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "danmaku_store.h"
+
+namespace danmaku {
+
+// Websocket frame header of the bilibili live danmaku stream (all big endian):
+// u32 packet_length, u16 header_length, u16 protocol, u32 operation, u32 sequence.
+constexpr size_t kLiveHeaderBytes = 16;
+
+constexpr uint16_t kLiveProtocolPlain = 0;
+constexpr uint16_t kLiveProtocolHeartbeat = 1;
+constexpr uint16_t kLiveProtocolZlib = 2;
+constexpr uint16_t kLiveProtocolBrotli = 3;
+
+constexpr uint32_t kLiveOpHeartbeatReply = 3;
+constexpr uint32_t kLiveOpCommand = 5;
+constexpr uint32_t kLiveOpAuthReply = 8;
+
+struct LivePacket {
+    uint32_t operation;
+    uint32_t sequence;
+    uint16_t protocol;
+    const uint8_t *body;  // points into the buffer that was split
+    uint32_t body_length;
+};
+
+/**
+ * Splits the frames packed in [data, data + size) without copying: every
+ * body points into `data`. Stops at the first frame that is malformed or runs
+ * past the end, like LiveDanmakuPacketCodec.decodeRaw; returns the number of
+ * frames appended to `out`.
+ */
+size_t SplitLivePackets(const uint8_t *data, size_t size, std::vector<LivePacket> *out);
+
+/**
+ * Decoded form of one websocket message, one contiguous block handed to
+ * Kotlin as a direct ByteBuffer (integers little endian, sections 4-byte
+ * aligned):
+ *
+ *   u32 magic "DDLB", u32 version, u32 comment_count, u32 packet_count
+ *   u32 offsets of the comment store, the timestamp, uid, name_offset,
+ *       name_length and score columns, the packet table and the arena,
+ *       u32 total_bytes
+ *   comment store: a "DDCS" block (danmaku_store.h) holding the DANMU_MSG
+ *       comments in arrival order, time_ms 0, size from info[0][2]
+ *   comment_count x i64 timestamp_ms   (sender clock, 0 when missing)
+ *   comment_count x i64 uid
+ *   comment_count x u32 name_offset    (into the arena)
+ *   comment_count x u32 name_length    (bytes)
+ *   comment_count x u8  recommend_score
+ *   packet_count x {u32 operation, u32 sequence, u32 body_offset, u32 body_length}
+ *       for every packet that is not a command (auth and heartbeat replies)
+ *   arena: user names and packet bodies
+ *
+ * Commands other than DANMU_MSG are dropped. LiveDanmakuBatch.kt reads the
+ * same layout.
+ */
+constexpr uint32_t kLiveBatchMagic = 0x424C4444;  // "DDLB"
+constexpr uint32_t kLiveBatchVersion = 1;
+constexpr size_t kLiveBatchHeaderBytes = 52;
+
+struct LiveDecodeStats {
+    uint64_t packets = 0;
+    uint64_t commands = 0;
+    uint64_t comments = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t inflated_bytes = 0;
+    uint64_t failures = 0;
+};
+
+/**
+ * Turns websocket messages into batches. Frames are split in place;
+ * compressed bodies (protover 2 zlib, protover 3 brotli) are decompressed
+ * into per-depth scratch buffers with decompressor state kept across
+ * messages, and DANMU_MSG JSON is parsed straight into the columns. Nested
+ * frames are followed two levels deep, as in the Kotlin codec.
+ *
+ * Not thread-safe; the batch stays valid until the next Decode().
+ */
+class LiveDecoder {
+public:
+    LiveDecoder();
+    ~LiveDecoder();
+    LiveDecoder(const LiveDecoder &) = delete;
+    LiveDecoder &operator=(const LiveDecoder &) = delete;
+
+    // False when nothing in the message could be decoded.
+    bool Decode(const uint8_t *data, size_t size);
+
+    const uint8_t *batch() const { return batch_.data(); }
+    size_t batch_bytes() const { return batch_.size(); }
+    const LiveDecodeStats &stats() const { return stats_; }
+
+    // Brotli needs libbrotlidec at build time (DANMAKU_BROTLI).
+    static bool SupportsBrotli();
+
+private:
+    struct Codecs;
+    struct Comment {
+        int64_t timestamp_ms;
+        int64_t uid;
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint8_t score;
+    };
+    struct Packet {
+        uint32_t operation;
+        uint32_t sequence;
+        uint32_t body_offset;
+        uint32_t body_length;
+    };
+
+    void Walk(const uint8_t *data, size_t size, int depth);
+    void ParseCommand(const uint8_t *body, size_t length);
+    void Pack();
+
+    std::unique_ptr<Codecs> codecs_;
+    std::vector<std::vector<uint8_t>> scratch_;
+    std::vector<std::vector<LivePacket>> frames_;
+    CommentStoreBuilder comments_;
+    std::vector<Comment> columns_;
+    std::vector<Packet> packets_;
+    std::string arena_;
+    std::string name_;
+    std::string extra_;
+    std::vector<uint8_t> batch_;
+    LiveDecodeStats stats_;
+    bool decoded_ = false;
+};
+
+}  // namespace danmaku
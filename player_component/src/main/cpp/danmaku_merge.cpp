@@ -0,0 +1,223 @@
+#include "danmaku_merge.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "danmaku_utf8.h"
+
+namespace danmaku {
+namespace {
+
+// 8 bands of 2 MinHash rows: a pair with bigram similarity 0.6 shares a band
+// with probability 0.97, one with 0.2 is a candidate one time in three.
+constexpr int kMinHashBands = 8;
+constexpr int kMinHashRows = 2;
+constexpr uint32_t kMaxRepeatCount = 0xFFFF;
+
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+bool IsMergeMode(uint8_t mode) {
+    return mode == 1 || mode == 4 || mode == 5 || mode == 6;
+}
+
+bool IsSpace(uint32_t code) {
+    return code == ' ' || (code >= '\t' && code <= '\r') || code == 0xA0 || code == 0x3000;
+}
+
+// Punctuation that varies between copies of one comment ("awsl!!", "awsl。").
+bool IsSentencePunctuation(uint32_t code) {
+    switch (code) {
+        case '!':
+        case '?':
+        case '.':
+        case ',':
+        case '~':
+        case 0x2026:  // …
+        case 0x3001:  // 、
+        case 0x3002:  // 。
+        case 0x301C:  // 〜
+        case 0xFF5E:  // ～ when width is not folded
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Normalize(std::string_view text, const MergeOptions &options, bool drop_punctuation,
+               std::vector<uint32_t> *out) {
+    out->clear();
+    const auto *p = reinterpret_cast<const unsigned char *>(text.data());
+    const auto *end = p + text.size();
+    int32_t run = 0;
+    while (p < end) {
+        uint32_t code = NextCodePoint(&p, end);
+        if (options.fold_width) {
+            if (code >= 0xFF01 && code <= 0xFF5E) {
+                code -= 0xFEE0;
+            } else if (code == 0x3000) {
+                code = ' ';
+            }
+            if (code >= 'A' && code <= 'Z') {
+                code += 'a' - 'A';
+            }
+        }
+        if (IsSpace(code) || (drop_punctuation && IsSentencePunctuation(code))) continue;
+        run = !out->empty() && out->back() == code ? run + 1 : 1;
+        if (options.max_run > 0 && run > options.max_run) continue;
+        out->push_back(code);
+    }
+}
+
+uint64_t HashCodes(const std::vector<uint32_t> &codes) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const uint32_t code : codes) {
+        hash = (hash ^ code) * 0x100000001B3ULL;
+    }
+    return Mix(hash ^ codes.size());
+}
+
+// Sorted distinct code point bigrams (a single code point for one-character texts).
+void Bigrams(const std::vector<uint32_t> &codes, std::vector<uint64_t> *out) {
+    out->clear();
+    if (codes.size() == 1) {
+        out->push_back(codes[0]);
+    }
+    for (size_t i = 1; i < codes.size(); ++i) {
+        out->push_back(static_cast<uint64_t>(codes[i - 1]) << 32 | codes[i]);
+    }
+    std::sort(out->begin(), out->end());
+    out->erase(std::unique(out->begin(), out->end()), out->end());
+}
+
+float Jaccard(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) {
+    size_t shared = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] == b[j]) {
+            ++shared;
+            ++i;
+            ++j;
+        } else if (a[i] < b[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    const size_t all = a.size() + b.size() - shared;
+    return all == 0 ? 1.0F : static_cast<float>(shared) / static_cast<float>(all);
+}
+
+// Bucket key of every band of the MinHash signature of `bigrams`.
+void BandKeys(const std::vector<uint64_t> &bigrams, uint64_t keys[kMinHashBands]) {
+    for (int band = 0; band < kMinHashBands; ++band) {
+        uint64_t key = Mix(static_cast<uint64_t>(band) + 1);
+        for (int row = 0; row < kMinHashRows; ++row) {
+            const uint64_t seed = Mix(static_cast<uint64_t>(band * kMinHashRows + row) + 0x9E3779B97F4A7C15ULL);
+            uint64_t minimum = UINT64_MAX;
+            for (const uint64_t bigram : bigrams) {
+                minimum = std::min(minimum, Mix(bigram ^ seed));
+            }
+            key = Mix(key ^ minimum);
+        }
+        keys[band] = key;
+    }
+}
+
+struct Group {
+    int64_t start_ms;
+    uint32_t row;
+    uint32_t count;
+    std::vector<uint64_t> bigrams;  // only for groups open to near matches
+};
+
+}  // namespace
+
+void NormalizeForMerge(std::string_view text, const MergeOptions &options, std::vector<uint32_t> *out) {
+    Normalize(text, options, true, out);
+    if (out->empty()) {
+        // "？？？" is a comment of its own kind, compare it as punctuation.
+        Normalize(text, options, false, out);
+    }
+}
+
+void MergeDuplicates(const CommentStore &store, const MergeOptions &options, std::vector<uint16_t> *counts,
+                     const uint64_t *excluded, size_t excluded_words) {
+    const uint32_t rows = store.count();
+    counts->assign(rows, 1);
+    const bool fuzzy = options.fuzzy_min_similarity > 0.0F;
+    const auto fuzzy_min_length = static_cast<size_t>(std::max(1, options.fuzzy_min_length));
+
+    std::vector<Group> groups;
+    std::unordered_map<uint64_t, uint32_t> exact;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    exact.reserve(rows);
+    std::vector<uint32_t> normalized;
+    std::vector<uint64_t> bigrams;
+    uint64_t keys[kMinHashBands];
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        if (!IsMergeMode(store.mode(row))) continue;
+        if ((row >> 6) < excluded_words && (excluded[row >> 6] >> (row & 63) & 1) != 0) continue;
+        NormalizeForMerge(store.text(row), options, &normalized);
+        if (normalized.empty()) continue;
+        const int64_t time = store.time_ms(row);
+        const auto live = [&](uint32_t group) { return time - groups[group].start_ms <= options.window_ms; };
+        const auto fold = [&](uint32_t group) {
+            Group &target = groups[group];
+            ++target.count;
+            (*counts)[row] = 0;
+            (*counts)[target.row] = static_cast<uint16_t>(std::min(target.count, kMaxRepeatCount));
+        };
+
+        const uint64_t hash = HashCodes(normalized);
+        const auto found = exact.find(hash);
+        if (found != exact.end() && live(found->second)) {
+            fold(found->second);
+            continue;
+        }
+
+        const bool use_fuzzy = fuzzy && normalized.size() >= fuzzy_min_length;
+        if (use_fuzzy) {
+            Bigrams(normalized, &bigrams);
+            BandKeys(bigrams, keys);
+            int64_t match = -1;
+            for (int band = 0; band < kMinHashBands && match < 0; ++band) {
+                const auto bucket = buckets.find(keys[band]);
+                if (bucket == buckets.end()) continue;
+                auto &members = bucket->second;
+                members.erase(std::remove_if(members.begin(), members.end(),
+                                             [&](uint32_t group) { return !live(group); }),
+                              members.end());
+                for (const uint32_t group : members) {
+                    if (Jaccard(groups[group].bigrams, bigrams) >= options.fuzzy_min_similarity) {
+                        match = group;
+                        break;
+                    }
+                }
+            }
+            if (match >= 0) {
+                fold(static_cast<uint32_t>(match));
+                // Further copies of this variant take the exact path.
+                exact[hash] = static_cast<uint32_t>(match);
+                continue;
+            }
+        }
+
+        const auto group = static_cast<uint32_t>(groups.size());
+        groups.push_back({time, row, 1, {}});
+        exact[hash] = group;
+        if (use_fuzzy) {
+            groups.back().bigrams = bigrams;
+            for (const uint64_t key : keys) {
+                buckets[key].push_back(group);
+            }
+        }
+    }
+}
+
+}  // namespace danmaku
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "danmaku_store.h"
+
+namespace danmaku {
+
+struct MergeOptions {
+    // A duplicate folds into a group while it starts at most this long after
+    // the group's first comment; later copies open a new group.
+    int32_t window_ms = 10 * 1000;
+    // Runs of one character are cut to this many ("233333" -> "23"); 0 keeps runs.
+    int32_t max_run = 1;
+    // Full-width ASCII and the ideographic space fold to ASCII, letters to lower case.
+    bool fold_width = true;
+    // Near duplicates: texts of at least fuzzy_min_length code points whose
+    // character bigram sets have at least this Jaccard similarity. 0 or less
+    // merges exact normalized matches only.
+    float fuzzy_min_similarity = 0.6F;
+    int32_t fuzzy_min_length = 6;
+};
+
+/**
+ * Folds spam waves: comments whose normalized texts are equal, or nearly so,
+ * within a sliding window become one comment with a repeat count.
+ * Normalization folds width and case, drops whitespace and sentence
+ * punctuation (unless nothing else is left) and collapses character runs.
+ *
+ * One pass over the store in time order. Exact matches go through a hash map
+ * of normalized-text hashes. Near matches are looked up in MinHash band
+ * buckets over the bigram sets (SimHash is too coarse for texts this short:
+ * one edited character flips a quarter of its bits) and confirmed with the
+ * exact Jaccard similarity. Groups that left the window are dropped from the
+ * buckets as they are met. Only scrolling, top and bottom comments take part.
+ *
+ * Fills `counts` (one per row): 0 for a comment folded into an earlier one,
+ * otherwise the size of the group it starts (1 when unique), saturated at
+ * 65535.
+ *
+ * Rows set in `excluded` (bit i of word i / 64, `excluded_words` words; the
+ * block list) neither start nor join a group and keep a count of 1, so a
+ * blocked comment never hides the copies folded into it.
+ */
+void MergeDuplicates(const CommentStore &store, const MergeOptions &options, std::vector<uint16_t> *counts,
+                     const uint64_t *excluded = nullptr, size_t excluded_words = 0);
+
+// The normalized form MergeDuplicates compares, as code points.
+void NormalizeForMerge(std::string_view text, const MergeOptions &options, std::vector<uint32_t> *out);
+
+}  // namespace danmaku
@@ -0,0 +1,758 @@
+#include "danmaku_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#include "danmaku_utf8.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DANMAKU_SIMD_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DANMAKU_SIMD_SSE2 1
+#endif
+
+namespace danmaku {
+namespace {
+
+constexpr int kMaxJsonDepth = 64;
+constexpr uint8_t kDefaultSize = 25;
+
+void PutU32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint32_t GetU32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+size_t AlignUp(size_t value) { return (value + 3) & ~static_cast<size_t>(3); }
+
+inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+/**
+ * First occurrence of `a` or `b` in [begin, end), or `end`. Comment texts are
+ * scanned 16 bytes at a time for their terminator or an escape; the tag scan
+ * itself relies on memchr, which is already vectorised in bionic and glibc.
+ */
+const char *FindEither(const char *begin, const char *end, char a, char b) {
+    const char *p = begin;
+#if DANMAKU_SIMD_NEON
+    const uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+    const uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+    for (; end - p >= 16; p += 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t hit = vorrq_u8(vceqq_u8(chunk, va), vceqq_u8(chunk, vb));
+        const uint64x2_t lanes = vreinterpretq_u64_u8(hit);
+        if ((vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0) {
+            break;
+        }
+    }
+#elif DANMAKU_SIMD_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; end - p >= 16; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b) {
+            return p;
+        }
+    }
+    return end;
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Decimal number with optional sign, fraction and exponent. Returns false when
+ * the field holds no digits; trailing garbage is ignored like Java's split-and-
+ * parse would have rejected, so callers fall back to 0 as BiliDanmakuParser did.
+ */
+bool ParseDecimal(const char *begin, const char *end, double *out) {
+    const char *p = begin;
+    while (p < end && IsSpace(*p)) ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    double value = 0;
+    bool digits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        value = value * 10 + (*p - '0');
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            value += (*p - '0') * scale;
+            scale *= 0.1;
+            digits = true;
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negative_exp = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative_exp = *p == '-';
+            ++p;
+        }
+        int exponent = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            exponent = std::min(exponent * 10 + (*p - '0'), 400);
+        }
+        value *= std::pow(10.0, negative_exp ? -exponent : exponent);
+    }
+    *out = negative ? -value : value;
+    return std::isfinite(*out);
+}
+
+int64_t ParseInteger(const char *begin, const char *end) {
+    double value = 0;
+    if (!ParseDecimal(begin, end, &value)) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::clamp(value, -9.0e18, 9.0e18));
+}
+
+int32_t ParseTimeMs(const char *begin, const char *end) {
+    double seconds = 0;
+    if (!ParseDecimal(begin, end, &seconds)) {
+        return 0;
+    }
+    return static_cast<int32_t>(std::clamp(std::llround(seconds * 1000.0), 0LL, static_cast<long long>(INT32_MAX)));
+}
+
+// Splits a `p` value into at most `max_fields` comma separated spans.
+size_t SplitFields(const char *begin, const char *end, const char **fields, const char **field_ends,
+                   size_t max_fields) {
+    size_t count = 0;
+    const char *p = begin;
+    while (count < max_fields) {
+        const char *comma = static_cast<const char *>(memchr(p, ',', static_cast<size_t>(end - p)));
+        const char *field_end = comma != nullptr ? comma : end;
+        fields[count] = p;
+        field_ends[count] = field_end;
+        ++count;
+        if (comma == nullptr) {
+            break;
+        }
+        p = comma + 1;
+    }
+    return count;
+}
+
+// Replaces every `from` in `text[start..]` by `to` (`to` is never longer).
+void ReplaceAllFrom(std::string *text, size_t start, std::string_view from, std::string_view to) {
+    size_t read = text->find(from.data(), start, from.size());
+    if (read == std::string::npos) {
+        return;
+    }
+    size_t write = read;
+    while (read < text->size()) {
+        if (text->compare(read, from.size(), from.data(), from.size()) == 0) {
+            text->replace(write, to.size(), to.data(), to.size());
+            write += to.size();
+            read += from.size();
+        } else {
+            (*text)[write++] = (*text)[read++];
+        }
+    }
+    text->resize(write);
+}
+
+/**
+ * Appends the XML text in [begin, end) to `out`, resolving the predefined and
+ * numeric character references.
+ */
+void AppendXmlText(const char *begin, const char *end, std::string *out) {
+    const char *p = begin;
+    while (p < end) {
+        const char *amp = static_cast<const char *>(memchr(p, '&', static_cast<size_t>(end - p)));
+        if (amp == nullptr) {
+            out->append(p, static_cast<size_t>(end - p));
+            return;
+        }
+        out->append(p, static_cast<size_t>(amp - p));
+        const char *semi = static_cast<const char *>(memchr(amp, ';', std::min<size_t>(end - amp, 12)));
+        if (semi == nullptr) {
+            out->push_back('&');
+            p = amp + 1;
+            continue;
+        }
+        const std::string_view name(amp + 1, static_cast<size_t>(semi - amp - 1));
+        if (name == "amp") {
+            out->push_back('&');
+        } else if (name == "lt") {
+            out->push_back('<');
+        } else if (name == "gt") {
+            out->push_back('>');
+        } else if (name == "quot") {
+            out->push_back('"');
+        } else if (name == "apos") {
+            out->push_back('\'');
+        } else if (name.size() > 1 && name[0] == '#') {
+            const bool hex = name[1] == 'x' || name[1] == 'X';
+            uint32_t code = 0;
+            bool valid = name.size() > (hex ? 2u : 1u);
+            for (size_t i = hex ? 2 : 1; valid && i < name.size(); ++i) {
+                const int digit = hex ? HexValue(name[i]) : (name[i] >= '0' && name[i] <= '9' ? name[i] - '0' : -1);
+                valid = digit >= 0 && code <= 0x10FFFF;
+                code = code * (hex ? 16 : 10) + static_cast<uint32_t>(digit);
+            }
+            if (!valid) {
+                out->append(amp, static_cast<size_t>(semi - amp + 1));
+            } else {
+                AppendUtf8(out, code);
+            }
+        } else {
+            out->append(amp, static_cast<size_t>(semi - amp + 1));
+        }
+        p = semi + 1;
+    }
+}
+
+class XmlParser {
+public:
+    XmlParser(const char *data, size_t size, CommentStoreBuilder *builder)
+        : p_(data), end_(data + size), builder_(builder) {}
+
+    void Run() {
+        while (p_ < end_) {
+            const char *open = static_cast<const char *>(memchr(p_, '<', static_cast<size_t>(end_ - p_)));
+            if (open == nullptr || end_ - open < 3) {
+                return;
+            }
+            p_ = open + 1;
+            if ((*p_ != 'd' && *p_ != 'D') || !(IsSpace(p_[1]) || p_[1] == '>' || p_[1] == '/')) {
+                continue;
+            }
+            ParseComment();
+        }
+    }
+
+private:
+    void ParseComment() {
+        const char *value = nullptr;
+        const char *value_end = nullptr;
+        bool self_closing = false;
+        ++p_;
+        // Attributes up to the closing '>'; values may legally contain '>'.
+        for (;;) {
+            while (p_ < end_ && IsSpace(*p_)) ++p_;
+            if (p_ >= end_) return;
+            if (*p_ == '>') {
+                ++p_;
+                break;
+            }
+            if (*p_ == '/') {
+                self_closing = true;
+                ++p_;
+                continue;
+            }
+            const char *name = p_;
+            while (p_ < end_ && *p_ != '=' && *p_ != '>' && !IsSpace(*p_)) ++p_;
+            const char *name_end = p_;
+            while (p_ < end_ && IsSpace(*p_)) ++p_;
+            if (p_ >= end_ || *p_ != '=') continue;
+            ++p_;
+            while (p_ < end_ && IsSpace(*p_)) ++p_;
+            if (p_ >= end_ || (*p_ != '"' && *p_ != '\'')) continue;
+            const char quote = *p_++;
+            const char *close = static_cast<const char *>(memchr(p_, quote, static_cast<size_t>(end_ - p_)));
+            if (close == nullptr) {
+                p_ = end_;
+                return;
+            }
+            if (name_end - name == 1 && (*name == 'p' || *name == 'P')) {
+                value = p_;
+                value_end = close;
+            }
+            p_ = close + 1;
+        }
+        if (self_closing || value == nullptr) {
+            return;
+        }
+
+        const char *fields[4];
+        const char *field_ends[4];
+        if (SplitFields(value, value_end, fields, field_ends, 4) < 4) {
+            return;
+        }
+        const int32_t time_ms = ParseTimeMs(fields[0], field_ends[0]);
+        const auto mode = static_cast<uint8_t>(std::clamp<int64_t>(ParseInteger(fields[1], field_ends[1]), 0, 255));
+        double size = kDefaultSize;
+        if (!ParseDecimal(fields[2], field_ends[2], &size)) size = 0;
+        const auto color = static_cast<uint32_t>(ParseInteger(fields[3], field_ends[3]));
+
+        std::string &text = builder_->PendingText();
+        text.clear();
+        ReadText(&text);
+        // BiliDanmakuParser decoded these four once more on top of the SAX decoding;
+        // sources that double-escape rely on it.
+        if (text.find('&') != std::string::npos) {
+            ReplaceAllFrom(&text, 0, "&amp;", "&");
+            ReplaceAllFrom(&text, 0, "&quot;", "\"");
+            ReplaceAllFrom(&text, 0, "&gt;", ">");
+            ReplaceAllFrom(&text, 0, "&lt;", "<");
+        }
+        builder_->Commit(time_ms, mode, static_cast<uint8_t>(std::clamp(std::lround(size), 0L, 255L)), color);
+    }
+
+    void ReadText(std::string *text) {
+        static constexpr std::string_view kCdataOpen = "<![CDATA[";
+        for (;;) {
+            const char *stop = FindEither(p_, end_, '<', '&');
+            if (stop >= end_) {
+                AppendXmlText(p_, end_, text);
+                p_ = end_;
+                return;
+            }
+            if (*stop == '&') {
+                // Entities are short; hand the run up to the next '<' to the decoder.
+                const char *lt = static_cast<const char *>(memchr(stop, '<', static_cast<size_t>(end_ - stop)));
+                const char *run_end = lt != nullptr ? lt : end_;
+                AppendXmlText(p_, run_end, text);
+                p_ = run_end;
+                continue;
+            }
+            text->append(p_, static_cast<size_t>(stop - p_));
+            p_ = stop;
+            if (static_cast<size_t>(end_ - p_) >= kCdataOpen.size() &&
+                std::string_view(p_, kCdataOpen.size()) == kCdataOpen) {
+                const char *body = p_ + kCdataOpen.size();
+                const std::string_view rest(body, static_cast<size_t>(end_ - body));
+                const size_t close = rest.find("]]>");
+                const size_t length = close == std::string_view::npos ? rest.size() : close;
+                text->append(body, length);
+                p_ = body + std::min(rest.size(), length + 3);
+                continue;
+            }
+            return;
+        }
+    }
+
+    const char *p_;
+    const char *end_;
+    CommentStoreBuilder *builder_;
+};
+
+/**
+ * Just enough JSON for the dandanplay comment API: every object carrying string
+ * members "p" and "m" becomes a comment, wherever it sits in the document.
+ */
+class JsonParser {
+public:
+    JsonParser(const char *data, size_t size, CommentStoreBuilder *builder)
+        : p_(data), end_(data + size), builder_(builder) {}
+
+    bool Run(std::string *error) {
+        SkipSpace();
+        if (!ParseValue(0)) {
+            *error = error_.empty() ? "malformed JSON" : error_;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void SkipSpace() {
+        while (p_ < end_ && IsSpace(*p_)) ++p_;
+    }
+
+    bool ParseValue(int depth) {
+        if (p_ >= end_) return false;
+        switch (*p_) {
+            case '{':
+                return ParseObject(depth + 1);
+            case '[':
+                return ParseArray(depth + 1);
+            case '"':
+                return ParseString(nullptr);
+            default:
+                while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !IsSpace(*p_)) ++p_;
+                return true;
+        }
+    }
+
+    bool ParseArray(int depth) {
+        if (depth > kMaxJsonDepth) {
+            error_ = "JSON nested too deeply";
+            return false;
+        }
+        ++p_;
+        SkipSpace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+            return true;
+        }
+        for (;;) {
+            SkipSpace();
+            if (!ParseValue(depth)) return false;
+            SkipSpace();
+            if (p_ >= end_) return false;
+            if (*p_ == ']') {
+                ++p_;
+                return true;
+            }
+            if (*p_ != ',') return false;
+            ++p_;
+        }
+    }
+
+    bool ParseObject(int depth) {
+        if (depth > kMaxJsonDepth) {
+            error_ = "JSON nested too deeply";
+            return false;
+        }
+        ++p_;
+        bool has_p = false;
+        bool has_m = false;
+        for (;;) {
+            SkipSpace();
+            if (p_ >= end_) return false;
+            if (*p_ == '}') {
+                ++p_;
+                break;
+            }
+            if (*p_ == ',') {
+                ++p_;
+                continue;
+            }
+            if (*p_ != '"') return false;
+            key_.clear();
+            if (!ParseString(&key_)) return false;
+            SkipSpace();
+            if (p_ >= end_ || *p_ != ':') return false;
+            ++p_;
+            SkipSpace();
+            if (p_ < end_ && *p_ == '"' && (key_ == "p" || key_ == "m")) {
+                std::string *target = key_ == "p" ? &params_ : &message_;
+                target->clear();
+                if (!ParseString(target)) return false;
+                (key_ == "p" ? has_p : has_m) = true;
+            } else if (!ParseValue(depth)) {
+                return false;
+            }
+        }
+        if (has_p && has_m) {
+            AddComment();
+        }
+        return true;
+    }
+
+    void AddComment() {
+        const char *begin = params_.data();
+        const char *end = begin + params_.size();
+        const char *fields[3];
+        const char *field_ends[3];
+        const size_t count = SplitFields(begin, end, fields, field_ends, 3);
+        const int32_t time_ms = ParseTimeMs(fields[0], field_ends[0]);
+        const auto mode =
+            count > 1 ? static_cast<uint8_t>(std::clamp<int64_t>(ParseInteger(fields[1], field_ends[1]), 0, 255)) : 1;
+        uint32_t color = 0xFFFFFF;
+        if (count > 2) {
+            const int64_t parsed = ParseInteger(fields[2], field_ends[2]);
+            // Same correction as DanmuContentGenerator: 0 and -1 mean "unset".
+            if (parsed > 0) color = static_cast<uint32_t>(parsed);
+        }
+        builder_->Add(time_ms, mode, kDefaultSize, color, message_);
+    }
+
+    // Reads a string token; `out` receives the unescaped value, null skips it.
+    bool ParseString(std::string *out) {
+        ++p_;
+        for (;;) {
+            const char *stop = FindEither(p_, end_, '"', '\\');
+            if (stop >= end_) return false;
+            if (out != nullptr) out->append(p_, static_cast<size_t>(stop - p_));
+            p_ = stop + 1;
+            if (*stop == '"') return true;
+            if (p_ >= end_) return false;
+            const char escape = *p_++;
+            if (out == nullptr) {
+                continue;
+            }
+            switch (escape) {
+                case 'n': out->push_back('\n'); break;
+                case 't': out->push_back('\t'); break;
+                case 'r': out->push_back('\r'); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!ReadHex4(&code)) return false;
+                    if (code >= 0xD800 && code <= 0xDBFF && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                        const char *saved = p_;
+                        p_ += 2;
+                        uint32_t low = 0;
+                        if (ReadHex4(&low) && low >= 0xDC00 && low <= 0xDFFF) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            p_ = saved;
+                        }
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default: out->push_back(escape); break;
+            }
+        }
+    }
+
+    bool ReadHex4(uint32_t *code) {
+        if (end_ - p_ < 4) return false;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int digit = HexValue(p_[i]);
+            if (digit < 0) return false;
+            value = value * 16 + static_cast<uint32_t>(digit);
+        }
+        p_ += 4;
+        *code = value;
+        return true;
+    }
+
+    const char *p_;
+    const char *end_;
+    CommentStoreBuilder *builder_;
+    std::string key_;
+    std::string params_;
+    std::string message_;
+    std::string error_;
+};
+
+SourceFormat DetectFormat(const char *data, size_t size) {
+    size_t i = 0;
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) i = 3;
+    while (i < size && IsSpace(data[i])) ++i;
+    if (i >= size) return SourceFormat::kAuto;
+    if (data[i] == '<') return SourceFormat::kXml;
+    if (data[i] == '{' || data[i] == '[') return SourceFormat::kJson;
+    return SourceFormat::kAuto;
+}
+
+}  // namespace
+
+void CommentStoreBuilder::Reserve(size_t comments, size_t arena_bytes) {
+    time_.reserve(comments);
+    color_.reserve(comments);
+    text_offset_.reserve(comments);
+    text_length_.reserve(comments);
+    mode_.reserve(comments);
+    size_.reserve(comments);
+    arena_.reserve(arena_bytes);
+}
+
+void CommentStoreBuilder::Add(int32_t time_ms, uint8_t mode, uint8_t size, uint32_t color, std::string_view text) {
+    pending_.assign(text.data(), text.size());
+    Commit(time_ms, mode, size, color);
+}
+
+void CommentStoreBuilder::Commit(int32_t time_ms, uint8_t mode, uint8_t size, uint32_t color) {
+    if (pending_.empty() || arena_.size() + pending_.size() > UINT32_MAX) {
+        return;
+    }
+    time_.push_back(time_ms);
+    color_.push_back(color);
+    text_offset_.push_back(static_cast<uint32_t>(arena_.size()));
+    text_length_.push_back(static_cast<uint32_t>(pending_.size()));
+    mode_.push_back(mode);
+    size_.push_back(size);
+    arena_.append(pending_);
+}
+
+std::unique_ptr<CommentStore> CommentStoreBuilder::Finish() {
+    const size_t count = time_.size();
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    if (!std::is_sorted(time_.begin(), time_.end())) {
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return time_[a] < time_[b]; });
+    }
+
+    const size_t time_offset = kStoreHeaderBytes;
+    const size_t color_offset = time_offset + count * 4;
+    const size_t text_offset_offset = color_offset + count * 4;
+    const size_t text_length_offset = text_offset_offset + count * 4;
+    const size_t mode_offset = text_length_offset + count * 4;
+    const size_t size_offset = mode_offset + count;
+    const size_t arena_offset = AlignUp(size_offset + count);
+    const size_t total = AlignUp(arena_offset + arena_.size());
+
+    auto store = std::unique_ptr<CommentStore>(new CommentStore());
+    store->block_.reset(new uint8_t[total]());
+    store->data_ = store->block_.get();
+    store->bytes_ = total;
+    store->count_ = static_cast<uint32_t>(count);
+    uint8_t *block = store->block_.get();
+
+    PutU32(block, kStoreMagic);
+    PutU32(block + 4, kStoreVersion);
+    PutU32(block + 8, static_cast<uint32_t>(count));
+    PutU32(block + 12, static_cast<uint32_t>(arena_.size()));
+    PutU32(block + 16, static_cast<uint32_t>(time_offset));
+    PutU32(block + 20, static_cast<uint32_t>(color_offset));
+    PutU32(block + 24, static_cast<uint32_t>(text_offset_offset));
+    PutU32(block + 28, static_cast<uint32_t>(text_length_offset));
+    PutU32(block + 32, static_cast<uint32_t>(mode_offset));
+    PutU32(block + 36, static_cast<uint32_t>(size_offset));
+    PutU32(block + 40, static_cast<uint32_t>(arena_offset));
+    PutU32(block + 44, static_cast<uint32_t>(total));
+
+    // Both ABIs we ship are little endian, so the columns are written natively.
+    auto *time = reinterpret_cast<int32_t *>(block + time_offset);
+    auto *color = reinterpret_cast<uint32_t *>(block + color_offset);
+    auto *text_offset = reinterpret_cast<uint32_t *>(block + text_offset_offset);
+    auto *text_length = reinterpret_cast<uint32_t *>(block + text_length_offset);
+    uint8_t *mode = block + mode_offset;
+    uint8_t *size = block + size_offset;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t source = order[i];
+        time[i] = time_[source];
+        color[i] = color_[source];
+        text_offset[i] = text_offset_[source];
+        text_length[i] = text_length_[source];
+        mode[i] = mode_[source];
+        size[i] = size_[source];
+    }
+    if (!arena_.empty()) {
+        memcpy(block + arena_offset, arena_.data(), arena_.size());
+    }
+
+    store->time_ = time;
+    store->color_ = color;
+    store->text_offset_ = text_offset;
+    store->text_length_ = text_length;
+    store->mode_ = mode;
+    store->size_ = size;
+    store->arena_ = block + arena_offset;
+
+    *this = CommentStoreBuilder();
+    return store;
+}
+
+std::unique_ptr<CommentStore> CommentStore::FromBlock(const uint8_t *data, size_t bytes,
+                                                     std::shared_ptr<const void> owner) {
+    if (data == nullptr || bytes < kStoreHeaderBytes || reinterpret_cast<uintptr_t>(data) % 4 != 0 ||
+        GetU32(data) != kStoreMagic || GetU32(data + 4) != kStoreVersion) {
+        return nullptr;
+    }
+    const uint64_t count = GetU32(data + 8);
+    const uint64_t arena_bytes = GetU32(data + 12);
+    const uint64_t time_offset = GetU32(data + 16);
+    const uint64_t color_offset = GetU32(data + 20);
+    const uint64_t text_offset_offset = GetU32(data + 24);
+    const uint64_t text_length_offset = GetU32(data + 28);
+    const uint64_t mode_offset = GetU32(data + 32);
+    const uint64_t size_offset = GetU32(data + 36);
+    const uint64_t arena_offset = GetU32(data + 40);
+    const uint64_t total = GetU32(data + 44);
+    const auto fits = [&](uint64_t offset, uint64_t length) { return offset + length <= total; };
+    if (total > bytes || time_offset % 4 != 0 || color_offset % 4 != 0 || text_offset_offset % 4 != 0 ||
+        text_length_offset % 4 != 0 || !fits(time_offset, count * 4) || !fits(color_offset, count * 4) ||
+        !fits(text_offset_offset, count * 4) || !fits(text_length_offset, count * 4) || !fits(mode_offset, count) ||
+        !fits(size_offset, count) || !fits(arena_offset, arena_bytes)) {
+        return nullptr;
+    }
+
+    auto store = std::unique_ptr<CommentStore>(new CommentStore());
+    store->owner_ = std::move(owner);
+    store->data_ = data;
+    store->bytes_ = static_cast<size_t>(total);
+    store->count_ = static_cast<uint32_t>(count);
+    store->time_ = reinterpret_cast<const int32_t *>(data + time_offset);
+    store->color_ = reinterpret_cast<const uint32_t *>(data + color_offset);
+    store->text_offset_ = reinterpret_cast<const uint32_t *>(data + text_offset_offset);
+    store->text_length_ = reinterpret_cast<const uint32_t *>(data + text_length_offset);
+    store->mode_ = data + mode_offset;
+    store->size_ = data + size_offset;
+    store->arena_ = data + arena_offset;
+    // Text ranges are checked once here so text() stays a plain lookup.
+    for (uint32_t i = 0; i < store->count_; ++i) {
+        if (static_cast<uint64_t>(store->text_offset_[i]) + store->text_length_[i] > arena_bytes) {
+            return nullptr;
+        }
+    }
+    return store;
+}
+
+std::unique_ptr<CommentStore> ParseBuffer(const char *data, size_t size, SourceFormat format,
+                                          std::string *error) {
+    if (format == SourceFormat::kAuto) {
+        format = DetectFormat(data, size);
+    }
+    CommentStoreBuilder builder;
+    // Bilibili XML averages roughly 90 bytes per comment, a third of it text.
+    builder.Reserve(size / 96, size / 3);
+    switch (format) {
+        case SourceFormat::kXml:
+            XmlParser(data, size, &builder).Run();
+            break;
+        case SourceFormat::kJson:
+            if (!JsonParser(data, size, &builder).Run(error)) {
+                return nullptr;
+            }
+            break;
+        case SourceFormat::kAuto:
+            *error = "unrecognised danmaku format";
+            return nullptr;
+    }
+    return builder.Finish();
+}
+
+std::unique_ptr<CommentStore> ParseFile(const std::string &path, SourceFormat format, std::string *error) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = std::string("open failed: ") + strerror(errno);
+        return nullptr;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        *error = "empty or unreadable danmaku file";
+        close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        *error = std::string("mmap failed: ") + strerror(errno);
+        return nullptr;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    auto store = ParseBuffer(static_cast<const char *>(mapped), size, format, error);
+    munmap(mapped, size);
+    return store;
+}
+
+}  // namespace danmaku
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace danmaku {
+
+/**
+ * Columnar comment store, one contiguous block handed to Kotlin as a direct
+ * ByteBuffer (all integers little endian, every column 4-byte aligned):
+ *
+ *   u32 magic "DDCS", u32 version, u32 count, u32 arena_bytes
+ *   u32 offsets of the time, color, text_offset, text_length, mode and size
+ *       columns and of the arena, u32 total_bytes
+ *   count x i32 time_ms
+ *   count x u32 color          (0xRRGGBB as written in the source)
+ *   count x u32 text_offset    (into the arena)
+ *   count x u32 text_length    (bytes)
+ *   count x u8  mode           (1 scroll, 4 bottom, 5 top, 6 reverse, 7 special, ...)
+ *   count x u8  size           (font size, clamped to 255)
+ *   arena: UTF-8 text with XML entities / JSON escapes decoded, not NUL-terminated
+ *
+ * Comments are sorted by time; ties keep source order. DanmakuStore.kt reads
+ * the same layout.
+ */
+constexpr uint32_t kStoreMagic = 0x53434444;  // "DDCS"
+constexpr uint32_t kStoreVersion = 1;
+constexpr size_t kStoreHeaderBytes = 48;
+
+class CommentStore {
+public:
+    /**
+     * Wraps a block packed earlier by CommentStoreBuilder (e.g. mapped from a
+     * DanmakuCache section) without copying it; `owner` keeps the memory alive.
+     * Null when the header or the column offsets do not fit in `bytes`.
+     */
+    static std::unique_ptr<CommentStore> FromBlock(const uint8_t *data, size_t bytes,
+                                                   std::shared_ptr<const void> owner);
+
+    const uint8_t *data() const { return data_; }
+    size_t bytes() const { return bytes_; }
+    uint32_t count() const { return count_; }
+
+    int32_t time_ms(uint32_t index) const { return time_[index]; }
+    uint32_t color(uint32_t index) const { return color_[index]; }
+    uint8_t mode(uint32_t index) const { return mode_[index]; }
+    uint8_t size(uint32_t index) const { return size_[index]; }
+    std::string_view text(uint32_t index) const {
+        return {reinterpret_cast<const char *>(arena_) + text_offset_[index], text_length_[index]};
+    }
+
+private:
+    friend class CommentStoreBuilder;
+
+    std::unique_ptr<uint8_t[]> block_;
+    std::shared_ptr<const void> owner_;
+    const uint8_t *data_ = nullptr;
+    size_t bytes_ = 0;
+    uint32_t count_ = 0;
+    const int32_t *time_ = nullptr;
+    const uint32_t *color_ = nullptr;
+    const uint32_t *text_offset_ = nullptr;
+    const uint32_t *text_length_ = nullptr;
+    const uint8_t *mode_ = nullptr;
+    const uint8_t *size_ = nullptr;
+    const uint8_t *arena_ = nullptr;
+};
+
+/**
+ * Collects comments in source order and packs them into a CommentStore.
+ */
+class CommentStoreBuilder {
+public:
+    void Reserve(size_t comments, size_t arena_bytes);
+
+    // `text` must already be decoded; empty texts are dropped, like the SAX parser did.
+    void Add(int32_t time_ms, uint8_t mode, uint8_t size, uint32_t color, std::string_view text);
+
+    // Appends decoded text piece by piece; Commit() turns it into a comment.
+    std::string &PendingText() { return pending_; }
+    void Commit(int32_t time_ms, uint8_t mode, uint8_t size, uint32_t color);
+
+    size_t count() const { return time_.size(); }
+
+    // Stable-sorts by time and packs the columns; the builder is left empty.
+    std::unique_ptr<CommentStore> Finish();
+
+private:
+    std::vector<int32_t> time_;
+    std::vector<uint32_t> color_;
+    std::vector<uint32_t> text_offset_;
+    std::vector<uint32_t> text_length_;
+    std::vector<uint8_t> mode_;
+    std::vector<uint8_t> size_;
+    std::string arena_;
+    std::string pending_;
+};
+
+enum class SourceFormat {
+    kAuto,
+    // Bilibili style: <d p="time,mode,size,color,...">text</d>
+    kXml,
+    // dandanplay API style: {"comments":[{"p":"time,mode,color,user","m":"text"}]}
+    kJson,
+};
+
+/**
+ * Parses a danmaku document held in memory. Returns null with `error` set when
+ * the format cannot be recognised; malformed comments are skipped.
+ */
+std::unique_ptr<CommentStore> ParseBuffer(const char *data, size_t size, SourceFormat format,
+                                          std::string *error);
+
+/**
+ * Maps `path` read-only and parses it with ParseBuffer. The mapping is released
+ * before returning, the store owns its own copy of every text.
+ */
+std::unique_ptr<CommentStore> ParseFile(const std::string &path, SourceFormat format, std::string *error);
+
+}  // namespace danmaku
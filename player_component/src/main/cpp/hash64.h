@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace hash64 {
+
+// XXH64-style hash of [data, data + bytes): four independent lanes of 8-byte
+// rounds, so checksumming a multi-megabyte cache section runs at memory speed.
+// Shared by the danmaku caches and the libass track and program caches.
+// Chaining the result in as the next `seed` hashes several ranges as one key.
+// The lane merge and the tail/finalization steps differ from the reference
+// XXH64, so values do not match it: only compare them with other Hash64 results.
+inline uint64_t Hash64(const void *data, size_t bytes, uint64_t seed = 0) {
+    constexpr uint64_t kP1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kP2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kP3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kP4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kP5 = 0x27D4EB2F165667C5ULL;
+    const auto rotl = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+    const auto round = [&](uint64_t acc, uint64_t input) { return rotl(acc + input * kP2, 31) * kP1; };
+    const auto load64 = [](const uint8_t *p) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    };
+
+    const auto *p = static_cast<const uint8_t *>(data);
+    const uint8_t *end = p + bytes;
+    uint64_t hash;
+    if (bytes >= 32) {
+        uint64_t lanes[4] = {seed + kP1 + kP2, seed + kP2, seed, seed - kP1};
+        for (; end - p >= 32; p += 32) {
+            for (int i = 0; i < 4; ++i) {
+                lanes[i] = round(lanes[i], load64(p + i * 8));
+            }
+        }
+        hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (const uint64_t lane : lanes) {
+            hash = (hash ^ round(0, lane)) * kP1 + kP4;
+        }
+    } else {
+        hash = seed + kP5;
+    }
+    hash += bytes;
+    for (; end - p >= 8; p += 8) {
+        hash = rotl(hash ^ round(0, load64(p)), 27) * kP1 + kP4;
+    }
+    if (end - p >= 4) {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        hash = rotl(hash ^ (static_cast<uint64_t>(word) * kP1), 23) * kP2 + kP3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash = rotl(hash ^ (*p * kP5), 11) * kP1;
+    }
+    hash ^= hash >> 33;
+    hash *= kP2;
+    hash ^= hash >> 29;
+    hash *= kP3;
+    return hash ^ (hash >> 32);
+}
+
+}  // namespace hash64
@@ -1,13 +1,20 @@
 #include <jni.h>
 #include <android/log.h>
 #include <android/native_window_jni.h>
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <deque>
 #include <dlfcn.h>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <time.h>
 #include <utility>
 #include <vector>
 
@@ -15,6 +22,8 @@
 #define MPV_PREBUILT_AVAILABLE 0
 #endif
 
+#include "mpv_thumbnail.h"
+
 #if MPV_PREBUILT_AVAILABLE
 extern "C" {
 #include <mpv/client.h>
@@ -23,6 +32,11 @@ extern "C" {
 }
 #include <EGL/egl.h>
 #include <GLES3/gl3.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "ass_gpu_compositor.h"
 #endif
 
 namespace {
@@ -35,6 +49,15 @@ constexpr jint kEventError = 5;
 constexpr jint kEventBufferingStart = 6;
 constexpr jint kEventBufferingEnd = 7;
 constexpr jint kEventLogMessage = 8;
+// Async request completions: arg1 = request id, arg2 = mpv error code (0 on success).
+constexpr jint kEventCommandReply = 9;
+constexpr jint kEventSetPropertyReply = 10;
+// First frame after a scrub release: arg1 = release-to-frame latency in ms, arg2 = drag
+// updates that were coalesced away instead of being sent to mpv.
+constexpr jint kEventScrubSettled = 11;
+// End of a playSegment() request: arg1 = position in ms where playback paused, arg2 = 1 when
+// the segment end was reached, 0 when it was cancelled by a seek elsewhere or end of file.
+constexpr jint kEventSegmentEnd = 12;
 constexpr jint kTrackVideo = 0;
 constexpr jint kTrackAudio = 1;
 constexpr jint kTrackSubtitle = 2;
@@ -42,18 +65,92 @@ constexpr jint kTrackSubtitle = 2;
 JavaVM* g_java_vm = nullptr;
 std::mutex g_app_ctx_mutex;
 jobject g_android_app_ctx = nullptr;
-std::mutex g_error_mutex;
-std::string g_last_error;
 
-void set_last_error(const std::string& message) {
-    std::lock_guard<std::mutex> lock(g_error_mutex);
-    g_last_error = message;
+// Error slots hold the last failure as one word: mpv/bridge error code in bits 0-31, interned
+// message id in bits 32-47 and a sequence number in bits 48-63 (bumped on every failure, so
+// Kotlin can tell a repeated error from a new one). 0 means no error. Only failures write a
+// slot, so successful calls and the property getters never touch it.
+// Keep the layout in sync with MpvNativeBridge.NativeError.
+using ErrorSlot = std::atomic<uint64_t>;
+
+// Messages are interned once and never freed, so ids are stable for the process lifetime and
+// reading one back needs no lock. Interned text must stay bounded: put paths, URLs and option
+// values in the log, not in the message.
+constexpr uint32_t kMaxErrorMessages = 1024;
+constexpr uint32_t kErrorMessageOverflowId = 1;
+// Fixed id for failed property reads: getters are polled, so they must not take the intern lock.
+constexpr uint32_t kGetPropertyFailedId = 2;
+std::atomic<const char*> g_error_messages[kMaxErrorMessages];
+std::mutex g_error_intern_mutex;
+std::deque<std::string> g_error_message_storage;
+uint32_t g_error_message_count = 3;
+
+// Failures that happen before there is a session (libmpv loading, mpv_create, ...).
+ErrorSlot g_process_error{0};
+
+uint32_t internErrorMessage(const std::string& message) {
+    std::lock_guard<std::mutex> lock(g_error_intern_mutex);
+    for (uint32_t id = 3; id < g_error_message_count; id++) {
+        if (message == g_error_messages[id].load(std::memory_order_relaxed)) {
+            return id;
+        }
+    }
+    if (g_error_message_count >= kMaxErrorMessages) {
+        return kErrorMessageOverflowId;
+    }
+    const uint32_t id = g_error_message_count++;
+    g_error_messages[id].store(g_error_message_storage.emplace_back(message).c_str(), std::memory_order_release);
+    return id;
+}
+
+const char* errorMessageById(uint32_t id) {
+    if (id == kErrorMessageOverflowId) {
+        return "mpv bridge error (message table full)";
+    }
+    if (id == kGetPropertyFailedId) {
+        return "mpv_get_property failed";
+    }
+    return id < kMaxErrorMessages ? g_error_messages[id].load(std::memory_order_acquire) : nullptr;
+}
+
+void storeError(ErrorSlot& slot, uint32_t messageId, int64_t code) {
+    uint64_t current = slot.load(std::memory_order_relaxed);
+    uint64_t next = 0;
+    do {
+        const uint64_t sequence = ((current >> 48) + 1) & 0xffff;
+        next = (sequence << 48) | (static_cast<uint64_t>(messageId & 0xffff) << 32) |
+               static_cast<uint32_t>(static_cast<int32_t>(code));
+    } while (!slot.compare_exchange_weak(current, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void recordError(ErrorSlot& slot, const std::string& message, int64_t code = 0) {
+    storeError(slot, internErrorMessage(message), code);
+}
+
+// Drops the error but keeps the sequence running.
+void clearError(ErrorSlot& slot) {
+    slot.fetch_and(0xffffULL << 48, std::memory_order_relaxed);
+}
+
+// Keeps the current error: used for auxiliary failures that must not hide the root cause.
+void storeErrorIfClear(ErrorSlot& slot, uint32_t messageId, int64_t code = 0) {
+    if ((slot.load(std::memory_order_relaxed) & 0xffffffffffffULL) != 0) {
+        return;
+    }
+    storeError(slot, messageId, code);
 }
 
-std::string get_last_error() {
-    std::lock_guard<std::mutex> lock(g_error_mutex);
-    return g_last_error;
+
+struct MpvSession;
+// Records into the session's slot, or the process slot when `session` is null.
+void recordError(MpvSession* session, const std::string& message, int64_t code = 0);
+
+#if MPV_PREBUILT_AVAILABLE
+// For mpv API failures: the mpv error text goes into the (bounded) message, the code alongside.
+void recordMpvError(MpvSession* session, const std::string& what, int result) {
+    recordError(session, what + " failed (" + mpv_error_string(result) + ")", result);
 }
+#endif
 
 #if MPV_PREBUILT_AVAILABLE
 int mpvLogLevelToInt(const char* level) {
@@ -124,19 +221,71 @@ std::vector<std::string> collectHeaders(JNIEnv* env, jobjectArray headers) {
     result.reserve(static_cast<size_t>(headerCount));
     for (jsize i = 0; i < headerCount; i++) {
         auto element = static_cast<jstring>(env->GetObjectArrayElement(headers, i));
+        if (element == nullptr) {
+            continue;
+        }
         const char* headerChars = env->GetStringUTFChars(element, nullptr);
         if (headerChars != nullptr) {
             result.emplace_back(headerChars);
+            env->ReleaseStringUTFChars(element, headerChars);
         }
-        env->ReleaseStringUTFChars(element, headerChars);
         env->DeleteLocalRef(element);
     }
     return result;
 }
 
 #if MPV_PREBUILT_AVAILABLE
+// Seek-bar drag state. Written by JNI callers and by the event thread, hence its own lock
+// (session->mutex is held across surface/render setup and must not gate seeking).
+struct ScrubState {
+    std::mutex mutex;
+    bool active = false;
+    bool seek_in_flight = false;
+    std::chrono::steady_clock::time_point seek_issued_at;
+    bool has_pending = false;
+    int64_t pending_ms = 0;
+    int64_t coalesced = 0;
+    bool final_queued = false;
+    bool final_acked = false;
+    std::chrono::steady_clock::time_point released_at;
+};
+
+// What a session may use while it is in the foreground; background sessions get a reduced
+// copy (see backgroundBudget()). Defaults match mpv's own, so a lone session is unaffected.
+struct ResourceBudget {
+    int64_t demuxer_max_bytes = 150LL << 20;
+    int64_t demuxer_max_back_bytes = 50LL << 20;
+    // 0 = libavcodec picks the thread count.
+    int decoder_threads = 0;
+    bool hwdec = true;
+};
+
+constexpr int kSessionForeground = 0;
+constexpr int kSessionBackground = 1;
+
+// A forward step completes on its next time-pos change, a backward one (a seek) on its
+// PLAYBACK_RESTART.
+constexpr int kFrameStepNone = 0;
+constexpr int kFrameStepForward = 1;
+constexpr int kFrameStepBackward = 2;
+
+// "Play [start, end) then pause". Armed by the PLAYBACK_RESTART of its own seek and then
+// checked by the event thread on every time-pos change, so the pause lands on the last frame
+// before `end` instead of whenever a Kotlin timer polls the position.
+struct SegmentState {
+    std::mutex mutex;
+    bool seeking = false;
+    bool seek_acked = false;
+    bool armed = false;
+    double start = 0.0;
+    double end = 0.0;
+    double last_pos = -1.0;
+    double frame_interval = 0.0;
+};
+
 struct MpvSession {
     mpv_handle* handle = nullptr;
+    ErrorSlot error{0};
     std::vector<std::string> headers;
     bool paused = false;
     bool looping = false;
@@ -153,25 +302,71 @@ struct MpvSession {
     std::atomic<bool> surface_changed = false;
     std::thread event_thread;
     EventCallbackRef event_callback;
+    // eventfd the event thread blocks on; written by mpv's wakeup callback and by the bridge.
+    // Lives as long as the mpv handle.
+    int wakeup_fd = -1;
 
     std::atomic<bool> render_requested = false;
     int surface_width = 0;
     int surface_height = 0;
-    // Rendering state (lives on event thread)
+
+    // Render-API output (vo=libmpv). The EGL/render state below is owned by render_thread;
+    // the fields guarded by render_mutex are how JNI callers talk to it.
+    bool render_api = false;
+    std::thread render_thread;
+    std::atomic<bool> render_running = false;
+    std::mutex render_mutex;
+    std::condition_variable render_cv;
+    ANativeWindow* pending_window = nullptr;
+    bool window_changed = false;
+    uint64_t window_generation = 0;
+    uint64_t applied_window_generation = 0;
+    int64_t vsync_ns = 0;
+    int64_t vsync_period_ns = 0;
+    bool vsync_pending = false;
+    bool subtitle_redraw = false;
+
+    // GPU ASS subtitles drawn into the render-API frame before the swap. The render thread
+    // holds compositor_mutex for the whole call, so clearing the handle also waits out a
+    // frame that is still using it.
+    std::mutex compositor_mutex;
+    AssGpuCompositeFrameFn compositor_fn = nullptr;
+    int64_t compositor_handle = 0;
+    int64_t compositor_offset_ms = 0;
+    // Bumped whenever the render thread builds a new EGL context.
+    uint64_t egl_generation = 0;
+
+    // Playback clock from observed properties, sampled on the event thread.
+    std::mutex clock_mutex;
+    double clock_time_pos = -1.0;
+    bool clock_paused = false;
+    double clock_speed = 1.0;
+    int64_t clock_sampled_ns = 0;
+
+    // Rendering state (lives on render_thread)
 
     EGLDisplay egl_display = EGL_NO_DISPLAY;
     EGLContext egl_context = EGL_NO_CONTEXT;
     EGLSurface egl_surface = EGL_NO_SURFACE;
     mpv_render_context* render_context = nullptr;
+
+    ScrubState scrub;
+    SegmentState segment;
+    // One frame step at a time; requests arriving meanwhile are dropped rather than queued
+    // behind expensive backward steps.
+    std::atomic<int> frame_step_in_flight{kFrameStepNone};
+    std::atomic<int64_t> frame_step_issued_ns{0};
+
+    // Arbiter state, guarded by g_sessions_mutex.
+    int role = kSessionForeground;
+    ResourceBudget budget;
+    // Last "hwdec" Kotlin asked for; applied only while the arbiter grants a decoder slot.
+    std::string preferred_hwdec = "mediacodec,mediacodec-copy";
+    bool hwdec_granted = true;
+    int applied_role = -1;
 };
 
-bool runtimeLinked() {
-    static bool checked = false;
-    static bool available = false;
-    if (checked) {
-        return available;
-    }
-    checked = true;
+bool probeRuntime() {
     void* handle = dlopen("libmpv.so", RTLD_LAZY | RTLD_LOCAL);
     if (handle == nullptr) {
         const char* dl_error = dlerror();
@@ -179,25 +374,29 @@ bool runtimeLinked() {
                                         ? "dlopen libmpv.so failed with unknown error"
                                         : std::string("dlopen libmpv.so failed: ") + dl_error;
         __android_log_print(ANDROID_LOG_WARN, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(nullptr, message);
         return false;
     }
     dlclose(handle);
-    set_last_error("");
-    available = true;
     return true;
 }
 
+// Sessions can be created concurrently, so the probe runs exactly once.
+bool runtimeLinked() {
+    static const bool available = probeRuntime();
+    return available;
+}
+
 	mpv_handle* createHandle() {
 	    if (!runtimeLinked()) {
-	        set_last_error("libmpv.so is not packaged or cannot be loaded");
+	        recordError(nullptr, "libmpv.so is not packaged or cannot be loaded");
 	        return nullptr;
 	    }
 	    mpv_handle* handle = mpv_create();
     if (handle == nullptr) {
         const std::string message = "mpv_create returned null handle";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(nullptr, message);
         return nullptr;
     }
 	    mpv_set_option_string(handle, "config", "no");
@@ -217,16 +416,15 @@ bool runtimeLinked() {
         char buffer[128] = {0};
         snprintf(buffer, sizeof(buffer), "mpv_initialize failed: %d", initResult);
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", buffer);
-        set_last_error(buffer);
+        recordMpvError(nullptr, "mpv_initialize", initResult);
         mpv_terminate_destroy(handle);
         return nullptr;
     }
-    set_last_error("");
     return handle;
 }
 
-bool applyHttpHeaders(mpv_handle* handle, const std::vector<std::string>& headers) {
-    if (handle == nullptr) {
+bool applyHttpHeaders(MpvSession* session, const std::vector<std::string>& headers) {
+    if (session == nullptr || session->handle == nullptr) {
         return false;
     }
     mpv_node root{};
@@ -248,82 +446,72 @@ bool applyHttpHeaders(mpv_handle* handle, const std::vector<std::string>& header
     root.format = MPV_FORMAT_NODE_ARRAY;
     root.u.list = &list;
 
-    const int setResult = mpv_set_property(handle, "http-header-fields", MPV_FORMAT_NODE, &root);
+    const int setResult = mpv_set_property(session->handle, "http-header-fields", MPV_FORMAT_NODE, &root);
     if (setResult < 0) {
         char buffer[128] = {0};
         snprintf(buffer, sizeof(buffer), "mpv_set_property http-header-fields failed: %d", setResult);
         __android_log_print(ANDROID_LOG_WARN, kLogTag, "%s", buffer);
-        set_last_error(buffer);
+        recordMpvError(session, "mpv_set_property http-header-fields", setResult);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
-bool loadFile(mpv_handle* handle, const char* path) {
-    if (handle == nullptr || path == nullptr) {
-        set_last_error("loadFile invoked with null handle or path");
+bool loadFile(MpvSession* session, const char* path) {
+    if (session == nullptr || session->handle == nullptr || path == nullptr) {
+        recordError(session, "loadFile invoked with null handle or path");
         return false;
     }
     const char* args[] = {"loadfile", path, nullptr};
-    const int cmdResult = mpv_command(handle, args);
+    const int cmdResult = mpv_command(session->handle, args);
     if (cmdResult < 0) {
         char buffer[256] = {0};
         snprintf(buffer, sizeof(buffer), "mpv_command loadfile failed: %d", cmdResult);
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", buffer);
-        set_last_error(buffer);
+        recordMpvError(session, "mpv_command loadfile", cmdResult);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
-bool setFlagProperty(mpv_handle* handle, const char* property, bool value) {
-    if (handle == nullptr) {
-        set_last_error("mpv_set_property flag called with null handle");
+bool setFlagProperty(MpvSession* session, const char* property, bool value) {
+    if (session == nullptr || session->handle == nullptr) {
+        recordError(session, "mpv_set_property flag called with null handle");
         return false;
     }
     int flag = value ? 1 : 0;
-    const int result = mpv_set_property(handle, property, MPV_FORMAT_FLAG, &flag);
+    const int result = mpv_set_property(session->handle, property, MPV_FORMAT_FLAG, &flag);
     if (result < 0) {
-        char buffer[128] = {0};
-        snprintf(buffer, sizeof(buffer), "mpv_set_property %s failed: %d", property, result);
-        set_last_error(buffer);
+        recordMpvError(session, std::string("mpv_set_property ") + property, result);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
-bool setDoubleProperty(mpv_handle* handle, const char* property, double value) {
-    if (handle == nullptr) {
-        set_last_error("mpv_set_property double called with null handle");
+bool setDoubleProperty(MpvSession* session, const char* property, double value) {
+    if (session == nullptr || session->handle == nullptr) {
+        recordError(session, "mpv_set_property double called with null handle");
         return false;
     }
-    const int result = mpv_set_property(handle, property, MPV_FORMAT_DOUBLE, &value);
+    const int result = mpv_set_property(session->handle, property, MPV_FORMAT_DOUBLE, &value);
     if (result < 0) {
-        char buffer[128] = {0};
-        snprintf(buffer, sizeof(buffer), "mpv_set_property %s failed: %d", property, result);
-        set_last_error(buffer);
+        recordMpvError(session, std::string("mpv_set_property ") + property, result);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
-double getDoubleProperty(mpv_handle* handle, const char* property) {
-    if (handle == nullptr) return 0.0;
+// Polled for the position and duration (failing on every poll for live streams), so neither path
+// allocates or locks: a failure stores the pre-interned kGetPropertyFailedId with the mpv code.
+double getDoubleProperty(MpvSession* session, const char* property) {
+    if (session == nullptr || session->handle == nullptr) return 0.0;
     double value = 0.0;
-    if (mpv_get_property(handle, property, MPV_FORMAT_DOUBLE, &value) < 0) {
-        char buffer[128] = {0};
-        snprintf(buffer, sizeof(buffer), "mpv_get_property %s failed", property);
+    const int result = mpv_get_property(session->handle, property, MPV_FORMAT_DOUBLE, &value);
+    if (result < 0) {
         // Avoid overwriting the actual playback/root-cause error with auxiliary query failures.
-        if (get_last_error().empty()) {
-            set_last_error(buffer);
-        }
+        storeErrorIfClear(session->error, kGetPropertyFailedId, result);
         return 0.0;
     }
-    set_last_error("");
     return value;
 }
 
@@ -342,6 +530,7 @@ bool tryGetDoubleProperty(mpv_handle* handle, const char* property, double* out_
 #else
 struct MpvSession {
     std::string path;
+    ErrorSlot error{0};
     std::vector<std::string> headers;
     bool paused = false;
     bool looping = false;
@@ -358,7 +547,7 @@ struct MpvSession {
 };
 
 bool runtimeLinked() {
-    set_last_error("libmpv.so not packaged; mpv bridge running in stub mode");
+    recordError(nullptr, "libmpv.so not packaged; mpv bridge running in stub mode");
     return false;
 }
 #endif
@@ -367,6 +556,10 @@ inline MpvSession* fromHandle(jlong handle) {
     return reinterpret_cast<MpvSession*>(handle);
 }
 
+void recordError(MpvSession* session, const std::string& message, int64_t code) {
+    recordError(session != nullptr ? session->error : g_process_error, message, code);
+}
+
 void dispatchEvent(JNIEnv* env, const EventCallbackRef& callback, jint type, jlong arg1, jlong arg2, const char* message) {
     if (callback.method == nullptr || callback.callback == nullptr || callback.callback_class == nullptr) {
         return;
@@ -379,7 +572,7 @@ void dispatchEvent(JNIEnv* env, const EventCallbackRef& callback, jint type, jlo
 }
 
 void dispatchError(JNIEnv* env, MpvSession* session, const std::string& message, int64_t code = 0, int64_t reason = 0) {
-    set_last_error(message);
+    recordError(session, message, code);
     if (env == nullptr || session == nullptr) {
         return;
     }
@@ -414,6 +607,18 @@ void observeProperties(mpv_handle* handle) {
         return;
     }
     mpv_observe_property(handle, 0, "paused-for-cache", MPV_FORMAT_FLAG);
+    mpv_observe_property(handle, 0, "time-pos", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(handle, 0, "pause", MPV_FORMAT_FLAG);
+    mpv_observe_property(handle, 0, "speed", MPV_FORMAT_DOUBLE);
+}
+
+// Called by mpv from arbitrary threads whenever the event queue becomes non-empty.
+void signalWakeup(void* ctx) {
+    auto* session = static_cast<MpvSession*>(ctx);
+    const uint64_t one = 1;
+    // A full counter already means "wake up", so a failed write needs no handling.
+    ssize_t written = write(session->wakeup_fd, &one, sizeof(one));
+    (void)written;
 }
 
 void destroyRenderContext(MpvSession* session) {
@@ -444,13 +649,15 @@ void destroyEgl(MpvSession* session) {
     }
 }
 
+// Called from an mpv thread; it must not call back into mpv, only wake the render thread.
 void on_mpv_render_update(void* data) {
     auto* session = static_cast<MpvSession*>(data);
     if (session == nullptr) return;
-    session->render_requested = true;
-    if (session->handle != nullptr) {
-        mpv_wakeup(session->handle);
+    {
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+        session->render_requested = true;
     }
+    session->render_cv.notify_all();
 }
 
 EGLContext createContext(EGLDisplay display, EGLConfig config, int version) {
@@ -471,13 +678,13 @@ bool initEgl(MpvSession* session) {
     if (session->egl_display == EGL_NO_DISPLAY) {
         const std::string message = "eglGetDisplay failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         return false;
     }
     if (!eglInitialize(session->egl_display, nullptr, nullptr)) {
         const std::string message = "eglInitialize failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyEgl(session);
         return false;
     }
@@ -495,7 +702,7 @@ bool initEgl(MpvSession* session) {
     if (!eglChooseConfig(session->egl_display, cfgAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
         const std::string message = "eglChooseConfig failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyEgl(session);
         return false;
     }
@@ -509,7 +716,7 @@ bool initEgl(MpvSession* session) {
     if (session->egl_surface == EGL_NO_SURFACE) {
         const std::string message = "eglCreateWindowSurface failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyEgl(session);
         return false;
     }
@@ -521,7 +728,7 @@ bool initEgl(MpvSession* session) {
     if (session->egl_context == EGL_NO_CONTEXT) {
         const std::string message = "eglCreateContext failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyEgl(session);
         return false;
     }
@@ -529,7 +736,7 @@ bool initEgl(MpvSession* session) {
     if (!eglMakeCurrent(session->egl_display, session->egl_surface, session->egl_surface, session->egl_context)) {
         const std::string message = "eglMakeCurrent failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyEgl(session);
         return false;
     }
@@ -557,16 +764,20 @@ bool ensureRenderContext(MpvSession* session) {
     gl_init_params.get_proc_address_ctx = nullptr;
 
     const char* api_type = MPV_RENDER_API_TYPE_OPENGL;
+    // The render thread only ever waits on its own condition variable and answers every
+    // update callback with mpv_render_context_update(), which is what advanced control asks.
+    int advanced_control = 1;
     mpv_render_param params[] = {
         {MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(api_type)},
         {MPV_RENDER_PARAM_OPENGL_INIT_PARAMS, &gl_init_params},
+        {MPV_RENDER_PARAM_ADVANCED_CONTROL, &advanced_control},
         {MPV_RENDER_PARAM_INVALID, nullptr},
     };
 
     if (mpv_render_context_create(&session->render_context, session->handle, params) < 0) {
         const std::string message = "mpv_render_context_create failed";
         __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", message.c_str());
-        set_last_error(message);
+        recordError(session, message);
         destroyRenderContext(session);
         destroyEgl(session);
         return false;
@@ -589,16 +800,93 @@ bool makeCurrent(MpvSession* session) {
     return eglMakeCurrent(session->egl_display, session->egl_surface, session->egl_surface, session->egl_context);
 }
 
-void renderFrame(MpvSession* session) {
+int64_t monotonicNowNs() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+// Clock samples older than this are not extrapolated further (stalled demuxer, lost
+// property updates); the subtitle then holds on the last known position.
+constexpr int64_t kClockExtrapolateLimitNs = 1000 * 1000000LL;
+
+// Subtitle time for a frame shown at `presentNs` (CLOCK_MONOTONIC): the last time-pos
+// sample advanced by the elapsed wall time at the current speed while playing.
+int64_t subtitlePtsForPresent(MpvSession* session, int64_t presentNs) {
+    std::lock_guard<std::mutex> lock(session->clock_mutex);
+    if (session->clock_time_pos < 0.0) {
+        return -1;
+    }
+    double seconds = session->clock_time_pos;
+    if (!session->clock_paused) {
+        int64_t elapsed = presentNs - session->clock_sampled_ns;
+        if (elapsed < 0) elapsed = 0;
+        if (elapsed > kClockExtrapolateLimitNs) elapsed = kClockExtrapolateLimitNs;
+        seconds += static_cast<double>(elapsed) / 1e9 * session->clock_speed;
+    }
+    return static_cast<int64_t>(seconds * 1000.0);
+}
+
+// Draws the attached GPU subtitle context over the video that mpv just rendered into the
+// default framebuffer. libass_bridge is looked up at runtime, so mpv_bridge keeps working
+// without it.
+AssGpuCompositeFrameFn resolveSubtitleCompositor(MpvSession* session) {
+    static std::mutex resolve_mutex;
+    static AssGpuCompositeFrameFn resolved = nullptr;
+    std::lock_guard<std::mutex> lock(resolve_mutex);
+    if (resolved != nullptr) {
+        return resolved;
+    }
+    // RTLD_NOLOAD: only use the library if the subtitle backend already loaded it.
+    void* library = dlopen(kAssGpuBridgeLibrary, RTLD_NOW | RTLD_NOLOAD);
+    if (library == nullptr) {
+        recordError(session, std::string(kAssGpuBridgeLibrary) + " is not loaded");
+        return nullptr;
+    }
+    resolved = reinterpret_cast<AssGpuCompositeFrameFn>(dlsym(library, kAssGpuCompositeFrameSymbol));
+    if (resolved == nullptr) {
+        recordError(session, std::string("missing symbol ") + kAssGpuCompositeFrameSymbol);
+        dlclose(library);
+    }
+    return resolved;
+}
+
+void compositeSubtitles(MpvSession* session, int64_t presentNs) {
+    std::lock_guard<std::mutex> lock(session->compositor_mutex);
+    if (session->compositor_fn == nullptr || session->compositor_handle == 0) {
+        return;
+    }
+    const int64_t pts = subtitlePtsForPresent(session, presentNs);
+    if (pts < 0) {
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!session->compositor_fn(session->compositor_handle, pts + session->compositor_offset_ms,
+                                session->surface_width, session->surface_height, session->egl_generation)) {
+        recordError(session, "subtitle compositor failed to draw frame");
+    }
+}
+
+// `presentNs` is when the frame is expected on screen (CLOCK_MONOTONIC), used to time the
+// subtitles composited into it.
+void renderFrame(MpvSession* session, bool blockForTargetTime, int64_t presentNs) {
     if (session == nullptr || session->render_context == nullptr) {
         return;
     }
     if (!makeCurrent(session)) {
-        set_last_error("eglMakeCurrent failed before rendering frame");
+        recordError(session, "eglMakeCurrent failed before rendering frame");
         return;
     }
 
-    if (session->surface_width == 0 || session->surface_height == 0) {
+    // The surface can be resized without being replaced.
+    EGLint width = 0;
+    EGLint height = 0;
+    if (eglQuerySurface(session->egl_display, session->egl_surface, EGL_WIDTH, &width) &&
+        eglQuerySurface(session->egl_display, session->egl_surface, EGL_HEIGHT, &height) && width > 0 &&
+        height > 0) {
+        session->surface_width = width;
+        session->surface_height = height;
+    } else if (session->surface_width == 0 || session->surface_height == 0) {
         session->surface_width = ANativeWindow_getWidth(session->native_window);
         session->surface_height = ANativeWindow_getHeight(session->native_window);
     }
@@ -610,9 +898,11 @@ void renderFrame(MpvSession* session) {
         .internal_format = 0
     };
     int flip = 1;
+    int block = blockForTargetTime ? 1 : 0;
     mpv_render_param render_params[] = {
         {MPV_RENDER_PARAM_OPENGL_FBO, &fbo},
         {MPV_RENDER_PARAM_FLIP_Y, &flip},
+        {MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block},
         {MPV_RENDER_PARAM_INVALID, nullptr},
     };
 
@@ -620,19 +910,21 @@ void renderFrame(MpvSession* session) {
     glClearColor(0.f, 0.f, 0.f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT);
     mpv_render_context_render(session->render_context, render_params);
+    compositeSubtitles(session, presentNs);
     eglSwapBuffers(session->egl_display, session->egl_surface);
-    session->render_requested = false;
+    mpv_render_context_report_swap(session->render_context);
 }
 
-void processRenderUpdates(JNIEnv* env, MpvSession* session) {
+// Returns true when mpv has a new frame for the next render.
+bool processRenderUpdates(JNIEnv* env, MpvSession* session) {
     if (session == nullptr) {
-        return;
+        return false;
     }
     if (!session->render_requested.exchange(false)) {
-        return;
+        return false;
     }
     if (session->render_context == nullptr) {
-        return;
+        return false;
     }
 
     const int update_flags = mpv_render_context_update(session->render_context);
@@ -646,12 +938,194 @@ void processRenderUpdates(JNIEnv* env, MpvSession* session) {
         char buffer[128] = {0};
         snprintf(buffer, sizeof(buffer), "mpv_render_context_update failed: %d", update_flags);
         dispatchError(env, session, buffer, update_flags, 0);
+        return false;
+    }
+
+    return (update_flags & MPV_RENDER_UPDATE_FRAME) != 0;
+}
+
+// Choreographer reports vsync on CLOCK_MONOTONIC; mpv's target_time uses mpv_get_time_us(),
+// whose base is private to mpv. Sampling both clocks back to back gives the offset.
+int64_t mpvTimeToMonotonicNs(mpv_handle* handle, int64_t mpvTimeUs) {
+    const int64_t monotonic = monotonicNowNs();
+    const int64_t mpv = mpv_get_time_us(handle) * 1000LL;
+    return mpvTimeUs * 1000LL + (monotonic - mpv);
+}
+
+// Vsync timestamps older than this mean the Choreographer callback stopped (app in the
+// background, surface hidden); mpv then paces frames by itself.
+constexpr int64_t kVsyncStaleNs = 100 * 1000000LL;
+
+// Decides whether the pending frame goes out on this vsync. A frame rendered now reaches
+// the screen on the next vsync; frames whose target lies further out than half a period
+// beyond that wait for a later vsync instead of being shown early.
+bool isFrameDueForVsync(mpv_handle* handle, const mpv_render_frame_info& info, int64_t vsyncNs, int64_t periodNs) {
+    if ((info.flags & MPV_RENDER_FRAME_INFO_REDRAW) != 0 || info.target_time <= 0) {
+        return true;
+    }
+    const int64_t presentNs = vsyncNs + periodNs;
+    return mpvTimeToMonotonicNs(handle, info.target_time) <= presentNs + periodNs / 2;
+}
+
+void attachRenderWindow(JNIEnv* env, MpvSession* session, ANativeWindow* window) {
+    if (session->render_context != nullptr) {
+        makeCurrent(session);
+    }
+    destroyRenderContext(session);
+    destroyEgl(session);
+    if (session->native_window != nullptr) {
+        ANativeWindow_release(session->native_window);
+        session->native_window = nullptr;
+    }
+    session->surface_width = 0;
+    session->surface_height = 0;
+    if (window == nullptr) {
+        return;
+    }
+    session->native_window = window;
+    if (!ensureRenderContext(session)) {
+        dispatchError(env, session, "mpv render context setup failed");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->compositor_mutex);
+        ++session->egl_generation;
+    }
+    // vo=libmpv only initialises while a render context exists, so it is (re)selected here.
+    // Async: a blocking property write from the render thread could wait on the VO, which
+    // in turn waits on this thread.
+    const char* vo = "libmpv";
+    mpv_set_property_async(session->handle, 0, "vo", MPV_FORMAT_STRING, &vo);
+    const char* force_window = "yes";
+    mpv_set_property_async(session->handle, 0, "force-window", MPV_FORMAT_STRING, &force_window);
+}
+
+void renderLoop(MpvSession* session) {
+    // event_callback can be reset by nativeStopEventLoop at any time, so this thread never
+    // calls into Java; failures only land in the session's error slot.
+    JNIEnv* env = nullptr;
+    bool frame_pending = false;
+
+    const auto has_work = [session] {
+        return !session->render_running.load() || session->window_changed || session->vsync_pending ||
+               session->subtitle_redraw || session->render_requested.load();
+    };
+    std::unique_lock<std::mutex> lock(session->render_mutex);
+    while (session->render_running.load()) {
+        if (frame_pending && session->render_context != nullptr) {
+            // A frame held back for a later vsync: should Choreographer stop ticking, wake up once
+            // the last vsync turns stale so the frame goes out on mpv's own timing.
+            const int64_t stale_in_ns = session->vsync_ns + kVsyncStaleNs - monotonicNowNs();
+            session->render_cv.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(stale_in_ns, 0)),
+                                        has_work);
+        } else {
+            // Idle until mpv, vsync, a subtitle change, a window change or stopRenderThread() signals.
+            session->render_cv.wait(lock, has_work);
+        }
+        if (!session->render_running.load()) {
+            break;
+        }
+        const bool window_changed = session->window_changed;
+        ANativeWindow* window = session->pending_window;
+        const uint64_t generation = session->window_generation;
+        session->window_changed = false;
+        session->pending_window = nullptr;
+        const bool vsync_tick = session->vsync_pending;
+        session->vsync_pending = false;
+        const int64_t vsync_ns = session->vsync_ns;
+        const int64_t period_ns = session->vsync_period_ns;
+        const bool subtitle_redraw = session->subtitle_redraw;
+        session->subtitle_redraw = false;
+        lock.unlock();
+
+        if (window_changed) {
+            attachRenderWindow(env, session, window);
+            frame_pending = false;
+            lock.lock();
+            session->applied_window_generation = generation;
+            lock.unlock();
+            session->render_cv.notify_all();
+        }
+
+        if (processRenderUpdates(env, session)) {
+            frame_pending = true;
+        }
+
+        if (frame_pending && session->render_context != nullptr) {
+            const bool vsync_live = period_ns > 0 && monotonicNowNs() - vsync_ns < kVsyncStaleNs;
+            if (!vsync_live || vsync_tick) {
+                mpv_render_frame_info info{};
+                mpv_render_param query = {MPV_RENDER_PARAM_NEXT_FRAME_INFO, &info};
+                if (mpv_render_context_get_info(session->render_context, query) < 0 ||
+                    (info.flags & MPV_RENDER_FRAME_INFO_PRESENT) == 0) {
+                    frame_pending = false;
+                } else if (!vsync_live) {
+                    const int64_t present_ns = info.target_time > 0
+                                                   ? mpvTimeToMonotonicNs(session->handle, info.target_time)
+                                                   : monotonicNowNs();
+                    renderFrame(session, true, present_ns);
+                    frame_pending = false;
+                } else if (isFrameDueForVsync(session->handle, info, vsync_ns, period_ns)) {
+                    renderFrame(session, false, vsync_ns + period_ns);
+                    frame_pending = false;
+                }
+            }
+        } else if (subtitle_redraw && session->render_context != nullptr) {
+            // No new video frame (paused, or between frames): redraw the current one so a
+            // subtitle seek, offset or track change shows up without waiting for playback.
+            renderFrame(session, false, monotonicNowNs());
+        }
+        lock.lock();
+    }
+    lock.unlock();
+
+    attachRenderWindow(env, session, nullptr);
+    {
+        std::lock_guard<std::mutex> guard(session->render_mutex);
+        if (session->pending_window != nullptr) {
+            ANativeWindow_release(session->pending_window);
+            session->pending_window = nullptr;
+        }
+        session->applied_window_generation = session->window_generation;
+    }
+    session->render_cv.notify_all();
+}
+
+void startRenderThread(MpvSession* session) {
+    if (session->render_running.exchange(true)) {
+        return;
+    }
+    session->render_thread = std::thread([session]() { renderLoop(session); });
+}
+
+void stopRenderThread(MpvSession* session) {
+    if (!session->render_running.exchange(false)) {
         return;
     }
+    {
+        // Taking the lock orders the flag change before the loop's next predicate check.
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+    }
+    session->render_cv.notify_all();
+    if (session->render_thread.joinable()) {
+        session->render_thread.join();
+    }
+}
 
-    if (update_flags & MPV_RENDER_UPDATE_FRAME) {
-        renderFrame(session);
+// Hands `window` (already acquired, may be null) to the render thread and waits until the
+// old window is no longer used, so surfaceDestroyed() can return safely.
+void setRenderWindow(MpvSession* session, ANativeWindow* window) {
+    std::unique_lock<std::mutex> lock(session->render_mutex);
+    if (session->pending_window != nullptr) {
+        ANativeWindow_release(session->pending_window);
     }
+    session->pending_window = window;
+    session->window_changed = true;
+    const uint64_t generation = ++session->window_generation;
+    session->render_cv.notify_all();
+    session->render_cv.wait(lock, [session, generation] {
+        return session->applied_window_generation >= generation || !session->render_running.load();
+    });
 }
 
 void markSurfaceChanged(MpvSession* session) {
@@ -669,8 +1143,8 @@ void stopEventThread(JNIEnv* env, MpvSession* session) {
     }
     if (session->running.exchange(false)) {
 #if MPV_PREBUILT_AVAILABLE
-        if (session->handle != nullptr) {
-            mpv_wakeup(session->handle);
+        if (session->wakeup_fd >= 0) {
+            signalWakeup(session);
         }
 #endif
         if (session->event_thread.joinable()) {
@@ -681,161 +1155,543 @@ void stopEventThread(JNIEnv* env, MpvSession* session) {
 }
 
 #if MPV_PREBUILT_AVAILABLE
-void eventLoop(MpvSession* session) {
-    bool did_attach = false;
-    JNIEnv* env = ensureEnv(&did_attach);
-    if (env == nullptr || session == nullptr || session->handle == nullptr) {
-        set_last_error("mpv eventLoop failed to attach JNI environment or session");
-        detachIfNeeded(did_attach);
-        return;
+// Reply ids for scrub seeks; Kotlin allocates its ids upwards from 1 and never reaches these.
+constexpr uint64_t kScrubPreviewReplyId = UINT64_MAX;
+constexpr uint64_t kScrubFinalReplyId = UINT64_MAX - 1;
+// A keyframe seek that never produces PLAYBACK_RESTART (e.g. the file is still opening)
+// must not stall the drag forever.
+constexpr auto kScrubSeekTimeout = std::chrono::milliseconds(750);
+
+bool issueScrubSeekLocked(MpvSession* session, int64_t positionMs, bool exact) {
+    if (session->handle == nullptr) {
+        return false;
+    }
+    char seconds[64] = {0};
+    snprintf(seconds, sizeof(seconds), "%.3f", static_cast<double>(positionMs) / 1000.0);
+    const char* cmd[] = {"seek", seconds, exact ? "absolute+exact" : "absolute+keyframes", nullptr};
+    const int result =
+        mpv_command_async(session->handle, exact ? kScrubFinalReplyId : kScrubPreviewReplyId, cmd);
+    if (result < 0) {
+        recordMpvError(session, "mpv scrub seek", result);
+        return false;
     }
+    if (!exact) {
+        session->scrub.seek_in_flight = true;
+        session->scrub.seek_issued_at = std::chrono::steady_clock::now();
+    }
+    return true;
+}
 
-    while (session->running.load()) {
-        mpv_event* event = mpv_wait_event(session->handle, 0.25);
-        if (event == nullptr || event->event_id == MPV_EVENT_NONE) {
-            continue;
+// The previous preview seek has landed (or failed): send the newest queued target, if any.
+void releaseScrubSeekLocked(MpvSession* session) {
+    ScrubState& scrub = session->scrub;
+    scrub.seek_in_flight = false;
+    if (scrub.active && scrub.has_pending) {
+        scrub.has_pending = false;
+        issueScrubSeekLocked(session, scrub.pending_ms, false);
+    }
+}
+
+void scrubBegin(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    ScrubState& scrub = session->scrub;
+    scrub.active = true;
+    scrub.seek_in_flight = false;
+    scrub.has_pending = false;
+    scrub.coalesced = 0;
+    scrub.final_queued = false;
+    scrub.final_acked = false;
+}
+
+// Latest wins: at most one keyframe seek is in flight, later targets overwrite the queued one.
+bool scrubUpdate(MpvSession* session, int64_t positionMs) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    ScrubState& scrub = session->scrub;
+    if (!scrub.active) {
+        return false;
+    }
+    if (scrub.seek_in_flight) {
+        if (scrub.has_pending) {
+            scrub.coalesced++;
         }
+        scrub.has_pending = true;
+        scrub.pending_ms = positionMs;
+        return true;
+    }
+    return issueScrubSeekLocked(session, positionMs, false);
+}
 
-        switch (event->event_id) {
-            case MPV_EVENT_LOG_MESSAGE: {
-                auto* log = static_cast<mpv_event_log_message*>(event->data);
-                if (log != nullptr) {
-                    const char* prefix = log->prefix == nullptr ? "" : log->prefix;
-                    const char* level = log->level == nullptr ? "" : log->level;
-                    const char* text = log->text == nullptr ? "" : log->text;
-                    __android_log_print(ANDROID_LOG_INFO, kLogTag, "mpv[%s][%s] %s", prefix, level, text);
-                    // Forward to Kotlin logger so it can be written into log.txt.
-                    // Note: do not include newlines; mpv log text usually ends with '\n'.
-                    std::string forwarded = std::string(prefix) + "[" + level + "] " + text;
-                    dispatchEvent(
-                        env,
-                        session->event_callback,
-                        kEventLogMessage,
-                        static_cast<jlong>(mpvLogLevelToInt(level)),
-                        0,
-                        forwarded.c_str()
-                    );
-                }
-                break;
-            }
-            case MPV_EVENT_FILE_LOADED: {
-                dispatchEvent(env, session->event_callback, kEventPrepared, 0, 0, nullptr);
-                break;
-            }
-            case MPV_EVENT_VIDEO_RECONFIG: {
-                int64_t width = 0;
-                int64_t height = 0;
-                mpv_get_property(session->handle, "width", MPV_FORMAT_INT64, &width);
-                mpv_get_property(session->handle, "height", MPV_FORMAT_INT64, &height);
-                session->video_width = static_cast<int>(width);
-                session->video_height = static_cast<int>(height);
-                dispatchEvent(env, session->event_callback, kEventVideoSize, width, height, nullptr);
-                break;
-            }
-            case MPV_EVENT_END_FILE: {
-                auto* endFile = static_cast<mpv_event_end_file*>(event->data);
-                if (endFile != nullptr) {
-                    if (endFile->reason == MPV_END_FILE_REASON_EOF) {
-                        dispatchEvent(env, session->event_callback, kEventCompleted, 0, 0, nullptr);
-                    } else {
-                        const char* errorMsg = mpv_error_string(endFile->error);
-                        dispatchEvent(env, session->event_callback, kEventError, endFile->error, endFile->reason, errorMsg);
-                    }
-                }
-                break;
-            }
-            case MPV_EVENT_PLAYBACK_RESTART: {
-                dispatchEvent(env, session->event_callback, kEventRenderingStart, 0, 0, nullptr);
-                break;
-            }
-            case MPV_EVENT_PROPERTY_CHANGE: {
-                auto* prop = static_cast<mpv_event_property*>(event->data);
-                if (prop == nullptr || prop->name == nullptr) {
-                    break;
-                }
-                if (prop->format == MPV_FORMAT_FLAG && strcmp(prop->name, "paused-for-cache") == 0) {
-                    const bool isCaching = *static_cast<int*>(prop->data) != 0;
-                    dispatchEvent(
-                        env,
-                        session->event_callback,
-                        isCaching ? kEventBufferingStart : kEventBufferingEnd,
-                        0,
-                        0,
-                        nullptr
-                    );
-                    break;
-                }
-                break;
-            }
-            default:
-                break;
+bool scrubEnd(MpvSession* session, int64_t positionMs) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    ScrubState& scrub = session->scrub;
+    if (scrub.has_pending) {
+        scrub.coalesced++;
+    }
+    scrub.active = false;
+    scrub.has_pending = false;
+    scrub.seek_in_flight = false;
+    // mpv drops a queued seek when a newer one arrives, so the exact seek need not wait
+    // for an outstanding keyframe seek.
+    if (!issueScrubSeekLocked(session, positionMs, true)) {
+        scrub.final_queued = false;
+        return false;
+    }
+    scrub.final_queued = true;
+    scrub.final_acked = false;
+    scrub.released_at = std::chrono::steady_clock::now();
+    return true;
+}
+
+void onScrubReply(MpvSession* session, uint64_t requestId, int error) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    ScrubState& scrub = session->scrub;
+    if (requestId == kScrubPreviewReplyId) {
+        if (error < 0 && scrub.seek_in_flight) {
+            releaseScrubSeekLocked(session);
         }
+        return;
     }
+    if (!scrub.final_queued) {
+        return;
+    }
+    if (error < 0) {
+        scrub.final_queued = false;
+        return;
+    }
+    // Restarts seen before this reply belong to preview seeks.
+    scrub.final_acked = true;
+}
+
+// Returns the release-to-frame latency when this restart is the first frame of the final seek.
+bool onScrubPlaybackRestart(MpvSession* session, int64_t* latencyMs, int64_t* coalesced) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    ScrubState& scrub = session->scrub;
+    if (scrub.final_queued && scrub.final_acked) {
+        scrub.final_queued = false;
+        scrub.final_acked = false;
+        *latencyMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - scrub.released_at)
+                         .count();
+        *coalesced = scrub.coalesced;
+        return true;
+    }
+    if (scrub.seek_in_flight) {
+        releaseScrubSeekLocked(session);
+    }
+    return false;
+}
 
-    detachIfNeeded(did_attach);
+void pollScrubTimeout(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    if (session->scrub.seek_in_flight &&
+        std::chrono::steady_clock::now() - session->scrub.seek_issued_at > kScrubSeekTimeout) {
+        releaseScrubSeekLocked(session);
+    }
 }
-#endif
 
-bool registerEventCallback(JNIEnv* env, MpvSession* session, jobject callback) {
-    if (env == nullptr || session == nullptr || callback == nullptr) {
-        set_last_error("registerEventCallback invoked with null argument");
+// Reply ids for frame steps and segment seeks, below the scrub ids.
+constexpr uint64_t kFrameStepReplyId = UINT64_MAX - 2;
+constexpr uint64_t kSegmentSeekReplyId = UINT64_MAX - 3;
+// A step whose frame never shows (end of file, stalled network) must not block later steps.
+constexpr int64_t kFrameStepTimeoutNs = 500'000'000;
+// Time-pos deltas above this are seeks or stalls, not frame intervals.
+constexpr double kMaxFrameInterval = 0.5;
+// A seek landing this close before the segment start still counts as inside it.
+constexpr double kSegmentStartTolerance = 0.05;
+
+bool frameStep(MpvSession* session, bool backward) {
+    if (session->handle == nullptr) {
         return false;
     }
-    stopEventThread(env, session);
-    jobject globalCallback = env->NewGlobalRef(callback);
-    if (globalCallback == nullptr) {
-        set_last_error("Failed to allocate global reference for mpv callback");
+    const int64_t now = monotonicNowNs();
+    if (session->frame_step_in_flight.load() != kFrameStepNone &&
+        now - session->frame_step_issued_ns.load() < kFrameStepTimeoutNs) {
         return false;
     }
-    jclass callbackClass = env->GetObjectClass(callback);
-    if (callbackClass == nullptr) {
-        set_last_error("Failed to resolve callback class for mpv event loop");
-        env->DeleteGlobalRef(globalCallback);
+    {
+        // Stepping means manual control; a running segment would pause under the user.
+        std::lock_guard<std::mutex> lock(session->segment.mutex);
+        session->segment.seeking = false;
+        session->segment.armed = false;
+    }
+    session->frame_step_issued_ns.store(now);
+    session->frame_step_in_flight.store(backward ? kFrameStepBackward : kFrameStepForward);
+    const char* cmd[] = {backward ? "frame-back-step" : "frame-step", nullptr};
+    const int result = mpv_command_async(session->handle, kFrameStepReplyId, cmd);
+    if (result < 0) {
+        session->frame_step_in_flight.store(kFrameStepNone);
+        recordMpvError(session, cmd[0], result);
         return false;
     }
-    jclass globalClass = static_cast<jclass>(env->NewGlobalRef(callbackClass));
-    env->DeleteLocalRef(callbackClass);
-    if (globalClass == nullptr) {
-        set_last_error("Failed to create global class reference for mpv callback");
-        env->DeleteGlobalRef(globalCallback);
+    return true;
+}
+
+bool playSegment(MpvSession* session, int64_t startMs, int64_t endMs) {
+    if (session->handle == nullptr || startMs < 0 || endMs <= startMs) {
+        recordError(session, "playSegment needs 0 <= start < end");
         return false;
     }
-    jmethodID method = env->GetMethodID(globalClass, "onNativeEvent", "(IJJLjava/lang/String;)V");
-    if (method == nullptr) {
-        set_last_error("onNativeEvent signature not found on mpv callback");
-        env->DeleteGlobalRef(globalCallback);
-        env->DeleteGlobalRef(globalClass);
+    std::lock_guard<std::mutex> lock(session->segment.mutex);
+    SegmentState& segment = session->segment;
+    char seconds[64] = {0};
+    snprintf(seconds, sizeof(seconds), "%.3f", static_cast<double>(startMs) / 1000.0);
+    const char* seek[] = {"seek", seconds, "absolute+exact", nullptr};
+    const int result = mpv_command_async(session->handle, kSegmentSeekReplyId, seek);
+    if (result < 0) {
+        recordMpvError(session, "mpv segment seek", result);
         return false;
     }
-
-    session->event_callback.callback = globalCallback;
-    session->event_callback.callback_class = globalClass;
-    session->event_callback.method = method;
-    set_last_error("");
+    const char* unpause = "no";
+    mpv_set_property_async(session->handle, 0, "pause", MPV_FORMAT_STRING, &unpause);
+    segment.seeking = true;
+    segment.seek_acked = false;
+    segment.armed = false;
+    segment.start = static_cast<double>(startMs) / 1000.0;
+    segment.end = static_cast<double>(endMs) / 1000.0;
+    segment.last_pos = -1.0;
+    segment.frame_interval = 0.0;
     return true;
 }
 
-#if MPV_PREBUILT_AVAILABLE
-std::vector<std::string> fetchTrackList(MpvSession* session) {
-    std::vector<std::string> result;
-    if (session == nullptr || session->handle == nullptr) {
-        return result;
-    }
-    mpv_node root{};
-    if (mpv_get_property(session->handle, "track-list", MPV_FORMAT_NODE, &root) < 0) {
-        return result;
+void cancelSegment(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(session->segment.mutex);
+    session->segment.seeking = false;
+    session->segment.armed = false;
+}
+
+void onSegmentSeekReply(MpvSession* session, int error) {
+    std::lock_guard<std::mutex> lock(session->segment.mutex);
+    if (!session->segment.seeking) {
+        return;
     }
-    if (root.format != MPV_FORMAT_NODE_ARRAY || root.u.list == nullptr) {
-        mpv_free_node_contents(&root);
-        return result;
+    if (error < 0) {
+        session->segment.seeking = false;
+        return;
     }
-    auto* list = root.u.list;
-    for (int i = 0; i < list->num; i++) {
-        mpv_node* track = &list->values[i];
-        if (track->format != MPV_FORMAT_NODE_MAP || track->u.list == nullptr) {
-            continue;
+    // Restarts seen before this reply belong to earlier seeks.
+    session->segment.seek_acked = true;
+}
+
+// Arms the segment on the restart of its own seek. Returns true with `positionMs` set when a
+// later restart (the user seeking) left the segment, which cancels it.
+bool onSegmentPlaybackRestart(MpvSession* session, int64_t* positionMs) {
+    std::lock_guard<std::mutex> lock(session->segment.mutex);
+    SegmentState& segment = session->segment;
+    if (segment.seeking) {
+        if (segment.seek_acked) {
+            segment.seeking = false;
+            segment.armed = true;
         }
-        int id = -1;
+        return false;
+    }
+    if (!segment.armed) {
+        return false;
+    }
+    double pos = 0.0;
+    if (mpv_get_property(session->handle, "time-pos", MPV_FORMAT_DOUBLE, &pos) < 0) {
+        return false;
+    }
+    segment.last_pos = -1.0;
+    if (pos >= segment.start - kSegmentStartTolerance && pos < segment.end) {
+        return false;
+    }
+    segment.armed = false;
+    *positionMs = static_cast<int64_t>(pos * 1000.0);
+    return true;
+}
+
+// Pauses before the first frame at or past `end`, predicted from the spacing of the last
+// two frames. Returns true with `positionMs` set when the segment ended.
+bool onSegmentTimePos(MpvSession* session, double pos, int64_t* positionMs) {
+    std::lock_guard<std::mutex> lock(session->segment.mutex);
+    SegmentState& segment = session->segment;
+    if (!segment.armed) {
+        return false;
+    }
+    const double delta = pos - segment.last_pos;
+    if (segment.last_pos >= 0.0 && delta > 0.0 && delta < kMaxFrameInterval) {
+        segment.frame_interval = delta;
+    }
+    segment.last_pos = pos;
+    if (pos + segment.frame_interval < segment.end) {
+        return false;
+    }
+    const char* pause = "yes";
+    mpv_set_property_async(session->handle, 0, "pause", MPV_FORMAT_STRING, &pause);
+    segment.armed = false;
+    *positionMs = static_cast<int64_t>(pos * 1000.0);
+    return true;
+}
+
+// Keeps the playback clock used to time composited subtitles. Returns true when `prop` was
+// one of the clock properties.
+bool updatePlaybackClock(MpvSession* session, const mpv_event_property* prop) {
+    const bool time_pos = strcmp(prop->name, "time-pos") == 0;
+    const bool pause = !time_pos && strcmp(prop->name, "pause") == 0;
+    const bool speed = !time_pos && !pause && strcmp(prop->name, "speed") == 0;
+    if (!time_pos && !pause && !speed) {
+        return false;
+    }
+    const int64_t now = monotonicNowNs();
+    std::lock_guard<std::mutex> lock(session->clock_mutex);
+    // Re-anchor first so the time spent at the old speed/pause state is not lost.
+    if (session->clock_time_pos >= 0.0 && !session->clock_paused && !time_pos) {
+        const int64_t elapsed = std::min(now - session->clock_sampled_ns, kClockExtrapolateLimitNs);
+        session->clock_time_pos += static_cast<double>(elapsed) / 1e9 * session->clock_speed;
+    }
+    session->clock_sampled_ns = now;
+    if (time_pos) {
+        session->clock_time_pos =
+            prop->format == MPV_FORMAT_DOUBLE ? *static_cast<double*>(prop->data) : -1.0;
+    } else if (pause && prop->format == MPV_FORMAT_FLAG) {
+        session->clock_paused = *static_cast<int*>(prop->data) != 0;
+    } else if (speed && prop->format == MPV_FORMAT_DOUBLE) {
+        session->clock_speed = *static_cast<double*>(prop->data);
+    }
+    return true;
+}
+
+void handleEvent(JNIEnv* env, MpvSession* session, mpv_event* event) {
+    switch (event->event_id) {
+        case MPV_EVENT_LOG_MESSAGE: {
+            auto* log = static_cast<mpv_event_log_message*>(event->data);
+            if (log != nullptr) {
+                const char* prefix = log->prefix == nullptr ? "" : log->prefix;
+                const char* level = log->level == nullptr ? "" : log->level;
+                const char* text = log->text == nullptr ? "" : log->text;
+                __android_log_print(ANDROID_LOG_INFO, kLogTag, "mpv[%s][%s] %s", prefix, level, text);
+                // Forward to Kotlin logger so it can be written into log.txt.
+                // Note: do not include newlines; mpv log text usually ends with '\n'.
+                std::string forwarded = std::string(prefix) + "[" + level + "] " + text;
+                dispatchEvent(
+                    env,
+                    session->event_callback,
+                    kEventLogMessage,
+                    static_cast<jlong>(mpvLogLevelToInt(level)),
+                    0,
+                    forwarded.c_str()
+                );
+            }
+            break;
+        }
+        case MPV_EVENT_FILE_LOADED: {
+            dispatchEvent(env, session->event_callback, kEventPrepared, 0, 0, nullptr);
+            break;
+        }
+        case MPV_EVENT_VIDEO_RECONFIG: {
+            int64_t width = 0;
+            int64_t height = 0;
+            mpv_get_property(session->handle, "width", MPV_FORMAT_INT64, &width);
+            mpv_get_property(session->handle, "height", MPV_FORMAT_INT64, &height);
+            session->video_width = static_cast<int>(width);
+            session->video_height = static_cast<int>(height);
+            dispatchEvent(env, session->event_callback, kEventVideoSize, width, height, nullptr);
+            break;
+        }
+        case MPV_EVENT_END_FILE: {
+            cancelSegment(session);
+            session->frame_step_in_flight.store(kFrameStepNone);
+            auto* endFile = static_cast<mpv_event_end_file*>(event->data);
+            if (endFile != nullptr) {
+                if (endFile->reason == MPV_END_FILE_REASON_EOF) {
+                    dispatchEvent(env, session->event_callback, kEventCompleted, 0, 0, nullptr);
+                } else {
+                    const char* errorMsg = mpv_error_string(endFile->error);
+                    dispatchEvent(env, session->event_callback, kEventError, endFile->error, endFile->reason, errorMsg);
+                }
+            }
+            break;
+        }
+        case MPV_EVENT_COMMAND_REPLY:
+        case MPV_EVENT_SET_PROPERTY_REPLY: {
+            if (event->reply_userdata == kScrubPreviewReplyId || event->reply_userdata == kScrubFinalReplyId) {
+                onScrubReply(session, event->reply_userdata, event->error);
+                break;
+            }
+            if (event->reply_userdata == kFrameStepReplyId) {
+                if (event->error < 0) {
+                    session->frame_step_in_flight.store(kFrameStepNone);
+                }
+                break;
+            }
+            if (event->reply_userdata == kSegmentSeekReplyId) {
+                onSegmentSeekReply(session, event->error);
+                break;
+            }
+            if (event->reply_userdata == 0) {
+                break;
+            }
+            dispatchEvent(
+                env,
+                session->event_callback,
+                event->event_id == MPV_EVENT_COMMAND_REPLY ? kEventCommandReply : kEventSetPropertyReply,
+                static_cast<jlong>(event->reply_userdata),
+                event->error,
+                event->error < 0 ? mpv_error_string(event->error) : nullptr
+            );
+            break;
+        }
+        case MPV_EVENT_PLAYBACK_RESTART: {
+            // A backward frame step seeks; its restart leaves the player paused, so it must not
+            // look like playback (re)starting to Kotlin.
+            int backwardStep = kFrameStepBackward;
+            if (!session->frame_step_in_flight.compare_exchange_strong(backwardStep, kFrameStepNone)) {
+                dispatchEvent(env, session->event_callback, kEventRenderingStart, 0, 0, nullptr);
+            }
+            int64_t segmentPositionMs = 0;
+            if (onSegmentPlaybackRestart(session, &segmentPositionMs)) {
+                dispatchEvent(env, session->event_callback, kEventSegmentEnd, segmentPositionMs, 0, nullptr);
+            }
+            int64_t latencyMs = 0;
+            int64_t coalesced = 0;
+            if (onScrubPlaybackRestart(session, &latencyMs, &coalesced)) {
+                dispatchEvent(env, session->event_callback, kEventScrubSettled, latencyMs, coalesced, nullptr);
+            }
+            break;
+        }
+        case MPV_EVENT_PROPERTY_CHANGE: {
+            auto* prop = static_cast<mpv_event_property*>(event->data);
+            if (prop == nullptr || prop->name == nullptr) {
+                break;
+            }
+            if (prop->format == MPV_FORMAT_DOUBLE && strcmp(prop->name, "time-pos") == 0) {
+                int forwardStep = kFrameStepForward;
+                session->frame_step_in_flight.compare_exchange_strong(forwardStep, kFrameStepNone);
+                int64_t segmentPositionMs = 0;
+                if (onSegmentTimePos(session, *static_cast<double*>(prop->data), &segmentPositionMs)) {
+                    dispatchEvent(env, session->event_callback, kEventSegmentEnd, segmentPositionMs, 1, nullptr);
+                }
+            }
+            if (updatePlaybackClock(session, prop)) {
+                break;
+            }
+            if (prop->format == MPV_FORMAT_FLAG && strcmp(prop->name, "paused-for-cache") == 0) {
+                const bool isCaching = *static_cast<int*>(prop->data) != 0;
+                dispatchEvent(
+                    env,
+                    session->event_callback,
+                    isCaching ? kEventBufferingStart : kEventBufferingEnd,
+                    0,
+                    0,
+                    nullptr
+                );
+                break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Milliseconds until an in-flight scrub seek times out, or -1 when none is pending.
+int scrubTimeoutRemainingMs(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(session->scrub.mutex);
+    if (!session->scrub.seek_in_flight) {
+        return -1;
+    }
+    const auto remaining =
+        kScrubSeekTimeout - (std::chrono::steady_clock::now() - session->scrub.seek_issued_at);
+    const auto remainingMs = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    return remainingMs < 0 ? 0 : static_cast<int>(remainingMs);
+}
+
+// Blocks on wakeup_fd, which mpv's wakeup callback and the bridge itself (stopEventThread)
+// signal, so an idle session does not wake up at all and shutdown is immediate.
+void eventLoop(MpvSession* session) {
+    bool did_attach = false;
+    JNIEnv* env = ensureEnv(&did_attach);
+    if (env == nullptr || session == nullptr || session->handle == nullptr || session->wakeup_fd < 0) {
+        recordError(session, "mpv eventLoop failed to attach JNI environment or session");
+        detachIfNeeded(did_attach);
+        return;
+    }
+
+    while (session->running.load()) {
+        // Drain before blocking: anything queued after this point signals wakeup_fd again.
+        while (session->running.load()) {
+            mpv_event* event = mpv_wait_event(session->handle, 0);
+            if (event == nullptr || event->event_id == MPV_EVENT_NONE) {
+                break;
+            }
+            handleEvent(env, session, event);
+        }
+        pollScrubTimeout(session);
+        if (!session->running.load()) {
+            break;
+        }
+
+        pollfd wakeup{session->wakeup_fd, POLLIN, 0};
+        if (poll(&wakeup, 1, scrubTimeoutRemainingMs(session)) > 0) {
+            uint64_t count = 0;
+            while (read(session->wakeup_fd, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count))) {
+            }
+        }
+    }
+
+    detachIfNeeded(did_attach);
+}
+#endif
+
+bool registerEventCallback(JNIEnv* env, MpvSession* session, jobject callback) {
+    if (env == nullptr || session == nullptr || callback == nullptr) {
+        recordError(session, "registerEventCallback invoked with null argument");
+        return false;
+    }
+    stopEventThread(env, session);
+    jobject globalCallback = env->NewGlobalRef(callback);
+    if (globalCallback == nullptr) {
+        recordError(session, "Failed to allocate global reference for mpv callback");
+        return false;
+    }
+    jclass callbackClass = env->GetObjectClass(callback);
+    if (callbackClass == nullptr) {
+        recordError(session, "Failed to resolve callback class for mpv event loop");
+        env->DeleteGlobalRef(globalCallback);
+        return false;
+    }
+    jclass globalClass = static_cast<jclass>(env->NewGlobalRef(callbackClass));
+    env->DeleteLocalRef(callbackClass);
+    if (globalClass == nullptr) {
+        recordError(session, "Failed to create global class reference for mpv callback");
+        env->DeleteGlobalRef(globalCallback);
+        return false;
+    }
+    jmethodID method = env->GetMethodID(globalClass, "onNativeEvent", "(IJJLjava/lang/String;)V");
+    if (method == nullptr) {
+        recordError(session, "onNativeEvent signature not found on mpv callback");
+        env->DeleteGlobalRef(globalCallback);
+        env->DeleteGlobalRef(globalClass);
+        return false;
+    }
+
+    session->event_callback.callback = globalCallback;
+    session->event_callback.callback_class = globalClass;
+    session->event_callback.method = method;
+    return true;
+}
+
+#if MPV_PREBUILT_AVAILABLE
+std::vector<std::string> fetchTrackList(MpvSession* session) {
+    std::vector<std::string> result;
+    if (session == nullptr || session->handle == nullptr) {
+        return result;
+    }
+    mpv_node root{};
+    if (mpv_get_property(session->handle, "track-list", MPV_FORMAT_NODE, &root) < 0) {
+        return result;
+    }
+    if (root.format != MPV_FORMAT_NODE_ARRAY || root.u.list == nullptr) {
+        mpv_free_node_contents(&root);
+        return result;
+    }
+    auto* list = root.u.list;
+    for (int i = 0; i < list->num; i++) {
+        mpv_node* track = &list->values[i];
+        if (track->format != MPV_FORMAT_NODE_MAP || track->u.list == nullptr) {
+            continue;
+        }
+        int id = -1;
         std::string type;
         std::string title;
         bool selected = false;
@@ -935,26 +1791,20 @@ bool addExternalTrack(MpvSession* session, jint trackType, const std::string& pa
 	        const char* cmd[] = {"audio-add", path.c_str(), "select", nullptr};
 	        const int result = mpv_command(session->handle, cmd);
 	        if (result < 0) {
-	            const std::string message =
-	                "mpv audio-add failed: " + std::to_string(result) + " (" + mpv_error_string(result) +
-	                ") path=" + path;
-	            set_last_error(message);
+	            __android_log_print(ANDROID_LOG_WARN, kLogTag, "mpv audio-add failed: %d path=%s", result, path.c_str());
+	            recordMpvError(session, "mpv audio-add", result);
 	            return false;
 	        }
-	        set_last_error("");
 	        return true;
 	    }
 	    if (trackType == kTrackSubtitle) {
 	        const char* cmd[] = {"sub-add", path.c_str(), "select", nullptr};
 	        const int result = mpv_command(session->handle, cmd);
 	        if (result < 0) {
-	            const std::string message =
-	                "mpv sub-add failed: " + std::to_string(result) + " (" + mpv_error_string(result) +
-	                ") path=" + path;
-	            set_last_error(message);
+	            __android_log_print(ANDROID_LOG_WARN, kLogTag, "mpv sub-add failed: %d path=%s", result, path.c_str());
+	            recordMpvError(session, "mpv sub-add", result);
 	            return false;
 	        }
-	        set_last_error("");
 	        return true;
 	    }
     return false;
@@ -967,13 +1817,11 @@ bool addShader(MpvSession* session, const std::string& path) {
     const char* cmd[] = {"change-list", "glsl-shaders", "append", path.c_str(), nullptr};
     const int result = mpv_command(session->handle, cmd);
     if (result < 0) {
-        const std::string message =
-            "mpv glsl-shaders append failed: " + std::to_string(result) + " (" + mpv_error_string(result) +
-            ") path=" + path;
-        set_last_error(message);
+        __android_log_print(ANDROID_LOG_WARN, kLogTag, "mpv glsl-shaders append failed: %d path=%s", result,
+                            path.c_str());
+        recordMpvError(session, "mpv glsl-shaders append", result);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
@@ -984,12 +1832,9 @@ bool setShaders(MpvSession* session, const std::string& listValue) {
     const char* cmd[] = {"change-list", "glsl-shaders", "set", listValue.c_str(), nullptr};
     const int result = mpv_command(session->handle, cmd);
     if (result < 0) {
-        const std::string message =
-            "mpv glsl-shaders set failed: " + std::to_string(result) + " (" + mpv_error_string(result) + ")";
-        set_last_error(message);
+        recordMpvError(session, "mpv glsl-shaders set", result);
         return false;
     }
-    set_last_error("");
     return true;
 }
 
@@ -1000,13 +1845,69 @@ bool clearShaders(MpvSession* session) {
     const char* cmd[] = {"change-list", "glsl-shaders", "clr", "", nullptr};
     const int result = mpv_command(session->handle, cmd);
     if (result < 0) {
-        const std::string message =
-            "mpv glsl-shaders clr failed: " + std::to_string(result) + " (" + mpv_error_string(result) +
-            ")";
-        set_last_error(message);
+        recordMpvError(session, "mpv glsl-shaders clr", result);
+        return false;
+    }
+    return true;
+}
+
+// Queues a command on the mpv core. `requestId` is allocated by Kotlin (so the reply
+// callback can be registered before the request is issued) and comes back as arg1 of
+// kEventCommandReply; 0 means nobody waits for the reply.
+bool commandAsync(MpvSession* session, uint64_t requestId, const std::vector<std::string>& args) {
+    if (session == nullptr || session->handle == nullptr || args.empty()) {
+        recordError(session, "commandAsync invoked without mpv handle or arguments");
+        return false;
+    }
+    std::vector<const char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+    const int result = mpv_command_async(session->handle, requestId, argv.data());
+    if (result < 0) {
+        recordMpvError(session, "mpv_command_async " + args.front(), result);
+        return false;
+    }
+    return true;
+}
+
+bool setPropertyAsync(MpvSession* session, uint64_t requestId, const char* property, const char* value) {
+    if (session == nullptr || session->handle == nullptr || property == nullptr || value == nullptr) {
+        recordError(session, "setPropertyAsync invoked without mpv handle, property or value");
+        return false;
+    }
+    // mpv copies the value before returning, so pointing at the caller's buffer is fine.
+    const int result = mpv_set_property_async(session->handle, requestId, property, MPV_FORMAT_STRING, &value);
+    if (result < 0) {
+        recordMpvError(session, std::string("mpv_set_property_async ") + property, result);
+        return false;
+    }
+    return true;
+}
+
+// Same node layout as applyHttpHeaders(), but queued behind any request issued before it.
+bool applyHttpHeadersAsync(MpvSession* session, const std::vector<std::string>& headers) {
+    std::vector<mpv_node> nodes(headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        nodes[i].format = MPV_FORMAT_STRING;
+        nodes[i].u.string = const_cast<char*>(headers[i].c_str());
+    }
+    mpv_node_list list{};
+    list.num = static_cast<int>(headers.size());
+    list.values = nodes.empty() ? nullptr : nodes.data();
+    mpv_node root{};
+    root.format = MPV_FORMAT_NODE_ARRAY;
+    root.u.list = &list;
+    const int result = mpv_set_property_async(session->handle, 0, "http-header-fields", MPV_FORMAT_NODE, &root);
+    if (result < 0) {
+        char buffer[128] = {0};
+        snprintf(buffer, sizeof(buffer), "mpv_set_property_async http-header-fields failed: %d", result);
+        __android_log_print(ANDROID_LOG_WARN, kLogTag, "%s", buffer);
+        recordMpvError(session, "mpv_set_property_async http-header-fields", result);
         return false;
     }
-    set_last_error("");
     return true;
 }
 #else
@@ -1038,8 +1939,341 @@ bool clearShaders(MpvSession*) {
     return true;
 }
 
+bool commandAsync(MpvSession* session, uint64_t, const std::vector<std::string>&) {
+    recordError(session, "libmpv.so not linked; async commands are unavailable");
+    return false;
+}
+
+bool setPropertyAsync(MpvSession* session, uint64_t, const char*, const char*) {
+    recordError(session, "libmpv.so not linked; async properties are unavailable");
+    return false;
+}
+
 void markSurfaceChanged(MpvSession*) {}
 #endif
+
+// Process-wide session lifecycle counters, read by nativeLifecycleMetrics().
+struct LifecycleMetrics {
+    std::atomic<int64_t> sessions_created{0};
+    std::atomic<int64_t> handles_reused{0};
+    std::atomic<int64_t> handles_recycled{0};
+    std::atomic<int64_t> sessions_reaped{0};
+    std::atomic<int64_t> last_destroy_call_us{0};
+    std::atomic<int64_t> last_teardown_ms{0};
+    std::atomic<int64_t> max_teardown_ms{0};
+    std::atomic<int64_t> total_teardown_ms{0};
+};
+LifecycleMetrics g_lifecycle;
+// Keep in sync with MpvNativeBridge.LifecycleMetrics.
+constexpr jsize kLifecycleMetricCount = 8;
+
+#if MPV_PREBUILT_AVAILABLE
+// Initialized handles parked for the next session; one covers an episode switch.
+constexpr size_t kMaxPooledHandles = 1;
+constexpr auto kRecycleIdleTimeout = std::chrono::seconds(3);
+std::mutex g_pool_mutex;
+std::vector<mpv_handle*> g_handle_pool;
+
+// Runtime state a session may have changed, put back to what createHandle() leaves. Track
+// selections and per-file options reset with the next loadfile.
+constexpr const char* kRecycleResetOptions[][2] = {
+    {"vo", "null"},
+    {"force-window", "no"},
+    {"wid", "-1"},
+    {"pause", "yes"},
+    {"hwdec", "mediacodec,mediacodec-copy"},
+    {"ao", "audiotrack,opensles"},
+    {"speed", "1"},
+    {"volume", "100"},
+    {"mute", "no"},
+    {"loop-file", "no"},
+    {"ab-loop-a", "no"},
+    {"ab-loop-b", "no"},
+    {"glsl-shaders", ""},
+    {"http-header-fields", ""},
+    {"user-agent", "libmpv"},
+    {"force-seekable", "no"},
+    {"video-sync", "audio"},
+    {"msg-level", ""},
+    {"demuxer-lavf-o", ""},
+    {"android-surface-size", ""},
+    // Arbiter budgets (mpv defaults).
+    {"demuxer-max-bytes", "150MiB"},
+    {"demuxer-max-back-bytes", "50MiB"},
+    {"demuxer-readahead-secs", "1"},
+    {"vd-lavc-threads", "0"},
+    {"vd-lavc-fast", "no"},
+    {"vd-lavc-skiploopfilter", "default"},
+    {"framedrop", "vo"},
+    {"sub-delay", "0"},
+};
+
+// Subtitle options MpvNativeBridge sets per file. Their defaults differ between libmpv
+// releases, so they are read from the first fresh handle rather than spelled out above.
+constexpr const char* kRecycleSnapshotOptions[] = {
+    "sub-font",
+    "sub-fonts-dir",
+    "sub-font-provider",
+    "sub-font-size",
+    "sub-scale",
+    "sub-pos",
+    "sub-visibility",
+};
+std::once_flag g_recycle_defaults_once;
+std::vector<std::pair<const char*, std::string>> g_recycle_defaults;
+
+// Called with a handle straight from createHandle(), before any session changed it.
+void captureRecycleDefaults(mpv_handle* handle) {
+    std::call_once(g_recycle_defaults_once, [handle] {
+        for (const char* name : kRecycleSnapshotOptions) {
+            char* value = mpv_get_property_string(handle, name);
+            if (value != nullptr) {
+                g_recycle_defaults.emplace_back(name, value);
+                mpv_free(value);
+            }
+        }
+    });
+}
+
+mpv_handle* takePooledHandle() {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    if (g_handle_pool.empty()) {
+        return nullptr;
+    }
+    mpv_handle* handle = g_handle_pool.back();
+    g_handle_pool.pop_back();
+    return handle;
+}
+
+bool poolHasRoom() {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    return g_handle_pool.size() < kMaxPooledHandles;
+}
+
+bool isIdleActive(mpv_handle* handle) {
+    int idle = 0;
+    return mpv_get_property(handle, "idle-active", MPV_FORMAT_FLAG, &idle) >= 0 && idle != 0;
+}
+
+// Stops playback and clears session state while keeping the initialized core. Returns false
+// when the core did not reach idle in time; the caller then destroys it instead.
+bool resetHandleForReuse(mpv_handle* handle) {
+    mpv_set_wakeup_callback(handle, nullptr, nullptr);
+    mpv_unobserve_property(handle, 0);
+    mpv_request_log_messages(handle, "no");
+    // With idle=once the core would quit as soon as the current file is stopped.
+    mpv_set_property_string(handle, "idle", "yes");
+    const char* stop[] = {"stop", nullptr};
+    if (mpv_command(handle, stop) < 0) {
+        return false;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + kRecycleIdleTimeout;
+    bool idle = isIdleActive(handle);
+    while (!idle && std::chrono::steady_clock::now() < deadline) {
+        const mpv_event* event = mpv_wait_event(handle, 0.1);
+        if (event->event_id == MPV_EVENT_SHUTDOWN) {
+            return false;
+        }
+        idle = event->event_id == MPV_EVENT_IDLE || isIdleActive(handle);
+    }
+    if (!idle) {
+        return false;
+    }
+    for (const auto& option : kRecycleResetOptions) {
+        mpv_set_property_string(handle, option[0], option[1]);
+    }
+    for (const auto& option : g_recycle_defaults) {
+        mpv_set_property_string(handle, option.first, option.second.c_str());
+    }
+    // Replies and property changes left over from the old session.
+    while (mpv_wait_event(handle, 0)->event_id != MPV_EVENT_NONE) {
+    }
+    return true;
+}
+
+struct ReapRequest {
+    MpvSession* session = nullptr;
+    bool recycle = false;
+    std::chrono::steady_clock::time_point queued_at;
+};
+
+std::mutex g_reaper_mutex;
+std::condition_variable g_reaper_cv;
+std::deque<ReapRequest> g_reaper_queue;
+bool g_reaper_started = false;
+
+void reapSession(const ReapRequest& request) {
+    MpvSession* session = request.session;
+    // The render context has to be gone before the handle is terminated or reset.
+    stopRenderThread(session);
+    if (session->native_window != nullptr) {
+        ANativeWindow_release(session->native_window);
+        session->native_window = nullptr;
+    }
+    mpv_handle* handle = session->handle;
+    session->handle = nullptr;
+    bool pooled = false;
+    if (handle != nullptr && request.recycle && poolHasRoom() && resetHandleForReuse(handle)) {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        if (g_handle_pool.size() < kMaxPooledHandles) {
+            g_handle_pool.push_back(handle);
+            pooled = true;
+        }
+    }
+    if (handle != nullptr && !pooled) {
+        // Can block for seconds while network streams close.
+        mpv_terminate_destroy(handle);
+    }
+    // Either path above guarantees the wakeup callback no longer runs.
+    if (session->wakeup_fd >= 0) {
+        close(session->wakeup_fd);
+    }
+    delete session;
+
+    const int64_t teardown_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    std::chrono::steady_clock::now() - request.queued_at)
+                                    .count();
+    if (pooled) {
+        g_lifecycle.handles_recycled.fetch_add(1);
+    }
+    g_lifecycle.sessions_reaped.fetch_add(1);
+    g_lifecycle.last_teardown_ms.store(teardown_ms);
+    g_lifecycle.total_teardown_ms.fetch_add(teardown_ms);
+    int64_t max = g_lifecycle.max_teardown_ms.load();
+    while (teardown_ms > max && !g_lifecycle.max_teardown_ms.compare_exchange_weak(max, teardown_ms)) {
+    }
+}
+
+void reaperLoop() {
+    std::unique_lock<std::mutex> lock(g_reaper_mutex);
+    for (;;) {
+        g_reaper_cv.wait(lock, [] { return !g_reaper_queue.empty(); });
+        const ReapRequest request = g_reaper_queue.front();
+        g_reaper_queue.pop_front();
+        lock.unlock();
+        reapSession(request);
+        lock.lock();
+    }
+}
+
+// Hands the session to the process-wide reaper thread, which owns it from here on.
+void queueForReaping(MpvSession* session, bool recycle) {
+    {
+        std::lock_guard<std::mutex> lock(g_reaper_mutex);
+        if (!g_reaper_started) {
+            std::thread(reaperLoop).detach();
+            g_reaper_started = true;
+        }
+        g_reaper_queue.push_back({session, recycle, std::chrono::steady_clock::now()});
+    }
+    g_reaper_cv.notify_one();
+}
+
+// Session arbiter: concurrent sessions (a PiP preview of the next episode, two encodes side
+// by side) share one device, so decoder slots, demuxer memory and decode threads are handed
+// out here rather than each session assuming it owns everything. Background sessions are
+// downgraded so the foreground one keeps its frame rate.
+std::mutex g_sessions_mutex;
+std::vector<MpvSession*> g_sessions;
+// Concurrent MediaCodec video decoders are scarce and device specific; two covers PiP and
+// comparison on any device that supports multiple instances at all.
+constexpr int kMaxHwdecSessions = 2;
+constexpr int64_t kBackgroundDemuxerMaxBytes = 8LL << 20;
+constexpr int kBackgroundDecoderThreads = 2;
+
+ResourceBudget backgroundBudget(const ResourceBudget& foreground) {
+    ResourceBudget budget;
+    budget.demuxer_max_bytes = std::min(foreground.demuxer_max_bytes, kBackgroundDemuxerMaxBytes);
+    budget.demuxer_max_back_bytes = 0;
+    budget.decoder_threads = kBackgroundDecoderThreads;
+    budget.hwdec = false;
+    return budget;
+}
+
+void setPropertyAsyncString(mpv_handle* handle, const char* name, const std::string& value) {
+    const char* data = value.c_str();
+    mpv_set_property_async(handle, 0, name, MPV_FORMAT_STRING, &data);
+}
+
+// Pushes the session's effective budget to mpv. Skips unchanged state: a hwdec change
+// reinitializes the decoder. Decoder thread changes take effect on the next decoder init.
+void applyBudgetLocked(MpvSession* session, bool hwdecGranted) {
+    if (session->handle == nullptr) {
+        return;
+    }
+    const bool background = session->role == kSessionBackground;
+    if (hwdecGranted != session->hwdec_granted || session->applied_role < 0) {
+        setPropertyAsyncString(session->handle, "hwdec", hwdecGranted ? session->preferred_hwdec : "no");
+        session->hwdec_granted = hwdecGranted;
+    }
+    if (session->applied_role == session->role) {
+        return;
+    }
+    const ResourceBudget budget = background ? backgroundBudget(session->budget) : session->budget;
+    setPropertyAsyncString(session->handle, "demuxer-max-bytes", std::to_string(budget.demuxer_max_bytes));
+    setPropertyAsyncString(session->handle, "demuxer-max-back-bytes", std::to_string(budget.demuxer_max_back_bytes));
+    setPropertyAsyncString(session->handle, "vd-lavc-threads", std::to_string(budget.decoder_threads));
+    // Cheaper software decoding that may drop frames, and a short readahead so a paused
+    // background session stops pulling data once its small cache is full.
+    setPropertyAsyncString(session->handle, "demuxer-readahead-secs", background ? "0.5" : "1");
+    setPropertyAsyncString(session->handle, "vd-lavc-fast", background ? "yes" : "no");
+    setPropertyAsyncString(session->handle, "vd-lavc-skiploopfilter", background ? "nonref" : "default");
+    setPropertyAsyncString(session->handle, "framedrop", background ? "decoder+vo" : "vo");
+    session->applied_role = session->role;
+}
+
+// Hardware decoder slots go to foreground sessions in creation order.
+void rebalanceSessionsLocked() {
+    int hwdecSlots = kMaxHwdecSessions;
+    for (MpvSession* session : g_sessions) {
+        const bool wantsHwdec = session->role == kSessionForeground && session->budget.hwdec &&
+                                session->preferred_hwdec != "no";
+        const bool granted = wantsHwdec && hwdecSlots > 0;
+        if (granted) {
+            hwdecSlots--;
+        }
+        applyBudgetLocked(session, granted);
+    }
+}
+
+void registerSession(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    g_sessions.push_back(session);
+    rebalanceSessionsLocked();
+}
+
+// Must run before the handle is destroyed or recycled; frees its decoder slot for the others.
+void unregisterSession(MpvSession* session) {
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    g_sessions.erase(std::remove(g_sessions.begin(), g_sessions.end(), session), g_sessions.end());
+    rebalanceSessionsLocked();
+}
+
+void setSessionRole(MpvSession* session, int role) {
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    if (session->role == role) {
+        return;
+    }
+    session->role = role;
+    rebalanceSessionsLocked();
+}
+
+void setSessionBudget(MpvSession* session, const ResourceBudget& budget) {
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    session->budget = budget;
+    session->applied_role = -1;
+    rebalanceSessionsLocked();
+}
+
+// Routes Kotlin's "hwdec" option through the arbiter. Returns true when the caller should set
+// it on mpv now; otherwise it is only recorded until the session gets a decoder slot.
+bool setPreferredHwdec(MpvSession* session, const std::string& value) {
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    session->preferred_hwdec = value;
+    rebalanceSessionsLocked();
+    return session->hwdec_granted;
+}
+#endif
 }  // namespace
 
 extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*) {
@@ -1062,9 +2296,10 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetAndroidAppContext
     JNIEnv* env, jclass, jobject context) {
     if (env == nullptr || context == nullptr) return;
     std::lock_guard<std::mutex> lock(g_app_ctx_mutex);
+    // FFmpeg keeps the pointer it is given and other sessions may be decoding with it, so the
+    // application context is registered once and never replaced.
     if (g_android_app_ctx != nullptr) {
-        env->DeleteGlobalRef(g_android_app_ctx);
-        g_android_app_ctx = nullptr;
+        return;
     }
     g_android_app_ctx = env->NewGlobalRef(context);
     initFfmpegJni(g_java_vm);
@@ -1076,55 +2311,113 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeIsLinked(JNIEnv*, jc
     return runtimeLinked() ? JNI_TRUE : JNI_FALSE;
 }
 
+// Lock-free snapshot of a session's error slot (the process slot for handle 0), packed as
+// described at ErrorSlot. Never blocks, so Kotlin may poll it.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeErrorState(JNIEnv*, jclass, jlong handle) {
+    auto* session = fromHandle(handle);
+    const ErrorSlot& slot = session != nullptr ? session->error : g_process_error;
+    return static_cast<jlong>(slot.load(std::memory_order_acquire));
+}
+
 extern "C" JNIEXPORT jstring JNICALL
-Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeLastError(JNIEnv* env, jclass) {
-    const std::string message = get_last_error();
-    if (message.empty()) {
-        return nullptr;
-    }
-    return env->NewStringUTF(message.c_str());
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeErrorMessage(JNIEnv* env, jclass, jint messageId) {
+    const char* message = messageId > 0 ? errorMessageById(static_cast<uint32_t>(messageId)) : nullptr;
+    return message != nullptr ? env->NewStringUTF(message) : nullptr;
 }
 
 extern "C" JNIEXPORT jlong JNICALL
 Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeCreate(JNIEnv*, jclass) {
 #if MPV_PREBUILT_AVAILABLE
-    mpv_handle* handle = createHandle();
+    mpv_handle* handle = takePooledHandle();
+    const bool reused = handle != nullptr;
+    if (reused) {
+        // resetHandleForReuse() switched to idle=yes; back to what createHandle() configures.
+        mpv_set_property_string(handle, "idle", "once");
+    } else {
+        handle = createHandle();
+        if (handle != nullptr) {
+            captureRecycleDefaults(handle);
+        }
+    }
     if (handle == nullptr) {
         return 0;
     }
+    const int wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeup_fd < 0) {
+        recordError(nullptr, std::string("eventfd failed: ") + strerror(errno), errno);
+        mpv_terminate_destroy(handle);
+        return 0;
+    }
     auto* session = new MpvSession();
     session->handle = handle;
+    session->wakeup_fd = wakeup_fd;
+    mpv_set_wakeup_callback(session->handle, signalWakeup, session);
     observeProperties(session->handle);
+    registerSession(session);
+    g_lifecycle.sessions_created.fetch_add(1);
+    if (reused) {
+        g_lifecycle.handles_reused.fetch_add(1);
+    }
     return reinterpret_cast<jlong>(session);
 #else
+    g_lifecycle.sessions_created.fetch_add(1);
     return reinterpret_cast<jlong>(new MpvSession());
 #endif
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeDestroy(
-    JNIEnv* env, jclass, jlong handle) {
+    JNIEnv* env, jclass, jlong handle, jboolean recycle) {
     auto* session = fromHandle(handle);
     if (session == nullptr) return;
+    const auto started = std::chrono::steady_clock::now();
+    // Java-facing state is released here; the caller must not see callbacks after return.
     stopEventThread(env, session);
 #if MPV_PREBUILT_AVAILABLE
+    {
+        // The subtitle handle belongs to the caller and may be destroyed right after this.
+        std::lock_guard<std::mutex> lock(session->compositor_mutex);
+        session->compositor_fn = nullptr;
+        session->compositor_handle = 0;
+    }
     {
         std::lock_guard<std::mutex> guard(session->mutex);
         if (session->surface_ref != nullptr) {
             env->DeleteGlobalRef(session->surface_ref);
             session->surface_ref = nullptr;
         }
-        if (session->native_window != nullptr) {
-            ANativeWindow_release(session->native_window);
-            session->native_window = nullptr;
-        }
-    }
-    if (session->handle != nullptr) {
-        mpv_terminate_destroy(session->handle);
-        session->handle = nullptr;
     }
-#endif
+    unregisterSession(session);
+    // Render thread shutdown and mpv_terminate_destroy() can take seconds on network streams,
+    // so they run on the reaper thread instead of the (usually UI) caller.
+    queueForReaping(session, recycle == JNI_TRUE);
+#else
+    (void)recycle;
     delete session;
+#endif
+    g_lifecycle.last_destroy_call_us.store(std::chrono::duration_cast<std::chrono::microseconds>(
+                                               std::chrono::steady_clock::now() - started)
+                                               .count());
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeLifecycleMetrics(JNIEnv* env, jclass) {
+    const jlong values[kLifecycleMetricCount] = {
+        g_lifecycle.sessions_created.load(),
+        g_lifecycle.handles_reused.load(),
+        g_lifecycle.handles_recycled.load(),
+        g_lifecycle.sessions_reaped.load(),
+        g_lifecycle.last_destroy_call_us.load(),
+        g_lifecycle.last_teardown_ms.load(),
+        g_lifecycle.max_teardown_ms.load(),
+        g_lifecycle.total_teardown_ms.load(),
+    };
+    jlongArray result = env->NewLongArray(kLifecycleMetricCount);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kLifecycleMetricCount, values);
+    }
+    return result;
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -1136,6 +2429,17 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSurface(
     std::lock_guard<std::mutex> guard(session->mutex);
     if (session->handle == nullptr) return;
 
+    if (session->render_api) {
+        ANativeWindow* window = surface != nullptr ? ANativeWindow_fromSurface(env, surface) : nullptr;
+        if (surface != nullptr && window == nullptr) {
+            recordError(session, "ANativeWindow_fromSurface failed for render API output");
+            return;
+        }
+        startRenderThread(session);
+        setRenderWindow(session, window);
+        return;
+    }
+
     if (session->surface_ref != nullptr) {
         int64_t wid = 0;
         const int result = mpv_set_option(session->handle, "wid", MPV_FORMAT_INT64, &wid);
@@ -1151,7 +2455,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSurface(
     if (surface != nullptr) {
         session->surface_ref = env->NewGlobalRef(surface);
         if (session->surface_ref == nullptr) {
-            set_last_error("Failed to allocate global surface reference");
+            recordError(session, "Failed to allocate global surface reference");
             return;
         }
 
@@ -1161,9 +2465,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSurface(
             char buffer[128] = {0};
             snprintf(buffer, sizeof(buffer), "mpv_set_option(wid) failed: %d", result);
             __android_log_print(ANDROID_LOG_ERROR, kLogTag, "%s", buffer);
-            set_last_error(buffer);
-        } else {
-            set_last_error("");
+            recordMpvError(session, "mpv_set_option(wid)", result);
         }
 
         // Keep mpv rendering enabled while the surface is alive.
@@ -1226,18 +2528,18 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetOptionString(
     JNIEnv* env, jclass, jlong handle, jstring name, jstring value) {
     auto* session = fromHandle(handle);
     if (session == nullptr || name == nullptr || value == nullptr) {
-        set_last_error("nativeSetOptionString called with null argument");
+        recordError(session, "nativeSetOptionString called with null argument");
         return JNI_FALSE;
     }
 #if MPV_PREBUILT_AVAILABLE
     if (session->handle == nullptr) {
-        set_last_error("mpv handle is null while setting option");
+        recordError(session, "mpv handle is null while setting option");
         return JNI_FALSE;
     }
     const char* nameChars = env->GetStringUTFChars(name, nullptr);
     const char* valueChars = env->GetStringUTFChars(value, nullptr);
     if (nameChars == nullptr || valueChars == nullptr) {
-        set_last_error("Failed to decode option name or value for mpv");
+        recordError(session, "Failed to decode option name or value for mpv");
         if (nameChars != nullptr) env->ReleaseStringUTFChars(name, nameChars);
         if (valueChars != nullptr) env->ReleaseStringUTFChars(value, valueChars);
         return JNI_FALSE;
@@ -1247,19 +2549,21 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetOptionString(
     env->ReleaseStringUTFChars(name, nameChars);
     env->ReleaseStringUTFChars(value, valueChars);
 
+    if (optionName == "hwdec" && !setPreferredHwdec(session, optionValue)) {
+        return JNI_TRUE;
+    }
     const int result = mpv_set_property_string(session->handle, optionName.c_str(), optionValue.c_str());
     if (result < 0) {
-        char buffer[192] = {0};
-        snprintf(buffer, sizeof(buffer), "mpv_set_property %s=%s failed: %d", optionName.c_str(), optionValue.c_str(), result);
-        set_last_error(buffer);
+        __android_log_print(ANDROID_LOG_WARN, kLogTag, "mpv_set_property %s=%s failed: %d", optionName.c_str(),
+                            optionValue.c_str(), result);
+        recordMpvError(session, "mpv_set_property " + optionName, result);
         return JNI_FALSE;
     }
-    set_last_error("");
     return JNI_TRUE;
 #else
     (void)name;
     (void)value;
-    set_last_error("libmpv.so not linked; setOptionString is unavailable");
+    recordError(session, "libmpv.so not linked; setOptionString is unavailable");
     return JNI_FALSE;
 #endif
 }
@@ -1269,17 +2573,17 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetLogLevel(
     JNIEnv* env, jclass, jlong handle, jstring level) {
     auto* session = fromHandle(handle);
     if (session == nullptr || level == nullptr) {
-        set_last_error("nativeSetLogLevel called with null argument");
+        recordError(session, "nativeSetLogLevel called with null argument");
         return JNI_FALSE;
     }
 #if MPV_PREBUILT_AVAILABLE
     if (session->handle == nullptr) {
-        set_last_error("mpv handle is null while setting log level");
+        recordError(session, "mpv handle is null while setting log level");
         return JNI_FALSE;
     }
     const char* levelChars = env->GetStringUTFChars(level, nullptr);
     if (levelChars == nullptr) {
-        set_last_error("Failed to decode log level for mpv");
+        recordError(session, "Failed to decode log level for mpv");
         return JNI_FALSE;
     }
     const std::string levelString = levelChars;
@@ -1287,16 +2591,13 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetLogLevel(
 
     const int result = mpv_request_log_messages(session->handle, levelString.c_str());
     if (result < 0) {
-        char buffer[160] = {0};
-        snprintf(buffer, sizeof(buffer), "mpv_request_log_messages(%s) failed: %d", levelString.c_str(), result);
-        set_last_error(buffer);
+        recordMpvError(session, "mpv_request_log_messages(" + levelString + ")", result);
         return JNI_FALSE;
     }
-    set_last_error("");
     return JNI_TRUE;
 #else
     (void)level;
-    set_last_error("libmpv.so not linked; mpv logging unavailable");
+    recordError(session, "libmpv.so not linked; mpv logging unavailable");
     return JNI_FALSE;
 #endif
 }
@@ -1356,7 +2657,11 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeAddExternalTrack(
     auto* session = fromHandle(handle);
     if (session == nullptr || path == nullptr) return JNI_FALSE;
     const char* pathChars = env->GetStringUTFChars(path, nullptr);
-    const std::string pathString = pathChars == nullptr ? "" : pathChars;
+    if (pathChars == nullptr) {
+        recordError(session, "Failed to decode external track path for mpv");
+        return JNI_FALSE;
+    }
+    const std::string pathString = pathChars;
     env->ReleaseStringUTFChars(path, pathChars);
     if (pathString.empty()) {
         return JNI_FALSE;
@@ -1372,7 +2677,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeAddShader(
 #if MPV_PREBUILT_AVAILABLE
     const char* pathChars = env->GetStringUTFChars(path, nullptr);
     if (pathChars == nullptr) {
-        set_last_error("Failed to decode shader path for mpv");
+        recordError(session, "Failed to decode shader path for mpv");
         return JNI_FALSE;
     }
     const std::string pathString = pathChars;
@@ -1384,7 +2689,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeAddShader(
 #else
     (void)env;
     (void)handle;
-    set_last_error("libmpv.so not linked; addShader is unavailable");
+    recordError(session, "libmpv.so not linked; addShader is unavailable");
     return JNI_FALSE;
 #endif
 }
@@ -1397,7 +2702,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetShaders(
 #if MPV_PREBUILT_AVAILABLE
     const char* valueChars = env->GetStringUTFChars(value, nullptr);
     if (valueChars == nullptr) {
-        set_last_error("Failed to decode shader list value for mpv");
+        recordError(session, "Failed to decode shader list value for mpv");
         return JNI_FALSE;
     }
     const std::string listValue = valueChars;
@@ -1406,7 +2711,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetShaders(
 #else
     (void)env;
     (void)handle;
-    set_last_error("libmpv.so not linked; setShaders is unavailable");
+    recordError(session, "libmpv.so not linked; setShaders is unavailable");
     return JNI_FALSE;
 #endif
 }
@@ -1419,7 +2724,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeClearShaders(
 #if MPV_PREBUILT_AVAILABLE
     return clearShaders(session) ? JNI_TRUE : JNI_FALSE;
 #else
-    set_last_error("libmpv.so not linked; clearShaders is unavailable");
+    recordError(session, "libmpv.so not linked; clearShaders is unavailable");
     return JNI_FALSE;
 #endif
 }
@@ -1462,7 +2767,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeGetHwdecCurrent(
 #else
     (void)env;
     (void)handle;
-    set_last_error("libmpv.so not linked; hwdec-current unavailable");
+    recordError(session, "libmpv.so not linked; hwdec-current unavailable");
     return nullptr;
 #endif
 }
@@ -1475,15 +2780,21 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetDataSource(
         return JNI_FALSE;
     }
     const char* pathChars = env->GetStringUTFChars(path, nullptr);
-    const std::string pathString = pathChars ? pathChars : "";
+    if (pathChars == nullptr) {
+        recordError(session, "Failed to decode data source path for mpv");
+        return JNI_FALSE;
+    }
+    const std::string pathString = pathChars;
     env->ReleaseStringUTFChars(path, pathChars);
     session->headers = collectHeaders(env, headers);
+    // A new playback attempt: errors of the previous source must not be reported for this one.
+    clearError(session->error);
 #if MPV_PREBUILT_AVAILABLE
     if (session->handle == nullptr) {
         return JNI_FALSE;
     }
-    applyHttpHeaders(session->handle, session->headers);
-    if (!loadFile(session->handle, pathString.c_str())) {
+    applyHttpHeaders(session, session->headers);
+    if (!loadFile(session, pathString.c_str())) {
         return JNI_FALSE;
     }
     session->paused = false;
@@ -1502,7 +2813,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativePlay(JNIEnv*, jclass
     auto* session = fromHandle(handle);
     if (session == nullptr) return;
 #if MPV_PREBUILT_AVAILABLE
-    setFlagProperty(session->handle, "pause", false);
+    setFlagProperty(session, "pause", false);
 #endif
     session->paused = false;
 }
@@ -1512,7 +2823,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativePause(JNIEnv*, jclas
     auto* session = fromHandle(handle);
     if (session == nullptr) return;
 #if MPV_PREBUILT_AVAILABLE
-    setFlagProperty(session->handle, "pause", true);
+    setFlagProperty(session, "pause", true);
 #endif
     session->paused = true;
 }
@@ -1550,7 +2861,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSpeed(
     auto* session = fromHandle(handle);
     if (session == nullptr) return;
 #if MPV_PREBUILT_AVAILABLE
-    setDoubleProperty(session->handle, "speed", static_cast<double>(speed));
+    setDoubleProperty(session, "speed", static_cast<double>(speed));
 #endif
     session->speed = speed;
 }
@@ -1562,7 +2873,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetVolume(
     if (session == nullptr) return;
 #if MPV_PREBUILT_AVAILABLE
     const double scaledVolume = static_cast<double>(volume) * 100.0;
-    setDoubleProperty(session->handle, "volume", scaledVolume);
+    setDoubleProperty(session, "volume", scaledVolume);
 #endif
     session->volume = volume;
 }
@@ -1579,6 +2890,109 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetLooping(
     session->looping = looping == JNI_TRUE;
 }
 
+// Negative positions clear the respective loop point; mpv loops once both are set.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetAbLoop(
+    JNIEnv*, jclass, jlong handle, jlong startMs, jlong endMs) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    if (session->handle == nullptr) return JNI_FALSE;
+    const std::pair<const char*, jlong> points[] = {{"ab-loop-a", startMs}, {"ab-loop-b", endMs}};
+    for (const auto& point : points) {
+        char value[64] = "no";
+        if (point.second >= 0) {
+            snprintf(value, sizeof(value), "%.3f", static_cast<double>(point.second) / 1000.0);
+        }
+        const int result = mpv_set_property_string(session->handle, point.first, value);
+        if (result < 0) {
+            recordMpvError(session, std::string("mpv_set_property ") + point.first, result);
+            return JNI_FALSE;
+        }
+    }
+    return JNI_TRUE;
+#else
+    (void)startMs;
+    (void)endMs;
+    recordError(session, "libmpv.so not linked; A-B loop is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+// Returns false when the step was dropped because the previous one is still in flight.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeFrameStep(
+    JNIEnv*, jclass, jlong handle, jboolean backward) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    return frameStep(session, backward == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+#else
+    (void)backward;
+    recordError(session, "libmpv.so not linked; frame stepping is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativePlaySegment(
+    JNIEnv*, jclass, jlong handle, jlong startMs, jlong endMs) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    return playSegment(session, startMs, endMs) ? JNI_TRUE : JNI_FALSE;
+#else
+    (void)startMs;
+    (void)endMs;
+    recordError(session, "libmpv.so not linked; segment playback is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeCancelSegment(JNIEnv*, jclass, jlong handle) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    cancelSegment(session);
+#endif
+}
+
+// role: 0 = foreground, 1 = background (downgraded by the session arbiter).
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSessionRole(
+    JNIEnv*, jclass, jlong handle, jint role) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    setSessionRole(session, role == kSessionBackground ? kSessionBackground : kSessionForeground);
+#else
+    (void)role;
+#endif
+}
+
+// Foreground budget of the session; the background budget is derived from it.
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetResourceBudget(
+    JNIEnv*, jclass, jlong handle, jlong demuxerMaxBytes, jlong demuxerMaxBackBytes, jint decoderThreads,
+    jboolean hwdec) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    ResourceBudget budget;
+    budget.demuxer_max_bytes = std::max<int64_t>(demuxerMaxBytes, 0);
+    budget.demuxer_max_back_bytes = std::max<int64_t>(demuxerMaxBackBytes, 0);
+    budget.decoder_threads = std::max(decoderThreads, 0);
+    budget.hwdec = hwdec == JNI_TRUE;
+    setSessionBudget(session, budget);
+#else
+    (void)demuxerMaxBytes;
+    (void)demuxerMaxBackBytes;
+    (void)decoderThreads;
+    (void)hwdec;
+#endif
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSubtitleDelay(
     JNIEnv*, jclass, jlong handle, jlong offsetMs) {
@@ -1586,7 +3000,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSubtitleDelay(
     if (session == nullptr) return;
 #if MPV_PREBUILT_AVAILABLE
     const double offsetSeconds = static_cast<double>(offsetMs) / 1000.0;
-    setDoubleProperty(session->handle, "sub-delay", offsetSeconds);
+    setDoubleProperty(session, "sub-delay", offsetSeconds);
 #endif
 }
 
@@ -1596,7 +3010,7 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeGetPosition(
     auto* session = fromHandle(handle);
     if (session == nullptr) return 0;
 #if MPV_PREBUILT_AVAILABLE
-    return static_cast<jlong>(getDoubleProperty(session->handle, "time-pos") * 1000.0);
+    return static_cast<jlong>(getDoubleProperty(session, "time-pos") * 1000.0);
 #else
     return static_cast<jlong>(session->position);
 #endif
@@ -1608,8 +3022,318 @@ Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeGetDuration(
     auto* session = fromHandle(handle);
     if (session == nullptr) return 0;
 #if MPV_PREBUILT_AVAILABLE
-    return static_cast<jlong>(getDoubleProperty(session->handle, "duration") * 1000.0);
+    return static_cast<jlong>(getDoubleProperty(session, "duration") * 1000.0);
 #else
     return static_cast<jlong>(session->duration);
 #endif
 }
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeCommandAsync(
+    JNIEnv* env, jclass, jlong handle, jlong requestId, jobjectArray args) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr || args == nullptr) return JNI_FALSE;
+    const std::vector<std::string> command = collectHeaders(env, args);
+    return commandAsync(session, static_cast<uint64_t>(requestId), command) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetPropertyAsync(
+    JNIEnv* env, jclass, jlong handle, jlong requestId, jstring name, jstring value) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr || name == nullptr || value == nullptr) return JNI_FALSE;
+    const char* nameChars = env->GetStringUTFChars(name, nullptr);
+    const char* valueChars = env->GetStringUTFChars(value, nullptr);
+    bool queued = false;
+    if (nameChars != nullptr && valueChars != nullptr) {
+        queued = setPropertyAsync(session, static_cast<uint64_t>(requestId), nameChars, valueChars);
+    } else {
+        recordError(session, "Failed to decode async property name/value for mpv");
+    }
+    if (nameChars != nullptr) env->ReleaseStringUTFChars(name, nameChars);
+    if (valueChars != nullptr) env->ReleaseStringUTFChars(value, valueChars);
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeAbortAsync(
+    JNIEnv*, jclass, jlong handle, jlong requestId) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr || requestId == 0) return;
+#if MPV_PREBUILT_AVAILABLE
+    // Only commands can be aborted; the aborted command still delivers its reply.
+    if (session->handle != nullptr) {
+        mpv_abort_async_command(session->handle, static_cast<uint64_t>(requestId));
+    }
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetDataSourceAsync(
+    JNIEnv* env, jclass, jlong handle, jlong requestId, jstring path, jobjectArray headers) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr || path == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        recordError(session, "Failed to decode data source path for mpv");
+        return JNI_FALSE;
+    }
+    const std::string pathString = pathChars;
+    env->ReleaseStringUTFChars(path, pathChars);
+    session->headers = collectHeaders(env, headers);
+    // A new playback attempt: errors of the previous source must not be reported for this one.
+    clearError(session->error);
+#if MPV_PREBUILT_AVAILABLE
+    if (session->handle == nullptr) {
+        return JNI_FALSE;
+    }
+    // Both requests go through the core's dispatch queue in order, so the headers are in
+    // place before loadfile opens the stream.
+    if (!applyHttpHeadersAsync(session, session->headers)) {
+        return JNI_FALSE;
+    }
+    if (!commandAsync(session, static_cast<uint64_t>(requestId), {"loadfile", pathString})) {
+        return JNI_FALSE;
+    }
+    session->paused = false;
+    return JNI_TRUE;
+#else
+    (void)requestId;
+    recordError(session, "libmpv.so not linked; async loadfile is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeScrubBegin(
+    JNIEnv*, jclass, jlong handle) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    scrubBegin(session);
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeScrubUpdate(
+    JNIEnv*, jclass, jlong handle, jlong positionMs) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    return scrubUpdate(session, positionMs) ? JNI_TRUE : JNI_FALSE;
+#else
+    session->position = positionMs;
+    return JNI_TRUE;
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeScrubEnd(
+    JNIEnv*, jclass, jlong handle, jlong positionMs) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    return scrubEnd(session, positionMs) ? JNI_TRUE : JNI_FALSE;
+#else
+    session->position = positionMs;
+    return JNI_TRUE;
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetRenderApi(
+    JNIEnv*, jclass, jlong handle, jboolean enabled) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    std::lock_guard<std::mutex> guard(session->mutex);
+    if (session->render_api == (enabled == JNI_TRUE)) {
+        return JNI_TRUE;
+    }
+    if (session->surface_ref != nullptr || session->render_running.load()) {
+        recordError(session, "render API output must be selected before a surface is attached");
+        return JNI_FALSE;
+    }
+    session->render_api = enabled == JNI_TRUE;
+    return JNI_TRUE;
+#else
+    (void)enabled;
+    recordError(session, "libmpv.so not linked; render API output is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeOnVsync(
+    JNIEnv*, jclass, jlong handle, jlong frameTimeNanos) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    {
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+        const int64_t delta = frameTimeNanos - session->vsync_ns;
+        // Skipped Choreographer frames show up as multiples of the period; only plausible
+        // single intervals (4-50 ms) feed the estimate.
+        if (session->vsync_ns > 0 && delta >= 4000000LL && delta <= 50000000LL) {
+            session->vsync_period_ns =
+                session->vsync_period_ns == 0 ? delta : (session->vsync_period_ns * 7 + delta) / 8;
+        }
+        session->vsync_ns = frameTimeNanos;
+        session->vsync_pending = true;
+    }
+    session->render_cv.notify_all();
+#else
+    (void)frameTimeNanos;
+#endif
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSubtitleCompositor(
+    JNIEnv*, jclass, jlong handle, jlong subtitleHandle) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return JNI_FALSE;
+#if MPV_PREBUILT_AVAILABLE
+    AssGpuCompositeFrameFn fn = nullptr;
+    if (subtitleHandle != 0) {
+        bool render_api = false;
+        {
+            std::lock_guard<std::mutex> guard(session->mutex);
+            render_api = session->render_api;
+        }
+        if (!render_api) {
+            recordError(session, "subtitle compositing requires the render API output");
+            return JNI_FALSE;
+        }
+        fn = resolveSubtitleCompositor(session);
+        if (fn == nullptr) {
+            return JNI_FALSE;
+        }
+    }
+    {
+        // Blocks while a frame is compositing, so the old handle is unused on return.
+        std::lock_guard<std::mutex> lock(session->compositor_mutex);
+        session->compositor_fn = fn;
+        session->compositor_handle = subtitleHandle;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+        session->subtitle_redraw = true;
+    }
+    session->render_cv.notify_all();
+    return JNI_TRUE;
+#else
+    (void)subtitleHandle;
+    recordError(session, "libmpv.so not linked; subtitle compositing is unavailable");
+    return JNI_FALSE;
+#endif
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeSetSubtitleCompositorOffset(
+    JNIEnv*, jclass, jlong handle, jlong offsetMs) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    {
+        std::lock_guard<std::mutex> lock(session->compositor_mutex);
+        session->compositor_offset_ms = offsetMs;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+        session->subtitle_redraw = true;
+    }
+    session->render_cv.notify_all();
+#else
+    (void)offsetMs;
+#endif
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvNativeBridge_nativeInvalidateSubtitleCompositor(
+    JNIEnv*, jclass, jlong handle) {
+    auto* session = fromHandle(handle);
+    if (session == nullptr) return;
+#if MPV_PREBUILT_AVAILABLE
+    {
+        std::lock_guard<std::mutex> lock(session->render_mutex);
+        session->subtitle_redraw = true;
+    }
+    session->render_cv.notify_all();
+#endif
+}
+
+namespace {
+// One MpvThumbnailEngine; `cancel` is the only field touched while a job runs.
+struct ThumbnailJob {
+    std::atomic<bool> cancel = false;
+    std::mutex mutex;
+    std::string error;
+};
+
+std::string jstringToString(JNIEnv* env, jstring value) {
+    if (value == nullptr) return "";
+    const char* chars = env->GetStringUTFChars(value, nullptr);
+    const std::string result = chars == nullptr ? "" : chars;
+    if (chars != nullptr) {
+        env->ReleaseStringUTFChars(value, chars);
+    }
+    return result;
+}
+}  // namespace
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvThumbnailEngine_nativeCreate(JNIEnv*, jclass) {
+    return reinterpret_cast<jlong>(new ThumbnailJob());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvThumbnailEngine_nativeDestroy(JNIEnv*, jclass, jlong handle) {
+    delete reinterpret_cast<ThumbnailJob*>(handle);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvThumbnailEngine_nativeGenerate(
+    JNIEnv* env, jclass, jlong handle, jstring path, jstring cachePath, jint tileWidth, jint intervalMs,
+    jint columns, jint rows, jint maxFrames) {
+    auto* job = reinterpret_cast<ThumbnailJob*>(handle);
+    if (job == nullptr) return JNI_FALSE;
+    const std::string pathString = jstringToString(env, path);
+    const std::string cacheString = jstringToString(env, cachePath);
+    std::string error;
+    bool ok = false;
+    if (pathString.empty() || cacheString.empty()) {
+        error = "thumbnail source or cache path is empty";
+    } else {
+        mpv_thumb::ThumbnailOptions options;
+        options.tile_width = tileWidth;
+        options.interval_ms = intervalMs;
+        options.columns = columns;
+        options.rows = rows;
+        options.max_frames = maxFrames;
+        ok = mpv_thumb::GenerateThumbnails(pathString, cacheString, options, job->cancel, &error);
+    }
+    job->cancel = false;
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->error = ok ? "" : error;
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvThumbnailEngine_nativeCancel(JNIEnv*, jclass, jlong handle) {
+    auto* job = reinterpret_cast<ThumbnailJob*>(handle);
+    if (job == nullptr) return;
+    job->cancel = true;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_xyoye_player_kernel_impl_mpv_MpvThumbnailEngine_nativeLastError(JNIEnv* env, jclass, jlong handle) {
+    auto* job = reinterpret_cast<ThumbnailJob*>(handle);
+    if (job == nullptr) return nullptr;
+    std::lock_guard<std::mutex> lock(job->mutex);
+    if (job->error.empty()) {
+        return nullptr;
+    }
+    return env->NewStringUTF(job->error.c_str());
+}
@@ -0,0 +1,380 @@
+#include "mpv_thumbnail.h"
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#if MPV_PREBUILT_AVAILABLE
+extern "C" {
+#include <mpv/client.h>
+#include <mpv/render.h>
+}
+#endif
+
+namespace mpv_thumb {
+namespace {
+
+void PutU32(std::vector<uint8_t> *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void PutU64(std::vector<uint8_t> *out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out->push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+inline uint16_t ToRgb565(const uint8_t *pixel) {
+    return static_cast<uint16_t>(((pixel[0] & 0xF8) << 8) | ((pixel[1] & 0xFC) << 3) | (pixel[2] >> 3));
+}
+
+}  // namespace
+
+SpriteSheetWriter::SpriteSheetWriter(int tile_width, int tile_height, int columns, int rows)
+    : tile_width_(tile_width), tile_height_(tile_height), columns_(columns), rows_(rows) {
+    sheet_.assign(static_cast<size_t>(columns_) * tile_width_ * rows_ * tile_height_, 0);
+}
+
+void SpriteSheetWriter::AddFrame(int64_t pts_ms, const uint8_t *rgb0, size_t stride) {
+    if (failed_) {
+        return;
+    }
+    const size_t sheet_stride = static_cast<size_t>(columns_) * tile_width_;
+    const size_t column = sheet_tiles_ % static_cast<size_t>(columns_);
+    const size_t row = sheet_tiles_ / static_cast<size_t>(columns_);
+    uint16_t *origin = sheet_.data() + row * tile_height_ * sheet_stride + column * tile_width_;
+    for (int y = 0; y < tile_height_; ++y) {
+        const uint8_t *src = rgb0 + static_cast<size_t>(y) * stride;
+        uint16_t *dst = origin + static_cast<size_t>(y) * sheet_stride;
+        for (int x = 0; x < tile_width_; ++x) {
+            dst[x] = ToRgb565(src + x * 4);
+        }
+    }
+    pts_.push_back(pts_ms);
+    if (++sheet_tiles_ == static_cast<size_t>(columns_) * rows_) {
+        failed_ = !FlushSheet();
+    }
+}
+
+bool SpriteSheetWriter::FlushSheet() {
+    if (sheet_tiles_ == 0) {
+        return true;
+    }
+    // RGB565 little endian, as read by Bitmap.copyPixelsFromBuffer on device.
+    std::vector<uint8_t> raw(sheet_.size() * 2);
+    for (size_t i = 0; i < sheet_.size(); ++i) {
+        raw[i * 2] = static_cast<uint8_t>(sheet_[i]);
+        raw[i * 2 + 1] = static_cast<uint8_t>(sheet_[i] >> 8);
+    }
+    uLongf compressed_size = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, raw.data(), static_cast<uLong>(raw.size()),
+                  Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    compressed.resize(compressed_size);
+    compressed_.push_back(std::move(compressed));
+    std::fill(sheet_.begin(), sheet_.end(), 0);
+    sheet_tiles_ = 0;
+    return true;
+}
+
+bool SpriteSheetWriter::Write(const std::string &path, int64_t duration_ms, std::string *error) {
+    if (!failed_ && !FlushSheet()) {
+        failed_ = true;
+    }
+    if (failed_) {
+        *error = "sprite sheet compression failed";
+        return false;
+    }
+    if (pts_.empty()) {
+        *error = "no frames rendered";
+        return false;
+    }
+
+    const uint32_t raw_bytes = static_cast<uint32_t>(sheet_.size() * 2);
+    std::vector<uint8_t> header;
+    PutU32(&header, kSpriteMagic);
+    PutU32(&header, kSpriteVersion);
+    PutU32(&header, static_cast<uint32_t>(tile_width_));
+    PutU32(&header, static_cast<uint32_t>(tile_height_));
+    PutU32(&header, static_cast<uint32_t>(columns_));
+    PutU32(&header, static_cast<uint32_t>(rows_));
+    PutU32(&header, static_cast<uint32_t>(pts_.size()));
+    PutU32(&header, static_cast<uint32_t>(compressed_.size()));
+    PutU64(&header, static_cast<uint64_t>(duration_ms));
+    for (const int64_t pts : pts_) {
+        PutU64(&header, static_cast<uint64_t>(pts));
+    }
+    uint64_t offset = header.size() + compressed_.size() * 16;
+    for (const auto &sheet : compressed_) {
+        PutU64(&header, offset);
+        PutU32(&header, static_cast<uint32_t>(sheet.size()));
+        PutU32(&header, raw_bytes);
+        offset += sheet.size();
+    }
+
+    const std::string temp_path = path + ".tmp";
+    FILE *file = std::fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) {
+        *error = "cannot open " + temp_path + ": " + std::strerror(errno);
+        return false;
+    }
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    for (const auto &sheet : compressed_) {
+        ok = ok && std::fwrite(sheet.data(), 1, sheet.size(), file) == sheet.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        *error = "cannot write " + path + ": " + std::strerror(errno);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+#if MPV_PREBUILT_AVAILABLE
+namespace {
+
+// Background nice level; threads created while it is in effect (mpv's core,
+// demuxer and decoder threads) inherit it.
+constexpr int kBackgroundNice = 10;
+constexpr double kLoadTimeoutSeconds = 15.0;
+constexpr double kSeekTimeoutSeconds = 5.0;
+constexpr double kEventPollSeconds = 0.02;
+
+class BackgroundPriorityScope {
+public:
+    BackgroundPriorityScope() : tid_(static_cast<id_t>(syscall(SYS_gettid))) {
+        errno = 0;
+        const int current = getpriority(PRIO_PROCESS, tid_);
+        if (errno == 0 && current < kBackgroundNice && setpriority(PRIO_PROCESS, tid_, kBackgroundNice) == 0) {
+            previous_ = current;
+            changed_ = true;
+        }
+    }
+
+    ~BackgroundPriorityScope() {
+        if (changed_) {
+            setpriority(PRIO_PROCESS, tid_, previous_);
+        }
+    }
+
+    BackgroundPriorityScope(const BackgroundPriorityScope &) = delete;
+    BackgroundPriorityScope &operator=(const BackgroundPriorityScope &) = delete;
+
+private:
+    id_t tid_;
+    int previous_ = 0;
+    bool changed_ = false;
+};
+
+struct MpvDeleter {
+    void operator()(mpv_handle *handle) const { mpv_terminate_destroy(handle); }
+};
+
+struct RenderContextDeleter {
+    void operator()(mpv_render_context *context) const { mpv_render_context_free(context); }
+};
+
+using MpvPtr = std::unique_ptr<mpv_handle, MpvDeleter>;
+using RenderContextPtr = std::unique_ptr<mpv_render_context, RenderContextDeleter>;
+
+// Waits for `wanted`; END_FILE and SHUTDOWN end the wait early with false.
+bool WaitForEvent(mpv_handle *mpv, mpv_event_id wanted, double timeout_seconds,
+                  const std::atomic<bool> &cancel) {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(timeout_seconds));
+    while (!cancel.load() && std::chrono::steady_clock::now() < deadline) {
+        const mpv_event *event = mpv_wait_event(mpv, kEventPollSeconds);
+        if (event->event_id == wanted) {
+            return true;
+        }
+        if (event->event_id == MPV_EVENT_END_FILE || event->event_id == MPV_EVENT_SHUTDOWN) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Polls the render context until the frame produced by the last seek arrives.
+bool WaitForFrame(mpv_handle *mpv, mpv_render_context *render, double timeout_seconds,
+                  const std::atomic<bool> &cancel) {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(timeout_seconds));
+    while (!cancel.load() && std::chrono::steady_clock::now() < deadline) {
+        if ((mpv_render_context_update(render) & MPV_RENDER_UPDATE_FRAME) != 0) {
+            return true;
+        }
+        mpv_wait_event(mpv, kEventPollSeconds);
+    }
+    return false;
+}
+
+MpvPtr CreateHeadlessMpv(std::string *error) {
+    MpvPtr mpv(mpv_create());
+    if (!mpv) {
+        *error = "mpv_create returned null handle";
+        return nullptr;
+    }
+    static const char *const kOptions[][2] = {
+        {"config", "no"},
+        {"load-scripts", "no"},
+        {"terminal", "no"},
+        {"vo", "libmpv"},
+        {"ao", "null"},
+        {"aid", "no"},
+        {"sid", "no"},
+        {"hwdec", "no"},
+        {"pause", "yes"},
+        {"keep-open", "always"},
+        {"hr-seek", "no"},
+        {"cache", "no"},
+        {"demuxer-max-bytes", "4MiB"},
+        {"demuxer-max-back-bytes", "0"},
+        {"vd-lavc-threads", "1"},
+        {"vd-lavc-skiploopfilter", "all"},
+        {"vd-lavc-fast", "yes"},
+        {"sw-fast", "yes"},
+    };
+    for (const auto &option : kOptions) {
+        mpv_set_option_string(mpv.get(), option[0], option[1]);
+    }
+    if (mpv_initialize(mpv.get()) < 0) {
+        *error = "mpv_initialize failed";
+        return nullptr;
+    }
+    return mpv;
+}
+
+}  // namespace
+
+bool GenerateThumbnails(const std::string &path, const std::string &cache_path,
+                        const ThumbnailOptions &options, const std::atomic<bool> &cancel,
+                        std::string *error) {
+    if (options.tile_width < 16 || options.interval_ms <= 0 || options.columns <= 0 || options.rows <= 0 ||
+        options.max_frames <= 0) {
+        *error = "invalid thumbnail options";
+        return false;
+    }
+    BackgroundPriorityScope priority;
+
+    MpvPtr mpv = CreateHeadlessMpv(error);
+    if (!mpv) {
+        return false;
+    }
+    const char *api_type = MPV_RENDER_API_TYPE_SW;
+    mpv_render_param create_params[] = {
+        {MPV_RENDER_PARAM_API_TYPE, const_cast<char *>(api_type)},
+        {MPV_RENDER_PARAM_INVALID, nullptr},
+    };
+    mpv_render_context *raw_render = nullptr;
+    if (mpv_render_context_create(&raw_render, mpv.get(), create_params) < 0) {
+        *error = "mpv_render_context_create (sw) failed";
+        return false;
+    }
+    // Declared after mpv so it is freed first, as libmpv requires.
+    RenderContextPtr render(raw_render);
+
+    const char *load_cmd[] = {"loadfile", path.c_str(), nullptr};
+    if (mpv_command(mpv.get(), load_cmd) < 0) {
+        *error = "loadfile failed";
+        return false;
+    }
+    // Paused playback still decodes and reconfigures for the first frame.
+    if (!WaitForEvent(mpv.get(), MPV_EVENT_FILE_LOADED, kLoadTimeoutSeconds, cancel) ||
+        !WaitForEvent(mpv.get(), MPV_EVENT_VIDEO_RECONFIG, kLoadTimeoutSeconds, cancel)) {
+        *error = cancel.load() ? "cancelled" : "file has no decodable video";
+        return false;
+    }
+
+    double duration = 0.0;
+    int64_t display_width = 0;
+    int64_t display_height = 0;
+    mpv_get_property(mpv.get(), "duration", MPV_FORMAT_DOUBLE, &duration);
+    mpv_get_property(mpv.get(), "dwidth", MPV_FORMAT_INT64, &display_width);
+    mpv_get_property(mpv.get(), "dheight", MPV_FORMAT_INT64, &display_height);
+    if (duration <= 0.0 || display_width <= 0 || display_height <= 0) {
+        *error = "missing duration or video size";
+        return false;
+    }
+
+    const int tile_width = options.tile_width & ~1;
+    int tile_height = static_cast<int>(std::lround(static_cast<double>(tile_width) * display_height / display_width));
+    tile_height = std::clamp(tile_height & ~1, 2, tile_width * 4);
+
+    // Both stride and pointer 64-byte aligned, for mpv's SIMD paths.
+    size_t stride = static_cast<size_t>(tile_width) * 4;
+    stride = (stride + 63) & ~static_cast<size_t>(63);
+    std::vector<uint8_t> storage(stride * tile_height + 63);
+    uint8_t *pixels = reinterpret_cast<uint8_t *>(
+        (reinterpret_cast<uintptr_t>(storage.data()) + 63) & ~static_cast<uintptr_t>(63));
+    int size[2] = {tile_width, tile_height};
+    const char *format = "rgb0";
+
+    SpriteSheetWriter writer(tile_width, tile_height, options.columns, options.rows);
+    const int64_t duration_ms = static_cast<int64_t>(duration * 1000.0);
+    int64_t last_pts = -1;
+    for (int64_t target = 0; target < duration_ms && writer.frame_count() < static_cast<size_t>(options.max_frames);
+         target += options.interval_ms) {
+        if (cancel.load()) {
+            *error = "cancelled";
+            return false;
+        }
+        char seconds[32];
+        std::snprintf(seconds, sizeof(seconds), "%.3f", static_cast<double>(target) / 1000.0);
+        const char *seek_cmd[] = {"seek", seconds, "absolute+keyframes", nullptr};
+        if (mpv_command(mpv.get(), seek_cmd) < 0 ||
+            !WaitForEvent(mpv.get(), MPV_EVENT_PLAYBACK_RESTART, kSeekTimeoutSeconds, cancel) ||
+            !WaitForFrame(mpv.get(), render.get(), kSeekTimeoutSeconds, cancel)) {
+            continue;
+        }
+        double position = 0.0;
+        if (mpv_get_property(mpv.get(), "time-pos", MPV_FORMAT_DOUBLE, &position) < 0) {
+            continue;
+        }
+        // Sparse keyframes make neighbouring targets land on the same frame.
+        const int64_t pts = static_cast<int64_t>(position * 1000.0);
+        if (pts <= last_pts) {
+            continue;
+        }
+        mpv_render_param render_params[] = {
+            {MPV_RENDER_PARAM_SW_SIZE, size},
+            {MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>(format)},
+            {MPV_RENDER_PARAM_SW_STRIDE, &stride},
+            {MPV_RENDER_PARAM_SW_POINTER, pixels},
+            {MPV_RENDER_PARAM_INVALID, nullptr},
+        };
+        if (mpv_render_context_render(render.get(), render_params) < 0) {
+            continue;
+        }
+        writer.AddFrame(pts, pixels, stride);
+        last_pts = pts;
+    }
+
+    render.reset();
+    mpv.reset();
+    return writer.Write(cache_path, duration_ms, error);
+}
+#else
+bool GenerateThumbnails(const std::string &, const std::string &, const ThumbnailOptions &,
+                        const std::atomic<bool> &, std::string *error) {
+    *error = "libmpv.so not linked; thumbnail engine is unavailable";
+    return false;
+}
+#endif
+
+}  // namespace mpv_thumb
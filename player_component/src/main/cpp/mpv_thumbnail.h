@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mpv_thumb {
+
+/**
+ * Sprite-sheet cache file (all integers little endian):
+ *
+ *   u32 magic "DDTH", u32 version
+ *   u32 tile_width, tile_height, columns, rows, frame_count, sheet_count
+ *   i64 duration_ms
+ *   frame_count x i64 pts_ms
+ *   sheet_count x { u64 offset, u32 compressed_bytes, u32 raw_bytes }
+ *   sheets: zlib-deflated RGB565 pixels, (columns * tile_width) x (rows * tile_height)
+ *
+ * Frame i is tile (i % (columns * rows)) of sheet i / (columns * rows), laid out
+ * row by row. Frames are in ascending pts order. MpvThumbnailSheet.kt reads the
+ * same layout.
+ */
+constexpr uint32_t kSpriteMagic = 0x48544444;  // "DDTH"
+constexpr uint32_t kSpriteVersion = 1;
+
+struct ThumbnailOptions {
+    int tile_width = 160;
+    int interval_ms = 10000;
+    int columns = 10;
+    int rows = 10;
+    int max_frames = 240;
+};
+
+/**
+ * Packs rendered frames into RGB565 sheets and writes the cache file. Each full
+ * sheet is compressed as soon as it fills, so only one raw sheet is held.
+ */
+class SpriteSheetWriter {
+public:
+    SpriteSheetWriter(int tile_width, int tile_height, int columns, int rows);
+
+    // `rgb0` holds tile_width x tile_height pixels of 4 bytes (r, g, b, pad),
+    // `stride` bytes per line.
+    void AddFrame(int64_t pts_ms, const uint8_t *rgb0, size_t stride);
+
+    size_t frame_count() const { return pts_.size(); }
+
+    // Writes a temporary file next to `path` and renames it into place, so
+    // readers never see a partial cache.
+    bool Write(const std::string &path, int64_t duration_ms, std::string *error);
+
+private:
+    bool FlushSheet();
+
+    int tile_width_;
+    int tile_height_;
+    int columns_;
+    int rows_;
+    std::vector<int64_t> pts_;
+    std::vector<uint16_t> sheet_;
+    size_t sheet_tiles_ = 0;
+    std::vector<std::vector<uint8_t>> compressed_;
+    bool failed_ = false;
+};
+
+/**
+ * Renders preview frames of `path` with a headless mpv instance (vo=libmpv and
+ * the software render API, so no GPU or surface is involved): keyframe seeks
+ * every `interval_ms`, frames scaled to `tile_width` at the video's aspect, and
+ * written to `cache_path` by SpriteSheetWriter. The calling thread and the mpv
+ * threads it spawns run at background priority.
+ *
+ * Blocking. Returns false with `error` set on failure, or when `cancel` becomes
+ * true between frames.
+ */
+bool GenerateThumbnails(const std::string &path, const std::string &cache_path,
+                        const ThumbnailOptions &options, const std::atomic<bool> &cancel,
+                        std::string *error);
+
+}  // namespace mpv_thumb
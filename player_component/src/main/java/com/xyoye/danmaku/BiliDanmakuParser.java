@@ -50,6 +50,8 @@ public class BiliDanmakuParser extends BaseDanmakuParser {
         System.setProperty("org.xml.sax.driver", "org.xmlpull.v1.sax2.Driver");
     }
 
+    private static final String TRUE_STRING = "true";
+
     protected float mDispScaleX;
     protected float mDispScaleY;
 
@@ -75,8 +77,6 @@ public class BiliDanmakuParser extends BaseDanmakuParser {
 
     public class XmlContentHandler extends DefaultHandler {
 
-        private static final String TRUE_STRING = "true";
-
         public Danmakus result;
 
         public BaseDanmaku item = null;
@@ -164,107 +164,8 @@ public class BiliDanmakuParser extends BaseDanmakuParser {
                 String text = String.valueOf(item.text).trim();
                 if (item.getType() == BaseDanmaku.TYPE_SPECIAL && text.startsWith("[")
                         && text.endsWith("]")) {
-                    //text = text.substring(1, text.length() - 1);
-                    String[] textArr = null;//text.split(",", -1);
-                    try {
-                        JSONArray jsonArray = new JSONArray(text);
-                        textArr = new String[jsonArray.length()];
-                        for (int i = 0; i < textArr.length; i++) {
-                            textArr[i] = jsonArray.getString(i);
-                        }
-                    } catch (JSONException e) {
-                        e.printStackTrace();
-                    }
-
-                    if (textArr == null || textArr.length < 5 || TextUtils.isEmpty(textArr[4])) {
+                    if (!fillSpecialData(item, text)) {
                         item = null;
-                        return;
-                    }
-                    DanmakuUtils.fillText(item, textArr[4]);
-                    float beginX = parseFloat(textArr[0]);
-                    float beginY = parseFloat(textArr[1]);
-                    float endX = beginX;
-                    float endY = beginY;
-                    int beginAlpha = 0;
-                    String[] alphaArr = textArr[2].split("-");
-                    if (alphaArr.length > 0) {
-                        beginAlpha = (int) (AlphaValue.MAX * parseFloat(alphaArr[0]));
-
-                    }
-                    int endAlpha = beginAlpha;
-                    if (alphaArr.length > 1) {
-                        endAlpha = (int) (AlphaValue.MAX * parseFloat(alphaArr[1]));
-                    }
-                    long alphaDuraion = (long) (parseFloat(textArr[3]) * 1000);
-                    long translationDuration = alphaDuraion;
-                    long translationStartDelay = 0;
-                    float rotateY = 0, rotateZ = 0;
-                    if (textArr.length >= 7) {
-                        rotateZ = parseFloat(textArr[5]);
-                        rotateY = parseFloat(textArr[6]);
-                    }
-                    if (textArr.length >= 11) {
-                        endX = parseFloat(textArr[7]);
-                        endY = parseFloat(textArr[8]);
-                        if (!"".equals(textArr[9])) {
-                            translationDuration = parseInteger(textArr[9]);
-                        }
-                        if (!"".equals(textArr[10])) {
-                            translationStartDelay = (long) (parseFloat(textArr[10]));
-                        }
-                    }
-                    if (isPercentageNumber(textArr[0])) {
-                        beginX *= DanmakuFactory.BILI_PLAYER_WIDTH;
-                    }
-                    if (isPercentageNumber(textArr[1])) {
-                        beginY *= DanmakuFactory.BILI_PLAYER_HEIGHT;
-                    }
-                    if (textArr.length >= 8 && isPercentageNumber(textArr[7])) {
-                        endX *= DanmakuFactory.BILI_PLAYER_WIDTH;
-                    }
-                    if (textArr.length >= 9 && isPercentageNumber(textArr[8])) {
-                        endY *= DanmakuFactory.BILI_PLAYER_HEIGHT;
-                    }
-                    item.duration = new Duration(alphaDuraion);
-                    item.rotationZ = rotateZ;
-                    item.rotationY = rotateY;
-                    mContext.mDanmakuFactory.fillTranslationData(item, beginX,
-                            beginY, endX, endY, translationDuration, translationStartDelay, mDispScaleX, mDispScaleY);
-                    mContext.mDanmakuFactory.fillAlphaData(item, beginAlpha, endAlpha, alphaDuraion);
-
-                    if (textArr.length >= 12) {
-                        // 是否有描边
-                        if (!TextUtils.isEmpty(textArr[11]) && TRUE_STRING.equalsIgnoreCase(textArr[11])) {
-                            item.textShadowColor = Color.TRANSPARENT;
-                        }
-                    }
-                    if (textArr.length >= 13) {
-                        //TODO 字体 textArr[12]
-                    }
-                    if (textArr.length >= 14) {
-                        // Linear.easeIn or Quadratic.easeOut
-                        ((SpecialDanmaku) item).isQuadraticEaseOut = ("0".equals(textArr[13]));
-                    }
-                    if (textArr.length >= 15) {
-                        // 路径数据
-                        if (!"".equals(textArr[14])) {
-                            String motionPathString = textArr[14].substring(1);
-                            if (!TextUtils.isEmpty(motionPathString)) {
-                                String[] pointStrArray = motionPathString.split("L");
-                                if (pointStrArray.length > 0) {
-                                    float[][] points = new float[pointStrArray.length][2];
-                                    for (int i = 0; i < pointStrArray.length; i++) {
-                                        String[] pointArray = pointStrArray[i].split(",");
-                                        if (pointArray.length >= 2) {
-                                            points[i][0] = parseFloat(pointArray[0]);
-                                            points[i][1] = parseFloat(pointArray[1]);
-                                        }
-                                    }
-                                    DanmakuFactory.fillLinePathData(item, points, mDispScaleX,
-                                            mDispScaleY);
-                                }
-                            }
-                        }
                     }
                 }
 
@@ -289,6 +190,116 @@ public class BiliDanmakuParser extends BaseDanmakuParser {
 
     }
 
+    /**
+     * 解析高级弹幕（type 7）的 JSON 数组内容并填充位移、透明度等数据
+     *
+     * @return 内容无效时返回 false，调用方应丢弃该弹幕
+     */
+    protected boolean fillSpecialData(BaseDanmaku item, String text) {
+        //text = text.substring(1, text.length() - 1);
+        String[] textArr = null;//text.split(",", -1);
+        try {
+            JSONArray jsonArray = new JSONArray(text);
+            textArr = new String[jsonArray.length()];
+            for (int i = 0; i < textArr.length; i++) {
+                textArr[i] = jsonArray.getString(i);
+            }
+        } catch (JSONException e) {
+            e.printStackTrace();
+        }
+
+        if (textArr == null || textArr.length < 5 || TextUtils.isEmpty(textArr[4])) {
+            return false;
+        }
+        DanmakuUtils.fillText(item, textArr[4]);
+        float beginX = parseFloat(textArr[0]);
+        float beginY = parseFloat(textArr[1]);
+        float endX = beginX;
+        float endY = beginY;
+        int beginAlpha = 0;
+        String[] alphaArr = textArr[2].split("-");
+        if (alphaArr.length > 0) {
+            beginAlpha = (int) (AlphaValue.MAX * parseFloat(alphaArr[0]));
+
+        }
+        int endAlpha = beginAlpha;
+        if (alphaArr.length > 1) {
+            endAlpha = (int) (AlphaValue.MAX * parseFloat(alphaArr[1]));
+        }
+        long alphaDuraion = (long) (parseFloat(textArr[3]) * 1000);
+        long translationDuration = alphaDuraion;
+        long translationStartDelay = 0;
+        float rotateY = 0, rotateZ = 0;
+        if (textArr.length >= 7) {
+            rotateZ = parseFloat(textArr[5]);
+            rotateY = parseFloat(textArr[6]);
+        }
+        if (textArr.length >= 11) {
+            endX = parseFloat(textArr[7]);
+            endY = parseFloat(textArr[8]);
+            if (!"".equals(textArr[9])) {
+                translationDuration = parseInteger(textArr[9]);
+            }
+            if (!"".equals(textArr[10])) {
+                translationStartDelay = (long) (parseFloat(textArr[10]));
+            }
+        }
+        if (isPercentageNumber(textArr[0])) {
+            beginX *= DanmakuFactory.BILI_PLAYER_WIDTH;
+        }
+        if (isPercentageNumber(textArr[1])) {
+            beginY *= DanmakuFactory.BILI_PLAYER_HEIGHT;
+        }
+        if (textArr.length >= 8 && isPercentageNumber(textArr[7])) {
+            endX *= DanmakuFactory.BILI_PLAYER_WIDTH;
+        }
+        if (textArr.length >= 9 && isPercentageNumber(textArr[8])) {
+            endY *= DanmakuFactory.BILI_PLAYER_HEIGHT;
+        }
+        item.duration = new Duration(alphaDuraion);
+        item.rotationZ = rotateZ;
+        item.rotationY = rotateY;
+        mContext.mDanmakuFactory.fillTranslationData(item, beginX,
+                beginY, endX, endY, translationDuration, translationStartDelay, mDispScaleX, mDispScaleY);
+        mContext.mDanmakuFactory.fillAlphaData(item, beginAlpha, endAlpha, alphaDuraion);
+
+        if (textArr.length >= 12) {
+            // 是否有描边
+            if (!TextUtils.isEmpty(textArr[11]) && TRUE_STRING.equalsIgnoreCase(textArr[11])) {
+                item.textShadowColor = Color.TRANSPARENT;
+            }
+        }
+        if (textArr.length >= 13) {
+            //TODO 字体 textArr[12]
+        }
+        if (textArr.length >= 14) {
+            // Linear.easeIn or Quadratic.easeOut
+            ((SpecialDanmaku) item).isQuadraticEaseOut = ("0".equals(textArr[13]));
+        }
+        if (textArr.length >= 15) {
+            // 路径数据
+            if (!"".equals(textArr[14])) {
+                String motionPathString = textArr[14].substring(1);
+                if (!TextUtils.isEmpty(motionPathString)) {
+                    String[] pointStrArray = motionPathString.split("L");
+                    if (pointStrArray.length > 0) {
+                        float[][] points = new float[pointStrArray.length][2];
+                        for (int i = 0; i < pointStrArray.length; i++) {
+                            String[] pointArray = pointStrArray[i].split(",");
+                            if (pointArray.length >= 2) {
+                                points[i][0] = parseFloat(pointArray[0]);
+                                points[i][1] = parseFloat(pointArray[1]);
+                            }
+                        }
+                        DanmakuFactory.fillLinePathData(item, points, mDispScaleX,
+                                mDispScaleY);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
     private boolean isPercentageNumber(String number) {
         //return number >= 0f && number <= 1f;
         return number != null && number.contains(".");
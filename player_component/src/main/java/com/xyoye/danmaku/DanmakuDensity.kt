@@ -0,0 +1,134 @@
+package com.xyoye.danmaku
+
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 弹幕密度时间轴与高能时刻索引（布局见 danmaku_density.h），供进度条热度条与跳转高能时刻使用
+ *
+ * 由 danmaku_bridge 按秒统计弹幕数与含热词的弹幕数，平滑后取峰值作为高能时刻；
+ * 结果保存在弹幕库的解析缓存（[DanmakuStore.parse] 的 cacheFile）中，弹幕文件或热词变化后自动重建。
+ * 索引只有每秒十几个字节，加载后复制到 JVM 持有的直接缓冲区，不依赖 [DanmakuStore] 的生命周期。
+ */
+class DanmakuDensity internal constructor(
+    buffer: ByteBuffer
+) {
+    private val view: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+
+    /**
+     * 统计的秒数，最后一条弹幕所在的秒为 seconds - 1
+     */
+    val seconds: Int
+
+    val peakCount: Int
+
+    /**
+     * [heat] 的最大值，用于热度条归一化
+     */
+    val maxHeat: Float
+
+    val maxCount: Int
+
+    private val countOffset = HEADER_BYTES
+    private val taggedOffset: Int
+    private val heatOffset: Int
+    private val peakSecondOffset: Int
+    private val peakHeatOffset: Int
+
+    init {
+        require(view.capacity() >= HEADER_BYTES && view.getInt(0) == MAGIC && view.getInt(4) == VERSION) {
+            "not a danmaku density index"
+        }
+        seconds = view.getInt(8)
+        peakCount = view.getInt(12)
+        maxHeat = view.getFloat(24)
+        maxCount = view.getInt(28)
+        val expectedBytes = HEADER_BYTES + seconds * 12L + peakCount * 8L
+        require(seconds >= 0 && peakCount >= 0 && expectedBytes == view.capacity().toLong()) {
+            "truncated danmaku density index"
+        }
+        taggedOffset = countOffset + seconds * 4
+        heatOffset = taggedOffset + seconds * 4
+        peakSecondOffset = heatOffset + seconds * 4
+        peakHeatOffset = peakSecondOffset + peakCount * 4
+    }
+
+    /**
+     * 只读视图，UI 可直接按 danmaku_density.h 的布局批量读取
+     */
+    val buffer: ByteBuffer
+        get() = view.asReadOnlyBuffer().order(ByteOrder.LITTLE_ENDIAN)
+
+    /**
+     * 第 [second] 秒内出现的弹幕数
+     */
+    fun count(second: Int): Int = view.getInt(countOffset + second * 4)
+
+    /**
+     * 第 [second] 秒内含热词的弹幕数
+     */
+    fun tagged(second: Int): Int = view.getInt(taggedOffset + second * 4)
+
+    /**
+     * 平滑后的热度，含热词的弹幕权重更高
+     */
+    fun heat(second: Int): Float = view.getFloat(heatOffset + second * 4)
+
+    /**
+     * 第 [index] 个高能时刻所在的秒，按时间升序
+     */
+    fun peakSecond(index: Int): Int = view.getInt(peakSecondOffset + index * 4)
+
+    fun peakHeat(index: Int): Float = view.getFloat(peakHeatOffset + index * 4)
+
+    /**
+     * [positionMs] 之后最近的高能时刻（毫秒），没有时返回 null
+     */
+    fun nextPeakMs(positionMs: Long): Long? {
+        for (index in 0 until peakCount) {
+            val peakMs = peakSecond(index) * 1000L
+            if (peakMs > positionMs) return peakMs
+        }
+        return null
+    }
+
+    companion object {
+        // 与 danmaku_density.h 中的 kDensityMagic / kDensityVersion / kDensityHeaderBytes 保持一致
+        private const val MAGIC = 0x49444444 // "DDDI"
+        private const val VERSION = 1
+        private const val HEADER_BYTES = 32
+
+        val DEFAULT_HOT_KEYWORDS = listOf("高能", "名场面", "泪目", "哈哈哈", "awsl", "卧槽", "燃起来了")
+
+        /**
+         * 读取或构建 [store] 的密度索引；[source] 为弹幕文件，用于判断缓存是否过期，为 null 时不缓存。
+         * 原生库不可用或 store 不是原生解析的时返回 null。
+         */
+        fun load(
+            store: DanmakuStore,
+            source: File?,
+            keywords: List<String> = DEFAULT_HOT_KEYWORDS
+        ): DanmakuDensity? {
+            val handle = store.nativeHandle
+            if (handle == 0L || !DanmakuStore.isNativeAvailable) return null
+            val native =
+                nativeLoad(
+                    handle,
+                    source?.absolutePath.orEmpty(),
+                    keywords.filter { it.isNotEmpty() }.toTypedArray(),
+                ) ?: return null
+            val copy = ByteBuffer.allocateDirect(native.capacity())
+            copy.put(native)
+            copy.flip()
+            return runCatching { DanmakuDensity(copy) }.getOrNull()
+        }
+
+        @JvmStatic
+        private external fun nativeLoad(
+            store: Long,
+            sourcePath: String,
+            keywords: Array<String>
+        ): ByteBuffer?
+    }
+}
@@ -0,0 +1,188 @@
+package com.xyoye.danmaku
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 整条时间轴的弹幕车道布局，由 danmaku_bridge 预先计算（见 danmaku_layout.h）
+ *
+ * 每条弹幕对应一行 [ROW_BYTES] 字节的放置结果（车道、y、宽高、时长与标记），下标与
+ * [DanmakuStore] 一致，通过直接 [ByteBuffer] 原地读取。时间轴按分钟切成窗口并行布局，
+ * 结果与逐条顺序分配完全一致；尺寸或屏蔽列表变化后只把窗口标记为过期，
+ * 由 [ensure] 按播放位置重新计算需要的窗口。
+ *
+ * 布局属于 [DanmakuStore] 的原生句柄，store 关闭后不可再使用。非线程安全。
+ */
+class DanmakuLayout internal constructor(
+    buffer: ByteBuffer,
+    private val storeHandle: Long = 0L
+) {
+    /**
+     * 字体每像素字号的字宽：[ascii] 为 U+0020..U+007E 共 95 个字符，[wide] 用于中日韩等全角字符，
+     * [other] 用于其余字符，[line] 为行高（descent - ascent）
+     */
+    class FontMetrics(
+        val ascii: FloatArray,
+        val wide: Float,
+        val other: Float,
+        val line: Float
+    ) {
+        init {
+            require(ascii.size == ASCII_COUNT) { "ascii advances must cover U+0020..U+007E" }
+        }
+    }
+
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+
+    /**
+     * 设置屏幕与字体参数，全部窗口随之过期
+     */
+    fun configure(
+        width: Int,
+        height: Int,
+        textScale: Float,
+        strokeWidth: Float,
+        laneHeight: Float,
+        scrollDurationMs: Int,
+        fixedDurationMs: Int,
+        metrics: FontMetrics
+    ): Boolean {
+        if (storeHandle == 0L) return false
+        return nativeConfigure(
+            storeHandle,
+            width,
+            height,
+            textScale,
+            strokeWidth,
+            laneHeight,
+            scrollDurationMs,
+            fixedDurationMs,
+            metrics.ascii,
+            metrics.wide,
+            metrics.other,
+            metrics.line,
+        )
+    }
+
+    /**
+     * 被屏蔽的弹幕不占车道；[mask] 每位对应一条弹幕（第 i 条在 mask[i / 64] 的第 i % 64 位），
+     * 为 null 时全部显示。全部窗口随之过期。
+     */
+    fun setHidden(mask: LongArray?) {
+        if (storeHandle != 0L) nativeSetHidden(storeHandle, mask)
+    }
+
+    /**
+     * 按 store 最近一次 [DanmakuMerge] 的结果折叠重复弹幕（被合并的不占车道，保留的一条按加上后缀的宽度布局），
+     * [merged] 为 false 时不折叠。全部窗口随之过期。
+     */
+    fun setMerged(merged: Boolean) {
+        if (storeHandle != 0L) nativeSetMerged(storeHandle, merged)
+    }
+
+    /**
+     * 计算全部过期窗口，[threads] 不大于 0 时按核心数选择
+     */
+    fun layoutAll(threads: Int = 0) {
+        if (storeHandle != 0L) nativeLayoutAll(storeHandle, threads)
+    }
+
+    /**
+     * 在调用线程计算与 [fromMs, toMs) 重叠的过期窗口，返回计算的窗口数
+     */
+    fun ensure(
+        fromMs: Long,
+        toMs: Long
+    ): Int = if (storeHandle != 0L) nativeLayout(storeHandle, fromMs, toMs) else 0
+
+    fun isLaidOut(index: Int): Boolean = (flags(index) and FLAG_LAID_OUT) != 0
+
+    fun isPlaced(index: Int): Boolean = (flags(index) and FLAG_PLACED) != 0
+
+    fun isHidden(index: Int): Boolean = (flags(index) and FLAG_HIDDEN) != 0
+
+    fun isFolded(index: Int): Boolean = (flags(index) and FLAG_FOLDED) != 0
+
+    /**
+     * 弹幕顶端的屏幕 y（像素）
+     */
+    fun y(index: Int): Float = buffer.getFloat(index * ROW_BYTES)
+
+    fun width(index: Int): Float = buffer.getFloat(index * ROW_BYTES + 4)
+
+    fun height(index: Int): Float = buffer.getFloat(index * ROW_BYTES + 8)
+
+    fun durationMs(index: Int): Int = buffer.getInt(index * ROW_BYTES + 12)
+
+    /**
+     * 未放置时为 -1
+     */
+    fun lane(index: Int): Int = buffer.getShort(index * ROW_BYTES + 16).toInt()
+
+    private fun flags(index: Int): Int = buffer.get(index * ROW_BYTES + 18).toInt() and 0xFF
+
+    companion object {
+        // 与 danmaku::Placement 保持一致
+        const val ROW_BYTES = 20
+        private const val FLAG_LAID_OUT = 1
+        private const val FLAG_PLACED = 2
+        private const val FLAG_HIDDEN = 4
+        private const val FLAG_FOLDED = 8
+
+        const val ASCII_COUNT = 95
+
+        /**
+         * 原生库不可用或 store 不是原生解析的（例如包装普通缓冲区）时返回 null
+         */
+        fun of(store: DanmakuStore): DanmakuLayout? {
+            val handle = store.nativeHandle
+            if (handle == 0L || !DanmakuStore.isNativeAvailable || store.count == 0) return null
+            val buffer = nativeBuffer(handle) ?: return null
+            return DanmakuLayout(buffer, handle)
+        }
+
+        @JvmStatic
+        private external fun nativeConfigure(
+            store: Long,
+            width: Int,
+            height: Int,
+            textScale: Float,
+            strokeWidth: Float,
+            laneHeight: Float,
+            scrollDurationMs: Int,
+            fixedDurationMs: Int,
+            ascii: FloatArray,
+            wide: Float,
+            other: Float,
+            line: Float
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeSetHidden(
+            store: Long,
+            mask: LongArray?
+        )
+
+        @JvmStatic
+        private external fun nativeSetMerged(
+            store: Long,
+            merged: Boolean
+        )
+
+        @JvmStatic
+        private external fun nativeLayoutAll(
+            store: Long,
+            threads: Int
+        )
+
+        @JvmStatic
+        private external fun nativeLayout(
+            store: Long,
+            fromMs: Long,
+            toMs: Long
+        ): Int
+
+        @JvmStatic
+        private external fun nativeBuffer(store: Long): ByteBuffer?
+    }
+}
@@ -0,0 +1,84 @@
+package com.xyoye.danmaku
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 重复弹幕合并结果（见 danmaku_merge.h），下标与 [DanmakuStore] 一致
+ *
+ * 文本归一化（全角转半角、忽略大小写与空白、连续重复字符折叠）后相同或相近（字符二元组 Jaccard 相似度）
+ * 且在 [Options.windowMs] 内出现的弹幕合并为第一条，显示为“原文 +N”。
+ * 结果由 danmaku_bridge 在一次遍历中算出，通过直接 [ByteBuffer] 原地读取。
+ *
+ * 结果属于 [DanmakuStore] 的原生句柄：store 关闭或再次合并后不可再使用。非线程安全。
+ */
+class DanmakuMerge internal constructor(
+    buffer: ByteBuffer
+) {
+    data class Options(
+        // 与组内第一条弹幕的时间差不超过该值才合并
+        val windowMs: Int = 10_000,
+        // 连续相同字符保留的个数（“233333”视为“23”），0 表示不折叠
+        val maxRun: Int = 1,
+        val foldWidth: Boolean = true,
+        // 近似重复的最小相似度，不大于 0 时只合并归一化后完全相同的弹幕
+        val fuzzyMinSimilarity: Float = 0.6f,
+        // 参与近似匹配的最短归一化长度
+        val fuzzyMinLength: Int = 6
+    )
+
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+
+    /**
+     * 第 [index] 条弹幕所在组的大小；0 表示已合并进更早的弹幕
+     */
+    fun count(index: Int): Int = buffer.getShort(index * 2).toInt() and 0xFFFF
+
+    fun isFolded(index: Int): Boolean = count(index) == 0
+
+    /**
+     * 绘制时追加在原文后的后缀，与 danmaku::LayoutEngine 测量宽度时使用的一致
+     */
+    fun suffix(index: Int): String {
+        val count = count(index)
+        return if (count > 1) " +${count - 1}" else ""
+    }
+
+    companion object {
+        /**
+         * [excluded] 中置位的弹幕（被屏蔽的，格式同 [DanmakuLayout.setHidden]）不参与合并，
+         * 既不作为组内第一条，也不计入其他组的数量。
+         * 原生库不可用或 store 不是原生解析的时返回 null
+         */
+        fun of(
+            store: DanmakuStore,
+            options: Options = Options(),
+            excluded: LongArray? = null
+        ): DanmakuMerge? {
+            val handle = store.nativeHandle
+            if (handle == 0L || !DanmakuStore.isNativeAvailable || store.count == 0) return null
+            val buffer =
+                nativeMerge(
+                    handle,
+                    options.windowMs,
+                    options.maxRun,
+                    options.foldWidth,
+                    options.fuzzyMinSimilarity,
+                    options.fuzzyMinLength,
+                    excluded,
+                ) ?: return null
+            return DanmakuMerge(buffer)
+        }
+
+        @JvmStatic
+        private external fun nativeMerge(
+            store: Long,
+            windowMs: Int,
+            maxRun: Int,
+            foldWidth: Boolean,
+            fuzzyMinSimilarity: Float,
+            fuzzyMinLength: Int,
+            excluded: LongArray?
+        ): ByteBuffer?
+    }
+}
@@ -0,0 +1,173 @@
+package com.xyoye.danmaku
+
+import android.util.Log
+import com.xyoye.common_component.utils.CacheKeyMapper
+import com.xyoye.common_component.utils.PathHelper
+import java.io.Closeable
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Columnar danmaku store parsed by danmaku_bridge (layout documented in danmaku_store.h)
+ * and read in place through a direct [ByteBuffer]: loading a track allocates nothing per
+ * comment until a caller asks for it. Comments are sorted by time.
+ *
+ * [close] frees the native block, the store must not be read afterwards. Not thread-safe.
+ */
+class DanmakuStore internal constructor(
+    buffer: ByteBuffer,
+    private var handle: Long = 0L
+) : Closeable {
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+    private var textScratch = ByteArray(64)
+
+    val count: Int
+
+    /**
+     * Native store handle for batch passes in danmaku_bridge; 0 for stores wrapping a plain buffer.
+     */
+    internal val nativeHandle: Long
+        get() = handle
+
+    private val timeOffset: Int
+    private val colorOffset: Int
+    private val textOffsetOffset: Int
+    private val textLengthOffset: Int
+    private val modeOffset: Int
+    private val sizeOffset: Int
+    private val arenaOffset: Int
+
+    init {
+        val view = this.buffer
+        require(view.capacity() >= HEADER_BYTES && view.getInt(0) == MAGIC && view.getInt(4) == VERSION) {
+            "not a danmaku store"
+        }
+        count = view.getInt(8)
+        timeOffset = view.getInt(16)
+        colorOffset = view.getInt(20)
+        textOffsetOffset = view.getInt(24)
+        textLengthOffset = view.getInt(28)
+        modeOffset = view.getInt(32)
+        sizeOffset = view.getInt(36)
+        arenaOffset = view.getInt(40)
+        require(count >= 0 && view.getInt(44) <= view.capacity() && arenaOffset + view.getInt(12) <= view.capacity()) {
+            "truncated danmaku store"
+        }
+    }
+
+    fun timeMs(index: Int): Long = buffer.getInt(timeOffset + index * 4).toLong()
+
+    /**
+     * 0xRRGGBB as written in the source, without alpha.
+     */
+    fun color(index: Int): Int = buffer.getInt(colorOffset + index * 4)
+
+    fun mode(index: Int): Int = buffer.get(modeOffset + index).toInt() and 0xFF
+
+    fun size(index: Int): Int = buffer.get(sizeOffset + index).toInt() and 0xFF
+
+    fun textLength(index: Int): Int = buffer.getInt(textLengthOffset + index * 4)
+
+    fun text(index: Int): String {
+        val length = textLength(index)
+        if (textScratch.size < length) {
+            textScratch = ByteArray(maxOf(length, textScratch.size * 2))
+        }
+        val start = arenaOffset + buffer.getInt(textOffsetOffset + index * 4)
+        buffer.position(start)
+        buffer.get(textScratch, 0, length)
+        return String(textScratch, 0, length, Charsets.UTF_8)
+    }
+
+    override fun close() {
+        val current = handle
+        if (current == 0L) return
+        handle = 0L
+        nativeRelease(current)
+    }
+
+    companion object {
+        private const val TAG = "DanmakuStore"
+
+        // Keep in sync with kStoreMagic / kStoreVersion / kStoreHeaderBytes in danmaku_store.h.
+        private const val MAGIC = 0x53434444 // "DDCS"
+        private const val VERSION = 1
+        private const val HEADER_BYTES = 48
+
+        // Values of danmaku::SourceFormat.
+        const val FORMAT_AUTO = 0
+        const val FORMAT_XML = 1
+        const val FORMAT_JSON = 2
+
+        // Binary cache (danmaku_cache.h), kept in the app's danmaku parse cache directory by default.
+        const val CACHE_SUFFIX = ".ddcache"
+
+        val isNativeAvailable: Boolean
+            get() = NativeLibrary.loaded
+
+        /**
+         * Returns null when the native parser is unavailable or the file cannot be parsed,
+         * so callers fall back to [BiliDanmakuParser].
+         *
+         * With a [cacheFile] the store is mapped from it when it still matches [file] (same size
+         * and mtime, or same content), skipping the parse; otherwise the file is parsed and the
+         * cache rewritten. Block masks, layout and density index computed for the store are kept
+         * in the same cache and written back on [close]. Pass null to always parse.
+         */
+        fun parse(
+            file: File,
+            format: Int = FORMAT_AUTO,
+            cacheFile: File? = defaultCacheFile(file)
+        ): DanmakuStore? {
+            if (!NativeLibrary.loaded || !file.isFile) return null
+            val handle = nativeParse(file.absolutePath, format, cacheFile?.absolutePath.orEmpty())
+            if (handle == 0L) return null
+            val buffer = nativeBuffer(handle)
+            if (buffer == null) {
+                nativeRelease(handle)
+                return null
+            }
+            return runCatching { DanmakuStore(buffer, handle) }
+                .onFailure { nativeRelease(handle) }
+                .getOrNull()
+        }
+
+        /**
+         * Cache file for [file] under [PathHelper.getDanmuParseCacheDirectory], named after its path,
+         * so nothing is written next to danmaku files in shared storage. Null when the app cache
+         * directory is unavailable.
+         */
+        fun defaultCacheFile(file: File): File? =
+            runCatching {
+                val name = CacheKeyMapper.toSafeFileName(file.absolutePath) + CACHE_SUFFIX
+                File(PathHelper.getDanmuParseCacheDirectory(), name)
+            }.getOrNull()
+
+        @JvmStatic
+        private external fun nativeParse(
+            path: String,
+            format: Int,
+            cachePath: String
+        ): Long
+
+        @JvmStatic
+        private external fun nativeBuffer(handle: Long): ByteBuffer?
+
+        @JvmStatic
+        private external fun nativeRelease(handle: Long)
+    }
+
+    // Loaded on first parse rather than with the class, so stores wrapping a plain buffer
+    // (cache files, tests) never touch the library.
+    private object NativeLibrary {
+        val loaded: Boolean =
+            try {
+                System.loadLibrary("danmaku_bridge")
+                true
+            } catch (e: UnsatisfiedLinkError) {
+                Log.e(TAG, "Failed to load danmaku_bridge: ${e.message}")
+                false
+            }
+    }
+}
@@ -0,0 +1,72 @@
+package com.xyoye.danmaku
+
+import android.graphics.Color
+import com.xyoye.danmaku.filter.DanmakuBlockIndex
+import master.flame.danmaku.danmaku.model.BaseDanmaku
+import master.flame.danmaku.danmaku.model.IDanmakus.ST_BY_TIME
+import master.flame.danmaku.danmaku.model.android.Danmakus
+import master.flame.danmaku.danmaku.util.DanmakuUtils
+import java.io.File
+
+/**
+ * 通过原生解析器（danmaku_bridge）读取弹幕文件，不可用或解析失败时回退到 SAX 解析
+ *
+ * 解析得到的弹幕库交给 [blockIndex] 持有，用于屏蔽列表的批量匹配。
+ * [mergeOptions] 不为 null 时按 [DanmakuMerge] 折叠重复弹幕：被合并的不创建弹幕对象，保留的一条显示为“原文 +N”，
+ * 与 GPU 图层的合并方式一致。合并在屏蔽列表匹配之后进行，被屏蔽的弹幕不参与合并。
+ * [onStoreParsed] 返回 true 表示弹幕库由其他渲染器绘制，此时不再为 DanmakuFlameMaster 创建弹幕对象。
+ */
+class NativeDanmakuParser(
+    private val danmuFile: File,
+    private val blockIndex: DanmakuBlockIndex,
+    private val mergeOptions: DanmakuMerge.Options? = null,
+    private val onStoreParsed: (DanmakuStore) -> Boolean = { false }
+) : BiliDanmakuParser() {
+    override fun parse(): Danmakus? {
+        val store = DanmakuStore.parse(danmuFile) ?: return super.parse()
+        if (onStoreParsed(store)) {
+            blockIndex.attach(store, emptyArray())
+            return Danmakus(ST_BY_TIME, false, mContext.baseComparator)
+        }
+        // 先关联弹幕库，合并时才能取得屏蔽结果；rows 在创建弹幕对象时填入
+        val rows = arrayOfNulls<BaseDanmaku>(store.count)
+        blockIndex.attach(store, rows)
+        return buildDanmakus(store, rows)
+    }
+
+    private fun buildDanmakus(
+        store: DanmakuStore,
+        rows: Array<BaseDanmaku?>
+    ): Danmakus {
+        val result = Danmakus(ST_BY_TIME, false, mContext.baseComparator)
+        val merge = mergeOptions?.let { DanmakuMerge.of(store, it, blockIndex.blockedMask()) }
+        for (index in 0 until store.count) {
+            if (merge?.isFolded(index) == true) continue
+            val item = mContext.mDanmakuFactory.createDanmaku(store.mode(index), mContext) ?: continue
+            val color = store.color(index) or 0xFF000000.toInt()
+            item.time = store.timeMs(index)
+            item.textSize = store.size(index) * (mDispDensity - 0.6f)
+            item.textColor = color
+            item.textShadowColor = if (color <= Color.BLACK) Color.WHITE else Color.BLACK
+            item.index = index
+
+            val text = store.text(index)
+            // 高级弹幕不参与合并，后缀为空
+            DanmakuUtils.fillText(item, text + merge?.suffix(index).orEmpty())
+            if (item.type == BaseDanmaku.TYPE_SPECIAL) {
+                val trimmed = text.trim()
+                if (!trimmed.startsWith("[") || !trimmed.endsWith("]") || !fillSpecialData(item, trimmed)) {
+                    continue
+                }
+            }
+            if (item.duration == null) {
+                continue
+            }
+            item.setTimer(mTimer)
+            item.flags = mContext.mGlobalFlagValues
+            result.addItem(item)
+            rows[index] = item
+        }
+        return result
+    }
+}
@@ -0,0 +1,139 @@
+package com.xyoye.danmaku.filter
+
+import com.xyoye.danmaku.DanmakuStore
+import master.flame.danmaku.danmaku.model.BaseDanmaku
+
+/**
+ * 弹幕屏蔽列表及其在已加载弹幕库上的匹配结果，由 [KeywordFilter] 与 [RegexFilter] 共享
+ *
+ * 屏蔽列表变化后，首次过滤时重建 [DanmakuBlockMatcher] 并对整个弹幕库批量匹配一次，
+ * 之后按弹幕下标直接查表；不属于弹幕库的弹幕（直播、发送的弹幕）逐条匹配。
+ * 过滤在弹幕绘制线程中调用，列表修改在主线程中调用。
+ */
+class DanmakuBlockIndex {
+    private class Snapshot(
+        val matcher: DanmakuBlockMatcher,
+        val rows: Array<BaseDanmaku?>,
+        val results: ByteArray?
+    )
+
+    private val lock = Any()
+    private val keywords = LinkedHashSet<String>()
+    private val regexes = LinkedHashSet<String>()
+
+    private var store: DanmakuStore? = null
+    private var rows: Array<BaseDanmaku?> = emptyArray()
+
+    // 屏蔽列表变化时置空，下次过滤时重建
+    private var matcher: DanmakuBlockMatcher? = null
+
+    @Volatile
+    private var snapshot: Snapshot? = null
+
+    fun addKeyword(keyword: String) =
+        synchronized(lock) {
+            if (keywords.add(keyword)) invalidateRules()
+        }
+
+    fun removeKeyword(keyword: String) =
+        synchronized(lock) {
+            if (keywords.remove(keyword)) invalidateRules()
+        }
+
+    fun clearKeywords() =
+        synchronized(lock) {
+            if (keywords.isNotEmpty()) {
+                keywords.clear()
+                invalidateRules()
+            }
+        }
+
+    fun addRegex(regex: String) =
+        synchronized(lock) {
+            if (regexes.add(regex)) invalidateRules()
+        }
+
+    fun removeRegex(regex: String) =
+        synchronized(lock) {
+            if (regexes.remove(regex)) invalidateRules()
+        }
+
+    fun clearRegexes() =
+        synchronized(lock) {
+            if (regexes.isNotEmpty()) {
+                regexes.clear()
+                invalidateRules()
+            }
+        }
+
+    /**
+     * 关联新加载的弹幕库，[rows] 为弹幕库下标对应的弹幕对象（被丢弃的为 null）
+     *
+     * 弹幕库由本对象持有，在下一次 [attach] 或 [detach] 时关闭。
+     */
+    fun attach(
+        store: DanmakuStore,
+        rows: Array<BaseDanmaku?>
+    ) = synchronized(lock) {
+        this.store?.close()
+        this.store = store
+        this.rows = rows
+        snapshot = null
+    }
+
+    fun detach() =
+        synchronized(lock) {
+            store?.close()
+            store = null
+            rows = emptyArray()
+            snapshot = null
+        }
+
+    /**
+     * 返回 [DanmakuBlockMatcher.MATCH_KEYWORD]、[DanmakuBlockMatcher.MATCH_REGEX] 或 0
+     */
+    fun match(danmaku: BaseDanmaku): Int {
+        val current = snapshot ?: rebuild()
+        val results = current.results
+        val row = danmaku.index
+        if (results != null && row in current.rows.indices && current.rows[row] === danmaku) {
+            return results[row].toInt()
+        }
+        val text = danmaku.text ?: return 0
+        return current.matcher.match(text.toString())
+    }
+
+    /**
+     * 弹幕库第 [row] 条是否被屏蔽，供不经过 DanmakuFlameMaster 过滤器的绘制路径使用
+     */
+    fun isBlocked(row: Int): Boolean {
+        val results = (snapshot ?: rebuild()).results ?: return false
+        return row in results.indices && results[row].toInt() != 0
+    }
+
+    /**
+     * 弹幕库中被屏蔽的弹幕，每位对应一条（格式同 [com.xyoye.danmaku.DanmakuLayout.setHidden]）；没有时返回 null
+     */
+    fun blockedMask(): LongArray? {
+        val results = (snapshot ?: rebuild()).results ?: return null
+        val mask = LongArray((results.size + 63) ushr 6)
+        for (row in results.indices) {
+            if (results[row].toInt() != 0) mask[row ushr 6] = mask[row ushr 6] or (1L shl (row and 63))
+        }
+        return if (mask.any { it != 0L }) mask else null
+    }
+
+    private fun rebuild(): Snapshot =
+        synchronized(lock) {
+            snapshot?.let { return it }
+            val compiled = matcher ?: DanmakuBlockMatcher(keywords, regexes).also { matcher = it }
+            val results = store?.let { compiled.scan(it) }
+            Snapshot(compiled, rows, results).also { snapshot = it }
+        }
+
+    private fun invalidateRules() {
+        matcher?.close()
+        matcher = null
+        snapshot = null
+    }
+}
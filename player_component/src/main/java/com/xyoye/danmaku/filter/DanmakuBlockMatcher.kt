@@ -0,0 +1,149 @@
+package com.xyoye.danmaku.filter
+
+import com.xyoye.danmaku.DanmakuStore
+import java.io.Closeable
+import java.util.regex.Pattern
+import java.util.regex.PatternSyntaxException
+
+/**
+ * 编译后的弹幕屏蔽规则，屏蔽列表变化时整体重建
+ *
+ * 关键字编译为原生 Aho-Corasick 自动机（danmaku_filter.h），一次扫描即可判断全部关键字；
+ * 正则在构造时编译一次，并以 [RegexRequiredLiteral] 提取的字面量在原生侧预筛，
+ * 只有命中字面量（或无法提取字面量）的弹幕才交给 java.util.regex 做完整匹配。
+ * 原生库不可用时退化为纯 Java 匹配，结果一致。
+ */
+class DanmakuBlockMatcher(
+    keywords: Collection<String>,
+    regexes: Collection<String>,
+    useNative: Boolean = DanmakuStore.isNativeAvailable
+) : Closeable {
+    private class CompiledRegex(
+        val pattern: Pattern,
+        val literal: String?
+    )
+
+    private val keywords: List<String> = keywords.filter { it.isNotEmpty() }
+
+    // 无法编译的正则不参与匹配，与原 RegexFilter 捕获异常后视为不匹配一致
+    private val regexes: List<CompiledRegex> =
+        regexes.mapNotNull { regex ->
+            try {
+                CompiledRegex(Pattern.compile(regex), RegexRequiredLiteral.of(regex))
+            } catch (e: PatternSyntaxException) {
+                null
+            }
+        }
+
+    private val hasLiteralFreeRegex = this.regexes.any { it.literal == null }
+
+    private var handle: Long =
+        if (useNative && (this.keywords.isNotEmpty() || this.regexes.isNotEmpty())) {
+            nativeCreate(
+                this.keywords.toTypedArray(),
+                this.regexes.mapNotNull { it.literal }.toTypedArray(),
+            )
+        } else {
+            0L
+        }
+
+    val isEmpty: Boolean
+        get() = keywords.isEmpty() && regexes.isEmpty()
+
+    /**
+     * 单条弹幕匹配，返回 [MATCH_KEYWORD]、[MATCH_REGEX] 或 0
+     */
+    fun match(text: String): Int {
+        if (isEmpty) return 0
+        val flags = synchronized(this) { if (handle != 0L) nativeMatch(handle, text) else -1 }
+        val literalHit =
+            if (flags >= 0) {
+                if ((flags and MATCH_KEYWORD) != 0) return MATCH_KEYWORD
+                (flags and NATIVE_MATCH_LITERAL) != 0
+            } else {
+                if (keywords.any { text.contains(it) }) return MATCH_KEYWORD
+                true
+            }
+        return if ((literalHit || hasLiteralFreeRegex) && matchesRegex(text)) MATCH_REGEX else 0
+    }
+
+    /**
+     * 批量匹配整个弹幕库，返回每条弹幕的匹配结果（下标与 [DanmakuStore] 一致）
+     *
+     * 原生库不可用时返回 null，调用方逐条使用 [match]。
+     */
+    fun scan(
+        store: DanmakuStore,
+        threads: Int = 0
+    ): ByteArray? {
+        val result = ByteArray(store.count)
+        if (isEmpty) return result
+        val words = (store.count + 63) ushr 6
+        val keywordMask = LongArray(words)
+        val literalMask = LongArray(words)
+        val scanned =
+            synchronized(this) {
+                handle != 0L && nativeScan(handle, store.nativeHandle, threads, keywordMask, literalMask)
+            }
+        if (!scanned) return null
+
+        for (index in 0 until store.count) {
+            val bit = 1L shl (index and 63)
+            if ((keywordMask[index ushr 6] and bit) != 0L) {
+                result[index] = MATCH_KEYWORD.toByte()
+            } else if (((literalMask[index ushr 6] and bit) != 0L || hasLiteralFreeRegex) &&
+                regexes.isNotEmpty() &&
+                matchesRegex(store.text(index))
+            ) {
+                result[index] = MATCH_REGEX.toByte()
+            }
+        }
+        return result
+    }
+
+    private fun matchesRegex(text: String): Boolean =
+        regexes.any { regex ->
+            (regex.literal == null || text.contains(regex.literal)) && regex.pattern.matcher(text).matches()
+        }
+
+    // 旧的匹配器可能仍在其他绘制线程中使用，原生调用与释放互斥
+    @Synchronized
+    override fun close() {
+        val current = handle
+        if (current == 0L) return
+        handle = 0L
+        nativeRelease(current)
+    }
+
+    companion object {
+        const val MATCH_KEYWORD = 1
+        const val MATCH_REGEX = 2
+
+        // 与 danmaku::BlockFilter::kMatchRegexLiteral 保持一致
+        private const val NATIVE_MATCH_LITERAL = 2
+
+        @JvmStatic
+        private external fun nativeCreate(
+            keywords: Array<String>,
+            regexLiterals: Array<String>
+        ): Long
+
+        @JvmStatic
+        private external fun nativeMatch(
+            handle: Long,
+            text: String
+        ): Int
+
+        @JvmStatic
+        private external fun nativeScan(
+            handle: Long,
+            store: Long,
+            threads: Int,
+            keywordMask: LongArray,
+            literalMask: LongArray
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeRelease(handle: Long)
+    }
+}
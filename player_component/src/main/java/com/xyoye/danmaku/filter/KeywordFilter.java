@@ -3,7 +3,6 @@ package com.xyoye.danmaku.filter;
 import com.xyoye.common_component.log.LogFacade;
 import com.xyoye.common_component.log.model.LogModule;
 
-import java.util.ArrayList;
 import java.util.Collections;
 import java.util.List;
 
@@ -18,20 +17,18 @@ import master.flame.danmaku.danmaku.model.android.DanmakuContext;
 
 public class KeywordFilter extends DanmakuFilters.BaseDanmakuFilter<List<String>> {
     private static final int FILTER_TYPE_KEYWORD = 1024;
-    private final List<String> mKeyWordList = new ArrayList<>();
+    private final DanmakuBlockIndex mBlockIndex;
+
+    public KeywordFilter(DanmakuBlockIndex blockIndex) {
+        mBlockIndex = blockIndex;
+    }
 
     @Override
     public boolean filter(BaseDanmaku danmaku, int index, int totalsizeInScreen, DanmakuTimer timer, boolean fromCachingTask, DanmakuContext config) {
-        boolean filtered = false;
-        for (int i = 0; i < mKeyWordList.size(); i++) {
-            String keyword = mKeyWordList.get(i);
-            String danmakuText = danmaku.text.toString();
-            if (danmakuText.contains(keyword)) {
-                logError(danmakuText);
-                filtered = true;
-                danmaku.mFilterParam |= FILTER_TYPE_KEYWORD;
-                break;
-            }
+        boolean filtered = mBlockIndex.match(danmaku) == DanmakuBlockMatcher.MATCH_KEYWORD;
+        if (filtered) {
+            logError(danmaku.text.toString());
+            danmaku.mFilterParam |= FILTER_TYPE_KEYWORD;
         }
         return filtered;
     }
@@ -48,16 +45,15 @@ public class KeywordFilter extends DanmakuFilters.BaseDanmakuFilter<List<String>
 
     @Override
     public void reset() {
-        mKeyWordList.clear();
+        mBlockIndex.clearKeywords();
     }
 
     public void addKeyword(String keyword) {
-        if (!mKeyWordList.contains(keyword)) {
-            mKeyWordList.add(keyword);
-        }
+        mBlockIndex.addKeyword(keyword);
     }
+
     public void removeKeyword(String keyword) {
-        mKeyWordList.remove(keyword);
+        mBlockIndex.removeKeyword(keyword);
     }
 
     private void logError(String message) {
@@ -3,10 +3,8 @@ package com.xyoye.danmaku.filter;
 import com.xyoye.common_component.log.LogFacade;
 import com.xyoye.common_component.log.model.LogModule;
 
-import java.util.ArrayList;
 import java.util.Collections;
 import java.util.List;
-import java.util.regex.Pattern;
 
 import master.flame.danmaku.controller.DanmakuFilters;
 import master.flame.danmaku.danmaku.model.BaseDanmaku;
@@ -19,25 +17,17 @@ import master.flame.danmaku.danmaku.model.android.DanmakuContext;
 
 public class RegexFilter extends DanmakuFilters.BaseDanmakuFilter<List<String>> {
     private static final int FILTER_TYPE_REGEX = 2048;
-    public final List<String> mRegexList = new ArrayList<>();
+    private final DanmakuBlockIndex mBlockIndex;
+
+    public RegexFilter(DanmakuBlockIndex blockIndex) {
+        mBlockIndex = blockIndex;
+    }
 
     @Override
     public boolean filter(BaseDanmaku danmaku, int index, int totalsizeInScreen, DanmakuTimer timer, boolean fromCachingTask, DanmakuContext config) {
-        boolean filtered = false;
-        for (int i = 0; i < mRegexList.size(); i++) {
-            String regex = mRegexList.get(i);
-
-            try {
-                filtered = Pattern.matches(regex, danmaku.text);
-            } catch (Exception e) {
-                e.printStackTrace();
-            }
-            if (filtered) {
-                logDebug(danmaku.text.toString());
-                break;
-            }
-        }
+        boolean filtered = mBlockIndex.match(danmaku) == DanmakuBlockMatcher.MATCH_REGEX;
         if (filtered) {
+            logDebug(danmaku.text.toString());
             danmaku.mFilterParam |= FILTER_TYPE_REGEX;
         }
         return filtered;
@@ -55,17 +45,15 @@ public class RegexFilter extends DanmakuFilters.BaseDanmakuFilter<List<String>>
 
     @Override
     public void reset() {
-        mRegexList.clear();
+        mBlockIndex.clearRegexes();
     }
 
     public void addRegex(String regex) {
-        if (!mRegexList.contains(regex)) {
-            mRegexList.add(regex);
-        }
+        mBlockIndex.addRegex(regex);
     }
 
     public void removeRegex(String regex) {
-        mRegexList.remove(regex);
+        mBlockIndex.removeRegex(regex);
     }
 
     private void logDebug(String message) {
@@ -0,0 +1,154 @@
+package com.xyoye.danmaku.filter
+
+/**
+ * 提取正则表达式完整匹配时必然出现的最长字面量，用于在原生侧预筛弹幕
+ *
+ * 只做保守分析：遇到分支、内联标志、\Q...\E 等无法确定的写法时返回 null，
+ * 此时该正则需要对每条弹幕执行。
+ */
+object RegexRequiredLiteral {
+    fun of(regex: String): String? {
+        var best = ""
+        val run = StringBuilder()
+        var depth = 0
+        var index = 0
+
+        fun endRun() {
+            if (run.length > best.length) {
+                best = run.toString()
+            }
+            run.setLength(0)
+        }
+
+        fun dropLastCodePoint() {
+            if (run.isEmpty()) return
+            val last = run.codePointBefore(run.length)
+            run.setLength(run.length - Character.charCount(last))
+        }
+
+        while (index < regex.length) {
+            val c = regex[index]
+            when {
+                c == '\\' -> {
+                    val next = regex.getOrNull(index + 1) ?: return null
+                    if (next == 'Q') return null
+                    if (depth == 0 && !next.isLetterOrDigit()) {
+                        run.append(next)
+                        index += 2
+                        continue
+                    }
+                    if (depth == 0) endRun()
+                    // 字母数字转义连同其参数（\x41、\u0041、\cA、\0101、\k<name>、\p{L}）一起跳过
+                    index = skipEscape(regex, index) ?: return null
+                    continue
+                }
+                c == '[' -> {
+                    if (depth == 0) endRun()
+                    index = skipCharClass(regex, index) ?: return null
+                    continue
+                }
+                c == '(' -> {
+                    if (regex.startsWith("(?", index) && !regex.startsWith("(?:", index)) return null
+                    if (depth == 0) endRun()
+                    depth++
+                }
+                c == ')' -> depth--
+                depth > 0 -> {}
+                c == '|' -> return null
+                c == '*' || c == '?' || c == '{' -> {
+                    // The preceding atom is optional
+                    dropLastCodePoint()
+                    endRun()
+                    index = skipQuantifier(regex, index)
+                    continue
+                }
+                c == '+' -> {
+                    endRun()
+                    index = skipQuantifier(regex, index)
+                    continue
+                }
+                c == '.' || c == '^' || c == '$' -> endRun()
+                else -> run.append(c)
+            }
+            index++
+        }
+        if (depth != 0) return null
+        endRun()
+        return best.ifEmpty { null }
+    }
+
+    // Index just past the letter or digit escape starting at [start], or null when malformed.
+    private fun skipEscape(
+        regex: String,
+        start: Int
+    ): Int? {
+        var index = start + 2
+        fun skipBraced(open: Char, close: Char): Int? {
+            if (regex.getOrNull(index) != open) return null
+            val end = regex.indexOf(close, index)
+            return if (end < 0) null else end + 1
+        }
+        return when (regex[start + 1]) {
+            'x' -> skipBraced('{', '}') ?: (index + 2).takeIf { it <= regex.length }
+            'u' -> (index + 4).takeIf { it <= regex.length }
+            'c' -> (index + 1).takeIf { it <= regex.length }
+            'k' -> skipBraced('<', '>')
+            'N' -> skipBraced('{', '}')
+            'p', 'P' -> skipBraced('{', '}') ?: (index + 1).takeIf { it <= regex.length }
+            '0' -> {
+                // Java 的八进制转义：\0n、\0nn、\0mnn（m 不大于 3）
+                val limit = if (regex.getOrNull(index)?.let { it in '0'..'3' } == true) 3 else 2
+                var digits = 0
+                while (digits < limit && regex.getOrNull(index)?.let { it in '0'..'7' } == true) {
+                    index++
+                    digits++
+                }
+                index
+            }
+            in '1'..'9' -> {
+                // 反向引用可以有多位组号
+                while (regex.getOrNull(index)?.isDigit() == true) index++
+                index
+            }
+            else -> index
+        }
+    }
+
+    // Index just past the character class starting at [start], or null when unterminated.
+    private fun skipCharClass(
+        regex: String,
+        start: Int
+    ): Int? {
+        var index = start + 1
+        if (regex.getOrNull(index) == '^') index++
+        if (regex.getOrNull(index) == ']') index++
+        var nested = 0
+        while (index < regex.length) {
+            when (regex[index]) {
+                '\\' -> index++
+                '[' -> nested++
+                ']' -> if (nested == 0) return index + 1 else nested--
+            }
+            index++
+        }
+        return null
+    }
+
+    // Index past a quantifier and its lazy/possessive suffix.
+    private fun skipQuantifier(
+        regex: String,
+        start: Int
+    ): Int {
+        var index = start
+        if (regex[index] == '{') {
+            val close = regex.indexOf('}', index)
+            index = if (close < 0) regex.length else close + 1
+        } else {
+            index++
+        }
+        if (index < regex.length && (regex[index] == '?' || regex[index] == '+')) {
+            index++
+        }
+        return index
+    }
+}
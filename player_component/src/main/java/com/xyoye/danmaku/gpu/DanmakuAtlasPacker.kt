@@ -0,0 +1,57 @@
+package com.xyoye.danmaku.gpu
+
+/**
+ * 弹幕图集页的行式（shelf）装箱
+ *
+ * 弹幕按时间顺序到达且高度相近，逐行从左到右放置，放不下时另起一行，行高取该行最高的矩形。
+ * 矩形之间保留 [padding] 像素，避免线性采样时相邻文字渗色。
+ */
+class DanmakuAtlasPacker(
+    val width: Int,
+    val height: Int,
+    private val padding: Int = 1
+) {
+    private var shelfY = 0
+    private var shelfHeight = 0
+    private var cursorX = 0
+
+    /**
+     * 最近一次 [place] 成功时矩形的左上角
+     */
+    var placedX = 0
+        private set
+    var placedY = 0
+        private set
+
+    fun canPlace(
+        w: Int,
+        h: Int
+    ): Boolean {
+        if (w <= 0 || h <= 0 || w > width || h > height) return false
+        if (cursorX + w <= width && shelfY + h <= height) return true
+        return shelfY + shelfHeight + padding + h <= height
+    }
+
+    fun place(
+        w: Int,
+        h: Int
+    ): Boolean {
+        if (!canPlace(w, h)) return false
+        if (cursorX + w > width || shelfY + h > height) {
+            shelfY += shelfHeight + padding
+            shelfHeight = 0
+            cursorX = 0
+        }
+        placedX = cursorX
+        placedY = shelfY
+        cursorX += w + padding
+        shelfHeight = maxOf(shelfHeight, h)
+        return true
+    }
+
+    fun reset() {
+        shelfY = 0
+        shelfHeight = 0
+        cursorX = 0
+    }
+}
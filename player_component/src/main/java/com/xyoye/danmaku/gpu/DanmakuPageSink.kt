@@ -0,0 +1,40 @@
+package com.xyoye.danmaku.gpu
+
+import android.graphics.Bitmap
+
+/**
+ * 接收 [GpuDanmakuLayer] 光栅化好的弹幕图集页，由字幕 GPU 管线（AssGpuNativeBridge）实现
+ */
+interface DanmakuPageSink {
+    /**
+     * 图集页尺寸与数量，变化时丢弃全部页
+     */
+    fun configureDanmakuPages(
+        pageWidth: Int,
+        pageHeight: Int,
+        pageCount: Int
+    )
+
+    /**
+     * 替换第 [page] 页的内容（ARGB_8888，红色通道为填充、绿色通道为描边）及放在该页上的 [count] 条弹幕
+     *
+     * 每条弹幕在 [attributes] 中占 [ATTRIBUTE_STRIDE] 个值：时长、模式、图集矩形 x/y/宽/高、填充色、描边色；
+     * 在 [geometry] 中占 [GEOMETRY_STRIDE] 个值：屏幕 y、宽、高。[bitmap] 调用返回后即可复用。
+     */
+    fun submitDanmakuPage(
+        page: Int,
+        bitmap: Bitmap,
+        startsMs: LongArray,
+        attributes: IntArray,
+        geometry: FloatArray,
+        count: Int
+    ): Boolean
+
+    fun clearDanmaku()
+
+    companion object {
+        // 与 ass_gpu_bridge.cpp 中 kDanmakuAttributeStride / kDanmakuGeometryStride 保持一致
+        const val ATTRIBUTE_STRIDE = 8
+        const val GEOMETRY_STRIDE = 3
+    }
+}
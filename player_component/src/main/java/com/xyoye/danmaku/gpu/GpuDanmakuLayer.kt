@@ -0,0 +1,371 @@
+package com.xyoye.danmaku.gpu
+
+import android.graphics.Bitmap
+import android.graphics.Canvas
+import android.graphics.Color
+import android.graphics.Paint
+import android.graphics.PorterDuff
+import android.graphics.PorterDuffXfermode
+import com.xyoye.danmaku.DanmakuLayout
+import com.xyoye.danmaku.DanmakuMerge
+import com.xyoye.danmaku.DanmakuStore
+import kotlin.math.ceil
+
+/**
+ * 在字幕 GPU 管线（ass_gpu_bridge）中绘制 [DanmakuStore] 的弹幕
+ *
+ * 每条弹幕只在即将出现前光栅化一次：描边画在绿色通道、填充画在红色通道，装入图集页后整页交给
+ * [sink]；屏幕位置由顶点着色器根据开始时间、时长与当前时间计算（见 ass_danmaku_layer.h），
+ * 所有可见弹幕一次实例化绘制。每帧这里只需判断是否要继续光栅化后面的弹幕。
+ * 图集页循环使用，页内弹幕全部结束后即可被新页覆盖。
+ *
+ * 车道由 [DanmakuLayout] 在首次绘制前为整条时间轴一次算好，字宽取自 [fillPaint] 的字体；
+ * 视口尺寸、样式或屏蔽规则变化（[setViewport]、[update]）后只重新计算播放位置附近的窗口。
+ * [isBlocked] 在首次布局及每次 [update] 后对每条弹幕求值一次。原生布局不可用时不绘制弹幕。
+ *
+ * 所有方法在渲染线程调用；[store] 关闭前必须先 [release]。
+ */
+class GpuDanmakuLayer(
+    val store: DanmakuStore,
+    private val sink: DanmakuPageSink,
+    private var style: Style = Style(),
+    private var isBlocked: (Int) -> Boolean = { false }
+) {
+    data class Style(
+        // 弹幕字号（弹幕文件中的 size，通常为 25）到像素的比例
+        val textScale: Float = 1.5f,
+        val strokeWidth: Float = 2f,
+        val lineSpacing: Float = 4f,
+        val scrollDurationMs: Int = 3800,
+        val fixedDurationMs: Int = 3800,
+        val pageWidth: Int = 2048,
+        val pageHeight: Int = 512,
+        val pageCount: Int = 6,
+        // 提前光栅化的时间窗口
+        val lookaheadMs: Long = 8000L,
+        // 页内最早的弹幕距离出现不足该时长时提交，未满也提交
+        val submitMarginMs: Long = 1000L,
+        // 正常播放时每帧最多光栅化的弹幕数，跳转后的首帧不限
+        val rasterBudget: Int = 48,
+        // 合并刷屏的重复弹幕，为 null 时逐条显示
+        val merge: DanmakuMerge.Options? = null
+    )
+
+    private class Page(
+        val slot: Int,
+        val packer: DanmakuAtlasPacker
+    ) {
+        var count = 0
+        var firstStartMs = 0L
+        var maxEndMs = Long.MIN_VALUE
+        var startsMs = LongArray(INITIAL_CAPACITY)
+        var attributes = IntArray(INITIAL_CAPACITY * DanmakuPageSink.ATTRIBUTE_STRIDE)
+        var geometry = FloatArray(INITIAL_CAPACITY * DanmakuPageSink.GEOMETRY_STRIDE)
+
+        fun ensureCapacity() {
+            if (count < startsMs.size) return
+            val capacity = startsMs.size * 2
+            startsMs = startsMs.copyOf(capacity)
+            attributes = attributes.copyOf(capacity * DanmakuPageSink.ATTRIBUTE_STRIDE)
+            geometry = geometry.copyOf(capacity * DanmakuPageSink.GEOMETRY_STRIDE)
+        }
+    }
+
+    private val fillPaint =
+        Paint(Paint.ANTI_ALIAS_FLAG).apply {
+            color = Color.RED
+            xfermode = PorterDuffXfermode(PorterDuff.Mode.ADD)
+        }
+    private val strokePaint =
+        Paint(Paint.ANTI_ALIAS_FLAG).apply {
+            color = Color.GREEN
+            style = Paint.Style.STROKE
+            strokeJoin = Paint.Join.ROUND
+            strokeWidth = this@GpuDanmakuLayer.style.strokeWidth * 2
+        }
+    private val fontMetrics = Paint.FontMetrics()
+
+    private var pageBitmap: Bitmap? = null
+    private var pageCanvas: Canvas? = null
+    private var openPage: Page? = null
+
+    // 各页中弹幕的最晚结束时间，早于当前时间即可复用；打开中的页为 Long.MAX_VALUE
+    private var slotEndMs = LongArray(style.pageCount) { Long.MIN_VALUE }
+
+    private val layout: DanmakuLayout? = DanmakuLayout.of(store)
+    private var merge: DanmakuMerge? = null
+    private var hiddenMask: LongArray? = null
+    private var layoutConfigured = false
+    private var layoutComplete = false
+    private var hiddenValid = false
+    private var mergeValid = false
+
+    private var configured = false
+    private var viewportWidth = 0
+    private var viewportHeight = 0
+    private var rasterValid = false
+    private var lastPtsMs = Long.MIN_VALUE
+    private var cursor = 0
+
+    /**
+     * 弹幕时间相对于传入 [prepare] 的时间的偏移，例如绘制时间包含字幕偏移时取其相反数
+     */
+    var timeOffsetMs: Long = 0L
+        set(value) {
+            if (field != value) {
+                field = value
+                rasterValid = false
+            }
+        }
+
+    fun setViewport(
+        width: Int,
+        height: Int
+    ) {
+        if (width == viewportWidth && height == viewportHeight) return
+        viewportWidth = width
+        viewportHeight = height
+        layoutConfigured = false
+        rasterValid = false
+    }
+
+    /**
+     * 换用新的样式与屏蔽规则。布局只把全部窗口标记为过期，由 [prepare] 按播放位置重新计算附近的窗口，
+     * 已光栅化的弹幕从下一帧起重新生成
+     */
+    fun update(
+        style: Style,
+        isBlocked: (Int) -> Boolean
+    ) {
+        val previous = this.style
+        this.style = style
+        this.isBlocked = isBlocked
+        strokePaint.strokeWidth = style.strokeWidth * 2
+        if (style.pageWidth != previous.pageWidth || style.pageHeight != previous.pageHeight ||
+            style.pageCount != previous.pageCount
+        ) {
+            release()
+            slotEndMs = LongArray(style.pageCount) { Long.MIN_VALUE }
+        }
+        if (style.merge != previous.merge) mergeValid = false
+        hiddenValid = false
+        layoutConfigured = false
+        rasterValid = false
+    }
+
+    /**
+     * 每帧渲染前调用，光栅化 [ptsMs] 之后 [Style.lookaheadMs] 内的弹幕；时间跳变时重新开始
+     */
+    fun prepare(ptsMs: Long) {
+        val layout = layout ?: return
+        if (viewportWidth <= 0 || viewportHeight <= 0) return
+        if (!layoutConfigured && !configureLayout(layout)) return
+        if (!configured) {
+            sink.configureDanmakuPages(style.pageWidth, style.pageHeight, style.pageCount)
+            configured = true
+        }
+        val jumped = lastPtsMs == Long.MIN_VALUE || ptsMs < lastPtsMs - SEEK_TOLERANCE_MS ||
+            ptsMs > lastPtsMs + SEEK_TOLERANCE_MS
+        if (jumped || !rasterValid) {
+            reset(ptsMs)
+        }
+        lastPtsMs = ptsMs
+        // 首次配置后已全部算好；尺寸变化后只补算将要光栅化的窗口
+        val storePtsMs = ptsMs - timeOffsetMs
+        layout.ensure(
+            storePtsMs - maxOf(style.scrollDurationMs, style.fixedDurationMs),
+            storePtsMs + style.lookaheadMs + 1,
+        )
+
+        var budget = if (jumped) Int.MAX_VALUE else style.rasterBudget
+        while (cursor < store.count && budget > 0) {
+            if (startOf(cursor) > ptsMs + style.lookaheadMs) break
+            val page = openPage ?: openPage(ptsMs) ?: break
+            if (!append(layout, cursor, page)) {
+                // 页已满；空页放不下说明弹幕本身超出页尺寸，直接跳过
+                if (page.count == 0) cursor++ else submit(page)
+                continue
+            }
+            cursor++
+            budget--
+        }
+        openPage?.let { page ->
+            if (page.count > 0 && page.firstStartMs <= ptsMs + style.submitMarginMs) {
+                submit(page)
+            }
+        }
+    }
+
+    fun release() {
+        sink.clearDanmaku()
+        openPage = null
+        pageCanvas = null
+        pageBitmap?.recycle()
+        pageBitmap = null
+        configured = false
+        lastPtsMs = Long.MIN_VALUE
+    }
+
+    private fun configureLayout(layout: DanmakuLayout): Boolean {
+        fillPaint.textSize = DEFAULT_TEXT_SIZE * style.textScale
+        fillPaint.getFontMetrics(fontMetrics)
+        val laneHeight = fontMetrics.descent - fontMetrics.ascent + style.strokeWidth * 2 + style.lineSpacing
+        val configuredNow =
+            layout.configure(
+                viewportWidth,
+                viewportHeight,
+                style.textScale,
+                style.strokeWidth,
+                laneHeight,
+                style.scrollDurationMs,
+                style.fixedDurationMs,
+                measureFont(),
+            )
+        if (!configuredNow) return false
+        if (!hiddenValid) {
+            val mask = LongArray((store.count + 63) ushr 6)
+            for (row in 0 until store.count) {
+                if (isBlocked(row)) mask[row ushr 6] = mask[row ushr 6] or (1L shl (row and 63))
+            }
+            hiddenMask = if (mask.any { it != 0L }) mask else null
+            layout.setHidden(hiddenMask)
+            hiddenValid = true
+            // 被屏蔽的弹幕不能作为合并组的第一条，屏蔽结果变化后重新合并
+            if (style.merge != null) mergeValid = false
+        }
+        if (!mergeValid) {
+            merge = style.merge?.let { DanmakuMerge.of(store, it, hiddenMask) }
+            layout.setMerged(merge != null)
+            mergeValid = true
+        }
+        // 之后的变化只让窗口过期，由 prepare 中的 ensure 按需补算
+        if (!layoutComplete) {
+            layout.layoutAll()
+            layoutComplete = true
+        }
+        layoutConfigured = true
+        return true
+    }
+
+    // 以 1px 字号为单位的字宽，供原生布局估算弹幕宽度
+    private fun measureFont(): DanmakuLayout.FontMetrics {
+        val size = fillPaint.textSize
+        val ascii =
+            FloatArray(DanmakuLayout.ASCII_COUNT) { fillPaint.measureText((it + 0x20).toChar().toString()) / size }
+        return DanmakuLayout.FontMetrics(
+            ascii,
+            fillPaint.measureText(WIDE_SAMPLE) / size,
+            fillPaint.measureText(OTHER_SAMPLE) / size,
+            (fontMetrics.descent - fontMetrics.ascent) / size,
+        )
+    }
+
+    private fun startOf(row: Int): Long = store.timeMs(row) + timeOffsetMs
+
+    private fun reset(ptsMs: Long) {
+        sink.clearDanmaku()
+        slotEndMs.fill(Long.MIN_VALUE)
+        openPage = null
+        rasterValid = true
+        // 从当前仍可能在屏幕上的第一条弹幕开始
+        val from = ptsMs - maxOf(style.scrollDurationMs, style.fixedDurationMs)
+        var low = 0
+        var high = store.count
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (startOf(mid) <= from) low = mid + 1 else high = mid
+        }
+        cursor = low
+    }
+
+    private fun openPage(ptsMs: Long): Page? {
+        val slot = slotEndMs.indices.firstOrNull { slotEndMs[it] < ptsMs } ?: return null
+        slotEndMs[slot] = Long.MAX_VALUE
+        val bitmap =
+            pageBitmap ?: Bitmap.createBitmap(style.pageWidth, style.pageHeight, Bitmap.Config.ARGB_8888).also {
+                pageBitmap = it
+                pageCanvas = Canvas(it)
+            }
+        bitmap.eraseColor(Color.TRANSPARENT)
+        return Page(slot, DanmakuAtlasPacker(style.pageWidth, style.pageHeight, ATLAS_PADDING)).also { openPage = it }
+    }
+
+    private fun submit(page: Page) {
+        openPage = null
+        val bitmap = pageBitmap
+        val submitted =
+            page.count > 0 && bitmap != null &&
+                sink.submitDanmakuPage(page.slot, bitmap, page.startsMs, page.attributes, page.geometry, page.count)
+        slotEndMs[page.slot] = if (submitted) page.maxEndMs else Long.MIN_VALUE
+    }
+
+    /**
+     * 光栅化第 [row] 条弹幕并放入 [page]；页已满时返回 false，被屏蔽或没有车道时跳过并返回 true
+     */
+    private fun append(
+        layout: DanmakuLayout,
+        row: Int,
+        page: Page
+    ): Boolean {
+        if (!layout.isPlaced(row)) return true
+        val text = store.text(row).replace('\n', ' ') + merge?.suffix(row).orEmpty()
+
+        val textSize = store.size(row) * style.textScale
+        fillPaint.textSize = textSize
+        strokePaint.textSize = textSize
+        fillPaint.getFontMetrics(fontMetrics)
+        val stroke = style.strokeWidth
+        // 宽度以布局为准，字体估算与实际排版的差异由裁剪吸收
+        val width = minOf(layout.width(row).toInt(), style.pageWidth)
+        val height = ceil(layout.height(row)).toInt()
+        if (!page.packer.canPlace(width, height)) return false
+
+        page.packer.place(width, height)
+        val x = page.packer.placedX
+        val top = page.packer.placedY
+        val canvas = pageCanvas ?: return true
+        val baseline = top + stroke - fontMetrics.ascent
+        canvas.save()
+        canvas.clipRect(x, top, x + width, top + height)
+        canvas.drawText(text, x + stroke, baseline, strokePaint)
+        canvas.drawText(text, x + stroke, baseline, fillPaint)
+        canvas.restore()
+
+        val start = startOf(row)
+        val duration = layout.durationMs(row)
+        val fill = store.color(row) or 0xFF000000.toInt()
+        page.ensureCapacity()
+        val index = page.count
+        if (index == 0) page.firstStartMs = start
+        page.startsMs[index] = start
+        val attributeBase = index * DanmakuPageSink.ATTRIBUTE_STRIDE
+        page.attributes[attributeBase] = duration
+        page.attributes[attributeBase + 1] = store.mode(row)
+        page.attributes[attributeBase + 2] = x
+        page.attributes[attributeBase + 3] = top
+        page.attributes[attributeBase + 4] = width
+        page.attributes[attributeBase + 5] = height
+        page.attributes[attributeBase + 6] = fill
+        page.attributes[attributeBase + 7] = if (fill <= Color.BLACK) Color.WHITE else Color.BLACK
+        val geometryBase = index * DanmakuPageSink.GEOMETRY_STRIDE
+        page.geometry[geometryBase] = layout.y(row)
+        page.geometry[geometryBase + 1] = width.toFloat()
+        page.geometry[geometryBase + 2] = height.toFloat()
+        page.count++
+        page.maxEndMs = maxOf(page.maxEndMs, start + duration)
+        return true
+    }
+
+    private companion object {
+        const val DEFAULT_TEXT_SIZE = 25f
+
+        // 布局按这两个字符估算全角字符与其他非 ASCII 字符的宽度
+        const val WIDE_SAMPLE = "中"
+        const val OTHER_SAMPLE = "é"
+        const val ATLAS_PADDING = 2
+        const val INITIAL_CAPACITY = 64
+
+        // 两帧之间的时间差超过该值视为跳转
+        const val SEEK_TOLERANCE_MS = 2000L
+    }
+}
@@ -19,6 +19,14 @@ object OpenCCFile {
     // 繁转简配置文件
     val t2s: File = File(PathHelper.getOpenCCDirectory(), "t2s.json")
 
+    // 简转繁词典（短语 / 单字），供 libass 原生转换直接加载
+    val stPhrases: File = File(PathHelper.getOpenCCDirectory(), "STPhrases.ocd2")
+    val stCharacters: File = File(PathHelper.getOpenCCDirectory(), "STCharacters.ocd2")
+
+    // 繁转简词典（短语 / 单字）
+    val tsPhrases: File = File(PathHelper.getOpenCCDirectory(), "TSPhrases.ocd2")
+    val tsCharacters: File = File(PathHelper.getOpenCCDirectory(), "TSCharacters.ocd2")
+
     // assets中open_cc文件夹名称
     private const val OPEN_CC_ASSETS_DIR = "open_cc"
 
@@ -162,6 +162,64 @@ class DanDanVideoPlayer(
         }
     }
 
+    override fun beginScrub() {
+        if (isInPlayState()) {
+            mVideoPlayer.beginScrub()
+        }
+    }
+
+    override fun updateScrub(timeMs: Long) {
+        if (timeMs >= 0 && isInPlayState()) {
+            mVideoPlayer.updateScrub(timeMs)
+        }
+    }
+
+    override fun endScrub(timeMs: Long) {
+        if (timeMs >= 0 && isInPlayState()) {
+            mVideoPlayer.endScrub(timeMs)
+            subtitleRenderer?.onSeek(timeMs)
+        }
+    }
+
+    override fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ) = isInPlayState() && mVideoPlayer.setAbLoop(startMs, endMs)
+
+    override fun stepFrame(backward: Boolean): Boolean {
+        if (!isInPlayState() || !mVideoPlayer.stepFrame(backward)) {
+            return false
+        }
+        onPausedByPlayer()
+        return true
+    }
+
+    override fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        if (startMs < 0 || !isInPlayState() || !mVideoPlayer.playSegment(startMs, endMs)) {
+            return false
+        }
+        subtitleRenderer?.onSeek(startMs)
+        setPlayState(PlayState.STATE_PLAYING)
+        keepScreenOn = true
+        mAudioFocusHelper.requestFocus()
+        return true
+    }
+
+    /**
+     * 内核自行暂停（逐帧步进、片段播放结束）后同步播放状态
+     */
+    private fun onPausedByPlayer() {
+        if (mCurrentPlayState == PlayState.STATE_PAUSED) {
+            return
+        }
+        setPlayState(PlayState.STATE_PAUSED)
+        mAudioFocusHelper.abandonFocus()
+        keepScreenOn = false
+    }
+
     override fun isPlaying() = isInPlayState() && mVideoPlayer.isPlaying()
 
     override fun getBufferedPercentage() = mVideoPlayer.getBufferedPercentage()
@@ -317,6 +375,10 @@ class DanDanVideoPlayer(
                 mRenderView?.setVideoRotation(extra)
             }
 
+            PlayerConstant.MEDIA_INFO_SEGMENT_END -> {
+                onPausedByPlayer()
+            }
+
             PlayerConstant.MEDIA_INFO_URL_EMPTY -> {
                 setPlayState(PlayState.STATE_ERROR)
             }
@@ -361,6 +361,7 @@ class VideoController(
                 }
             }
             PlayerAction.ToggleDanmu -> mControlWrapper.toggleDanmuVisible()
+            PlayerAction.NextHotMoment -> seekToNextHotMoment()
         }
     }
 }
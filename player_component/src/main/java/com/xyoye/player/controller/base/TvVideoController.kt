@@ -46,6 +46,10 @@ abstract class TvVideoController(
                     dispatchAction(PlayerAction.OpenEpisodePanel)
                     return true
                 }
+
+                override fun seekToNextHotMoment() {
+                    dispatchAction(PlayerAction.NextHotMoment)
+                }
             },
         )
 
@@ -67,7 +71,8 @@ abstract class TvVideoController(
                 KeyEvent.KEYCODE_DPAD_RIGHT,
                 KeyEvent.KEYCODE_DPAD_UP,
                 KeyEvent.KEYCODE_DPAD_DOWN,
-                KeyEvent.KEYCODE_MENU -> true
+                KeyEvent.KEYCODE_MENU,
+                KeyEvent.KEYCODE_MEDIA_FAST_FORWARD -> true
                 else -> false
             }
         if (event.action == KeyEvent.ACTION_DOWN && isDpadKey) {
@@ -135,6 +140,7 @@ abstract class TvVideoController(
                 }
                 PlayerAction.OpenSourceList -> mControlWrapper.showSettingView(SettingViewType.SWITCH_VIDEO_SOURCE)
                 PlayerAction.ToggleDanmu -> mControlWrapper.toggleDanmuVisible()
+                PlayerAction.NextHotMoment -> seekToNextHotMoment()
             }
         }
     }
@@ -176,6 +182,30 @@ abstract class TvVideoController(
         postDelayed(pendingSeekRunnable, SEEK_DEBOUNCE_MS)
     }
 
+    /**
+     * 跳到下一个弹幕高能时刻（见 DanmakuDensity），没有弹幕密度索引或已过最后一个时只显示控制栏
+     */
+    protected fun seekToNextHotMoment() {
+        if (!mControlWrapper.isUserSeekAllowed()) {
+            return
+        }
+        val duration = mControlWrapper.getDuration()
+        if (duration <= 0) {
+            return
+        }
+        // 方向键调整中的进度尚未提交时从调整后的位置往后找
+        val target = mControlWrapper.nextHotMomentMs(calculateTargetPosition(duration))
+        if (target == null || target >= duration) {
+            showController(true)
+            return
+        }
+        if (pendingSeekStartPosition != null) {
+            finishSeekSlide()
+            resetPendingSeek()
+        }
+        mControlWrapper.seekTo(target)
+    }
+
     private fun commitPendingSeek() {
         if (pendingSeekStartPosition == null) {
             return
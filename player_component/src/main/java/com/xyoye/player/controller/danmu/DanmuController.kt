@@ -2,6 +2,7 @@ package com.xyoye.player.controller.danmu
 
 import android.content.Context
 import androidx.lifecycle.LiveData
+import androidx.media3.common.util.UnstableApi
 import com.xyoye.data_component.bean.SendDanmuBean
 import com.xyoye.data_component.bean.VideoTrackBean
 import com.xyoye.data_component.entity.DanmuBlockEntity
@@ -13,6 +14,7 @@ import com.xyoye.player.wrapper.InterDanmuController
  * Created by xyoye on 2021/4/14.
  */
 
+@UnstableApi
 class DanmuController(
     context: Context
 ) : InterDanmuController {
@@ -102,6 +104,8 @@ class DanmuController(
         danmuView.seekTo(timeMs, isPlaying)
     }
 
+    override fun nextHotMomentMs(positionMs: Long): Long? = danmuView.nextHotMomentMs(positionMs)
+
     override fun setLanguage(language: DanmakuLanguage) {
         danmuView.setLanguage(language)
     }
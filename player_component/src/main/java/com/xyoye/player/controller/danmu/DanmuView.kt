@@ -6,16 +6,22 @@ import android.graphics.Point
 import android.util.AttributeSet
 import androidx.lifecycle.LifecycleOwner
 import androidx.lifecycle.LiveData
+import androidx.media3.common.util.UnstableApi
 import com.xyoye.common_component.config.DanmuConfig
 import com.xyoye.common_component.utils.danmu.live.LiveDanmakuClient
 import com.xyoye.common_component.utils.danmu.live.LiveDanmakuClientFactory
 import com.xyoye.common_component.weight.ToastCenter
 import com.xyoye.danmaku.BiliDanmakuLoader
-import com.xyoye.danmaku.BiliDanmakuParser
+import com.xyoye.danmaku.DanmakuDensity
+import com.xyoye.danmaku.DanmakuMerge
+import com.xyoye.danmaku.DanmakuStore
 import com.xyoye.danmaku.EmptyDanmakuParser
+import com.xyoye.danmaku.NativeDanmakuParser
+import com.xyoye.danmaku.filter.DanmakuBlockIndex
 import com.xyoye.danmaku.filter.KeywordFilter
 import com.xyoye.danmaku.filter.LanguageConverter
 import com.xyoye.danmaku.filter.RegexFilter
+import com.xyoye.danmaku.gpu.GpuDanmakuLayer
 import com.xyoye.data_component.bean.DanmuTrackResource
 import com.xyoye.data_component.bean.SendDanmuBean
 import com.xyoye.data_component.bean.VideoTrackBean
@@ -25,6 +31,8 @@ import com.xyoye.data_component.enums.DanmakuLanguage
 import com.xyoye.data_component.enums.PlayState
 import com.xyoye.player.controller.video.InterControllerView
 import com.xyoye.player.info.PlayerInitializer
+import com.xyoye.player.subtitle.backend.SubtitleRenderer
+import com.xyoye.player.subtitle.backend.SubtitleRendererRegistry
 import com.xyoye.player.wrapper.ControlWrapper
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
@@ -49,6 +57,7 @@ import kotlin.math.max
  * Created by xyoye on 2020/11/17.
  */
 
+@UnstableApi
 class DanmuView(
     context: Context,
     attrs: AttributeSet? = null,
@@ -72,8 +81,9 @@ class DanmuView(
 
     private val mDanmakuContext = DanmakuContext.create()
     private val mDanmakuLoader = BiliDanmakuLoader.instance()
-    private val mKeywordFilter = KeywordFilter()
-    private val mRegexFilter = RegexFilter()
+    private val mBlockIndex = DanmakuBlockIndex()
+    private val mKeywordFilter = KeywordFilter(mBlockIndex)
+    private val mRegexFilter = RegexFilter(mBlockIndex)
     private val mLanguageConverter = LanguageConverter()
 
     private var mSeekPosition = INVALID_VALUE
@@ -92,6 +102,23 @@ class DanmuView(
 
     private var danmuResource: DanmuTrackResource? = null
 
+    // 本地弹幕改由字幕 GPU 管线（SubtitleRenderer.setDanmakuStore）绘制时的渲染器与弹幕库；
+    // 弹幕库在解析线程中写入，由 mBlockIndex 持有并关闭
+    private var gpuDanmakuRenderer: SubtitleRenderer? = null
+
+    @Volatile
+    private var gpuDanmakuStore: DanmakuStore? = null
+
+    private var popupMode = false
+
+    // 本地弹幕的密度索引，用于跳转高能时刻；在解析线程中写入
+    @Volatile
+    private var danmakuDensity: DanmakuDensity? = null
+
+    private val subtitleRendererListener: (SubtitleRenderer?) -> Unit = { renderer ->
+        post { onSubtitleRendererChanged(renderer) }
+    }
+
     private var liveDanmakuClient: LiveDanmakuClient? = null
     private var liveDanmakuScope: CoroutineScope? = null
     private var liveDanmakuRenderJob: Job? = null
@@ -117,6 +144,10 @@ class DanmuView(
                 override fun prepared() {
                     post {
                         mDanmuLoaded = true
+                        if (gpuDanmakuStore == null) {
+                            gpuDanmakuRenderer = null
+                        }
+                        syncGpuDanmaku()
                         if (mControlWrapper.isPlaying()) {
                             val position =
                                 if (mSeekPosition == INVALID_VALUE) {
@@ -141,6 +172,16 @@ class DanmuView(
         mControlWrapper = controlWrapper
     }
 
+    override fun onAttachedToWindow() {
+        super.onAttachedToWindow()
+        SubtitleRendererRegistry.addListener(subtitleRendererListener)
+    }
+
+    override fun onDetachedFromWindow() {
+        SubtitleRendererRegistry.removeListener(subtitleRendererListener)
+        super.onDetachedFromWindow()
+    }
+
     override fun onVisibilityChanged(isVisible: Boolean) {
     }
 
@@ -210,6 +251,9 @@ class DanmuView(
             stroke *= 0.5f
         }
         mDanmakuContext.setDanmakuStyle(DANMAKU_STYLE_STROKEN, stroke)
+
+        popupMode = isPopup
+        syncGpuDanmaku()
     }
 
     override fun resume() {
@@ -229,6 +273,9 @@ class DanmuView(
         clear()
         clearDanmakusOnScreen()
         super.release()
+        detachGpuDanmaku()
+        danmakuDensity = null
+        mBlockIndex.detach()
     }
 
     fun seekTo(
@@ -242,6 +289,15 @@ class DanmuView(
         }
     }
 
+    /**
+     * 播放位置 [positionMs] 之后最近的高能时刻（视频时间），已计入弹幕偏移
+     */
+    fun nextHotMomentMs(positionMs: Long): Long? {
+        val density = danmakuDensity ?: return null
+        val offset = PlayerInitializer.Danmu.offsetPosition
+        return density.nextPeakMs(positionMs + offset)?.let { it - offset }
+    }
+
     fun addTrack(track: VideoTrackBean): Boolean {
         val resource = track.type.getDanmuResource(track.trackResource) ?: return false
 
@@ -286,11 +342,13 @@ class DanmuView(
 
     private fun syncVisibility() {
         setDanmuVisible(mTrackSelected && userVisible)
+        syncGpuDanmaku()
     }
 
     private fun addLocalTrack(
         track: VideoTrackBean,
-        resource: DanmuTrackResource.LocalFile
+        resource: DanmuTrackResource.LocalFile,
+        allowGpu: Boolean = true
     ): Boolean {
         val danmu = resource.danmu
         val danmuFile = File(danmu.danmuPath)
@@ -313,14 +371,106 @@ class DanmuView(
 
         mAddedTrack = track
         mDanmuLoaded = false
+        val gpuRenderer = if (allowGpu) gpuDanmakuCandidate() else null
+        gpuDanmakuRenderer = gpuRenderer
         val danmuParser =
-            BiliDanmakuParser().apply {
+            NativeDanmakuParser(danmuFile, mBlockIndex, mergeOptions()) { store ->
+                // 索引在弹幕文件旁缓存，之后再打开同一文件时直接读取
+                danmakuDensity = DanmakuDensity.load(store, danmuFile)
+                if (gpuRenderer != null) gpuDanmakuStore = store
+                gpuRenderer != null
+            }.apply {
                 load(dataSource)
             }
         prepare(danmuParser, mDanmakuContext)
         return true
     }
 
+    /**
+     * 字幕渲染器能在自己的管线中绘制弹幕时（见 [SubtitleRenderer.supportsDanmaku]）返回该渲染器；
+     * 简繁转换只作用于 DanmakuFlameMaster 的过滤器，开启时仍由本视图绘制
+     */
+    private fun gpuDanmakuCandidate(): SubtitleRenderer? =
+        SubtitleRendererRegistry.current()?.takeIf {
+            PlayerInitializer.Danmu.language == DanmakuLanguage.ORIGINAL && it.supportsDanmaku()
+        }
+
+    /**
+     * 把当前的显示状态、样式与屏蔽规则交给字幕 GPU 管线；渲染器已不能绘制弹幕时改回由本视图绘制
+     */
+    private fun syncGpuDanmaku() {
+        val renderer = gpuDanmakuRenderer ?: return
+        val store = gpuDanmakuStore ?: return
+        if (!mDanmuLoaded) return
+        val visible = mTrackSelected && userVisible
+        val accepted =
+            renderer.setDanmakuStore(
+                if (visible) store else null,
+                gpuDanmakuStyle(),
+            ) { row -> mBlockIndex.isBlocked(row) || isModeHidden(store.mode(row)) }
+        if (!accepted) {
+            reloadLocalTrack(allowGpu = false)
+        }
+    }
+
+    private fun gpuDanmakuStyle(): GpuDanmakuLayer.Style {
+        val popupScale = if (popupMode) 0.5f else 1f
+        val density = max(0.1f, resources.displayMetrics.density - DANMU_TEXT_SIZE_DENSITY_OFFSET)
+        val defaults = GpuDanmakuLayer.Style()
+        return defaults.copy(
+            textScale = density * danmuTextScale() * popupScale,
+            // DanmakuFlameMaster 的描边宽度为两侧合计
+            strokeWidth = danmuStroke() * popupScale / 2f,
+            scrollDurationMs = (defaults.scrollDurationMs * danmuSpeedFactor()).toInt(),
+            merge = mergeOptions(),
+        )
+    }
+
+    private fun mergeOptions(): DanmakuMerge.Options? =
+        if (PlayerInitializer.Danmu.mergeDuplicate) DanmakuMerge.Options() else null
+
+    private fun isModeHidden(mode: Int): Boolean =
+        when (mode) {
+            BaseDanmaku.TYPE_SCROLL_RL -> !PlayerInitializer.Danmu.mobileDanmu
+            BaseDanmaku.TYPE_FIX_TOP -> !PlayerInitializer.Danmu.topDanmu
+            BaseDanmaku.TYPE_FIX_BOTTOM -> !PlayerInitializer.Danmu.bottomDanmu
+            else -> false
+        }
+
+    /**
+     * 字幕渲染器变化后重新决定本地弹幕由谁绘制：原渲染器已被替换，或新渲染器可以接管绘制
+     */
+    private fun onSubtitleRendererChanged(renderer: SubtitleRenderer?) {
+        if (danmuResource !is DanmuTrackResource.LocalFile) return
+        val current = gpuDanmakuRenderer
+        val replaced = current != null && current !== renderer
+        val takeOver = current == null && gpuDanmakuCandidate() != null
+        if (replaced || takeOver) {
+            reloadLocalTrack()
+        }
+    }
+
+    /**
+     * 从字幕 GPU 管线移除弹幕库并等待渲染线程停止读取；重新解析会关闭旧的弹幕库，之前必须调用
+     */
+    private fun detachGpuDanmaku() {
+        gpuDanmakuRenderer?.setDanmakuStore(null)
+        gpuDanmakuRenderer = null
+        gpuDanmakuStore = null
+    }
+
+    private fun reloadLocalTrack(allowGpu: Boolean = true) {
+        val track = mAddedTrack ?: return
+        val resource = danmuResource as? DanmuTrackResource.LocalFile ?: return
+        detachGpuDanmaku()
+        val selected = mTrackSelected
+        if (!addLocalTrack(track, resource, allowGpu)) return
+        if (this::mControlWrapper.isInitialized) {
+            mSeekPosition = mControlWrapper.getCurrentPosition() + PlayerInitializer.Danmu.offsetPosition
+        }
+        setTrackSelected(selected)
+    }
+
     private fun addBilibiliLiveTrack(
         track: VideoTrackBean,
         resource: DanmuTrackResource.BilibiliLive
@@ -527,18 +677,24 @@ class DanmuView(
     }
 
     fun updateDanmuSize() {
-        val progress = PlayerInitializer.Danmu.size / 100f
-        val size = progress * DANMU_MAX_TEXT_SIZE
-        mDanmakuContext.setScaleTextSize(size)
+        mDanmakuContext.setScaleTextSize(danmuTextScale())
+        syncGpuDanmaku()
     }
 
     fun updateDanmuSpeed() {
+        mDanmakuContext.setScrollSpeedFactor(danmuSpeedFactor())
+        syncGpuDanmaku()
+    }
+
+    private fun danmuTextScale(): Float = PlayerInitializer.Danmu.size / 100f * DANMU_MAX_TEXT_SIZE
+
+    private fun danmuSpeedFactor(): Float {
         val progress = PlayerInitializer.Danmu.speed / 100f
-        var speed = DANMU_MAX_TEXT_SPEED * (1 - progress)
-        speed = max(0.1f, speed)
-        mDanmakuContext.setScrollSpeedFactor(speed)
+        return max(0.1f, DANMU_MAX_TEXT_SPEED * (1 - progress))
     }
 
+    private fun danmuStroke(): Float = PlayerInitializer.Danmu.stoke / 100f * DANMU_MAX_TEXT_STOKE
+
     fun updateDanmuAlpha() {
         val progress = PlayerInitializer.Danmu.alpha / 100f
         val alpha = progress * DANMU_MAX_TEXT_ALPHA
@@ -546,21 +702,23 @@ class DanmuView(
     }
 
     fun updateDanmuStoke() {
-        val progress = PlayerInitializer.Danmu.stoke / 100f
-        val stoke = progress * DANMU_MAX_TEXT_STOKE
-        mDanmakuContext.setDanmakuStyle(DANMAKU_STYLE_STROKEN, stoke)
+        mDanmakuContext.setDanmakuStyle(DANMAKU_STYLE_STROKEN, danmuStroke())
+        syncGpuDanmaku()
     }
 
     fun updateMobileDanmuState() {
         mDanmakuContext.r2LDanmakuVisibility = PlayerInitializer.Danmu.mobileDanmu
+        syncGpuDanmaku()
     }
 
     fun updateTopDanmuState() {
         mDanmakuContext.ftDanmakuVisibility = PlayerInitializer.Danmu.topDanmu
+        syncGpuDanmaku()
     }
 
     fun updateBottomDanmuState() {
         mDanmakuContext.fbDanmakuVisibility = PlayerInitializer.Danmu.bottomDanmu
+        syncGpuDanmaku()
     }
 
     fun updateOffsetTime() {
@@ -664,10 +822,22 @@ class DanmuView(
 
     fun setLanguage(language: DanmakuLanguage) {
         mLanguageConverter.setData(language)
+        // 简繁转换决定本地弹幕能否交给字幕 GPU 管线绘制
+        if (danmuResource is DanmuTrackResource.LocalFile &&
+            (gpuDanmakuRenderer != null) != (gpuDanmakuCandidate() != null)
+        ) {
+            reloadLocalTrack()
+        }
     }
 
     private fun notifyFilterChanged() {
         // 该方法内部会调用弹幕刷新，能达到相应效果
         mDanmakuContext.addUserHashBlackList()
+        // GPU 管线在布局时求值屏蔽规则，需要重建
+        syncGpuDanmaku()
+        // 合并结果在解析时固定，由本视图绘制时重新解析，使被屏蔽的弹幕不再作为合并组的第一条
+        if (PlayerInitializer.Danmu.mergeDuplicate && mDanmuLoaded && gpuDanmakuRenderer == null) {
+            reloadLocalTrack(allowGpu = false)
+        }
     }
 }
@@ -305,6 +305,9 @@ class PlayerBottomView(
         val newPosition = (duration * progress) / viewBinding.playSeekBar.max
         viewBinding.currentPositionTv.text =
             formatDuration(newPosition)
+        if (mIsDragging) {
+            mControlWrapper.updateScrub(newPosition)
+        }
     }
 
     override fun onStartTrackingTouch(seekBar: SeekBar?) {
@@ -314,6 +317,7 @@ class PlayerBottomView(
         mIsDragging = true
         mControlWrapper.stopProgress()
         mControlWrapper.stopFadeOut()
+        mControlWrapper.beginScrub()
     }
 
     override fun onStopTrackingTouch(seekBar: SeekBar?) {
@@ -325,7 +329,7 @@ class PlayerBottomView(
         val duration = mControlWrapper.getDuration()
         val newPosition =
             (duration * viewBinding.playSeekBar.progress) / viewBinding.playSeekBar.max
-        mControlWrapper.seekTo(newPosition)
+        mControlWrapper.endScrub(newPosition)
         mControlWrapper.startFadeOut()
     }
 
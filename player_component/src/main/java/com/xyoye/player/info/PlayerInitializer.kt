@@ -61,6 +61,7 @@ object PlayerInitializer {
         var maxBottomLine = DEFAULT_MAX_LINE
         var maxNum = DEFAULT_MAX_NUM
         var cloudBlock = false
+        var mergeDuplicate = false
         var updateInChoreographer = true
         var language = DEFAULT_LANGUAGE
     }
@@ -4,10 +4,14 @@ import android.content.Context
 import android.os.Handler
 import android.os.Looper
 import android.util.Log
+import android.view.Choreographer
 import android.view.Surface
 import androidx.annotation.Keep
 import com.xyoye.common_component.log.model.LogLevel
 import com.xyoye.data_component.enums.TrackType
+import java.util.Locale
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicLong
 
 private const val TAG = "MpvNativeBridge"
 
@@ -17,6 +21,9 @@ private const val TAG = "MpvNativeBridge"
  * The native side currently falls back to no-op behavior when libmpv
  * is not packaged, so callers should check [isAvailable] before invoking
  * player commands to surface a readable error to the UI.
+ *
+ * Each instance owns one native session and several may run at once; see [SessionRole]
+ * for how they share decoders and memory.
  */
 class MpvNativeBridge {
     data class TrackInfo(
@@ -53,6 +60,37 @@ class MpvNativeBridge {
             val level: Int,
             val message: String?
         ) : Event
+
+        /**
+         * First frame of the exact seek issued by [scrubEnd]; [latencyMs] is measured from the
+         * release, [coalescedUpdates] counts drag positions that never reached mpv.
+         */
+        data class ScrubSettled(
+            val latencyMs: Long,
+            val coalescedUpdates: Int
+        ) : Event
+
+        /**
+         * A [playSegment] request finished: paused at [positionMs] when [reachedEnd], or
+         * cancelled because playback left the segment (seek elsewhere, end of file).
+         */
+        data class SegmentEnded(
+            val positionMs: Long,
+            val reachedEnd: Boolean
+        ) : Event
+    }
+
+    /**
+     * Completion of an async command/property request. [error] is the mpv error code,
+     * negative on failure (an aborted command reports MPV_ERROR_COMMAND).
+     */
+    data class AsyncResult(
+        val requestId: Long,
+        val error: Int,
+        val message: String?
+    ) {
+        val success: Boolean
+            get() = error >= 0
     }
 
     private var nativeHandle: Long = 0
@@ -64,6 +102,25 @@ class MpvNativeBridge {
     @Volatile
     private var eventLoopStarted = false
 
+    private val requestIds = AtomicLong(0)
+    private val pendingReplies = ConcurrentHashMap<Long, (AsyncResult) -> Unit>()
+
+    // Render-API output: frames are presented by the native render thread, paced by the
+    // vsync timestamps forwarded from Choreographer below.
+    private var renderApiEnabled = false
+
+    // Main thread only: start and stop are both posted there, so they apply in call order.
+    private var vsyncActive = false
+
+    private val vsyncCallback =
+        object : Choreographer.FrameCallback {
+            override fun doFrame(frameTimeNanos: Long) {
+                if (!vsyncActive || nativeHandle == 0L) return
+                nativeOnVsync(nativeHandle, frameTimeNanos)
+                Choreographer.getInstance().postFrameCallback(this)
+            }
+        }
+
     val availabilityReason: String?
         get() = availabilityMessage
 
@@ -74,7 +131,17 @@ class MpvNativeBridge {
         if (!nativeLoaded) {
             return availabilityMessage
         }
-        return nativeLastError()
+        return lastErrorRecord()?.describe()
+    }
+
+    /**
+     * Last failure of this session, or of the process before [ensureCreated] succeeded.
+     * Lock-free on the native side; successful calls leave it untouched and a new data
+     * source clears it.
+     */
+    fun lastErrorRecord(): NativeError? {
+        if (!nativeLoaded) return null
+        return NativeError.decode(nativeErrorState(nativeHandle)) { errorMessage(it) }
     }
 
     fun ensureCreated(): Boolean {
@@ -95,15 +162,23 @@ class MpvNativeBridge {
         return true
     }
 
-    fun destroy() {
+    /**
+     * Returns once Java callbacks have stopped; the render thread and mpv core are torn
+     * down on a native reaper thread. With [recycle] the core is reset and kept for the
+     * next [ensureCreated] instead of being destroyed.
+     */
+    fun destroy(recycle: Boolean = false) {
+        stopVsync()
+        renderApiEnabled = false
         if (nativeHandle != 0L) {
             if (eventLoopStarted) {
                 nativeStopEventLoop(nativeHandle)
             }
-            nativeDestroy(nativeHandle)
+            nativeDestroy(nativeHandle, recycle)
             nativeHandle = 0
         }
         eventLoopStarted = false
+        pendingReplies.clear()
         synchronized(listenerLock) {
             eventListeners.clear()
         }
@@ -112,9 +187,40 @@ class MpvNativeBridge {
     fun setSurface(surface: Surface?) {
         if (nativeHandle != 0L) {
             nativeSetSurface(nativeHandle, surface)
+            if (renderApiEnabled) {
+                if (surface != null) startVsync() else stopVsync()
+            }
         }
     }
 
+    val isRenderApiEnabled: Boolean
+        get() = renderApiEnabled
+
+    /**
+     * Composites the GPU subtitle context behind [subtitleHandle] (0 detaches) into every
+     * render-API frame. Detaching returns only once the render thread stopped using it.
+     */
+    fun setSubtitleCompositor(subtitleHandle: Long): Boolean {
+        if (nativeHandle == 0L) return false
+        return nativeSetSubtitleCompositor(nativeHandle, subtitleHandle)
+    }
+
+    fun setSubtitleCompositorOffset(offsetMs: Long) {
+        if (nativeHandle == 0L) return
+        nativeSetSubtitleCompositorOffset(nativeHandle, offsetMs)
+    }
+
+    fun invalidateSubtitleCompositor() {
+        if (nativeHandle == 0L) return
+        nativeInvalidateSubtitleCompositor(nativeHandle)
+    }
+
+    fun releaseRenderSurface() {
+        if (!renderApiEnabled || nativeHandle == 0L) return
+        stopVsync()
+        nativeSetSurface(nativeHandle, null)
+    }
+
     fun setDataSource(
         path: String,
         headers: Map<String, String>
@@ -132,6 +238,95 @@ class MpvNativeBridge {
         return success
     }
 
+    /**
+     * Queues `loadfile` (and the HTTP headers before it) without waiting for the mpv core.
+     * Returns false if mpv rejected the request immediately; load failures after that are
+     * reported through [onReply] or, for demux/open errors, the regular [Event.Error].
+     */
+    fun setDataSourceAsync(
+        path: String,
+        headers: Map<String, String>,
+        onReply: ((AsyncResult) -> Unit)? = null
+    ): Boolean {
+        if (nativeHandle == 0L) return false
+        val headerArray =
+            headers.entries
+                .sortedBy { it.key.lowercase() }
+                .map { "${it.key}: ${it.value}" }
+                .toTypedArray()
+        val requestId = registerReply(onReply)
+        val queued = nativeSetDataSourceAsync(nativeHandle, requestId, path, headerArray)
+        if (!queued) {
+            pendingReplies.remove(requestId)
+            Log.w(TAG, "mpv setDataSourceAsync failed: ${lastError().orEmpty()}")
+        }
+        return queued
+    }
+
+    /**
+     * Runs an mpv command on the core thread. The returned id can be passed to [cancel];
+     * 0 means the command was rejected immediately (see [lastError]). Replies require the
+     * event loop, i.e. at least one event listener.
+     */
+    fun commandAsync(
+        vararg args: String,
+        onReply: ((AsyncResult) -> Unit)? = null
+    ): Long {
+        if (nativeHandle == 0L || args.isEmpty()) return 0
+        val requestId = registerReply(onReply)
+        if (!nativeCommandAsync(nativeHandle, requestId, arrayOf(*args))) {
+            pendingReplies.remove(requestId)
+            return 0
+        }
+        return requestId
+    }
+
+    fun setPropertyAsync(
+        name: String,
+        value: String,
+        onReply: ((AsyncResult) -> Unit)? = null
+    ): Long {
+        if (nativeHandle == 0L) return 0
+        val requestId = registerReply(onReply)
+        if (!nativeSetPropertyAsync(nativeHandle, requestId, name, value)) {
+            pendingReplies.remove(requestId)
+            return 0
+        }
+        return requestId
+    }
+
+    /**
+     * Aborts an in-flight command. Its reply is still delivered, carrying an error.
+     * Property writes cannot be aborted by mpv.
+     */
+    fun cancel(requestId: Long) {
+        if (nativeHandle == 0L || requestId == 0L) return
+        nativeAbortAsync(nativeHandle, requestId)
+    }
+
+    fun addExternalTrackAsync(
+        type: TrackType,
+        path: String,
+        onReply: ((AsyncResult) -> Unit)? = null
+    ): Long {
+        if (path.isEmpty()) return 0
+        val command =
+            when (type) {
+                TrackType.AUDIO -> "audio-add"
+                TrackType.SUBTITLE -> "sub-add"
+                else -> return 0
+            }
+        return commandAsync(command, path, "select", onReply = onReply)
+    }
+
+    fun setShadersAsync(
+        value: String,
+        onReply: ((AsyncResult) -> Unit)? = null
+    ): Long = commandAsync("change-list", "glsl-shaders", "set", value, onReply = onReply)
+
+    fun clearShadersAsync(onReply: ((AsyncResult) -> Unit)? = null): Long =
+        commandAsync("change-list", "glsl-shaders", "clr", "", onReply = onReply)
+
     fun play() {
         if (nativeHandle != 0L) nativePlay(nativeHandle)
     }
@@ -144,24 +339,118 @@ class MpvNativeBridge {
         if (nativeHandle != 0L) nativeStop(nativeHandle)
     }
 
+    // The setters below are issued asynchronously so the caller (usually the main thread)
+    // never waits for a core that is busy opening a stream or seeking. The blocking native
+    // call is only used when mpv refuses to queue the request.
+
     fun seek(positionMs: Long) {
-        if (nativeHandle != 0L) nativeSeek(nativeHandle, positionMs)
+        if (nativeHandle == 0L) return
+        if (commandAsync("seek", formatSeconds(positionMs), "absolute+exact", onReply = ::logAsyncFailure) == 0L) {
+            nativeSeek(nativeHandle, positionMs)
+        }
+    }
+
+    // Seek-bar drag: while scrubbing only keyframe seeks are sent, one at a time, and updates
+    // arriving in between replace each other natively. scrubEnd() issues the exact seek.
+
+    fun scrubBegin() {
+        if (nativeHandle == 0L) return
+        nativeScrubBegin(nativeHandle)
+    }
+
+    fun scrubUpdate(positionMs: Long): Boolean {
+        if (nativeHandle == 0L) return false
+        return nativeScrubUpdate(nativeHandle, positionMs)
+    }
+
+    fun scrubEnd(positionMs: Long) {
+        if (nativeHandle == 0L) return
+        if (!nativeScrubEnd(nativeHandle, positionMs)) {
+            seek(positionMs)
+        }
     }
 
     fun setSpeed(speed: Float) {
-        if (nativeHandle != 0L) nativeSetSpeed(nativeHandle, speed)
+        if (nativeHandle == 0L) return
+        if (setPropertyAsync("speed", speed.toString(), onReply = ::logAsyncFailure) == 0L) {
+            nativeSetSpeed(nativeHandle, speed)
+        }
     }
 
     fun setVolume(volume: Float) {
-        if (nativeHandle != 0L) nativeSetVolume(nativeHandle, volume)
+        if (nativeHandle == 0L) return
+        if (setPropertyAsync("volume", (volume * 100f).toString(), onReply = ::logAsyncFailure) == 0L) {
+            nativeSetVolume(nativeHandle, volume)
+        }
     }
 
     fun setLooping(looping: Boolean) {
-        if (nativeHandle != 0L) nativeSetLooping(nativeHandle, looping)
+        if (nativeHandle == 0L) return
+        val value = if (looping) "inf" else "no"
+        if (setPropertyAsync("loop-file", value, onReply = ::logAsyncFailure) == 0L) {
+            nativeSetLooping(nativeHandle, looping)
+        }
+    }
+
+    /**
+     * Loops between [startMs] and [endMs] (mpv ab-loop); a negative value clears that point.
+     */
+    fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        if (nativeHandle == 0L) return false
+        return nativeSetAbLoop(nativeHandle, startMs, endMs)
+    }
+
+    /**
+     * Shows the next (or previous) frame and leaves playback paused. Returns false when the
+     * step was dropped because the previous one has not landed yet.
+     */
+    fun frameStep(backward: Boolean): Boolean {
+        if (nativeHandle == 0L) return false
+        return nativeFrameStep(nativeHandle, backward)
+    }
+
+    /**
+     * Seeks to [startMs], plays and pauses on the last frame before [endMs]; completion is
+     * reported as [Event.SegmentEnded]. The end is watched by the native event loop, so
+     * event listeners must be registered.
+     */
+    fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        if (nativeHandle == 0L) return false
+        return nativePlaySegment(nativeHandle, startMs, endMs)
+    }
+
+    fun cancelSegment() {
+        if (nativeHandle == 0L) return
+        nativeCancelSegment(nativeHandle)
+    }
+
+    fun setSessionRole(role: SessionRole) {
+        if (nativeHandle == 0L) return
+        nativeSetSessionRole(nativeHandle, role.nativeValue)
+    }
+
+    fun setResourceBudget(budget: ResourceBudget) {
+        if (nativeHandle == 0L) return
+        nativeSetResourceBudget(
+            nativeHandle,
+            budget.demuxerMaxBytes,
+            budget.demuxerMaxBackBytes,
+            budget.decoderThreads,
+            budget.hwdec,
+        )
     }
 
     fun setSubtitleDelay(offsetMs: Long) {
-        if (nativeHandle != 0L) nativeSetSubtitleDelay(nativeHandle, offsetMs)
+        if (nativeHandle == 0L) return
+        if (setPropertyAsync("sub-delay", formatSeconds(offsetMs), onReply = ::logAsyncFailure) == 0L) {
+            nativeSetSubtitleDelay(nativeHandle, offsetMs)
+        }
     }
 
     fun applyDefaultOptions(logLevel: LogLevel?) {
@@ -218,6 +507,15 @@ class MpvNativeBridge {
     fun setVideoOutput(output: String) {
         if (nativeHandle == 0L) return
         if (output.isBlank()) return
+        if (output == MpvOptions.VO_LIBMPV) {
+            // vo=libmpv is selected natively once the render thread has a surface.
+            if (renderApiEnabled) return
+            renderApiEnabled = nativeSetRenderApi(nativeHandle, true)
+            if (renderApiEnabled) return
+            Log.w(TAG, "render API output unavailable, using ${MpvOptions.VO_GPU}: ${lastError().orEmpty()}")
+            setOption("vo", MpvOptions.VO_GPU)
+            return
+        }
         setOption("vo", output)
     }
 
@@ -378,6 +676,12 @@ class MpvNativeBridge {
         arg2: Long,
         message: String?
     ) {
+        if (type == EVENT_COMMAND_REPLY || type == EVENT_SET_PROPERTY_REPLY) {
+            val callback = pendingReplies.remove(arg1) ?: return
+            val result = AsyncResult(arg1, arg2.toInt(), message)
+            mainHandler.post { runCatching { callback(result) } }
+            return
+        }
         val event =
             when (type) {
                 EVENT_PREPARED -> Event.Prepared
@@ -388,6 +692,8 @@ class MpvNativeBridge {
                 EVENT_BUFFERING_END -> Event.Buffering(false)
                 EVENT_ERROR -> Event.Error(arg1.toInt(), arg2.toInt(), message)
                 EVENT_LOG_MESSAGE -> Event.LogMessage(arg1.toInt(), message)
+                EVENT_SCRUB_SETTLED -> Event.ScrubSettled(arg1, arg2.toInt())
+                EVENT_SEGMENT_END -> Event.SegmentEnded(arg1, arg2 != 0L)
                 else -> null
             }
 
@@ -410,12 +716,122 @@ class MpvNativeBridge {
         }
     }
 
+    private fun registerReply(onReply: ((AsyncResult) -> Unit)?): Long {
+        val requestId = requestIds.incrementAndGet()
+        onReply?.let { pendingReplies[requestId] = it }
+        return requestId
+    }
+
+    private fun logAsyncFailure(result: AsyncResult) {
+        if (!result.success) {
+            Log.w(TAG, "mpv async request ${result.requestId} failed: ${result.error} ${result.message.orEmpty()}")
+        }
+    }
+
+    private fun formatSeconds(milliseconds: Long): String = String.format(Locale.US, "%.3f", milliseconds / 1000.0)
+
+    private fun startVsync() {
+        mainHandler.post {
+            if (vsyncActive || nativeHandle == 0L) return@post
+            vsyncActive = true
+            Choreographer.getInstance().postFrameCallback(vsyncCallback)
+        }
+    }
+
+    private fun stopVsync() {
+        mainHandler.post {
+            vsyncActive = false
+            Choreographer.getInstance().removeFrameCallback(vsyncCallback)
+        }
+    }
+
     private fun startEventLoop() {
         if (eventLoopStarted || nativeHandle == 0L) return
         nativeStartEventLoop(nativeHandle, this)
         eventLoopStarted = true
     }
 
+    /**
+     * Role of this session when several run at once (PiP preview, side-by-side comparison).
+     * The native arbiter downgrades background sessions: software decoding, a small demuxer
+     * cache and cheaper decoding, so the foreground session keeps its frame rate.
+     * [MpvVideoPlayer] claims [FOREGROUND] for the main player; seekbar thumbnails do not use
+     * a session ([MpvThumbnailEngine] runs its own headless instance with reduced settings).
+     */
+    enum class SessionRole(
+        internal val nativeValue: Int
+    ) {
+        FOREGROUND(0),
+        BACKGROUND(1)
+    }
+
+    /**
+     * Resources the session may use in the foreground; defaults are mpv's own. Hardware
+     * decoding is further limited by the process-wide decoder slots of the arbiter.
+     * [decoderThreads] 0 lets libavcodec decide and applies from the next decoder init.
+     */
+    data class ResourceBudget(
+        val demuxerMaxBytes: Long = 150L shl 20,
+        val demuxerMaxBackBytes: Long = 50L shl 20,
+        val decoderThreads: Int = 0,
+        val hwdec: Boolean = true
+    )
+
+    /**
+     * Decoded native error slot (see ErrorSlot in mpv_bridge.cpp). [messageId] is stable for
+     * the process lifetime; [sequence] changes with every recorded failure, so a repeated
+     * failure can be told apart from a stale one.
+     */
+    data class NativeError(
+        val code: Int,
+        val messageId: Int,
+        val sequence: Int,
+        val message: String
+    ) {
+        fun describe(): String = if (code != 0) "$message: $code" else message
+
+        internal companion object {
+            fun decode(
+                state: Long,
+                messageOf: (Int) -> String?
+            ): NativeError? {
+                val messageId = ((state ushr 32) and 0xFFFF).toInt()
+                if (messageId == 0) return null
+                return NativeError(
+                    code = state.toInt(),
+                    messageId = messageId,
+                    sequence = ((state ushr 48) and 0xFFFF).toInt(),
+                    message = messageOf(messageId) ?: "mpv bridge error #$messageId",
+                )
+            }
+        }
+    }
+
+    /**
+     * [lastDestroyCallUs] is the time [destroy] blocked its caller; teardown times run from
+     * that call until the reaper finished the session.
+     */
+    data class LifecycleMetrics(
+        val sessionsCreated: Long,
+        val handlesReused: Long,
+        val handlesRecycled: Long,
+        val sessionsReaped: Long,
+        val lastDestroyCallUs: Long,
+        val lastTeardownMs: Long,
+        val maxTeardownMs: Long,
+        val totalTeardownMs: Long
+    ) {
+        val reuseRate: Float
+            get() = if (sessionsCreated > 0) handlesReused.toFloat() / sessionsCreated else 0f
+
+        val averageTeardownMs: Long
+            get() = if (sessionsReaped > 0) totalTeardownMs / sessionsReaped else 0L
+
+        internal companion object {
+            const val FIELD_COUNT = 8
+        }
+    }
+
     companion object {
         private const val EVENT_PREPARED = 1
         private const val EVENT_VIDEO_SIZE = 2
@@ -425,6 +841,10 @@ class MpvNativeBridge {
         private const val EVENT_BUFFERING_START = 6
         private const val EVENT_BUFFERING_END = 7
         private const val EVENT_LOG_MESSAGE = 8
+        private const val EVENT_COMMAND_REPLY = 9
+        private const val EVENT_SET_PROPERTY_REPLY = 10
+        private const val EVENT_SCRUB_SETTLED = 11
+        private const val EVENT_SEGMENT_END = 12
 
         const val TRACK_TYPE_AUDIO = 1
         const val TRACK_TYPE_SUBTITLE = 2
@@ -436,6 +856,9 @@ class MpvNativeBridge {
         @Volatile
         private var appContextRegistered: Boolean = false
 
+        // Interned on the native side and never reused, so ids can be cached forever.
+        private val errorMessages = ConcurrentHashMap<Int, String>()
+
         init {
             var loaded = false
             var linked = false
@@ -445,7 +868,7 @@ class MpvNativeBridge {
                 loaded = true
                 linked = nativeIsLinked()
                 if (!linked) {
-                    availability = nativeLastError()
+                    availability = NativeError.decode(nativeErrorState(0L)) { errorMessage(it) }?.describe()
                         ?: "libmpv.so not packaged; mpv bridge will operate in stub mode"
                     Log.w(TAG, availability)
                 }
@@ -461,6 +884,31 @@ class MpvNativeBridge {
             availabilityMessage = availability
         }
 
+        /**
+         * Whether mpv_bridge loaded and links libmpv; also gates [MpvThumbnailEngine].
+         */
+        val isNativeAvailable: Boolean
+            get() = nativeLoaded && nativeLinked
+
+        /**
+         * Process-wide session lifecycle counters, see nativeLifecycleMetrics in mpv_bridge.cpp.
+         */
+        fun lifecycleMetrics(): LifecycleMetrics? {
+            if (!nativeLoaded) return null
+            val values = nativeLifecycleMetrics() ?: return null
+            if (values.size < LifecycleMetrics.FIELD_COUNT) return null
+            return LifecycleMetrics(
+                sessionsCreated = values[0],
+                handlesReused = values[1],
+                handlesRecycled = values[2],
+                sessionsReaped = values[3],
+                lastDestroyCallUs = values[4],
+                lastTeardownMs = values[5],
+                maxTeardownMs = values[6],
+                totalTeardownMs = values[7],
+            )
+        }
+
         fun registerAndroidAppContext(context: Context) {
             if (!nativeLoaded || !nativeLinked || appContextRegistered) return
             try {
@@ -471,8 +919,15 @@ class MpvNativeBridge {
             }
         }
 
+        private fun errorMessage(messageId: Int): String? =
+            errorMessages[messageId]
+                ?: nativeErrorMessage(messageId)?.also { errorMessages[messageId] = it }
+
+        @JvmStatic
+        private external fun nativeErrorState(handle: Long): Long
+
         @JvmStatic
-        private external fun nativeLastError(): String?
+        private external fun nativeErrorMessage(messageId: Int): String?
 
         @JvmStatic
         private external fun nativeIsLinked(): Boolean
@@ -481,7 +936,13 @@ class MpvNativeBridge {
         private external fun nativeCreate(): Long
 
         @JvmStatic
-        private external fun nativeDestroy(handle: Long)
+        private external fun nativeDestroy(
+            handle: Long,
+            recycle: Boolean
+        )
+
+        @JvmStatic
+        private external fun nativeLifecycleMetrics(): LongArray?
 
         @JvmStatic
         private external fun nativeSetSurface(
@@ -562,6 +1023,35 @@ class MpvNativeBridge {
             headers: Array<String>?
         ): Boolean
 
+        @JvmStatic
+        private external fun nativeSetDataSourceAsync(
+            handle: Long,
+            requestId: Long,
+            path: String,
+            headers: Array<String>?
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeCommandAsync(
+            handle: Long,
+            requestId: Long,
+            args: Array<String>
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeSetPropertyAsync(
+            handle: Long,
+            requestId: Long,
+            name: String,
+            value: String
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeAbortAsync(
+            handle: Long,
+            requestId: Long
+        )
+
         @JvmStatic
         private external fun nativePlay(handle: Long)
 
@@ -571,12 +1061,54 @@ class MpvNativeBridge {
         @JvmStatic
         private external fun nativeStop(handle: Long)
 
+        @JvmStatic
+        private external fun nativeSetRenderApi(
+            handle: Long,
+            enabled: Boolean
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeOnVsync(
+            handle: Long,
+            frameTimeNanos: Long
+        )
+
+        @JvmStatic
+        private external fun nativeSetSubtitleCompositor(
+            handle: Long,
+            subtitleHandle: Long
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeSetSubtitleCompositorOffset(
+            handle: Long,
+            offsetMs: Long
+        )
+
+        @JvmStatic
+        private external fun nativeInvalidateSubtitleCompositor(handle: Long)
+
         @JvmStatic
         private external fun nativeSeek(
             handle: Long,
             positionMs: Long
         )
 
+        @JvmStatic
+        private external fun nativeScrubBegin(handle: Long)
+
+        @JvmStatic
+        private external fun nativeScrubUpdate(
+            handle: Long,
+            positionMs: Long
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeScrubEnd(
+            handle: Long,
+            positionMs: Long
+        ): Boolean
+
         @JvmStatic
         private external fun nativeSetSpeed(
             handle: Long,
@@ -595,6 +1127,44 @@ class MpvNativeBridge {
             looping: Boolean
         )
 
+        @JvmStatic
+        private external fun nativeSetAbLoop(
+            handle: Long,
+            startMs: Long,
+            endMs: Long
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeFrameStep(
+            handle: Long,
+            backward: Boolean
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativePlaySegment(
+            handle: Long,
+            startMs: Long,
+            endMs: Long
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeCancelSegment(handle: Long)
+
+        @JvmStatic
+        private external fun nativeSetSessionRole(
+            handle: Long,
+            role: Int
+        )
+
+        @JvmStatic
+        private external fun nativeSetResourceBudget(
+            handle: Long,
+            demuxerMaxBytes: Long,
+            demuxerMaxBackBytes: Long,
+            decoderThreads: Int,
+            hwdec: Boolean
+        )
+
         @JvmStatic
         private external fun nativeSetSubtitleDelay(
             handle: Long,
@@ -5,20 +5,28 @@ internal object MpvOptions {
     const val VO_GPU_NEXT = "gpu-next"
     const val VO_MEDIACODEC_EMBED = "mediacodec_embed"
 
+    // Render API: mpv draws into an EGL surface owned by the bridge's render thread.
+    const val VO_LIBMPV = "libmpv"
+
     fun resolveVideoOutput(configured: String?): String {
         val normalized = configured.orEmpty().trim()
         return when {
             normalized.equals(VO_GPU_NEXT, ignoreCase = true) -> VO_GPU_NEXT
             normalized.equals(VO_MEDIACODEC_EMBED, ignoreCase = true) -> VO_MEDIACODEC_EMBED
+            normalized.equals(VO_LIBMPV, ignoreCase = true) -> VO_LIBMPV
             else -> VO_GPU
         }
     }
 
     fun isGpuVideoOutput(configured: String?): Boolean =
         when (resolveVideoOutput(configured)) {
-            VO_GPU, VO_GPU_NEXT -> true
+            VO_GPU, VO_GPU_NEXT, VO_LIBMPV -> true
             else -> false
         }
 
-    fun isAnime4kSupportedVideoOutput(configured: String?): Boolean = resolveVideoOutput(configured) == VO_GPU
+    fun isAnime4kSupportedVideoOutput(configured: String?): Boolean =
+        when (resolveVideoOutput(configured)) {
+            VO_GPU, VO_LIBMPV -> true
+            else -> false
+        }
 }
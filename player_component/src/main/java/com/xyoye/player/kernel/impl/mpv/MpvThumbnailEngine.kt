@@ -0,0 +1,93 @@
+package com.xyoye.player.kernel.impl.mpv
+
+import java.io.File
+
+/**
+ * Headless mpv instance that renders seekbar/episode preview frames with the software
+ * render API (no surface, no GPU) into a sprite-sheet cache file read by
+ * [MpvThumbnailSheet]. The native side lowers the priority of its own threads.
+ *
+ * [generate] blocks until the file is written, so call it from a background thread;
+ * one engine runs one job at a time. [cancel] may be called from any thread, [release]
+ * only once [generate] has returned.
+ */
+class MpvThumbnailEngine {
+    data class Spec(
+        val tileWidth: Int = 160,
+        val intervalMs: Int = 10_000,
+        val columns: Int = 10,
+        val rows: Int = 10,
+        val maxFrames: Int = 240
+    )
+
+    @Volatile
+    private var handle: Long = if (MpvNativeBridge.isNativeAvailable) nativeCreate() else 0L
+
+    val isAvailable: Boolean
+        get() = handle != 0L
+
+    fun generate(
+        path: String,
+        cacheFile: File,
+        spec: Spec = Spec()
+    ): Boolean {
+        val current = handle
+        if (current == 0L) return false
+        cacheFile.parentFile?.mkdirs()
+        return nativeGenerate(
+            current,
+            path,
+            cacheFile.absolutePath,
+            spec.tileWidth,
+            spec.intervalMs,
+            spec.columns,
+            spec.rows,
+            spec.maxFrames,
+        )
+    }
+
+    fun cancel() {
+        val current = handle
+        if (current == 0L) return
+        nativeCancel(current)
+    }
+
+    fun lastError(): String? {
+        val current = handle
+        if (current == 0L) return "mpv thumbnail engine unavailable"
+        return nativeLastError(current)
+    }
+
+    fun release() {
+        val current = handle
+        if (current == 0L) return
+        handle = 0L
+        nativeDestroy(current)
+    }
+
+    private companion object {
+        @JvmStatic
+        private external fun nativeCreate(): Long
+
+        @JvmStatic
+        private external fun nativeDestroy(handle: Long)
+
+        @JvmStatic
+        private external fun nativeGenerate(
+            handle: Long,
+            path: String,
+            cachePath: String,
+            tileWidth: Int,
+            intervalMs: Int,
+            columns: Int,
+            rows: Int,
+            maxFrames: Int
+        ): Boolean
+
+        @JvmStatic
+        private external fun nativeCancel(handle: Long)
+
+        @JvmStatic
+        private external fun nativeLastError(handle: Long): String?
+    }
+}
@@ -0,0 +1,176 @@
+package com.xyoye.player.kernel.impl.mpv
+
+import android.graphics.Bitmap
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.ShortBuffer
+import java.util.zip.Inflater
+
+/**
+ * Reader for the sprite-sheet cache written by [MpvThumbnailEngine]; the layout is
+ * documented in mpv_thumbnail.h. Sheets are inflated on demand and the most recent one
+ * is kept, since hover lookups usually stay on neighbouring frames.
+ *
+ * Not thread-safe.
+ */
+class MpvThumbnailSheet private constructor(
+    private val file: File,
+    val tileWidth: Int,
+    val tileHeight: Int,
+    private val columns: Int,
+    private val rows: Int,
+    val durationMs: Long,
+    private val framePts: LongArray,
+    private val sheetOffsets: LongArray,
+    private val sheetCompressedBytes: IntArray,
+    private val sheetRawBytes: IntArray
+) {
+    private var cachedSheetIndex = -1
+    private var cachedSheet: ShortArray? = null
+
+    val frameCount: Int
+        get() = framePts.size
+
+    fun framePtsMs(index: Int): Long = framePts[index]
+
+    /**
+     * Index of the last frame at or before [positionMs]; the first frame for earlier
+     * positions.
+     */
+    fun frameIndexAt(positionMs: Long): Int {
+        var low = 0
+        var high = framePts.size - 1
+        var found = 0
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            if (framePts[mid] <= positionMs) {
+                found = mid
+                low = mid + 1
+            } else {
+                high = mid - 1
+            }
+        }
+        return found
+    }
+
+    /**
+     * RGB565 pixels of frame [index], row by row; null when the sheet cannot be read.
+     */
+    fun tilePixels(index: Int): ShortArray? {
+        if (index !in framePts.indices) return null
+        val tilesPerSheet = columns * rows
+        val sheet = loadSheet(index / tilesPerSheet) ?: return null
+        val tile = index % tilesPerSheet
+        val sheetStride = columns * tileWidth
+        val originX = (tile % columns) * tileWidth
+        val originY = (tile / columns) * tileHeight
+        val pixels = ShortArray(tileWidth * tileHeight)
+        for (y in 0 until tileHeight) {
+            System.arraycopy(sheet, (originY + y) * sheetStride + originX, pixels, y * tileWidth, tileWidth)
+        }
+        return pixels
+    }
+
+    fun decodeFrame(index: Int): Bitmap? {
+        val pixels = tilePixels(index) ?: return null
+        return Bitmap.createBitmap(tileWidth, tileHeight, Bitmap.Config.RGB_565).apply {
+            copyPixelsFromBuffer(ShortBuffer.wrap(pixels))
+        }
+    }
+
+    private fun loadSheet(sheetIndex: Int): ShortArray? {
+        if (sheetIndex == cachedSheetIndex) return cachedSheet
+        if (sheetIndex !in sheetOffsets.indices) return null
+        val compressed = ByteArray(sheetCompressedBytes[sheetIndex])
+        val raw = ByteArray(sheetRawBytes[sheetIndex])
+        val inflated =
+            runCatching {
+                RandomAccessFile(file, "r").use { input ->
+                    input.seek(sheetOffsets[sheetIndex])
+                    input.readFully(compressed)
+                }
+                val inflater = Inflater()
+                try {
+                    inflater.setInput(compressed)
+                    inflater.inflate(raw)
+                } finally {
+                    inflater.end()
+                }
+            }.getOrNull() ?: return null
+        if (inflated != raw.size) return null
+        val pixels = ShortArray(raw.size / 2)
+        ByteBuffer.wrap(raw).order(ByteOrder.LITTLE_ENDIAN).asShortBuffer().get(pixels)
+        cachedSheetIndex = sheetIndex
+        cachedSheet = pixels
+        return pixels
+    }
+
+    companion object {
+        private const val MAGIC = 0x48544444 // "DDTH"
+        private const val VERSION = 1
+        private const val HEADER_BYTES = 40
+        private const val SHEET_ENTRY_BYTES = 16
+
+        /**
+         * Returns null for a missing, truncated or foreign file, so callers simply regenerate.
+         */
+        fun open(file: File): MpvThumbnailSheet? {
+            if (!file.isFile) return null
+            return runCatching {
+                RandomAccessFile(file, "r").use { input ->
+                    val header = readLittleEndian(input, HEADER_BYTES)
+                    if (header.int != MAGIC || header.int != VERSION) return null
+                    val tileWidth = header.int
+                    val tileHeight = header.int
+                    val columns = header.int
+                    val rows = header.int
+                    val frameCount = header.int
+                    val sheetCount = header.int
+                    val durationMs = header.long
+                    if (tileWidth <= 0 || tileHeight <= 0 || columns <= 0 || rows <= 0 || frameCount <= 0) {
+                        return null
+                    }
+                    if (sheetCount != (frameCount + columns * rows - 1) / (columns * rows)) return null
+
+                    val index = readLittleEndian(input, frameCount * 8 + sheetCount * SHEET_ENTRY_BYTES)
+                    val framePts = LongArray(frameCount) { index.long }
+                    val offsets = LongArray(sheetCount)
+                    val compressedBytes = IntArray(sheetCount)
+                    val rawBytes = IntArray(sheetCount)
+                    val expectedRaw = columns * tileWidth * rows * tileHeight * 2
+                    for (i in 0 until sheetCount) {
+                        offsets[i] = index.long
+                        compressedBytes[i] = index.int
+                        rawBytes[i] = index.int
+                        if (rawBytes[i] != expectedRaw || offsets[i] + compressedBytes[i] > input.length()) {
+                            return null
+                        }
+                    }
+                    MpvThumbnailSheet(
+                        file,
+                        tileWidth,
+                        tileHeight,
+                        columns,
+                        rows,
+                        durationMs,
+                        framePts,
+                        offsets,
+                        compressedBytes,
+                        rawBytes,
+                    )
+                }
+            }.getOrNull()
+        }
+
+        private fun readLittleEndian(
+            input: RandomAccessFile,
+            size: Int
+        ): ByteBuffer {
+            val bytes = ByteArray(size)
+            input.readFully(bytes)
+            return ByteBuffer.wrap(bytes).order(ByteOrder.LITTLE_ENDIAN)
+        }
+    }
+}
@@ -69,6 +69,8 @@ class MpvVideoPlayer(
             failInitialization(reason)
             return
         }
+        // The main player keeps the hardware decoder slot when a preview session runs next to it
+        nativeBridge.setSessionRole(MpvNativeBridge.SessionRole.FOREGROUND)
         setOptions()
     }
 
@@ -138,6 +140,14 @@ class MpvVideoPlayer(
         setAnime4kMode(anime4kMode)
     }
 
+    /**
+     * Render-API output draws from its own thread, which must let go of the surface before
+     * surfaceDestroyed() returns. The wid path keeps its existing behaviour.
+     */
+    fun releaseRenderSurface() {
+        nativeBridge.releaseRenderSurface()
+    }
+
     fun setSurfaceSize(
         width: Int,
         height: Int
@@ -204,12 +214,14 @@ class MpvVideoPlayer(
         val outputSupported = MpvOptions.isAnime4kSupportedVideoOutput(PlayerConfig.getMpvVideoOutput())
 
         if (safeMode == Anime4kShaderManager.MODE_OFF || outputSupported) {
-            if (!nativeBridge.clearShaders()) {
-                LogFacade.w(
-                    LogModule.PLAYER,
-                    "MpvVideoPlayer",
-                    "clearShaders failed: ${nativeBridge.lastError().orEmpty()}",
-                )
+            nativeBridge.clearShadersAsync { result ->
+                if (!result.success) {
+                    LogFacade.w(
+                        LogModule.PLAYER,
+                        "MpvVideoPlayer",
+                        "clearShaders failed: ${result.message ?: result.error}",
+                    )
+                }
             }
         }
 
@@ -229,14 +241,25 @@ class MpvVideoPlayer(
         }
 
         val shaderList = shaderPaths.joinToString(separator = ":")
-        if (nativeBridge.setShaders(shaderList)) {
-            return
+        val requestId =
+            nativeBridge.setShadersAsync(shaderList) { result ->
+                if (!result.success && anime4kMode == safeMode) {
+                    appendShaders(shaderPaths, result.message ?: result.error.toString())
+                }
+            }
+        if (requestId == 0L) {
+            appendShaders(shaderPaths, nativeBridge.lastError().orEmpty())
         }
+    }
 
+    private fun appendShaders(
+        shaderPaths: List<String>,
+        setShadersError: String
+    ) {
         LogFacade.w(
             LogModule.PLAYER,
             "MpvVideoPlayer",
-            "setShaders failed, fallback to append: ${nativeBridge.lastError().orEmpty()}",
+            "setShaders failed, fallback to append: $setShadersError",
         )
 
         shaderPaths.forEach { path ->
@@ -278,7 +301,16 @@ class MpvVideoPlayer(
                     val playServer = HttpPlayServer.getInstance()
                     nativeBridge.setForceSeekable(playServer.isServingUrl(path))
                 }.getOrNull()
-                nativeBridge.setDataSource(path, headers)
+                nativeBridge.setDataSourceAsync(path, headers) { result ->
+                    // loadfile runs on the mpv core; only a rejected load ends up here.
+                    if (!result.success && isPreparing) {
+                        isPreparing = false
+                        failInitialization(
+                            "mpv loadfile failed: ${result.message ?: result.error}",
+                            code = result.error,
+                        )
+                    }
+                }
             } catch (e: Exception) {
                 dataSourceError = e
                 ErrorReportHelper.postCatchedExceptionWithContext(
@@ -335,7 +367,21 @@ class MpvVideoPlayer(
         clearPlayerEventListener()
         stop()
         nativeBridge.clearEventListener()
-        nativeBridge.destroy()
+        nativeBridge.destroy(recycle = PlayerConfig.isMpvReuseHandle())
+        // Only the synchronous counters: the session is torn down on the reaper thread after
+        // destroy() returns, so the teardown times would still describe the previous session.
+        MpvNativeBridge.lifecycleMetrics()?.let { metrics ->
+            LogFacade.i(
+                LogModule.PLAYER,
+                "MpvVideoPlayer",
+                "mpv session released",
+                context =
+                    mapOf(
+                        "destroyCallUs" to metrics.lastDestroyCallUs.toString(),
+                        "reuseRate" to "%.2f".format(metrics.reuseRate),
+                    ),
+            )
+        }
         isPrepared = false
         isPreparing = false
         isPlaying = false
@@ -344,19 +390,58 @@ class MpvVideoPlayer(
 
     override fun seekTo(timeMs: Long) {
         if (!isPrepared) return
-        if (!proxySeekEnabled) {
-            val path = dataSource
-            if (!path.isNullOrEmpty()) {
-                val isLocalProxy = runCatching { HttpPlayServer.getInstance().isServingUrl(path) }.getOrDefault(false)
-                if (isLocalProxy) {
-                    pendingSeekMs = timeMs
-                    return
-                }
-            }
+        if (!proxySeekEnabled && isServingLocalProxy()) {
+            pendingSeekMs = timeMs
+            return
         }
         nativeBridge.seek(timeMs)
     }
 
+    override fun beginScrub() {
+        if (!isPrepared || !proxySeekEnabled && isServingLocalProxy()) return
+        nativeBridge.scrubBegin()
+    }
+
+    override fun updateScrub(timeMs: Long) {
+        if (!isPrepared || !proxySeekEnabled && isServingLocalProxy()) return
+        nativeBridge.scrubUpdate(timeMs)
+    }
+
+    override fun endScrub(timeMs: Long) {
+        if (!isPrepared) return
+        if (!proxySeekEnabled && isServingLocalProxy()) {
+            pendingSeekMs = timeMs
+            return
+        }
+        nativeBridge.scrubEnd(timeMs)
+    }
+
+    override fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        if (!isPrepared) return false
+        return nativeBridge.setAbLoop(startMs, endMs)
+    }
+
+    override fun stepFrame(backward: Boolean): Boolean {
+        if (!isPrepared) return false
+        if (!nativeBridge.frameStep(backward)) return false
+        // mpv pauses after every step
+        isPlaying = false
+        return true
+    }
+
+    override fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        if (!isPrepared || !proxySeekEnabled && isServingLocalProxy()) return false
+        if (!nativeBridge.playSegment(startMs, endMs)) return false
+        isPlaying = true
+        return true
+    }
+
     override fun setSpeed(speed: Float) {
         playbackSpeed = speed
         if (!isPrepared) return
@@ -420,7 +505,17 @@ class MpvVideoPlayer(
 
     override fun addTrack(track: VideoTrackBean): Boolean {
         val path = track.trackResource as? String ?: return false
-        return nativeBridge.addExternalTrack(track.type, path)
+        val requestId =
+            nativeBridge.addExternalTrackAsync(track.type, path) { result ->
+                if (!result.success) {
+                    LogFacade.w(
+                        LogModule.PLAYER,
+                        "MpvVideoPlayer",
+                        "addTrack failed: type=${track.type} reason=${result.message ?: result.error}",
+                    )
+                }
+            }
+        return requestId != 0L
     }
 
     override fun getTracks(type: TrackType): List<VideoTrackBean> {
@@ -556,6 +651,24 @@ class MpvVideoPlayer(
                 }
                 mPlayerEventListener.onInfo(PlayerConstant.MEDIA_INFO_VIDEO_RENDERING_START, 0)
             }
+            is MpvNativeBridge.Event.ScrubSettled -> {
+                LogFacade.i(
+                    LogModule.PLAYER,
+                    "MpvVideoPlayer",
+                    "scrub release to first frame: ${event.latencyMs}ms",
+                    context =
+                        mapOf(
+                            "latencyMs" to event.latencyMs.toString(),
+                            "coalescedUpdates" to event.coalescedUpdates.toString(),
+                        ),
+                )
+            }
+            is MpvNativeBridge.Event.SegmentEnded -> {
+                if (event.reachedEnd) {
+                    isPlaying = false
+                    mPlayerEventListener.onInfo(PlayerConstant.MEDIA_INFO_SEGMENT_END, event.positionMs.toInt())
+                }
+            }
             is MpvNativeBridge.Event.VideoSize -> {
                 videoSize = Point(event.width, event.height)
                 mPlayerEventListener.onVideoSizeChange(event.width, event.height)
@@ -563,6 +676,12 @@ class MpvVideoPlayer(
         }
     }
 
+    private fun isServingLocalProxy(): Boolean {
+        val path = dataSource
+        if (path.isNullOrEmpty()) return false
+        return runCatching { HttpPlayServer.getInstance().isServingUrl(path) }.getOrDefault(false)
+    }
+
     private fun refreshDecodeTypeFromNative() {
         if (!nativeBridge.isAvailable) {
             decodeType = DecodeType.SW
@@ -719,7 +838,37 @@ class MpvVideoPlayer(
         return details.joinToString(" | ").ifEmpty { "mpv playback error" }
     }
 
-    override fun canStartGpuSubtitlePipeline(): Boolean = false
+    // An overlay surface cannot be ordered reliably above mpv's video surface, so GPU
+    // subtitles are only offered when the render-API output can composite them itself.
+    override fun canStartGpuSubtitlePipeline(): Boolean = nativeBridge.isRenderApiEnabled
+
+    override fun supportsSubtitleCompositor(): Boolean = nativeBridge.isRenderApiEnabled
+
+    override fun attachSubtitleCompositor(nativeHandle: Long): Boolean {
+        if (!nativeBridge.isRenderApiEnabled) return false
+        val attached = nativeBridge.setSubtitleCompositor(nativeHandle)
+        if (!attached) {
+            LogFacade.w(
+                LogModule.PLAYER,
+                "MpvVideoPlayer",
+                "subtitle compositor attach failed",
+                context = mapOf("reason" to nativeBridge.lastError().orEmpty()),
+            )
+        }
+        return attached
+    }
+
+    override fun detachSubtitleCompositor() {
+        nativeBridge.setSubtitleCompositor(0L)
+    }
+
+    override fun setSubtitleCompositorOffset(offsetMs: Long) {
+        nativeBridge.setSubtitleCompositorOffset(offsetMs)
+    }
+
+    override fun invalidateSubtitleCompositor() {
+        nativeBridge.invalidateSubtitleCompositor()
+    }
 }
 
 private class MpvPlaybackException(
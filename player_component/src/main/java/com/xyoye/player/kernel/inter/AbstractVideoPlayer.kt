@@ -87,6 +87,46 @@ abstract class AbstractVideoPlayer : InterVideoTrack {
      */
     abstract fun seekTo(timeMs: Long)
 
+    /**
+     * 开始拖动进度条，内核可在拖动期间使用低成本的预览跳转
+     */
+    open fun beginScrub() {
+    }
+
+    /**
+     * 拖动中的位置更新，默认不跳转，仅在松手时跳转
+     */
+    open fun updateScrub(timeMs: Long) {
+    }
+
+    /**
+     * 结束拖动，跳转至最终位置
+     */
+    open fun endScrub(timeMs: Long) {
+        seekTo(timeMs)
+    }
+
+    /**
+     * 设置 A-B 循环区间（毫秒），负值表示清除对应端点，默认不支持
+     */
+    open fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ): Boolean = false
+
+    /**
+     * 逐帧步进（backward 为后退一帧），步进后保持暂停，默认不支持
+     */
+    open fun stepFrame(backward: Boolean): Boolean = false
+
+    /**
+     * 播放 [startMs, endMs) 区间后自动暂停，默认不支持
+     */
+    open fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean = false
+
     /**
      * 设置视频倍速
      */
@@ -33,4 +33,40 @@ interface SubtitleKernelBridge {
      * accurate frame callbacks (the session will fall back to choreographer polling).
      */
     fun createFrameDriver(callback: SubtitleFrameDriver.Callback): SubtitleFrameDriver? = null
+
+    /**
+     * Whether the kernel draws GPU subtitles into its own video frames instead of letting the
+     * session stack an overlay surface on top. When true the session hands its native libass
+     * handle to [attachSubtitleCompositor] and does not drive frames itself.
+     */
+    fun supportsSubtitleCompositor(): Boolean = false
+
+    /**
+     * Starts compositing the libass GPU context behind [nativeHandle] into each presented
+     * frame, timed by the kernel's own clock. Returns false when compositing cannot start.
+     */
+    fun attachSubtitleCompositor(nativeHandle: Long): Boolean = false
+
+    /**
+     * Stops compositing. Returns only after the kernel no longer uses the attached handle,
+     * so the caller may destroy it right away.
+     */
+    fun detachSubtitleCompositor() {
+        // default no-op
+    }
+
+    /**
+     * User subtitle offset added to the kernel clock when compositing.
+     */
+    fun setSubtitleCompositorOffset(offsetMs: Long) {
+        // default no-op
+    }
+
+    /**
+     * Requests a redraw of the current frame after subtitle content changed while the video
+     * itself did not (paused seek, new track, opacity).
+     */
+    fun invalidateSubtitleCompositor() {
+        // default no-op
+    }
 }
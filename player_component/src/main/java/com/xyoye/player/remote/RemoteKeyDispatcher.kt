@@ -33,6 +33,8 @@ class RemoteKeyDispatcher(
         fun openPlayerSettings()
 
         fun openEpisodePanel(): Boolean
+
+        fun seekToNextHotMoment()
     }
 
     fun onKeyDown(
@@ -49,6 +51,7 @@ class RemoteKeyDispatcher(
             KeyEvent.KEYCODE_DPAD_UP -> handleUp(state)
             KeyEvent.KEYCODE_DPAD_DOWN -> handleDown(state)
             KeyEvent.KEYCODE_MENU -> handleMenu()
+            KeyEvent.KEYCODE_MEDIA_FAST_FORWARD -> handleHotMoment(state)
             else -> DispatchResult.IGNORED
         }
     }
@@ -116,6 +119,18 @@ class RemoteKeyDispatcher(
         return DispatchResult.CONSUMED
     }
 
+    private fun handleHotMoment(state: UiState): DispatchResult {
+        if (state.isSettingShowing) {
+            return DispatchResult.PASS_TO_CONTROL
+        }
+        if (state.isLocked) {
+            remoteAction.showController()
+            return DispatchResult.CONSUMED
+        }
+        remoteAction.seekToNextHotMoment()
+        return DispatchResult.CONSUMED
+    }
+
     private fun handleMenu(): DispatchResult {
         remoteAction.openPlayerSettings()
         return DispatchResult.CONSUMED
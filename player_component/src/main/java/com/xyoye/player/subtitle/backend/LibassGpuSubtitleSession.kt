@@ -7,9 +7,14 @@ import android.os.SystemClock
 import android.view.Choreographer
 import android.view.Surface
 import androidx.media3.common.util.UnstableApi
+import com.xyoye.common_component.config.SubtitleConfig
 import com.xyoye.common_component.config.SubtitlePreferenceUpdater
 import com.xyoye.common_component.subtitle.SubtitleFontManager
+import com.xyoye.common_component.utils.PathHelper
+import com.xyoye.danmaku.DanmakuStore
+import com.xyoye.danmaku.gpu.GpuDanmakuLayer
 import com.xyoye.data_component.enums.SubtitleFallbackReason
+import com.xyoye.data_component.enums.SubtitleLanguage
 import com.xyoye.data_component.enums.SubtitlePipelineFallbackReason
 import com.xyoye.data_component.enums.SubtitlePipelineMode
 import com.xyoye.data_component.enums.SubtitleViewType
@@ -18,6 +23,9 @@ import com.xyoye.player.kernel.subtitle.SubtitleFrameDriver
 import com.xyoye.player.kernel.subtitle.SubtitleKernelBridge
 import com.xyoye.player.subtitle.ui.SubtitleSurfaceOverlay
 import com.xyoye.player.subtitle.gpu.AssGpuRenderer
+import com.xyoye.player.subtitle.gpu.AssRendererProfile
+import com.xyoye.player.subtitle.gpu.AssTextConversion
+import com.xyoye.player.subtitle.gpu.AssTrackCacheConfig
 import com.xyoye.player.subtitle.gpu.LocalSubtitlePipelineApi
 import com.xyoye.player.subtitle.gpu.SubtitleFallbackController
 import com.xyoye.player.subtitle.gpu.SubtitleOutputTargetTracker
@@ -29,6 +37,7 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.SupervisorJob
 import kotlinx.coroutines.cancel
 import kotlinx.coroutines.launch
+import java.io.File
 import java.util.concurrent.atomic.AtomicBoolean
 
 @UnstableApi
@@ -76,11 +85,37 @@ internal class LibassGpuSubtitleSession(
     private var choreographer: Choreographer? = null
     private var choreographerRunning = false
 
+    // 内核在自己的视频帧里合成字幕时为 true：此时没有 overlay，也不由本会话驱动渲染。
+    private var compositorAttached = false
+
     fun start() {
-        attachOverlay()
+        // 在 surface 绑定前设置，首次建立 EGL 上下文时即可读取缓存的着色器程序
+        gpuRenderer.setProgramCacheFile(
+            runCatching { File(PathHelper.getSubtitleTrackCacheDirectory(), PROGRAM_CACHE_FILE) }.getOrNull(),
+        )
+        if (kernelBridge?.supportsSubtitleCompositor() == true) {
+            if (!attachCompositor()) return
+        } else {
+            attachOverlay()
+        }
         gpuRenderer.updateOpacity(PlayerInitializer.Subtitle.alpha)
+        val rendererProfile = AssRendererProfile.fromPreferences(environment.context)
+        gpuRenderer.setRendererProfile(rendererProfile)
+        val bitmapCacheMb =
+            SubtitleConfig
+                .getAssBitmapCacheMaxMb()
+                .coerceIn(0L, rendererProfile.maxBitmapCacheMb)
+        gpuRenderer.setBitmapCacheBudget(bitmapCacheMb * BYTES_PER_MB)
+        gpuRenderer.setTrackCacheConfig(runCatching { AssTrackCacheConfig.fromPreferences() }.getOrNull())
+        gpuRenderer.setTextConversion(
+            runCatching {
+                AssTextConversion.forLanguage(SubtitleLanguage.fromName(SubtitleConfig.getSubtitleLanguage()))
+            }.getOrNull(),
+        )
         registerEmbeddedSink()
-        startFrameDriver()
+        if (!compositorAttached) {
+            startFrameDriver()
+        }
     }
 
     fun release() {
@@ -94,6 +129,11 @@ internal class LibassGpuSubtitleSession(
             }
         }
         overlay = null
+        if (compositorAttached) {
+            // 同步等待内核停止使用原生句柄，之后才能释放
+            runCatching { kernelBridge?.detachSubtitleCompositor() }
+            compositorAttached = false
+        }
         runCatching { gpuRenderer.release() }
         runCatching { renderThread.quitSafely() }
         runCatching { renderThread.join(1500) }
@@ -104,25 +144,56 @@ internal class LibassGpuSubtitleSession(
     fun loadExternalTrack(path: String) {
         val fonts = buildFontDirectories(environment.context)
         val defaultFont = SubtitleFontManager.getDefaultFontPath(environment.context)
-        gpuRenderer.loadTrack(path, fonts, defaultFont)
-        gpuRenderer.frameCleaner.onTrackChanged()
         val positionMs = environment.playerView?.getCurrentPosition() ?: 0L
+        gpuRenderer.loadTrack(path, fonts, defaultFont, positionMs)
+        gpuRenderer.frameCleaner.onTrackChanged()
         renderOnceIfPaused(positionMs)
+        invalidateCompositor()
     }
 
     fun updateOpacity(alphaPercent: Int) {
         gpuRenderer.updateOpacity(alphaPercent)
+        invalidateCompositor()
     }
 
     fun onSeek(positionMs: Long) {
         gpuRenderer.frameCleaner.onSeek()
         renderOnceIfPaused(positionMs)
+        invalidateCompositor()
     }
 
     fun onOffsetChanged(positionMs: Long) {
+        if (compositorAttached) {
+            kernelBridge?.setSubtitleCompositorOffset(SubtitlePreferenceUpdater.currentOffset())
+        }
         renderOnceIfPaused(positionMs)
     }
 
+    /**
+     * 弹幕只在本会话逐帧驱动 overlay 时绘制：合成模式下帧由内核驱动，没有时机提前光栅化弹幕。
+     */
+    fun supportsDanmaku(): Boolean = overlay != null && !compositorAttached
+
+    /**
+     * 在字幕下方绘制 [store] 的弹幕，null 移除；弹幕时间按弹幕偏移与字幕偏移之差换算到字幕时间。
+     * 返回 false 时已移除之前的弹幕，调用方可以关闭之前传入的弹幕库。
+     */
+    fun setDanmakuStore(
+        store: DanmakuStore?,
+        style: GpuDanmakuLayer.Style,
+        isBlocked: (Int) -> Boolean
+    ): Boolean {
+        if (store != null && !supportsDanmaku()) {
+            gpuRenderer.setDanmakuStore(null)
+            return false
+        }
+        gpuRenderer.setDanmakuStore(store, style, isBlocked) {
+            SubtitlePreferenceUpdater.currentOffset() - PlayerInitializer.Danmu.offsetPosition
+        }
+        renderOnceIfPaused(environment.playerView?.getCurrentPosition() ?: 0L)
+        return true
+    }
+
     override fun onVideoFrame(
         videoPtsMs: Long,
         vsyncId: Long
@@ -231,6 +302,32 @@ internal class LibassGpuSubtitleSession(
             }
         }
 
+    private fun attachCompositor(): Boolean {
+        val bridge = kernelBridge ?: return false
+        val handle = gpuRenderer.obtainNativeHandle()
+        if (handle != 0L && bridge.attachSubtitleCompositor(handle)) {
+            compositorAttached = true
+            bridge.setSubtitleCompositorOffset(SubtitlePreferenceUpdater.currentOffset())
+            return true
+        }
+        // 内核不支持叠加 overlay（画面层级无法保证），只能回退到 CPU 渲染
+        onPipelineError(
+            SubtitlePipelineFallbackReason.UNSUPPORTED_GPU,
+            IllegalStateException("kernel subtitle compositor unavailable"),
+        )
+        return false
+    }
+
+    /**
+     * 字幕内容变化而视频帧未变（暂停中 seek、换轨、透明度）时请求内核重绘当前帧；
+     * 排在渲染线程已提交的操作之后，确保重绘时轨道/参数已生效。
+     */
+    private fun invalidateCompositor() {
+        if (!compositorAttached) return
+        val bridge = kernelBridge ?: return
+        gpuRenderer.runAfterPendingWork { bridge.invalidateSubtitleCompositor() }
+    }
+
     private fun attachOverlay() {
         val playerView = environment.playerView ?: return
         val overlay =
@@ -323,4 +420,11 @@ internal class LibassGpuSubtitleSession(
         val vsyncId = SystemClock.elapsedRealtimeNanos() / 1_000_000L
         gpuRenderer.renderFrame(pts, vsyncId)
     }
+
+    private companion object {
+        const val BYTES_PER_MB = 1024L * 1024L
+
+        // 与字幕解析缓存同目录；该目录的淘汰只处理 .asstrk 文件
+        const val PROGRAM_CACHE_FILE = "ass_gpu_program.bin"
+    }
 }
@@ -4,6 +4,8 @@ import androidx.media3.common.util.UnstableApi
 import com.xyoye.common_component.enums.SubtitleRendererBackend
 import com.xyoye.common_component.log.LogFacade
 import com.xyoye.common_component.log.model.LogModule
+import com.xyoye.danmaku.DanmakuStore
+import com.xyoye.danmaku.gpu.GpuDanmakuLayer
 import com.xyoye.data_component.enums.SurfaceType
 import com.xyoye.player.kernel.subtitle.SubtitleKernelBridge
 import com.xyoye.subtitle.MixedSubtitle
@@ -14,6 +16,7 @@ import com.xyoye.subtitle.MixedSubtitle
  * - Embedded ASS/SSA is fed through the kernel bridge via [EmbeddedSubtitleSink].
  * - External ASS/SSA is loaded directly into the GPU renderer.
  * - Text/bitmap subtitles are still rendered by the legacy controller pipeline.
+ * - File danmaku can be drawn below the subtitles, see [LibassGpuSubtitleSession.setDanmakuStore].
  */
 @UnstableApi
 class LibassRendererBackend(
@@ -72,6 +75,14 @@ class LibassRendererBackend(
         session?.onOffsetChanged(positionMs)
     }
 
+    override fun supportsDanmaku(): Boolean = session?.supportsDanmaku() == true
+
+    override fun setDanmakuStore(
+        store: DanmakuStore?,
+        style: GpuDanmakuLayer.Style,
+        isBlocked: (Int) -> Boolean
+    ): Boolean = session?.setDanmakuStore(store, style, isBlocked) == true
+
     companion object {
         private const val TAG = "LibassRendererBackend"
     }
@@ -2,6 +2,8 @@ package com.xyoye.player.subtitle.backend
 
 import androidx.media3.common.util.UnstableApi
 import com.xyoye.common_component.enums.SubtitleRendererBackend
+import com.xyoye.danmaku.DanmakuStore
+import com.xyoye.danmaku.gpu.GpuDanmakuLayer
 import com.xyoye.data_component.enums.SurfaceType
 import com.xyoye.subtitle.MixedSubtitle
 
@@ -45,4 +47,20 @@ interface SubtitleRenderer {
     fun onOffsetChanged(positionMs: Long) {
         // default no-op
     }
+
+    /**
+     * Whether [setDanmakuStore] would currently take over drawing of file danmaku.
+     */
+    fun supportsDanmaku(): Boolean = false
+
+    /**
+     * Draws the danmaku of [store] in the renderer's own pipeline; null removes them and
+     * must happen before the store is closed.
+     * @return false if the renderer cannot draw danmaku, the caller keeps drawing them.
+     */
+    fun setDanmakuStore(
+        store: DanmakuStore?,
+        style: GpuDanmakuLayer.Style = GpuDanmakuLayer.Style(),
+        isBlocked: (Int) -> Boolean = { false }
+    ): Boolean = false
 }
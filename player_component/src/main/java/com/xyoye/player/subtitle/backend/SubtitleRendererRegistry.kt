@@ -1,19 +1,41 @@
 package com.xyoye.player.subtitle.backend
 
 import androidx.media3.common.util.UnstableApi
+import java.util.concurrent.CopyOnWriteArraySet
 import java.util.concurrent.atomic.AtomicReference
 
 @UnstableApi
 object SubtitleRendererRegistry {
     private val rendererRef = AtomicReference<SubtitleRenderer?>(null)
+    private val listeners = CopyOnWriteArraySet<(SubtitleRenderer?) -> Unit>()
 
     fun register(renderer: SubtitleRenderer) {
         rendererRef.set(renderer)
+        notifyChanged()
     }
 
     fun unregister(renderer: SubtitleRenderer?) {
-        rendererRef.compareAndSet(renderer, null)
+        if (rendererRef.compareAndSet(renderer, null)) {
+            notifyChanged()
+        }
     }
 
     fun current(): SubtitleRenderer? = rendererRef.get()
+
+    /**
+     * [listener] is called with the current renderer on the registering thread whenever
+     * a renderer is registered or unregistered.
+     */
+    fun addListener(listener: (SubtitleRenderer?) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (SubtitleRenderer?) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    private fun notifyChanged() {
+        val renderer = rendererRef.get()
+        listeners.forEach { it(renderer) }
+    }
 }
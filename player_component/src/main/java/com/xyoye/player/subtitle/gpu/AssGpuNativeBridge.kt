@@ -1,28 +1,47 @@
 package com.xyoye.player.subtitle.gpu
 
+import android.graphics.Bitmap
 import android.view.Surface
+import com.xyoye.danmaku.gpu.DanmakuPageSink
 import com.xyoye.data_component.bean.subtitle.SubtitleOutputTarget
 
-class AssGpuNativeBridge {
+class AssGpuNativeBridge : DanmakuPageSink {
     data class NativeRenderResult(
         val rendered: Boolean,
         val renderLatencyMs: Long,
         val uploadLatencyMs: Long,
-        val compositeLatencyMs: Long
+        val compositeLatencyMs: Long,
+        // 静态事件位图缓存的累计命中数与查询数
+        val bitmapCacheHits: Long = 0,
+        val bitmapCacheLookups: Long = 0,
+        // 静态事件位图缓存当前占用，以及 libass 位图缓存上限（libass 不提供实际占用）
+        val bitmapCacheBytes: Long = 0,
+        val libassCacheLimitBytes: Long = 0,
+        // 本帧所用的渲染分辨率档位（SubtitleRenderQuality.nativeValue）
+        val renderQualityLevel: Int = 0
     )
 
     companion object {
         init {
             System.loadLibrary("libass_bridge")
         }
+
+        // 与 ass_gpu_bridge.cpp 中 kRenderMetricCount 保持一致
+        private const val METRIC_COUNT = 8
     }
 
     private var handle: Long = nativeCreate()
-    private val metricsBuffer = LongArray(3)
+    private val metricsBuffer = LongArray(METRIC_COUNT)
 
     val isReady: Boolean
         get() = handle != 0L
 
+    /**
+     * 原生上下文句柄，交给播放内核在其 GL 上下文中合成字幕（见 ass_gpu_compositor.h）。
+     */
+    val nativeHandle: Long
+        get() = handle
+
     fun attachSurface(
         surface: Surface?,
         target: SubtitleOutputTarget
@@ -59,15 +78,18 @@ class AssGpuNativeBridge {
             val rendered = nativeRender(handle, subtitlePtsMs, vsyncId, null)
             NativeRenderResult(rendered = rendered, renderLatencyMs = 0, uploadLatencyMs = 0, compositeLatencyMs = 0)
         } else {
-            metricsBuffer[0] = 0
-            metricsBuffer[1] = 0
-            metricsBuffer[2] = 0
+            metricsBuffer.fill(0)
             val rendered = nativeRender(handle, subtitlePtsMs, vsyncId, metricsBuffer)
             NativeRenderResult(
                 rendered = rendered,
                 renderLatencyMs = metricsBuffer[0],
                 uploadLatencyMs = metricsBuffer[1],
                 compositeLatencyMs = metricsBuffer[2],
+                bitmapCacheHits = metricsBuffer[3],
+                bitmapCacheLookups = metricsBuffer[4],
+                bitmapCacheBytes = metricsBuffer[5],
+                libassCacheLimitBytes = metricsBuffer[6],
+                renderQualityLevel = metricsBuffer[7].toInt(),
             )
         }
     }
@@ -82,13 +104,91 @@ class AssGpuNativeBridge {
         nativeSetGlobalOpacity(handle, percent)
     }
 
+    /**
+     * 传入 null 关闭转换；词典加载失败时返回 false。
+     */
+    fun setTextConversion(conversion: AssTextConversion?): Boolean {
+        if (!isReady) return false
+        return nativeSetTextConversion(handle, conversion?.phrasesPath, conversion?.charactersPath)
+    }
+
+    fun setRendererProfile(profile: AssRendererProfile) {
+        if (!isReady) return
+        nativeSetRendererProfile(handle, profile.nativeValue)
+    }
+
+    /**
+     * libass 的栅格化分辨率档位，降级时按缩小的帧尺寸渲染后放大绘制。
+     */
+    fun setRenderQuality(quality: SubtitleRenderQuality) {
+        if (!isReady) return
+        nativeSetRenderQuality(handle, quality.nativeValue)
+    }
+
+    /**
+     * 静态事件位图缓存的内存上限，0 表示关闭。
+     */
+    fun setBitmapCacheBudget(maxBytes: Long) {
+        if (!isReady) return
+        nativeSetBitmapCacheBudget(handle, maxBytes)
+    }
+
+    override fun configureDanmakuPages(
+        pageWidth: Int,
+        pageHeight: Int,
+        pageCount: Int
+    ) {
+        if (!isReady) return
+        nativeDanmakuConfigure(handle, pageWidth, pageHeight, pageCount)
+    }
+
+    override fun submitDanmakuPage(
+        page: Int,
+        bitmap: Bitmap,
+        startsMs: LongArray,
+        attributes: IntArray,
+        geometry: FloatArray,
+        count: Int
+    ): Boolean {
+        if (!isReady) return false
+        return nativeDanmakuSubmitPage(handle, page, bitmap, startsMs, attributes, geometry, count)
+    }
+
+    override fun clearDanmaku() {
+        if (!isReady) return
+        nativeDanmakuClear(handle)
+    }
+
+    fun configureTrackCache(config: AssTrackCacheConfig) {
+        if (!isReady) return
+        nativeConfigureTrackCache(
+            handle,
+            config.directory,
+            config.maxBytes,
+            config.maxEntries,
+            config.eviction.nativeValue,
+        )
+    }
+
+    /**
+     * 链接好的着色器程序（glGetProgramBinary）缓存到 [path]，冷启动时跳过编译；null 关闭缓存。
+     */
+    fun setProgramCache(path: String?) {
+        if (!isReady) return
+        nativeSetProgramCache(handle, path)
+    }
+
+    /**
+     * 大文件会在后台线程流式解析，[positionHintMs] 附近的事件优先可用。
+     */
     fun loadTrack(
         path: String,
         fontDirs: List<String>,
-        defaultFont: String?
+        defaultFont: String?,
+        positionHintMs: Long = 0L
     ) {
         if (!isReady) return
-        nativeLoadTrack(handle, path, fontDirs.toTypedArray(), defaultFont)
+        nativeLoadTrack(handle, path, fontDirs.toTypedArray(), defaultFont, positionHintMs)
     }
 
     fun initEmbeddedTrack(
@@ -167,11 +267,65 @@ class AssGpuNativeBridge {
         percent: Int
     )
 
+    private external fun nativeSetTextConversion(
+        handle: Long,
+        phrasesPath: String?,
+        charactersPath: String?
+    ): Boolean
+
+    private external fun nativeSetRendererProfile(
+        handle: Long,
+        profile: Int
+    )
+
+    private external fun nativeSetRenderQuality(
+        handle: Long,
+        level: Int
+    )
+
+    private external fun nativeSetBitmapCacheBudget(
+        handle: Long,
+        maxBytes: Long
+    )
+
+    private external fun nativeDanmakuConfigure(
+        handle: Long,
+        pageWidth: Int,
+        pageHeight: Int,
+        pageCount: Int
+    )
+
+    private external fun nativeDanmakuSubmitPage(
+        handle: Long,
+        page: Int,
+        bitmap: Bitmap,
+        startsMs: LongArray,
+        attributes: IntArray,
+        geometry: FloatArray,
+        count: Int
+    ): Boolean
+
+    private external fun nativeDanmakuClear(handle: Long)
+
+    private external fun nativeConfigureTrackCache(
+        handle: Long,
+        directory: String,
+        maxBytes: Long,
+        maxEntries: Int,
+        eviction: Int
+    )
+
+    private external fun nativeSetProgramCache(
+        handle: Long,
+        path: String?
+    )
+
     private external fun nativeLoadTrack(
         handle: Long,
         path: String,
         fontDirs: Array<String>,
-        defaultFont: String?
+        defaultFont: String?,
+        positionHintMs: Long
     )
 
     private external fun nativeInitEmbeddedTrack(
@@ -4,6 +4,8 @@ import android.os.Handler
 import android.view.Surface
 import com.xyoye.common_component.log.LogFacade
 import com.xyoye.common_component.log.model.LogModule
+import com.xyoye.danmaku.DanmakuStore
+import com.xyoye.danmaku.gpu.GpuDanmakuLayer
 import com.xyoye.data_component.bean.subtitle.SubtitleOutputTarget
 import com.xyoye.data_component.enums.SubtitlePipelineFallbackReason
 import com.xyoye.data_component.enums.SubtitlePipelineMode
@@ -11,6 +13,7 @@ import com.xyoye.data_component.enums.SubtitlePipelineStatus
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Job
 import kotlinx.coroutines.launch
+import java.io.File
 import java.util.concurrent.CountDownLatch
 import java.util.concurrent.TimeUnit
 import java.util.concurrent.atomic.AtomicBoolean
@@ -22,7 +25,8 @@ import java.util.concurrent.atomic.AtomicLong
 class AssGpuRenderer(
     private val pipelineController: SubtitlePipelineController,
     private val renderHandler: Handler,
-    private val loadSheddingPolicy: SubtitleLoadSheddingPolicy = SubtitleLoadSheddingPolicy(),
+    private val loadSheddingPolicy: SubtitleLoadSheddingPolicy =
+        SubtitleLoadSheddingPolicy(renderQualityLadder = SubtitleRenderQuality.LADDER),
     private val scope: CoroutineScope,
     nativeBridgeFactory: () -> AssGpuNativeBridge = { AssGpuNativeBridge() },
     private val pipelineErrorListener: ((SubtitlePipelineFallbackReason, Throwable?) -> Unit)? = null
@@ -52,6 +56,23 @@ class AssGpuRenderer(
     @Volatile
     private var released = false
 
+    @Volatile
+    private var trackCacheConfig: AssTrackCacheConfig? = null
+
+    @Volatile
+    private var programCacheFile: File? = null
+
+    @Volatile
+    private var textConversion: AssTextConversion? = null
+    private var appliedTextConversion: AssTextConversion? = null
+
+    // 仅在渲染线程访问
+    private var danmakuLayer: GpuDanmakuLayer? = null
+    private var danmakuTimeOffsetMs: () -> Long = { 0L }
+    private var appliedRenderQuality = SubtitleRenderQuality.FULL
+    private var outputWidth = 0
+    private var outputHeight = 0
+
     private val renderRunnable: Runnable =
         object : Runnable {
             override fun run() {
@@ -81,6 +102,10 @@ class AssGpuRenderer(
             if (released) return@postAtFrontOfQueue
             blockedByFailure = false
             this.telemetryEnabled = telemetryEnabled
+            outputWidth = target.width
+            outputHeight = target.height
+            danmakuLayer?.setViewport(target.width, target.height)
+            nativeBridge.setProgramCache(programCacheFile?.absolutePath)
             if (!nativeBridge.attachSurface(surface, target)) {
                 blockedByFailure = true
                 pipelineErrorListener?.invoke(SubtitlePipelineFallbackReason.UNSUPPORTED_GPU, null)
@@ -127,6 +152,59 @@ class AssGpuRenderer(
         }
     }
 
+    fun setRendererProfile(profile: AssRendererProfile) {
+        if (released) return
+        renderHandler.postAtFrontOfQueue {
+            if (released) return@postAtFrontOfQueue
+            nativeBridge.setRendererProfile(profile)
+        }
+    }
+
+    fun setBitmapCacheBudget(maxBytes: Long) {
+        if (released) return
+        renderHandler.postAtFrontOfQueue {
+            if (released) return@postAtFrontOfQueue
+            nativeBridge.setBitmapCacheBudget(maxBytes)
+        }
+    }
+
+    /**
+     * 在字幕下方绘制 [store] 中的弹幕，传入 null 移除；关闭 [store] 之前必须先移除。
+     * [timeOffsetMs] 在渲染线程每帧求值，见 [GpuDanmakuLayer.timeOffsetMs]。
+     * 同一 [store] 再次传入时沿用已有的布局，只重新计算播放位置附近的窗口。
+     */
+    fun setDanmakuStore(
+        store: DanmakuStore?,
+        style: GpuDanmakuLayer.Style = GpuDanmakuLayer.Style(),
+        isBlocked: (Int) -> Boolean = { false },
+        timeOffsetMs: () -> Long = { 0L }
+    ) {
+        if (released) return
+        val latch = CountDownLatch(1)
+        renderHandler.postAtFrontOfQueue {
+            if (!released) {
+                val current = danmakuLayer
+                if (store != null && current?.store === store) {
+                    current.update(style, isBlocked)
+                } else {
+                    current?.release()
+                    danmakuLayer =
+                        store?.let {
+                            GpuDanmakuLayer(it, nativeBridge, style, isBlocked).apply {
+                                setViewport(outputWidth, outputHeight)
+                            }
+                        }
+                }
+                danmakuTimeOffsetMs = timeOffsetMs
+            }
+            latch.countDown()
+        }
+        // 移除后调用方才能关闭弹幕库，需等渲染线程不再读取
+        if (!latch.await(1500, TimeUnit.MILLISECONDS)) {
+            LogFacade.w(LogModule.PLAYER, TAG, "setDanmakuStore timed out, render thread may be blocked")
+        }
+    }
+
     fun detachSurface() {
         if (released) return
         renderHandler.postAtFrontOfQueue {
@@ -136,16 +214,40 @@ class AssGpuRenderer(
         frameCleaner.onSurfaceLost()
     }
 
+    /**
+     * 着色器程序二进制缓存文件，在下一次 [bindSurface] 时生效。
+     */
+    fun setProgramCacheFile(file: File?) {
+        programCacheFile = file
+    }
+
+    /**
+     * 在下一次 [loadTrack] 时生效。
+     */
+    fun setTrackCacheConfig(config: AssTrackCacheConfig?) {
+        trackCacheConfig = config
+    }
+
+    /**
+     * 在下一次加载外挂轨道或初始化内嵌轨道时生效。
+     */
+    fun setTextConversion(conversion: AssTextConversion?) {
+        textConversion = conversion
+    }
+
     fun loadTrack(
         path: String,
         fontDirs: List<String>,
-        defaultFont: String?
+        defaultFont: String?,
+        positionHintMs: Long = 0L
     ) {
         if (released) return
         renderHandler.postAtFrontOfQueue {
             if (released) return@postAtFrontOfQueue
             trackLoaded = true
-            nativeBridge.loadTrack(path, fontDirs, defaultFont)
+            applyTextConversion()
+            trackCacheConfig?.let { nativeBridge.configureTrackCache(it) }
+            nativeBridge.loadTrack(path, fontDirs, defaultFont, positionHintMs)
         }
     }
 
@@ -158,10 +260,20 @@ class AssGpuRenderer(
         renderHandler.post {
             if (released) return@post
             trackLoaded = true
+            applyTextConversion()
             nativeBridge.initEmbeddedTrack(codecPrivate, fontDirs, defaultFont)
         }
     }
 
+    private fun applyTextConversion() {
+        val conversion = textConversion
+        if (conversion == appliedTextConversion) return
+        appliedTextConversion = conversion
+        if (!nativeBridge.setTextConversion(conversion)) {
+            LogFacade.w(LogModule.PLAYER, TAG, "subtitle text conversion unavailable")
+        }
+    }
+
     fun appendEmbeddedSample(
         data: ByteArray,
         timeMs: Long,
@@ -199,6 +311,37 @@ class AssGpuRenderer(
         }
     }
 
+    /**
+     * 在渲染线程上读取已有的原生句柄（不会创建原生上下文），供播放内核合成字幕；
+     * 尚未创建、已释放或等待超时时返回 0。
+     */
+    fun obtainNativeHandle(): Long {
+        if (released) return 0L
+        val handle = AtomicLong(0L)
+        val latch = CountDownLatch(1)
+        renderHandler.postAtFrontOfQueue {
+            if (!released) {
+                handle.set(nativeBridge.nativeHandle)
+            }
+            latch.countDown()
+        }
+        if (!latch.await(1500, TimeUnit.MILLISECONDS)) {
+            LogFacade.w(LogModule.PLAYER, TAG, "obtainNativeHandle timed out, render thread may be blocked")
+        }
+        return handle.get()
+    }
+
+    /**
+     * 在已提交的轨道/参数操作完成后于渲染线程执行 [action]。
+     */
+    fun runAfterPendingWork(action: () -> Unit) {
+        if (released) return
+        renderHandler.post {
+            if (released) return@post
+            action()
+        }
+    }
+
     fun release() {
         if (released) return
         released = true
@@ -207,6 +350,7 @@ class AssGpuRenderer(
         val latch = CountDownLatch(1)
         renderHandler.postAtFrontOfQueue {
             initJob?.cancel()
+            danmakuLayer = null
             runCatching { nativeBridge.flush() }
             runCatching { nativeBridge.release() }
             pipelineController.reset()
@@ -229,8 +373,13 @@ class AssGpuRenderer(
             telemetryCollector.recordSkippedFrame(subtitlePtsMs, vsyncId)
             return
         }
+        danmakuLayer?.let { layer ->
+            layer.timeOffsetMs = danmakuTimeOffsetMs()
+            layer.prepare(subtitlePtsMs)
+        }
         val result = nativeBridge.renderFrame(subtitlePtsMs, vsyncId, telemetryEnabled)
         telemetryCollector.recordRenderResult(result, subtitlePtsMs, vsyncId, telemetryEnabled)
+        applyRenderQuality(loadSheddingPolicy.renderQuality)
 
         if (!result.rendered && trackLoaded && state?.status == SubtitlePipelineStatus.Active) {
             blockedByFailure = true
@@ -238,6 +387,20 @@ class AssGpuRenderer(
         }
     }
 
+    /**
+     * 负载降级先沿分辨率阶梯降低 libass 的栅格化尺寸，字幕仍保持动画；新档位从下一帧生效。
+     */
+    private fun applyRenderQuality(quality: SubtitleRenderQuality) {
+        if (quality == appliedRenderQuality) return
+        LogFacade.i(
+            LogModule.PLAYER,
+            TAG,
+            "render quality ${appliedRenderQuality.name} -> ${quality.name} (scale=${quality.scale})",
+        )
+        appliedRenderQuality = quality
+        nativeBridge.setRenderQuality(quality)
+    }
+
     companion object {
         private const val TAG = "AssGpuRenderer"
     }
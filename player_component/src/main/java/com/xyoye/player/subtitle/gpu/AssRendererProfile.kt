@@ -0,0 +1,48 @@
+package com.xyoye.player.subtitle.gpu
+
+import android.app.ActivityManager
+import android.content.Context
+import com.xyoye.common_component.config.SubtitleConfig
+
+/**
+ * libass 渲染档位：决定 glyph/bitmap 缓存上限、整形器与 hinting（见 ass_gpu_bridge.cpp 中的
+ * kRendererProfiles），以及静态事件位图缓存允许使用的内存上限。
+ */
+enum class AssRendererProfile(
+    val nativeValue: Int,
+    val maxBitmapCacheMb: Long
+) {
+    LOW_MEMORY(0, 8L),
+    BALANCED(1, 32L),
+    QUALITY(2, 64L);
+
+    companion object {
+        private const val PREFERENCE_AUTO = "AUTO"
+        private const val LOW_MEMORY_CLASS_MB = 128
+        private const val QUALITY_MEMORY_CLASS_MB = 256
+
+        fun fromMemoryClass(
+            memoryClassMb: Int,
+            lowRamDevice: Boolean
+        ): AssRendererProfile =
+            when {
+                lowRamDevice || memoryClassMb <= LOW_MEMORY_CLASS_MB -> LOW_MEMORY
+                memoryClassMb >= QUALITY_MEMORY_CLASS_MB -> QUALITY
+                else -> BALANCED
+            }
+
+        /**
+         * 设置项为 AUTO（默认）时按 [ActivityManager.getMemoryClass] 选择。
+         */
+        fun fromPreferences(context: Context): AssRendererProfile {
+            val configured = SubtitleConfig.getAssRendererProfile()
+            if (configured != PREFERENCE_AUTO) {
+                values().firstOrNull { it.name == configured }?.let { return it }
+            }
+            val activityManager =
+                context.getSystemService(Context.ACTIVITY_SERVICE) as? ActivityManager
+                    ?: return BALANCED
+            return fromMemoryClass(activityManager.memoryClass, activityManager.isLowRamDevice)
+        }
+    }
+}
@@ -0,0 +1,32 @@
+package com.xyoye.player.subtitle.gpu
+
+import com.xyoye.data_component.enums.SubtitleLanguage
+import com.xyoye.open_cc.OpenCCFile
+import java.io.File
+
+/**
+ * libass 轨道在解析/追加事件时使用的 OpenCC 词典（短语 + 单字），只转换事件文本，保留特效标签。
+ */
+data class AssTextConversion(
+    val phrasesPath: String,
+    val charactersPath: String
+) {
+    companion object {
+        fun forLanguage(language: SubtitleLanguage): AssTextConversion? =
+            when (language) {
+                SubtitleLanguage.ORIGINAL -> null
+                SubtitleLanguage.SC -> of(OpenCCFile.tsPhrases, OpenCCFile.tsCharacters)
+                SubtitleLanguage.TC -> of(OpenCCFile.stPhrases, OpenCCFile.stCharacters)
+            }
+
+        private fun of(
+            phrases: File,
+            characters: File
+        ): AssTextConversion? {
+            if (phrases.exists().not() || characters.exists().not()) {
+                return null
+            }
+            return AssTextConversion(phrases.absolutePath, characters.absolutePath)
+        }
+    }
+}
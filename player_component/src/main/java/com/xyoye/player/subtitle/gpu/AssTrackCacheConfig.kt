@@ -0,0 +1,39 @@
+package com.xyoye.player.subtitle.gpu
+
+import com.xyoye.common_component.config.SubtitleConfig
+import com.xyoye.common_component.utils.PathHelper
+
+/**
+ * 外挂 ASS 字幕解析结果的二进制缓存配置，按文件内容哈希 + libass 版本命中。
+ * 目录为空、[maxBytes] 或 [maxEntries] 不大于 0 时原生侧关闭缓存（见 TrackCacheConfig::enabled）。
+ */
+data class AssTrackCacheConfig(
+    val directory: String,
+    val maxBytes: Long,
+    val maxEntries: Int,
+    val eviction: Eviction = Eviction.LRU
+) {
+    enum class Eviction(
+        val nativeValue: Int
+    ) {
+        // 命中时刷新时间，优先淘汰最久未使用的条目
+        LRU(0),
+
+        // 按写入时间淘汰，命中不刷新
+        OLDEST_FIRST(1)
+    }
+
+    companion object {
+        private const val BYTES_PER_MB = 1024L * 1024L
+
+        fun fromPreferences(): AssTrackCacheConfig =
+            AssTrackCacheConfig(
+                directory = PathHelper.getSubtitleTrackCacheDirectory().absolutePath,
+                maxBytes = SubtitleConfig.getAssTrackCacheMaxMb().coerceAtLeast(0) * BYTES_PER_MB,
+                maxEntries = SubtitleConfig.getAssTrackCacheMaxEntries(),
+                eviction =
+                    Eviction.values().firstOrNull { it.name == SubtitleConfig.getAssTrackCacheEviction() }
+                        ?: Eviction.LRU,
+            )
+    }
+}
@@ -6,16 +6,36 @@ import kotlin.math.max
 
 /**
  * Simple load-shedding heuristic to avoid overwhelming the render/upload pipeline.
- * If recent frames exceed the budget or keep dropping, throttle both rendering
- * and telemetry submissions for a short cool-down window.
+ * A burst of over-budget or dropped frames first steps down [renderQualityLadder]
+ * (libass rasterizes at a reduced frame size), so subtitles keep animating at a
+ * lower resolution. Only once the lowest rung is reached does the policy throttle
+ * both rendering and telemetry submissions for a short cool-down window.
+ *
+ * A lower rung is left again after [qualityRecoveryFrames] frames in a row whose
+ * cost, scaled up to the next rung's pixel count, still fits the budget, and no
+ * sooner than [qualityHoldMs] after the last step down.
  */
 class SubtitleLoadSheddingPolicy(
     private val frameBudgetMs: Double = 25.0,
     private val dropBurstThreshold: Int = 5,
-    private val throttleWindowMs: Long = 500L
+    private val throttleWindowMs: Long = 500L,
+    private val renderQualityLadder: List<SubtitleRenderQuality> = listOf(SubtitleRenderQuality.FULL),
+    private val qualityRecoveryFrames: Int = 60,
+    private val qualityHoldMs: Long = 2_000L
 ) {
     private var throttleUntilMs: Long = 0L
     private var consecutiveOverBudget: Int = 0
+    private var qualityIndex: Int = 0
+    private var consecutiveHeadroom: Int = 0
+    private var qualityChangedAtMs: Long = 0L
+
+    init {
+        require(renderQualityLadder.isNotEmpty()) { "renderQualityLadder must not be empty" }
+    }
+
+    /** Rung the renderer should rasterize at; read after each [evaluateTelemetry]. */
+    val renderQuality: SubtitleRenderQuality
+        get() = renderQualityLadder[qualityIndex]
 
     fun allowRender(nowMs: Long = System.currentTimeMillis()): Boolean = nowMs >= throttleUntilMs
 
@@ -24,7 +44,8 @@ class SubtitleLoadSheddingPolicy(
         nowMs: Long = System.currentTimeMillis()
     ): LoadSheddingDecision {
         val composite = sample.compositeLatencyMs ?: 0.0
-        val overBudget = (sample.renderLatencyMs + sample.uploadLatencyMs + composite) > frameBudgetMs
+        val frameCostMs = sample.renderLatencyMs + sample.uploadLatencyMs + composite
+        val overBudget = frameCostMs > frameBudgetMs
         val dropped = sample.frameStatus != SubtitleFrameStatus.Rendered
         if (overBudget || dropped) {
             consecutiveOverBudget++
@@ -32,8 +53,14 @@ class SubtitleLoadSheddingPolicy(
             consecutiveOverBudget = max(consecutiveOverBudget - 1, 0)
         }
         if (consecutiveOverBudget >= dropBurstThreshold) {
-            throttleUntilMs = nowMs + throttleWindowMs
             consecutiveOverBudget = 0
+            if (qualityIndex < renderQualityLadder.lastIndex) {
+                stepQuality(qualityIndex + 1, nowMs)
+            } else {
+                throttleUntilMs = nowMs + throttleWindowMs
+            }
+        } else if (qualityIndex > 0) {
+            evaluateQualityRecovery(frameCostMs, overBudget || dropped, nowMs)
         }
         val throttling = nowMs < throttleUntilMs
         return LoadSheddingDecision(
@@ -41,13 +68,42 @@ class SubtitleLoadSheddingPolicy(
             skipTelemetry = throttling,
             gpuOverutilized = overBudget || throttling,
             vsyncMiss = dropped,
+            renderQuality = renderQuality,
         )
     }
+
+    private fun evaluateQualityRecovery(
+        frameCostMs: Double,
+        overBudget: Boolean,
+        nowMs: Long
+    ) {
+        // Rasterization and upload grow with the pixel count of the frame.
+        val upper = renderQualityLadder[qualityIndex - 1]
+        val projectedCostMs = frameCostMs * upper.pixelRatio / renderQuality.pixelRatio
+        if (overBudget || projectedCostMs > frameBudgetMs) {
+            consecutiveHeadroom = 0
+            return
+        }
+        consecutiveHeadroom++
+        if (consecutiveHeadroom >= qualityRecoveryFrames && nowMs - qualityChangedAtMs >= qualityHoldMs) {
+            stepQuality(qualityIndex - 1, nowMs)
+        }
+    }
+
+    private fun stepQuality(
+        index: Int,
+        nowMs: Long
+    ) {
+        qualityIndex = index
+        qualityChangedAtMs = nowMs
+        consecutiveHeadroom = 0
+    }
 }
 
 data class LoadSheddingDecision(
     val dropFrame: Boolean,
     val skipTelemetry: Boolean,
     val gpuOverutilized: Boolean,
-    val vsyncMiss: Boolean
+    val vsyncMiss: Boolean,
+    val renderQuality: SubtitleRenderQuality = SubtitleRenderQuality.FULL
 )
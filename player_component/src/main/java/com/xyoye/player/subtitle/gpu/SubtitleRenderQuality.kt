@@ -0,0 +1,26 @@
+package com.xyoye.player.subtitle.gpu
+
+/**
+ * GPU 字幕的渲染分辨率阶梯（见 ass_gpu_bridge.cpp 中的 kRenderQualityScales）：libass 按
+ * [scale] 缩小后的帧尺寸栅格化，storage size 保持输出尺寸，绘制时再放大回输出尺寸。
+ * 每降一级，栅格化与上传的像素量约为原来的 [pixelRatio]。
+ */
+enum class SubtitleRenderQuality(
+    val nativeValue: Int,
+    val scale: Double
+) {
+    FULL(0, 1.0),
+    TWO_THIRDS(1, 2.0 / 3.0),
+    HALF(2, 0.5);
+
+    val pixelRatio: Double
+        get() = scale * scale
+
+    companion object {
+        /** 从原始分辨率依次降级的完整阶梯。 */
+        val LADDER: List<SubtitleRenderQuality> = values().toList()
+
+        fun fromNativeValue(value: Int): SubtitleRenderQuality =
+            values().firstOrNull { it.nativeValue == value } ?: FULL
+    }
+}
@@ -58,6 +58,17 @@ class SubtitleTelemetryCollector(
                 compositeLatencyMs = result.compositeLatencyMs.toDouble(),
                 frameStatus = frameStatus,
                 dropReason = if (result.rendered) null else DROP_REASON_NO_FRAME,
+                bitmapCacheHitRate =
+                    if (result.bitmapCacheLookups > 0) {
+                        result.bitmapCacheHits.toDouble() / result.bitmapCacheLookups.toDouble()
+                    } else {
+                        null
+                    },
+                bitmapCacheBytes = result.bitmapCacheBytes.takeIf { result.libassCacheLimitBytes > 0 },
+                libassCacheLimitBytes = result.libassCacheLimitBytes.takeIf { it > 0 },
+                // 关闭遥测时原生层不回填 metrics，档位未知
+                renderScale =
+                    SubtitleRenderQuality.fromNativeValue(result.renderQualityLevel).scale.takeIf { telemetryEnabled },
             )
         val decision = loadSheddingPolicy.evaluateTelemetry(baseSample)
         val adjustedFrameStatus =
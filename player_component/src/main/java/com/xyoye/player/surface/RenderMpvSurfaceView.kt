@@ -29,6 +29,9 @@ class RenderMpvSurfaceView(
             }
 
             override fun surfaceDestroyed(holder: SurfaceHolder) {
+                if (this@RenderMpvSurfaceView::videoPlayer.isInitialized) {
+                    (videoPlayer as? MpvVideoPlayer)?.releaseRenderSurface()
+                }
             }
 
             override fun surfaceCreated(holder: SurfaceHolder) {
@@ -19,4 +19,7 @@ object PlayerConstant {
 
     // 视频旋转
     const val MEDIA_INFO_VIDEO_ROTATION_CHANGED = 10001
+
+    // 片段播放到达终点并已暂停，extra 为暂停位置（毫秒）
+    const val MEDIA_INFO_SEGMENT_END = 10002
 }
@@ -55,6 +55,13 @@ class ControlWrapper(
     override fun seekTo(timeMs: Long) {
         // 播放器
         mVideoPlayer.seekTo(timeMs)
+        syncAfterSeek(timeMs)
+    }
+
+    /**
+     * 播放器跳转后同步弹幕与进度视图
+     */
+    private fun syncAfterSeek(timeMs: Long) {
         // 弹幕
         seekTo(timeMs, isPlaying())
         // 视图
@@ -65,6 +72,49 @@ class ControlWrapper(
         }
     }
 
+    override fun beginScrub() {
+        mVideoPlayer.beginScrub()
+    }
+
+    override fun updateScrub(timeMs: Long) {
+        mVideoPlayer.updateScrub(timeMs)
+    }
+
+    override fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ) = mVideoPlayer.setAbLoop(startMs, endMs)
+
+    override fun stepFrame(backward: Boolean): Boolean {
+        val stepped = mVideoPlayer.stepFrame(backward)
+        if (stepped) {
+            // 弹幕随画面暂停
+            seekTo(getCurrentPosition(), false)
+        }
+        return stepped
+    }
+
+    override fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean {
+        // 播放器
+        val started = mVideoPlayer.playSegment(startMs, endMs)
+        if (started) {
+            // 弹幕
+            seekTo(startMs, true)
+            // 视图
+            startProgress()
+        }
+        return started
+    }
+
+    override fun endScrub(timeMs: Long) {
+        // 播放器
+        mVideoPlayer.endScrub(timeMs)
+        syncAfterSeek(timeMs)
+    }
+
     override fun isPlaying() = mVideoPlayer.isPlaying()
 
     override fun getBufferedPercentage() = mVideoPlayer.getBufferedPercentage()
@@ -333,6 +383,8 @@ class ControlWrapper(
         mDanmuController.seekTo(timeMs, isPlaying)
     }
 
+    override fun nextHotMomentMs(positionMs: Long): Long? = mDanmuController.nextHotMomentMs(positionMs)
+
     override fun setLanguage(language: DanmakuLanguage) {
         mDanmuController.setLanguage(language)
         mDanmuController.seekTo(getCurrentPosition(), isPlaying())
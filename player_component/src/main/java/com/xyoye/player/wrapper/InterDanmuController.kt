@@ -112,6 +112,11 @@ interface InterDanmuController : InterVideoTrack {
         isPlaying: Boolean
     )
 
+    /**
+     * 播放位置 [positionMs] 之后最近的弹幕高能时刻，没有时返回 null
+     */
+    fun nextHotMomentMs(positionMs: Long): Long?
+
     /**
      * 弹幕简繁
      */
@@ -43,6 +43,42 @@ interface InterVideoPlayer : InterVideoTrack {
      */
     fun seekTo(timeMs: Long)
 
+    /**
+     * 开始拖动进度条
+     */
+    fun beginScrub()
+
+    /**
+     * 拖动进度条中，跳转至预览位置
+     */
+    fun updateScrub(timeMs: Long)
+
+    /**
+     * 结束拖动进度条，精确跳转至指定时间
+     */
+    fun endScrub(timeMs: Long)
+
+    /**
+     * 设置 A-B 循环区间（毫秒），负值表示清除对应端点
+     */
+    fun setAbLoop(
+        startMs: Long,
+        endMs: Long
+    ): Boolean
+
+    /**
+     * 逐帧步进，步进后保持暂停
+     */
+    fun stepFrame(backward: Boolean): Boolean
+
+    /**
+     * 播放指定区间后自动暂停
+     */
+    fun playSegment(
+        startMs: Long,
+        endMs: Long
+    ): Boolean
+
     /**
      * 是否正在播放中
      */
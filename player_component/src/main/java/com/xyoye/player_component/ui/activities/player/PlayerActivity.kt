@@ -783,6 +783,7 @@ class PlayerActivity :
         PlayerInitializer.Danmu.maxBottomLine = DanmuConfig.getDanmuBottomMaxLine()
         PlayerInitializer.Danmu.maxNum = DanmuConfig.getDanmuMaxCount()
         PlayerInitializer.Danmu.cloudBlock = DanmuConfig.isCloudDanmuBlock()
+        PlayerInitializer.Danmu.mergeDuplicate = DanmuConfig.isMergeDuplicateDanmu()
         PlayerInitializer.Danmu.updateInChoreographer = DanmuConfig.isDanmuUpdateInChoreographer()
         PlayerInitializer.Danmu.language = DanmakuLanguage.formValue(DanmuConfig.getDanmuLanguage())
         LogFacade.d(
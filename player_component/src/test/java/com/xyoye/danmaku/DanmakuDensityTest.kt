@@ -0,0 +1,78 @@
+package com.xyoye.danmaku
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+class DanmakuDensityTest {
+    @Test
+    fun readsSecondsAndPeaks() {
+        val density =
+            DanmakuDensity(
+                writeIndex(
+                    counts = intArrayOf(3, 0, 12, 40),
+                    tagged = intArrayOf(0, 0, 2, 9),
+                    heat = floatArrayOf(2.5f, 6f, 21f, 64f),
+                    peaks = intArrayOf(3),
+                ),
+            )
+
+        assertEquals(4, density.seconds)
+        assertEquals(1, density.peakCount)
+        assertEquals(64f, density.maxHeat, 0f)
+        assertEquals(40, density.maxCount)
+        assertEquals(12, density.count(2))
+        assertEquals(9, density.tagged(3))
+        assertEquals(21f, density.heat(2), 0f)
+        assertEquals(3, density.peakSecond(0))
+        assertEquals(64f, density.peakHeat(0), 0f)
+        assertEquals(3_000L, density.nextPeakMs(1_500L))
+        assertNull(density.nextPeakMs(3_000L))
+    }
+
+    @Test
+    fun emptyIndex() {
+        val density = DanmakuDensity(writeIndex(IntArray(0), IntArray(0), FloatArray(0), IntArray(0)))
+        assertEquals(0, density.seconds)
+        assertNull(density.nextPeakMs(0L))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsForeignBuffer() {
+        DanmakuDensity(ByteBuffer.allocate(64))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsTruncatedBuffer() {
+        val valid = writeIndex(intArrayOf(1, 2), intArrayOf(0, 0), floatArrayOf(1f, 2f), intArrayOf(1))
+        val truncated = ByteBuffer.allocate(valid.capacity() - 4)
+        truncated.put(valid.array(), 0, truncated.capacity())
+        DanmakuDensity(truncated)
+    }
+
+    private fun writeIndex(
+        counts: IntArray,
+        tagged: IntArray,
+        heat: FloatArray,
+        peaks: IntArray
+    ): ByteBuffer {
+        val seconds = counts.size
+        val buffer = ByteBuffer.allocate(32 + seconds * 12 + peaks.size * 8).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.putInt(0x49444444)
+        buffer.putInt(1)
+        buffer.putInt(seconds)
+        buffer.putInt(peaks.size)
+        buffer.putLong(0L)
+        buffer.putFloat(heat.maxOrNull() ?: 0f)
+        buffer.putInt(counts.maxOrNull() ?: 0)
+        counts.forEach { buffer.putInt(it) }
+        tagged.forEach { buffer.putInt(it) }
+        heat.forEach { buffer.putFloat(it) }
+        peaks.forEach { buffer.putInt(it) }
+        peaks.forEach { buffer.putFloat(heat[it]) }
+        buffer.flip()
+        return buffer
+    }
+}
@@ -0,0 +1,71 @@
+package com.xyoye.danmaku
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+class DanmakuLayoutTest {
+    @Test
+    fun readsPlacementRows() {
+        val buffer = ByteBuffer.allocate(DanmakuLayout.ROW_BYTES * 4).order(ByteOrder.LITTLE_ENDIAN)
+        putRow(buffer, y = 48f, width = 310f, height = 42f, durationMs = 3800, lane = 1, flags = 3)
+        putRow(buffer, y = 0f, width = 0f, height = 0f, durationMs = 0, lane = -1, flags = 5)
+        putRow(buffer, y = 0f, width = 120f, height = 42f, durationMs = 3800, lane = -1, flags = 0)
+        putRow(buffer, y = 0f, width = 0f, height = 0f, durationMs = 0, lane = -1, flags = 9)
+        val layout = DanmakuLayout(buffer)
+
+        assertTrue(layout.isLaidOut(0))
+        assertTrue(layout.isPlaced(0))
+        assertFalse(layout.isHidden(0))
+        assertEquals(48f, layout.y(0), 0f)
+        assertEquals(310f, layout.width(0), 0f)
+        assertEquals(42f, layout.height(0), 0f)
+        assertEquals(3800, layout.durationMs(0))
+        assertEquals(1, layout.lane(0))
+
+        assertTrue(layout.isHidden(1))
+        assertFalse(layout.isPlaced(1))
+        assertEquals(-1, layout.lane(1))
+
+        assertFalse(layout.isLaidOut(2))
+
+        assertTrue(layout.isFolded(3))
+        assertFalse(layout.isPlaced(3))
+        assertFalse(layout.isFolded(0))
+    }
+
+    @Test
+    fun bufferWithoutNativeHandleIgnoresLayoutCalls() {
+        val layout = DanmakuLayout(ByteBuffer.allocate(DanmakuLayout.ROW_BYTES))
+        val metrics = DanmakuLayout.FontMetrics(FloatArray(DanmakuLayout.ASCII_COUNT) { 0.5f }, 1f, 0.6f, 1.2f)
+
+        assertFalse(layout.configure(1920, 1080, 1.5f, 2f, 50f, 3800, 3800, metrics))
+        assertEquals(0, layout.ensure(0L, 60_000L))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsIncompleteAsciiAdvances() {
+        DanmakuLayout.FontMetrics(FloatArray(26), 1f, 0.6f, 1.2f)
+    }
+
+    private fun putRow(
+        buffer: ByteBuffer,
+        y: Float,
+        width: Float,
+        height: Float,
+        durationMs: Int,
+        lane: Int,
+        flags: Int
+    ) {
+        buffer.putFloat(y)
+        buffer.putFloat(width)
+        buffer.putFloat(height)
+        buffer.putInt(durationMs)
+        buffer.putShort(lane.toShort())
+        buffer.put(flags.toByte())
+        buffer.put(0)
+    }
+}
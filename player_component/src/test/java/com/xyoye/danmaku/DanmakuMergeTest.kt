@@ -0,0 +1,28 @@
+package com.xyoye.danmaku
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+class DanmakuMergeTest {
+    @Test
+    fun readsRepeatCounts() {
+        val buffer = ByteBuffer.allocate(8).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.putShort(3)
+        buffer.putShort(0)
+        buffer.putShort(1)
+        buffer.putShort(0xFFFF.toShort())
+        val merge = DanmakuMerge(buffer)
+
+        assertEquals(3, merge.count(0))
+        assertFalse(merge.isFolded(0))
+        assertEquals(" +2", merge.suffix(0))
+        assertTrue(merge.isFolded(1))
+        assertEquals("", merge.suffix(2))
+        assertEquals(65535, merge.count(3))
+        assertEquals(" +65534", merge.suffix(3))
+    }
+}
@@ -0,0 +1,94 @@
+package com.xyoye.danmaku
+
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+class DanmakuStoreTest {
+    @Test
+    fun readsColumnsAndArenaText() {
+        val store =
+            DanmakuStore(
+                writeStore(
+                    listOf(
+                        Comment(1_500, 1, 25, 0xFFFFFF, "前方高能"),
+                        Comment(2_000, 5, 18, 0x00FF00, "a<b & c"),
+                        Comment(2_000, 7, 25, 0x123456, "[0,0,\"1-1\",4,\"x\"]"),
+                    ),
+                ),
+            )
+
+        assertEquals(3, store.count)
+        assertEquals(1_500L, store.timeMs(0))
+        assertEquals(5, store.mode(1))
+        assertEquals(18, store.size(1))
+        assertEquals(0x123456, store.color(2))
+        assertEquals("前方高能", store.text(0))
+        assertEquals(12, store.textLength(0))
+        assertEquals("a<b & c", store.text(1))
+        assertEquals("[0,0,\"1-1\",4,\"x\"]", store.text(2))
+        store.close()
+    }
+
+    @Test
+    fun emptyStore() {
+        val store = DanmakuStore(writeStore(emptyList()))
+        assertEquals(0, store.count)
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsForeignBuffer() {
+        DanmakuStore(ByteBuffer.allocate(64))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun rejectsTruncatedBuffer() {
+        val valid = writeStore(listOf(Comment(0, 1, 25, 0, "text")))
+        val truncated = ByteBuffer.allocate(valid.capacity() - 8)
+        truncated.put(valid.array(), 0, truncated.capacity())
+        DanmakuStore(truncated)
+    }
+
+    private data class Comment(
+        val timeMs: Int,
+        val mode: Int,
+        val size: Int,
+        val color: Int,
+        val text: String
+    )
+
+    // Mirrors CommentStoreBuilder::Finish in danmaku_store.cpp.
+    private fun writeStore(comments: List<Comment>): ByteBuffer {
+        val texts = comments.map { it.text.toByteArray(Charsets.UTF_8) }
+        val arenaBytes = texts.sumOf { it.size }
+        val count = comments.size
+        val timeOffset = 48
+        val colorOffset = timeOffset + count * 4
+        val textOffsetOffset = colorOffset + count * 4
+        val textLengthOffset = textOffsetOffset + count * 4
+        val modeOffset = textLengthOffset + count * 4
+        val sizeOffset = modeOffset + count
+        val arenaOffset = align(sizeOffset + count)
+        val total = align(arenaOffset + arenaBytes)
+
+        val buffer = ByteBuffer.allocate(total).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.putInt(0x53434444).putInt(1).putInt(count).putInt(arenaBytes)
+        buffer.putInt(timeOffset).putInt(colorOffset).putInt(textOffsetOffset).putInt(textLengthOffset)
+        buffer.putInt(modeOffset).putInt(sizeOffset).putInt(arenaOffset).putInt(total)
+        var textOffset = 0
+        comments.forEachIndexed { index, comment ->
+            buffer.putInt(timeOffset + index * 4, comment.timeMs)
+            buffer.putInt(colorOffset + index * 4, comment.color)
+            buffer.putInt(textOffsetOffset + index * 4, textOffset)
+            buffer.putInt(textLengthOffset + index * 4, texts[index].size)
+            buffer.put(modeOffset + index, comment.mode.toByte())
+            buffer.put(sizeOffset + index, comment.size.toByte())
+            texts[index].forEachIndexed { i, byte -> buffer.put(arenaOffset + textOffset + i, byte) }
+            textOffset += texts[index].size
+        }
+        return buffer
+    }
+
+    private fun align(value: Int): Int = (value + 3) and 3.inv()
+}
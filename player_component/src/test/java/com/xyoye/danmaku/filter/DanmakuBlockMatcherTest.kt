@@ -0,0 +1,45 @@
+package com.xyoye.danmaku.filter
+
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+/**
+ * JVM 单元测试加载不了 danmaku_bridge，只覆盖纯 Java 匹配；原生 Aho-Corasick 与这里的子串匹配是否一致
+ * 由 src/main/cpp/bench/block_filter_test.cpp 检查（ctest 中的 block_filter_matches_fallback）。
+ */
+class DanmakuBlockMatcherTest {
+    private fun matcher(
+        keywords: List<String>,
+        regexes: List<String>
+    ) = DanmakuBlockMatcher(keywords, regexes, useNative = false)
+
+    @Test
+    fun keywordsMatchSubstrings() {
+        val matcher = matcher(listOf("剧透", "awsl"), emptyList())
+        assertEquals(DanmakuBlockMatcher.MATCH_KEYWORD, matcher.match("前方剧透预警"))
+        assertEquals(DanmakuBlockMatcher.MATCH_KEYWORD, matcher.match("awslawsl"))
+        assertEquals(0, matcher.match("好耶"))
+    }
+
+    @Test
+    fun regexesUseFullMatchSemantics() {
+        val matcher = matcher(emptyList(), listOf("前方高能\\d*", "[0-9]{6,}"))
+        assertEquals(DanmakuBlockMatcher.MATCH_REGEX, matcher.match("前方高能233"))
+        assertEquals(0, matcher.match("真·前方高能"))
+        assertEquals(DanmakuBlockMatcher.MATCH_REGEX, matcher.match("2333333"))
+        assertEquals(0, matcher.match("23333"))
+    }
+
+    @Test
+    fun keywordWinsOverRegex() {
+        val matcher = matcher(listOf("高能"), listOf(".*高能.*"))
+        assertEquals(DanmakuBlockMatcher.MATCH_KEYWORD, matcher.match("前方高能"))
+    }
+
+    @Test
+    fun skipsInvalidAndEmptyRules() {
+        val matcher = matcher(listOf(""), listOf("(unclosed"))
+        assertEquals(true, matcher.isEmpty)
+        assertEquals(0, matcher.match("anything"))
+    }
+}
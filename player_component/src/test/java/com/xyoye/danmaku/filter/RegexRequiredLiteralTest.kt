@@ -0,0 +1,66 @@
+package com.xyoye.danmaku.filter
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.regex.Pattern
+
+class RegexRequiredLiteralTest {
+    @Test
+    fun picksLongestMandatoryRun() {
+        assertEquals("广告", RegexRequiredLiteral.of(".*广告.*"))
+        assertEquals("前方高能", RegexRequiredLiteral.of("^前方高能\\d+$"))
+        assertEquals("abc", RegexRequiredLiteral.of("x[0-9]+abc(de)?"))
+        assertEquals("a.b", RegexRequiredLiteral.of("a\\.b"))
+    }
+
+    @Test
+    fun dropsOptionalAtoms() {
+        assertEquals("colo", RegexRequiredLiteral.of("colou?r"))
+        assertEquals("ab", RegexRequiredLiteral.of("abc*?d"))
+        assertEquals("xy", RegexRequiredLiteral.of("xyz{0,2}"))
+        assertEquals("哈", RegexRequiredLiteral.of("哈+"))
+    }
+
+    @Test
+    fun givesUpWhenUnsure() {
+        assertNull(RegexRequiredLiteral.of("foo|bar"))
+        assertNull(RegexRequiredLiteral.of("(?i)spam"))
+        assertNull(RegexRequiredLiteral.of("\\Qa.b\\E"))
+        assertNull(RegexRequiredLiteral.of(".*"))
+        assertNull(RegexRequiredLiteral.of("[abc]+"))
+    }
+
+    @Test
+    fun skipsEscapePayloads() {
+        assertEquals("bc", RegexRequiredLiteral.of("\\x41bc"))
+        assertEquals("bc", RegexRequiredLiteral.of("\\x{41}bc"))
+        assertEquals("bcd", RegexRequiredLiteral.of("\\u0041bcd"))
+        assertEquals("xyz", RegexRequiredLiteral.of("\\cAxyz"))
+        assertEquals("zz", RegexRequiredLiteral.of("\\0101zz"))
+        assertEquals("abc", RegexRequiredLiteral.of("\\p{L}abc"))
+        assertEquals("cd", RegexRequiredLiteral.of("(ab)\\1cd"))
+        assertNull(RegexRequiredLiteral.of("\\x41"))
+        assertNull(RegexRequiredLiteral.of("\\p{L}+"))
+    }
+
+    @Test
+    fun literalOccursInEveryMatch() {
+        val cases =
+            mapOf(
+                "\\x41bc" to "Abc",
+                "\\u0041bcd" to "Abcd",
+                "\\cAxyz" to "\u0001xyz",
+                "\\0101zz" to "Azz",
+                "(ab)\\1cd" to "ababcd",
+                "\\p{L}abc" to "Xabc",
+                "前方\\x{9ad8}能" to "前方高能",
+            )
+        for ((regex, text) in cases) {
+            assertTrue(regex, Pattern.compile(regex).matcher(text).matches())
+            val literal = RegexRequiredLiteral.of(regex) ?: continue
+            assertTrue("$regex requires \"$literal\"", text.contains(literal))
+        }
+    }
+}
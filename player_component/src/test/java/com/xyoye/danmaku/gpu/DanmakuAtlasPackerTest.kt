@@ -0,0 +1,58 @@
+package com.xyoye.danmaku.gpu
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class DanmakuAtlasPackerTest {
+    @Test
+    fun placesLeftToRightWithPadding() {
+        val packer = DanmakuAtlasPacker(100, 50, padding = 2)
+        assertTrue(packer.place(40, 10))
+        assertEquals(0, packer.placedX)
+        assertEquals(0, packer.placedY)
+        assertTrue(packer.place(40, 12))
+        assertEquals(42, packer.placedX)
+        assertEquals(0, packer.placedY)
+    }
+
+    @Test
+    fun startsNewShelfBelowTallestRect() {
+        val packer = DanmakuAtlasPacker(100, 50, padding = 2)
+        packer.place(60, 10)
+        packer.place(30, 14)
+        assertTrue(packer.place(50, 10))
+        assertEquals(0, packer.placedX)
+        assertEquals(16, packer.placedY)
+    }
+
+    @Test
+    fun rejectsWhenPageIsFull() {
+        val packer = DanmakuAtlasPacker(100, 30, padding = 2)
+        assertTrue(packer.place(90, 14))
+        assertTrue(packer.place(90, 14))
+        assertFalse(packer.canPlace(10, 14))
+        assertFalse(packer.place(10, 14))
+        // 仍可放入当前行剩余的空间
+        assertTrue(packer.place(6, 14))
+    }
+
+    @Test
+    fun rejectsOversizedRects() {
+        val packer = DanmakuAtlasPacker(100, 30)
+        assertFalse(packer.canPlace(101, 10))
+        assertFalse(packer.canPlace(10, 31))
+        assertFalse(packer.canPlace(0, 10))
+    }
+
+    @Test
+    fun resetReusesThePage() {
+        val packer = DanmakuAtlasPacker(100, 30, padding = 2)
+        packer.place(90, 14)
+        packer.place(90, 14)
+        packer.reset()
+        assertTrue(packer.place(90, 14))
+        assertEquals(0, packer.placedY)
+    }
+}
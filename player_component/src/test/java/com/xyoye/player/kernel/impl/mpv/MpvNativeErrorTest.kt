@@ -0,0 +1,36 @@
+package com.xyoye.player.kernel.impl.mpv
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Test
+
+class MpvNativeErrorTest {
+    @Test
+    fun decode_emptySlotIsNoError() {
+        assertNull(MpvNativeBridge.NativeError.decode(0L) { "unused" })
+        // A cleared slot keeps its sequence bits.
+        assertNull(MpvNativeBridge.NativeError.decode(7L shl 48) { "unused" })
+    }
+
+    @Test
+    fun decode_unpacksCodeMessageAndSequence() {
+        // Same packing as storeError() in mpv_bridge.cpp: sequence | message id | int32 code.
+        val state = (3L shl 48) or (42L shl 32) or (-13).toLong().and(0xFFFFFFFFL)
+
+        val error = MpvNativeBridge.NativeError.decode(state) { id -> "message $id" }!!
+
+        assertEquals(-13, error.code)
+        assertEquals(42, error.messageId)
+        assertEquals(3, error.sequence)
+        assertEquals("message 42: -13", error.describe())
+    }
+
+    @Test
+    fun decode_unknownMessageFallsBackToId() {
+        val state = (1L shl 48) or (5L shl 32)
+
+        val error = MpvNativeBridge.NativeError.decode(state) { null }!!
+
+        assertEquals("mpv bridge error #5", error.describe())
+    }
+}
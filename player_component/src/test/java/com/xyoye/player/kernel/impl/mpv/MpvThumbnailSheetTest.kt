@@ -0,0 +1,118 @@
+package com.xyoye.player.kernel.impl.mpv
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertNull
+import org.junit.Test
+import java.io.ByteArrayOutputStream
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.zip.Deflater
+
+class MpvThumbnailSheetTest {
+    @Test
+    fun open_readsIndexAndTilesAcrossSheets() {
+        // 2x1 tiles of 2x2 pixels per sheet, 3 frames -> 2 sheets; pixel value = frame + 1
+        val file = writeSheetFile(tileWidth = 2, tileHeight = 2, columns = 2, rows = 1, pts = longArrayOf(0L, 4_000L, 9_500L))
+
+        val sheet = MpvThumbnailSheet.open(file)
+        assertNotNull(sheet)
+        sheet!!
+
+        assertEquals(3, sheet.frameCount)
+        assertEquals(12_000L, sheet.durationMs)
+        for (frame in 0 until 3) {
+            assertArrayEquals(ShortArray(4) { (frame + 1).toShort() }, sheet.tilePixels(frame))
+        }
+        assertNull(sheet.tilePixels(3))
+        file.delete()
+    }
+
+    @Test
+    fun frameIndexAt_picksLastFrameNotAfterPosition() {
+        val file = writeSheetFile(tileWidth = 2, tileHeight = 2, columns = 2, rows = 1, pts = longArrayOf(0L, 4_000L, 9_500L))
+        val sheet = MpvThumbnailSheet.open(file)!!
+
+        assertEquals(0, sheet.frameIndexAt(-10L))
+        assertEquals(0, sheet.frameIndexAt(3_999L))
+        assertEquals(1, sheet.frameIndexAt(4_000L))
+        assertEquals(2, sheet.frameIndexAt(60_000L))
+        file.delete()
+    }
+
+    @Test
+    fun open_rejectsForeignOrTruncatedFile() {
+        val foreign = File.createTempFile("thumb", ".bin").apply { writeBytes(ByteArray(64)) }
+        assertNull(MpvThumbnailSheet.open(foreign))
+        foreign.delete()
+
+        val valid = writeSheetFile(tileWidth = 2, tileHeight = 2, columns = 2, rows = 1, pts = longArrayOf(0L, 4_000L))
+        val truncated = File.createTempFile("thumb", ".bin").apply { writeBytes(valid.readBytes().copyOf(60)) }
+        assertNull(MpvThumbnailSheet.open(truncated))
+        valid.delete()
+        truncated.delete()
+    }
+
+    // Mirrors SpriteSheetWriter in mpv_thumbnail.cpp; the native writer itself is checked
+    // against the same layout by bench/thumbnail_sheet_test.cpp (ctest, DANMAKU_HOST_BENCH).
+    private fun writeSheetFile(
+        tileWidth: Int,
+        tileHeight: Int,
+        columns: Int,
+        rows: Int,
+        pts: LongArray
+    ): File {
+        val tilesPerSheet = columns * rows
+        val sheetCount = (pts.size + tilesPerSheet - 1) / tilesPerSheet
+        val sheetStride = columns * tileWidth
+        val rawBytes = sheetStride * rows * tileHeight * 2
+        val sheets =
+            (0 until sheetCount).map { sheetIndex ->
+                val raw = ByteBuffer.allocate(rawBytes).order(ByteOrder.LITTLE_ENDIAN)
+                for (tile in 0 until tilesPerSheet) {
+                    val frame = sheetIndex * tilesPerSheet + tile
+                    if (frame >= pts.size) break
+                    for (y in 0 until tileHeight) {
+                        for (x in 0 until tileWidth) {
+                            val px = (tile % columns) * tileWidth + x
+                            val py = (tile / columns) * tileHeight + y
+                            raw.putShort((py * sheetStride + px) * 2, (frame + 1).toShort())
+                        }
+                    }
+                }
+                deflate(raw.array())
+            }
+
+        val headerBytes = 40 + pts.size * 8 + sheetCount * 16
+        val header = ByteBuffer.allocate(headerBytes).order(ByteOrder.LITTLE_ENDIAN)
+        header.putInt(0x48544444).putInt(1)
+        header.putInt(tileWidth).putInt(tileHeight).putInt(columns).putInt(rows)
+        header.putInt(pts.size).putInt(sheetCount).putLong(12_000L)
+        pts.forEach { header.putLong(it) }
+        var offset = headerBytes.toLong()
+        sheets.forEach { compressed ->
+            header.putLong(offset).putInt(compressed.size).putInt(rawBytes)
+            offset += compressed.size
+        }
+
+        val out = ByteArrayOutputStream()
+        out.write(header.array())
+        sheets.forEach { out.write(it) }
+        return File.createTempFile("thumb", ".ddth").apply { writeBytes(out.toByteArray()) }
+    }
+
+    private fun deflate(data: ByteArray): ByteArray {
+        val deflater = Deflater()
+        deflater.setInput(data)
+        deflater.finish()
+        val out = ByteArrayOutputStream()
+        val buffer = ByteArray(1024)
+        while (!deflater.finished()) {
+            out.write(buffer, 0, deflater.deflate(buffer))
+        }
+        deflater.end()
+        return out.toByteArray()
+    }
+}
@@ -0,0 +1,19 @@
+package com.xyoye.player.subtitle.gpu
+
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+class AssRendererProfileTest {
+    @Test
+    fun fromMemoryClass_picksProfileByHeapBudget() {
+        assertEquals(AssRendererProfile.LOW_MEMORY, AssRendererProfile.fromMemoryClass(96, lowRamDevice = false))
+        assertEquals(AssRendererProfile.LOW_MEMORY, AssRendererProfile.fromMemoryClass(128, lowRamDevice = false))
+        assertEquals(AssRendererProfile.BALANCED, AssRendererProfile.fromMemoryClass(192, lowRamDevice = false))
+        assertEquals(AssRendererProfile.QUALITY, AssRendererProfile.fromMemoryClass(512, lowRamDevice = false))
+    }
+
+    @Test
+    fun fromMemoryClass_lowRamDeviceAlwaysUsesLowMemory() {
+        assertEquals(AssRendererProfile.LOW_MEMORY, AssRendererProfile.fromMemoryClass(512, lowRamDevice = true))
+    }
+}
@@ -2,6 +2,7 @@ package com.xyoye.player.subtitle.gpu
 
 import com.xyoye.data_component.bean.subtitle.TelemetrySample
 import com.xyoye.data_component.enums.SubtitleFrameStatus
+import org.junit.Assert.assertEquals
 import org.junit.Assert.assertFalse
 import org.junit.Assert.assertTrue
 import org.junit.Test
@@ -35,5 +36,70 @@ class SubtitleLoadSheddingPolicyTest {
         assertFalse(policy.allowRender(nowMs = 1_000L))
         assertTrue(policy.allowRender(nowMs = 1_500L))
     }
+
+    @Test
+    fun evaluateTelemetry_stepsDownRenderQualityBeforeThrottling() {
+        val policy =
+            SubtitleLoadSheddingPolicy(
+                frameBudgetMs = 1.0,
+                dropBurstThreshold = 2,
+                throttleWindowMs = 500L,
+                renderQualityLadder = SubtitleRenderQuality.LADDER,
+            )
+        val overBudgetSample = sample(renderLatencyMs = 10.0)
+
+        policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        val firstBurst = policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        assertFalse(firstBurst.dropFrame)
+        assertEquals(SubtitleRenderQuality.TWO_THIRDS, firstBurst.renderQuality)
+        assertTrue(policy.allowRender(nowMs = 1_000L))
+
+        policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        val secondBurst = policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        assertFalse(secondBurst.dropFrame)
+        assertEquals(SubtitleRenderQuality.HALF, secondBurst.renderQuality)
+
+        policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        val lowestRung = policy.evaluateTelemetry(overBudgetSample, nowMs = 1_000L)
+        assertTrue(lowestRung.dropFrame)
+        assertEquals(SubtitleRenderQuality.HALF, lowestRung.renderQuality)
+        assertFalse(policy.allowRender(nowMs = 1_000L))
+    }
+
+    @Test
+    fun evaluateTelemetry_restoresRenderQualityAfterSustainedHeadroom() {
+        val policy =
+            SubtitleLoadSheddingPolicy(
+                frameBudgetMs = 10.0,
+                dropBurstThreshold = 1,
+                renderQualityLadder = SubtitleRenderQuality.LADDER,
+                qualityRecoveryFrames = 3,
+                qualityHoldMs = 1_000L,
+            )
+        policy.evaluateTelemetry(sample(renderLatencyMs = 20.0), nowMs = 0L)
+        assertEquals(SubtitleRenderQuality.TWO_THIRDS, policy.renderQuality)
+
+        // Enough headroom, but still inside the hold window.
+        repeat(3) { policy.evaluateTelemetry(sample(renderLatencyMs = 2.0), nowMs = 500L) }
+        assertEquals(SubtitleRenderQuality.TWO_THIRDS, policy.renderQuality)
+
+        // 6ms at 2/3 scale projects to 13.5ms at full resolution, which restarts the count.
+        policy.evaluateTelemetry(sample(renderLatencyMs = 6.0), nowMs = 1_500L)
+        repeat(2) { policy.evaluateTelemetry(sample(renderLatencyMs = 2.0), nowMs = 1_500L) }
+        assertEquals(SubtitleRenderQuality.TWO_THIRDS, policy.renderQuality)
+
+        policy.evaluateTelemetry(sample(renderLatencyMs = 2.0), nowMs = 1_500L)
+        assertEquals(SubtitleRenderQuality.FULL, policy.renderQuality)
+    }
+
+    private fun sample(renderLatencyMs: Double) =
+        TelemetrySample(
+            timestampMs = 1_000L,
+            subtitlePtsMs = 0L,
+            renderLatencyMs = renderLatencyMs,
+            uploadLatencyMs = 0.0,
+            compositeLatencyMs = 0.0,
+            frameStatus = SubtitleFrameStatus.Rendered,
+        )
 }
 
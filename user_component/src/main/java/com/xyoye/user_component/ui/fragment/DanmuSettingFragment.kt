@@ -72,6 +72,7 @@ class DanmuSettingFragment : PreferenceFragmentCompat() {
                 "auto_match_danmu" -> DanmuConfig.isAutoMatchDanmu()
                 "danmu_update_in_choreographer" -> DanmuConfig.isDanmuUpdateInChoreographer()
                 "danmu_cloud_block" -> DanmuConfig.isCloudDanmuBlock()
+                "danmu_merge_duplicate" -> DanmuConfig.isMergeDuplicateDanmu()
                 "danmu_debug" -> DanmuConfig.isDanmuDebug()
                 else -> super.getBoolean(key, defValue)
             }
@@ -85,6 +86,7 @@ class DanmuSettingFragment : PreferenceFragmentCompat() {
                 "auto_match_danmu" -> DanmuConfig.putAutoMatchDanmu(value)
                 "danmu_update_in_choreographer" -> DanmuConfig.putDanmuUpdateInChoreographer(value)
                 "danmu_cloud_block" -> DanmuConfig.putCloudDanmuBlock(value)
+                "danmu_merge_duplicate" -> DanmuConfig.putMergeDuplicateDanmu(value)
                 "danmu_debug" -> DanmuConfig.putDanmuDebug(value)
                 else -> super.putBoolean(key, value)
             }
@@ -81,6 +81,7 @@ class PlayerSettingFragment : PreferenceFragmentCompat() {
                 Pair("gpu（默认，可使用自定义后处理效果）", "gpu"),
                 Pair("gpu-next（实验）", "gpu-next"),
                 Pair("mediacodec_embed（系统硬件渲染，MPV 不会渲染字幕）", "mediacodec_embed"),
+                Pair("libmpv（实验，渲染线程按 vsync 呈现）", "libmpv"),
             )
 
         val mpvHwdecPriority =
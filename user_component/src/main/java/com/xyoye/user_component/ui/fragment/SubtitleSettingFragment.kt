@@ -11,6 +11,7 @@ import androidx.preference.PreferenceFragmentCompat
 import androidx.preference.SwitchPreference
 import com.xyoye.common_component.config.SubtitleConfig
 import com.xyoye.common_component.enums.SubtitleRendererBackend
+import com.xyoye.data_component.enums.SubtitleLanguage
 import com.xyoye.user_component.R
 
 /**
@@ -20,6 +21,14 @@ import com.xyoye.user_component.R
 class SubtitleSettingFragment : PreferenceFragmentCompat() {
     companion object {
         fun newInstance() = SubtitleSettingFragment()
+
+        // 仅 libass GPU 渲染后端生效，下次加载字幕时应用
+        val subtitleLanguage =
+            mapOf(
+                Pair("不转换", SubtitleLanguage.ORIGINAL.name),
+                Pair("转为简体", SubtitleLanguage.SC.name),
+                Pair("转为繁体", SubtitleLanguage.TC.name),
+            )
     }
 
     override fun onCreatePreferences(
@@ -48,6 +57,12 @@ class SubtitleSettingFragment : PreferenceFragmentCompat() {
             return@setOnPreferenceChangeListener true
         }
 
+        findPreference<ListPreference>("subtitle_language")?.apply {
+            entries = subtitleLanguage.keys.toTypedArray()
+            entryValues = subtitleLanguage.values.toTypedArray()
+            summaryProvider = ListPreference.SimpleSummaryProvider.getInstance()
+        }
+
         sameSubtitlePriority?.apply {
             isVisible = loadSameSubtitleSwitch?.isChecked ?: false
             summary = if (TextUtils.isEmpty(this.text)) "未设置" else text
@@ -79,6 +94,7 @@ class SubtitleSettingFragment : PreferenceFragmentCompat() {
             when (key) {
                 "same_name_subtitle_priority" -> SubtitleConfig.getSubtitlePriority()
                 "subtitle_renderer_backend" -> SubtitleRendererBackend.LIBASS.name
+                "subtitle_language" -> SubtitleLanguage.fromName(SubtitleConfig.getSubtitleLanguage()).name
                 else -> super.getString(key, defValue)
             }
 
@@ -101,6 +117,7 @@ class SubtitleSettingFragment : PreferenceFragmentCompat() {
             when (key) {
                 "same_name_subtitle_priority" -> SubtitleConfig.putSubtitlePriority(value ?: "")
                 "subtitle_renderer_backend" -> Unit
+                "subtitle_language" -> SubtitleConfig.putSubtitleLanguage(SubtitleLanguage.fromName(value).name)
                 else -> super.putString(key, value)
             }
         }